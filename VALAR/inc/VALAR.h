@@ -19,33 +19,22 @@
 // OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
+#include "VALARTypes.h"
+
 #define USE_EMBEDED_SHADERS
 #define USE_DYNAMIC_DESCRIPTOR
 
+// Views of one VALAR_ComputeMaskBatch dispatch, the VALAR_MAX_BATCH_VIEW_COUNT of VRSCommon.hlsli.
+#define VALAR_MAX_BATCH_VIEW_COUNT 8
+
 namespace Intel
 {
-    typedef enum VALAR_AXIS_SHADING_RATE {
-        VALAR_AXIS_SHADING_RATE_1X = 0,
-        VALAR_AXIS_SHADING_RATE_2X = 0x1,
-        VALAR_AXIS_SHADING_RATE_4X = 0x2
-    } VALAR_AXIS_SHADING_RATE;
-
     typedef enum VALAR_VARIABLE_SHADING_RATE_TIER {
         VALAR_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED = 0,
         VALAR_VARIABLE_SHADING_RATE_TIER_1 = 1,
         VALAR_VARIABLE_SHADING_RATE_TIER_2 = 2
     } VALAR_VARIABLE_SHADING_RATE_TIER;
 
-    typedef enum VALAR_SHADING_RATE {
-        VALAR_SHADING_RATE_1X1 = 0,
-        VALAR_SHADING_RATE_1X2 = 0x1,
-        VALAR_SHADING_RATE_2X1 = 0x4,
-        VALAR_SHADING_RATE_2X2 = 0x5,
-        VALAR_SHADING_RATE_2X4 = 0x6,
-        VALAR_SHADING_RATE_4X2 = 0x9,
-        VALAR_SHADING_RATE_4X4 = 0xa
-    } VALAR_SHADING_RATE;
-
     typedef enum VALAR_SHADING_RATE_COMBINER {
         VALAR_SHADING_RATE_COMBINER_PASSTHROUGH = 0,
         VALAR_SHADING_RATE_COMBINER_OVERRIDE = 1,
@@ -54,29 +43,56 @@ namespace Intel
         VALAR_SHADING_RATE_COMBINER_SUM = 4
     } VALAR_SHADING_RATE_COMBINER;
 
-    typedef enum VALAR_RETURN_CODE {
-        VALAR_RETURN_CODE_SUCCESS,
-        VALAR_RETURN_CODE_ROOTSIG_FAIL,
-        VALAR_RETURN_CODE_PSO_FAIL,
-        VALAR_RETURN_CODE_INVALID_ARGUMENT,
-        VALAR_RETURN_CODE_INVALID_DEVICE,
-        VALAR_RETURN_CODE_NOT_SUPPORTED,
-        VALAR_RETURN_CODE_INITIALIZED,
-        VALAR_RETURN_CODE_NOT_INITIALIZED,
-        VALAR_RETURN_CODE_MAX
-    } VALAR_RETURN_CODE;
-
     typedef enum VALAR_SHADER_PERMUTATIONS
     {
         VALAR_SHADER_8X8,
         VALAR_SHADER_16X16,
         VALAR_DEBUG_SHADER,
         VALAR_LP_SHADER,
+        // Permutations of the VALAR_SHADER_8X8, VALAR_SHADER_16X16 and VALAR_SHADER_32X32 shaders with the Weber-Fechner (WF) and motion vector
+        // modes compiled in. VALAR_ComputeMask falls back to the generic shader when a custom blob is missing.
+        VALAR_SHADER_8X8_LUMA,
+        VALAR_SHADER_8X8_VELOCITY,
+        VALAR_SHADER_8X8_UPSCALED_VELOCITY,
+        VALAR_SHADER_8X8_WF,
+        VALAR_SHADER_8X8_WF_VELOCITY,
+        VALAR_SHADER_8X8_WF_UPSCALED_VELOCITY,
+        VALAR_SHADER_16X16_LUMA,
+        VALAR_SHADER_16X16_VELOCITY,
+        VALAR_SHADER_16X16_UPSCALED_VELOCITY,
+        VALAR_SHADER_16X16_WF,
+        VALAR_SHADER_16X16_WF_VELOCITY,
+        VALAR_SHADER_16X16_WF_UPSCALED_VELOCITY,
+        // Generic shader for hardware with a shading rate tile size of 32, and its permutations.
+        VALAR_SHADER_32X32,
+        VALAR_SHADER_32X32_LUMA,
+        VALAR_SHADER_32X32_VELOCITY,
+        VALAR_SHADER_32X32_UPSCALED_VELOCITY,
+        VALAR_SHADER_32X32_WF,
+        VALAR_SHADER_32X32_WF_VELOCITY,
+        VALAR_SHADER_32X32_WF_UPSCALED_VELOCITY,
+        // Shaders of the amortized updates per tile size, selected when m_amortizationPeriod is larger than 1.
+        VALAR_SHADER_8X8_AMORTIZED,
+        VALAR_SHADER_16X16_AMORTIZED,
+        VALAR_SHADER_32X32_AMORTIZED,
+        // Shaders of VALAR_ComputeMaskBatch per tile size, one view per SV_GroupID.z.
+        VALAR_SHADER_8X8_BATCHED,
+        VALAR_SHADER_16X16_BATCHED,
+        VALAR_SHADER_32X32_BATCHED,
         VALAR_SHADER_COUNT
     } VALAR_SHADER_PERMUTATIONS;
 
     struct VALAR_DESCRIPTOR_OPAQUE;
 
+    // Tile coordinates of a VALAR mask region, m_right and m_bottom are exclusive.
+    struct VALAR_TILE_RECT
+    {
+        UINT                                m_left                              = 0;
+        UINT                                m_top                               = 0;
+        UINT                                m_right                             = 0;
+        UINT                                m_bottom                            = 0;
+    };
+
     struct VALAR_HARDWARE_FEATURES
     {
         UINT                                m_shadingRateTileSize               = 0;
@@ -106,6 +122,16 @@ namespace Intel
         bool                                m_debugGrid                         = false;
         bool                                m_enabled                           = true;
         bool                                m_LPShader                          = false;
+        // Re-evaluates 1 / m_amortizationPeriod of the tiles per frame, 1, 2, 4, 8 or 16, picked in Bayer order by
+        // m_frameIndex. The other tiles keep their rate, unless they move faster than m_amortizationVelocityBound.
+        UINT                                m_frameIndex                        = 0;
+        UINT                                m_amortizationPeriod                = 1;
+        float                               m_amortizationVelocityBound         = 2.0f;
+        // Tile rects of the mask dispatched by VALAR_ComputeMask. With a m_regionOfInterestCount above 0 the tiles outside
+        // of them are filled with m_outsideShadingRate instead.
+        const VALAR_TILE_RECT*              m_regionsOfInterest                 = nullptr;
+        UINT                                m_regionOfInterestCount             = 0;
+        VALAR_SHADING_RATE                  m_outsideShadingRate                = VALAR_SHADING_RATE_1X1;
         UINT                                m_bufferWidth                       = 0;
         UINT                                m_bufferHeight                      = 0;
         UINT                                m_upscaleWidth                      = 0;
@@ -113,7 +139,7 @@ namespace Intel
         ID3D12Device*                       m_device                            = nullptr;
         ID3D12DescriptorHeap*               m_uavHeap                           = nullptr;
         ID3D12Resource*                     m_valarBuffer                       = nullptr;
-        ID3DBlob*                           m_shaderBlobs[VALAR_SHADER_COUNT];
+        ID3DBlob*                           m_shaderBlobs[VALAR_SHADER_COUNT]   = {};
         ID3D12GraphicsCommandList5*         m_commandList                       = nullptr;
         VALAR_DESCRIPTOR_OPAQUE*            m_pOpaque;
         VALAR_HARDWARE_FEATURES             m_hwFeatures;
@@ -124,7 +150,9 @@ namespace Intel
     const VALAR_RETURN_CODE VALAR_Release(const VALAR_DESCRIPTOR& desc);
     const VALAR_RETURN_CODE VALAR_ComputeMask(const VALAR_DESCRIPTOR& desc);
     const VALAR_RETURN_CODE VALAR_ComputeMaskLP(const VALAR_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskBatch(const VALAR_DESCRIPTOR& desc, ID3D12Resource* const* valarBuffers, UINT viewCount);
     const VALAR_RETURN_CODE VALAR_DebugOverlay(const VALAR_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_UploadMask(const VALAR_DESCRIPTOR& desc, ID3D12Resource* uploadBuffer, UINT64 uploadOffset);
     const VALAR_RETURN_CODE VALAR_ApplyMask(const VALAR_DESCRIPTOR& desc);
     const VALAR_RETURN_CODE VALAR_ResetMask(const VALAR_DESCRIPTOR& desc);
     const VALAR_RETURN_CODE VALAR_SetScreenSpaceCombiners(const VALAR_DESCRIPTOR& desc);
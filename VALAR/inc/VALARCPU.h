@@ -0,0 +1,286 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "VALARTypes.h"
+
+// Let VALAR_InitializeCPU create one worker thread per additional hardware thread.
+#define VALAR_CPU_WORKER_THREAD_COUNT_AUTO 0xFFFFFFFF
+
+// Upper bound for m_asyncMaskBufferCount, triple buffering.
+#define VALAR_CPU_MAX_ASYNC_MASK_BUFFER_COUNT 3
+
+// Number of entries needed to index per shading rate data directly with a VALAR_SHADING_RATE.
+#define VALAR_CPU_SHADING_RATE_COUNT (Intel::VALAR_SHADING_RATE_4X4 + 1)
+
+// Row pitch alignment of a texture in an upload buffer, the same as D3D12_TEXTURE_DATA_PITCH_ALIGNMENT.
+#define VALAR_CPU_MASK_PITCH_ALIGNMENT 256
+
+// Number of masks of a VALAR_CPU_MASK_PYRAMID, one per supported tile size.
+#define VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT 3
+
+// Range of VALAR_CPU_SHADER_EMULATION::m_waveLaneCount, the wave sizes of D3D12 wave intrinsics.
+#define VALAR_CPU_MIN_WAVE_LANE_COUNT 4
+#define VALAR_CPU_MAX_WAVE_LANE_COUNT 128
+
+namespace Intel
+{
+    typedef enum VALAR_CPU_INSTRUCTION_SET {
+        VALAR_CPU_INSTRUCTION_SET_AUTO,
+        VALAR_CPU_INSTRUCTION_SET_SCALAR,
+        VALAR_CPU_INSTRUCTION_SET_SSE41,
+        VALAR_CPU_INSTRUCTION_SET_AVX2,
+        VALAR_CPU_INSTRUCTION_SET_AVX512,
+        VALAR_CPU_INSTRUCTION_SET_NEON
+    } VALAR_CPU_INSTRUCTION_SET;
+
+    // Pixel layout of the CPU inputs, named after the matching DXGI format. Color channels are decoded like a typed
+    // load of that format, the 8-bit formats are 4 bytes per pixel in the channel order of their name. R32_UINT is the
+    // packed velocity and R32G32_FLOAT the upscaled velocity, every other format is a color format.
+    typedef enum VALAR_CPU_FORMAT {
+        VALAR_CPU_FORMAT_R32G32B32A32_FLOAT,
+        // Linearized with the square law of the shader, the same as a UNORM view of the color buffer.
+        VALAR_CPU_FORMAT_R8G8B8A8_UNORM,
+        // Linearized with the exact sRGB transfer function instead of the square law.
+        VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB,
+        VALAR_CPU_FORMAT_B8G8R8A8_UNORM,
+        VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB,
+        VALAR_CPU_FORMAT_R10G10B10A2_UNORM,
+        VALAR_CPU_FORMAT_R11G11B10_FLOAT,
+        VALAR_CPU_FORMAT_R16G16B16A16_FLOAT,
+        VALAR_CPU_FORMAT_R32_UINT,
+        VALAR_CPU_FORMAT_R32G32_FLOAT
+    } VALAR_CPU_FORMAT;
+
+    struct VALAR_CPU_DESCRIPTOR_OPAQUE;
+
+    // Strided view of a CPU image, such as a mapped readback buffer, a video decoder surface or a sub-rectangle of
+    // an atlas. Row y starts m_rowPitch * (y - m_firstRow) bytes after m_data, a row pitch of 0 means tightly packed
+    // rows. The row pitch and m_data have to be multiples of 4 bytes. Only the row bands of VALAR_ComputeRowBandCPU
+    // start at a later row, the views of a descriptor keep m_firstRow at 0.
+    struct VALAR_CPU_IMAGE_VIEW
+    {
+        const void*                         m_data                              = nullptr;
+        uint32_t                            m_rowPitch                          = 0;
+        uint32_t                            m_width                             = 0;
+        uint32_t                            m_height                            = 0;
+        VALAR_CPU_FORMAT                    m_format                            = VALAR_CPU_FORMAT_R32G32B32A32_FLOAT;
+        uint32_t                            m_firstRow                          = 0;
+    };
+
+    struct VALAR_CPU_FEATURES
+    {
+        bool                                m_sse41Supported                    = false;
+        bool                                m_avx2Supported                     = false;
+        bool                                m_avx512Supported                   = false;
+        bool                                m_neonSupported                     = false;
+        VALAR_CPU_INSTRUCTION_SET           m_instructionSet                    = VALAR_CPU_INSTRUCTION_SET_SCALAR;
+    };
+
+    // Tile coordinates of a VALAR mask region, m_right and m_bottom are exclusive.
+    struct VALAR_CPU_TILE_RECT
+    {
+        uint32_t                            m_left                              = 0;
+        uint32_t                            m_top                               = 0;
+        uint32_t                            m_right                             = 0;
+        uint32_t                            m_bottom                            = 0;
+    };
+
+    // Pixel coordinates of a color buffer region, m_right and m_bottom are exclusive.
+    struct VALAR_CPU_RECT
+    {
+        uint32_t                            m_left                              = 0;
+        uint32_t                            m_top                               = 0;
+        uint32_t                            m_right                             = 0;
+        uint32_t                            m_bottom                            = 0;
+    };
+
+    struct VALAR_CPU_MASK_STATISTICS
+    {
+        uint32_t                            m_tileCount                         = 0;
+        uint32_t                            m_shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+        float                               m_shadingRateRatio                  = 1.0f;
+    };
+
+    // Fence like handle of a mask computed by VALAR_ComputeMaskAsyncCPU. m_valarBuffer is owned by VALAR
+    // and may only be read once the fence completed, it stays valid until VALAR_CPU_DESCRIPTOR::m_asyncMaskBufferCount
+    // more masks have been submitted, also when the mask size changes in between.
+    struct VALAR_CPU_ASYNC_MASK
+    {
+        uint64_t                            m_fenceValue                        = 0;
+        const uint8_t*                      m_valarBuffer                       = nullptr;
+    };
+
+    // Color (and velocity) rows needed to compute one row of tiles with VALAR_ComputeRowBandCPU. The rows
+    // start with the halo row directly above the tile row, except for tile row 0 which starts at row 0,
+    // and end with the last row of the tile row. Both buffers have the format and row pitch of the color
+    // and velocity inputs of VALAR_CPU_DESCRIPTOR, the row pitch of its views when they are set.
+    struct VALAR_CPU_ROW_BAND
+    {
+        uint32_t                            m_tileRow                           = 0;
+        const void*                         m_colorRows                         = nullptr;
+        const uint32_t*                     m_velocityRows                      = nullptr;
+    };
+
+    // Masks computed by VALAR_ComputeMaskPyramidCPU, level 0 is the 8x8 mask, level 1 the 16x16 mask and level 2 the
+    // 32x32 mask. A null buffer skips its level, a row pitch of 0 means tightly packed rows.
+    struct VALAR_CPU_MASK_PYRAMID
+    {
+        uint8_t*                            m_valarBuffers[VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT] = {};
+        uint32_t                            m_valarRowPitches[VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT] = {};
+    };
+
+    // Counters of the emulated dispatches of one call. Out of bounds accesses are counted per lane and access,
+    // resources return zero like a UAV and groupshared arrays like the flat array, see the README.
+    struct VALAR_CPU_SHADER_EMULATION_STATISTICS
+    {
+        uint64_t                            m_groupCount                        = 0;
+        uint64_t                            m_barrierCount                      = 0;
+        uint64_t                            m_waveIntrinsicCount                = 0;
+        uint64_t                            m_groupSharedOutOfBoundsCount       = 0;
+        uint64_t                            m_resourceOutOfBoundsCount          = 0;
+    };
+
+    // Runs the shipped HLSL of the mask, LP and debug overlay shaders on the CPU. m_waveLaneCount is the wave size
+    // returned by WaveGetLaneCount, a power of two from VALAR_CPU_MIN_WAVE_LANE_COUNT to VALAR_CPU_MAX_WAVE_LANE_COUNT.
+    // m_genericShader runs the permutation reading the modes from the root constants instead of the specialized one.
+    // The overlay is written to m_overlayBuffer, m_upscaleWidth x m_upscaleHeight tightly packed RGBA floats.
+    struct VALAR_CPU_SHADER_EMULATION
+    {
+        uint32_t                            m_waveLaneCount                     = 32;
+        bool                                m_genericShader                     = false;
+        bool                                m_debugGrid                         = false;
+        float*                              m_overlayBuffer                     = nullptr;
+        VALAR_CPU_SHADER_EMULATION_STATISTICS* m_pStatistics                    = nullptr;
+    };
+
+    // What a VALAR allocation is used for, passed to the allocation callbacks.
+    typedef enum VALAR_CPU_ALLOCATION_TAG {
+        VALAR_CPU_ALLOCATION_TAG_DESCRIPTOR,
+        VALAR_CPU_ALLOCATION_TAG_THREAD_POOL,
+        VALAR_CPU_ALLOCATION_TAG_ASYNC_QUEUE,
+        VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY,
+        VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION
+    } VALAR_CPU_ALLOCATION_TAG;
+
+    typedef void* (*VALAR_CPU_ALLOCATE_FUNCTION)(void* userData, size_t size, size_t alignment, VALAR_CPU_ALLOCATION_TAG tag);
+    typedef void (*VALAR_CPU_FREE_FUNCTION)(void* userData, void* memory, VALAR_CPU_ALLOCATION_TAG tag);
+
+    // Allocator of all memory owned by VALAR, set both functions or none. The alignment is a power of two, a failed
+    // allocation returns nullptr. The stacks and the bookkeeping of the threads VALAR creates are allocated by the
+    // C++ runtime instead.
+    struct VALAR_CPU_ALLOCATION_CALLBACKS
+    {
+        VALAR_CPU_ALLOCATE_FUNCTION         m_allocate                          = nullptr;
+        VALAR_CPU_FREE_FUNCTION             m_free                              = nullptr;
+        void*                               m_userData                          = nullptr;
+    };
+
+    struct VALAR_CPU_DESCRIPTOR
+    {
+        float                               m_sensitivityThreshold              = 0.50f;
+        float                               m_quarterRateShadingModifier        = 2.13f;
+        float                               m_environmentLuminance              = 0.02f;
+        bool                                m_allowQuarterRateShading           = true;
+        bool                                m_weberFechnerMode                  = false;
+        float                               m_weberFechnerConstant              = 1.0f;
+        bool                                m_useMotionVectors                  = false;
+        bool                                m_useUpscaleMotionVectors           = false;
+        bool                                m_enabled                           = true;
+        // Samples per tile of VALAR_ComputeMaskLPCPU, 4, 8 or 16. m_LPRotateSamples moves them inside of their
+        // strata every frame, m_frameIndex selects the pattern of the frame.
+        uint32_t                            m_LPSampleCount                     = 4;
+        bool                                m_LPRotateSamples                   = false;
+        uint32_t                            m_frameIndex                        = 0;
+        // Tiles re-evaluated per frame are 1 / m_amortizationPeriod, 1, 2, 4, 8 or 16, picked in Bayer order by
+        // m_frameIndex. The other tiles keep their rate in m_valarBuffer, unless they move faster than
+        // m_amortizationVelocityBound pixels per frame with motion vectors.
+        uint32_t                            m_amortizationPeriod                = 1;
+        float                               m_amortizationVelocityBound         = 2.0f;
+        // Reuses the statistics of the previous mask for tiles whose content moved along the motion vectors without
+        // changing. A tile is recomputed when its sampled luminance changed by more than m_temporalLumaTolerance
+        // (relative), its motion vector differs from the reprojected tile by more than m_temporalVelocityTolerance
+        // pixels, or its statistics are m_temporalMaxAge masks old. Not combinable with amortized masks
+        // or VALAR_ComputeTilesCPU.
+        bool                                m_temporalReuse                     = false;
+        float                               m_temporalLumaTolerance             = 0.05f;
+        float                               m_temporalVelocityTolerance         = 1.0f;
+        uint32_t                            m_temporalMaxAge                    = 8;
+        // Tile rects of the mask computed by VALAR_ComputeMaskCPU and VALAR_ComputeTilesCPU. With a
+        // m_regionOfInterestCount above 0 the tiles outside of them are filled with m_outsideShadingRate instead.
+        // Asynchronous masks read the rects when they run.
+        const VALAR_CPU_TILE_RECT*          m_regionsOfInterest                 = nullptr;
+        uint32_t                            m_regionOfInterestCount             = 0;
+        VALAR_SHADING_RATE                  m_outsideShadingRate                = VALAR_SHADING_RATE_1X1;
+        uint32_t                            m_shadingRateTileSize               = 8;
+        uint32_t                            m_bufferWidth                       = 0;
+        uint32_t                            m_bufferHeight                      = 0;
+        uint32_t                            m_upscaleWidth                      = 0;
+        uint32_t                            m_upscaleHeight                     = 0;
+        VALAR_CPU_FORMAT                    m_colorFormat                       = VALAR_CPU_FORMAT_R32G32B32A32_FLOAT;
+        const void*                         m_colorBuffer                       = nullptr;
+        const uint32_t*                     m_velocityBuffer                    = nullptr;
+        const float*                        m_upscaledVelocityBuffer            = nullptr;
+        // Strided views of the inputs, each one replaces the tightly packed buffer above when its m_data is set.
+        // The views have to be m_bufferWidth x m_bufferHeight, the upscaled velocity view m_upscaleWidth x m_upscaleHeight.
+        VALAR_CPU_IMAGE_VIEW                m_colorView;
+        VALAR_CPU_IMAGE_VIEW                m_velocityView;
+        VALAR_CPU_IMAGE_VIEW                m_upscaledVelocityView;
+        uint8_t*                            m_valarBuffer                       = nullptr;
+        // Bytes between two tile rows of m_valarBuffer, 0 means tightly packed rows. Set it to the row pitch of
+        // VALAR_GetMaskFootprintCPU to write the mask straight into a mapped D3D12 upload buffer.
+        uint32_t                            m_valarRowPitch                     = 0;
+        VALAR_CPU_INSTRUCTION_SET           m_instructionSet                    = VALAR_CPU_INSTRUCTION_SET_AUTO;
+        uint32_t                            m_workerThreadCount                 = VALAR_CPU_WORKER_THREAD_COUNT_AUTO;
+        // Cores of the worker threads, only used when m_workerThreadCoreCount matches the number of worker threads.
+        const uint32_t*                     m_workerThreadCores                 = nullptr;
+        uint32_t                            m_workerThreadCoreCount             = 0;
+        uint32_t                            m_asyncMaskBufferCount              = 0;
+        // Read by VALAR_InitializeCPU only, the functions are used until VALAR_ReleaseCPU.
+        VALAR_CPU_ALLOCATION_CALLBACKS      m_allocationCallbacks;
+        VALAR_CPU_DESCRIPTOR_OPAQUE*        m_pOpaque                           = nullptr;
+        VALAR_CPU_FEATURES                  m_cpuFeatures;
+    };
+
+    const VALAR_RETURN_CODE VALAR_CheckSupportCPU(VALAR_CPU_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_InitializeCPU(VALAR_CPU_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_ReleaseCPU(VALAR_CPU_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskCPU(const VALAR_CPU_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskLPCPU(const VALAR_CPU_DESCRIPTOR& desc);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskEmulatedCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_SHADER_EMULATION& emulation);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskLPEmulatedCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_SHADER_EMULATION& emulation);
+    const VALAR_RETURN_CODE VALAR_DebugOverlayEmulatedCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_SHADER_EMULATION& emulation);
+    const VALAR_RETURN_CODE VALAR_ComputeTilesCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_TILE_RECT& tileRect);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskBatchCPU(const VALAR_CPU_DESCRIPTOR* views, uint32_t viewCount);
+    const VALAR_RETURN_CODE VALAR_ComputeDirtyRectsCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_RECT* dirtyRects, uint32_t dirtyRectCount);
+    const VALAR_RETURN_CODE VALAR_PredictMaskCPU(const VALAR_CPU_DESCRIPTOR& desc, uint8_t* predictedMask);
+    const VALAR_RETURN_CODE VALAR_FinalizeMaskCPU(const VALAR_CPU_DESCRIPTOR& desc, VALAR_CPU_MASK_STATISTICS* pStatistics);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskPyramidCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_MASK_PYRAMID& pyramid);
+    const VALAR_RETURN_CODE VALAR_ComputeRowBandCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_ROW_BAND& band, uint8_t* valarRow);
+    const VALAR_RETURN_CODE VALAR_ComputeMaskAsyncCPU(const VALAR_CPU_DESCRIPTOR& desc, VALAR_CPU_ASYNC_MASK& asyncMask);
+    const VALAR_RETURN_CODE VALAR_GetCompletedFenceValueCPU(const VALAR_CPU_DESCRIPTOR& desc, uint64_t& fenceValue);
+    const VALAR_RETURN_CODE VALAR_WaitForMaskCPU(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_ASYNC_MASK& asyncMask);
+    const VALAR_RETURN_CODE VALAR_GetAllocationCountCPU(const VALAR_CPU_DESCRIPTOR& desc, uint64_t& allocationCount);
+    const VALAR_RETURN_CODE VALAR_SetWarmUpCompleteCPU(const VALAR_CPU_DESCRIPTOR& desc, bool isWarmUpComplete);
+    const VALAR_RETURN_CODE VALAR_GetMaskFootprintCPU(const VALAR_CPU_DESCRIPTOR& desc, uint32_t& rowPitch, uint32_t& sizeInBytes);
+}
\ No newline at end of file
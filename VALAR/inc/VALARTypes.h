@@ -0,0 +1,52 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+namespace Intel
+{
+    typedef enum VALAR_AXIS_SHADING_RATE {
+        VALAR_AXIS_SHADING_RATE_1X = 0,
+        VALAR_AXIS_SHADING_RATE_2X = 0x1,
+        VALAR_AXIS_SHADING_RATE_4X = 0x2
+    } VALAR_AXIS_SHADING_RATE;
+
+    typedef enum VALAR_SHADING_RATE {
+        VALAR_SHADING_RATE_1X1 = 0,
+        VALAR_SHADING_RATE_1X2 = 0x1,
+        VALAR_SHADING_RATE_2X1 = 0x4,
+        VALAR_SHADING_RATE_2X2 = 0x5,
+        VALAR_SHADING_RATE_2X4 = 0x6,
+        VALAR_SHADING_RATE_4X2 = 0x9,
+        VALAR_SHADING_RATE_4X4 = 0xa
+    } VALAR_SHADING_RATE;
+
+    typedef enum VALAR_RETURN_CODE {
+        VALAR_RETURN_CODE_SUCCESS,
+        VALAR_RETURN_CODE_ROOTSIG_FAIL,
+        VALAR_RETURN_CODE_PSO_FAIL,
+        VALAR_RETURN_CODE_INVALID_ARGUMENT,
+        VALAR_RETURN_CODE_INVALID_DEVICE,
+        VALAR_RETURN_CODE_NOT_SUPPORTED,
+        VALAR_RETURN_CODE_INITIALIZED,
+        VALAR_RETURN_CODE_NOT_INITIALIZED,
+        VALAR_RETURN_CODE_OUT_OF_MEMORY,
+        VALAR_RETURN_CODE_MAX
+    } VALAR_RETURN_CODE;
+}
\ No newline at end of file
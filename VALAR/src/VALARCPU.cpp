@@ -0,0 +1,1672 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARCPUThreadPool.h"
+#include "VALARCPUAsync.h"
+#include "VALARCPUTemporal.h"
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_CheckSupportCPU(Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    return CheckCPUFeatureSupport(desc.m_cpuFeatures);
+}
+
+static void DestroyOpaque(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE* opaque)
+{
+    // Pending async masks still use the thread pool, so the queue goes first.
+    Intel::DestroyAsyncQueue(*opaque, opaque->m_asyncQueue);
+    Intel::DestroyThreadPool(*opaque, opaque->m_threadPool);
+    Intel::DestroyTemporalHistory(*opaque, opaque->m_temporalHistory);
+
+    // The opaque holds the callbacks it is freed with.
+    const Intel::VALAR_CPU_ALLOCATION_CALLBACKS allocationCallbacks = opaque->m_allocationCallbacks;
+    opaque->~VALAR_CPU_DESCRIPTOR_OPAQUE();
+    Intel::FreeMemory(allocationCallbacks, opaque, Intel::VALAR_CPU_ALLOCATION_TAG_DESCRIPTOR);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_InitializeCPU(Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    if (desc.m_pOpaque != nullptr && desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_INITIALIZED;
+    }
+
+    VALAR_RETURN_CODE retCode = CheckCPUFeatureSupport(desc.m_cpuFeatures);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    switch (desc.m_instructionSet)
+    {
+    case VALAR_CPU_INSTRUCTION_SET_AUTO:
+        break;
+    case VALAR_CPU_INSTRUCTION_SET_SCALAR:
+        desc.m_cpuFeatures.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_SCALAR;
+        break;
+    case VALAR_CPU_INSTRUCTION_SET_SSE41:
+    case VALAR_CPU_INSTRUCTION_SET_AVX2:
+    case VALAR_CPU_INSTRUCTION_SET_AVX512:
+    case VALAR_CPU_INSTRUCTION_SET_NEON:
+        if ((desc.m_instructionSet == VALAR_CPU_INSTRUCTION_SET_SSE41 && !desc.m_cpuFeatures.m_sse41Supported) ||
+            (desc.m_instructionSet == VALAR_CPU_INSTRUCTION_SET_AVX2 && !desc.m_cpuFeatures.m_avx2Supported) ||
+            (desc.m_instructionSet == VALAR_CPU_INSTRUCTION_SET_AVX512 && !desc.m_cpuFeatures.m_avx512Supported) ||
+            (desc.m_instructionSet == VALAR_CPU_INSTRUCTION_SET_NEON && !desc.m_cpuFeatures.m_neonSupported)) {
+            return VALAR_RETURN_CODE_NOT_SUPPORTED;
+        }
+        desc.m_cpuFeatures.m_instructionSet = desc.m_instructionSet;
+        break;
+    default:
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    uint32_t workerThreadCount = desc.m_workerThreadCount;
+    if (workerThreadCount == VALAR_CPU_WORKER_THREAD_COUNT_AUTO) {
+        // The calling thread also computes tiles, so one less worker than hardware threads.
+        const uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+        workerThreadCount = (hardwareThreadCount > 1) ? hardwareThreadCount - 1 : 0;
+    }
+
+    // The core array is only read when it has one core per worker, the automatic count is rarely known up front.
+    const uint32_t* workerThreadCores = (desc.m_workerThreadCoreCount == workerThreadCount) ? desc.m_workerThreadCores : nullptr;
+
+    if (desc.m_asyncMaskBufferCount > VALAR_CPU_MAX_ASYNC_MASK_BUFFER_COUNT) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if ((desc.m_allocationCallbacks.m_allocate == nullptr) != (desc.m_allocationCallbacks.m_free == nullptr)) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    void* opaqueMemory = AllocateMemory(desc.m_allocationCallbacks, sizeof(VALAR_CPU_DESCRIPTOR_OPAQUE), alignof(VALAR_CPU_DESCRIPTOR_OPAQUE), VALAR_CPU_ALLOCATION_TAG_DESCRIPTOR);
+    if (opaqueMemory == nullptr) {
+        return VALAR_RETURN_CODE_OUT_OF_MEMORY;
+    }
+
+    VALAR_CPU_DESCRIPTOR_OPAQUE* opaque = new (opaqueMemory) VALAR_CPU_DESCRIPTOR_OPAQUE();
+    opaque->m_allocationCallbacks = desc.m_allocationCallbacks;
+    opaque->m_allocationCount = 1;
+    opaque->m_featureSupport = desc.m_cpuFeatures;
+    SelectTileKernels(desc.m_cpuFeatures.m_instructionSet, opaque->m_tileKernels);
+    opaque->m_threadPool = CreateThreadPool(*opaque, workerThreadCount, workerThreadCores);
+    opaque->m_asyncQueue = (desc.m_asyncMaskBufferCount > 0) ? CreateAsyncQueue(*opaque, desc.m_asyncMaskBufferCount) : nullptr;
+    opaque->m_temporalHistory = CreateTemporalHistory(*opaque);
+
+    if (opaque->m_threadPool == nullptr || (desc.m_asyncMaskBufferCount > 0 && opaque->m_asyncQueue == nullptr) ||
+        opaque->m_temporalHistory == nullptr) {
+        DestroyOpaque(opaque);
+        return VALAR_RETURN_CODE_OUT_OF_MEMORY;
+    }
+
+    desc.m_pOpaque = opaque;
+    desc.m_pOpaque->m_isInitialized = true;
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ReleaseCPU(Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    DestroyOpaque(desc.m_pOpaque);
+    desc.m_pOpaque = nullptr;
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+static bool IsValidImageView(const Intel::VALAR_CPU_IMAGE_VIEW& view, uint32_t width, uint32_t height, uint32_t pixelSize)
+{
+    if (view.m_data == nullptr || pixelSize == 0 || view.m_width != width || view.m_height != height || view.m_firstRow != 0) {
+        return false;
+    }
+
+    // The kernels load whole 32-bit words, a row also has to hold all of its pixels.
+    return ((uintptr_t)view.m_data % 4) == 0 && (view.m_rowPitch % 4) == 0 && view.m_rowPitch >= width * pixelSize;
+}
+
+Intel::VALAR_RETURN_CODE Intel::ValidateCPUDescriptor(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    if (desc.m_valarBuffer == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_bufferWidth == 0 || desc.m_bufferHeight == 0) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (!IsValidTileSize(desc.m_shadingRateTileSize)) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    if (desc.m_valarRowPitch != 0 && desc.m_valarRowPitch < tilesX) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (!IsValidAmortizationPeriod(desc.m_amortizationPeriod)) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    // Amortized tiles keep their rate without statistics to reuse.
+    if (desc.m_temporalReuse && desc.m_amortizationPeriod > 1) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_regionOfInterestCount > 0) {
+        if (desc.m_regionsOfInterest == nullptr || desc.m_temporalReuse || !IsValidShadingRate(desc.m_outsideShadingRate)) {
+            return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+        }
+
+        const uint32_t tilesY = (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+
+        for (uint32_t i = 0; i < desc.m_regionOfInterestCount; i++) {
+            const VALAR_CPU_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+            if (tileRect.m_left > tileRect.m_right || tileRect.m_top > tileRect.m_bottom || tileRect.m_right > tilesX || tileRect.m_bottom > tilesY) {
+                return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+            }
+        }
+    }
+
+    const VALAR_CPU_IMAGE_VIEW colorView = GetColorView(desc);
+    if (!IsValidImageView(colorView, desc.m_bufferWidth, desc.m_bufferHeight, GetColorPixelSize(colorView.m_format))) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_useMotionVectors) {
+        if (desc.m_useUpscaleMotionVectors) {
+            const VALAR_CPU_IMAGE_VIEW velocityView = GetUpscaledVelocityView(desc);
+            const uint32_t pixelSize = (velocityView.m_format == VALAR_CPU_FORMAT_R32G32_FLOAT) ? 2 * sizeof(float) : 0;
+
+            if (desc.m_upscaleWidth == 0 || desc.m_upscaleHeight == 0 ||
+                !IsValidImageView(velocityView, desc.m_upscaleWidth, desc.m_upscaleHeight, pixelSize)) {
+                return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+            }
+        } else {
+            const VALAR_CPU_IMAGE_VIEW velocityView = GetVelocityView(desc);
+            const uint32_t pixelSize = (velocityView.m_format == VALAR_CPU_FORMAT_R32_UINT) ? sizeof(uint32_t) : 0;
+
+            if (!IsValidImageView(velocityView, desc.m_bufferWidth, desc.m_bufferHeight, pixelSize)) {
+                return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+            }
+        }
+    }
+
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+void Intel::BuildColumnMasks(uint32_t tileSize, Intel::VALAR_CPU_COLUMN_MASKS& masks)
+{
+    for (uint32_t x = 0; x < VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING; x++) {
+        masks.m_left[x] = (x % tileSize == 0) ? 10000.0f : -FLT_MAX;
+        masks.m_right[x] = (x % tileSize == tileSize - 1) ? 10000.0f : -FLT_MAX;
+    }
+
+    for (uint32_t x = 0; x < 1 + VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING; x++) {
+        masks.m_sentinel[x] = 10000.0f;
+    }
+}
+
+const Intel::VALAR_CPU_COLUMN_MASKS& Intel::GetColumnMasks(uint32_t tileSize)
+{
+    struct VALAR_CPU_COLUMN_MASK_TABLES
+    {
+        VALAR_CPU_COLUMN_MASK_TABLES()
+        {
+            BuildColumnMasks(INTEL_TILE_SIZE, m_intelTileMasks);
+            BuildColumnMasks(OTHER_TILE_SIZE, m_otherTileMasks);
+            BuildColumnMasks(LARGE_TILE_SIZE, m_largeTileMasks);
+        }
+
+        VALAR_CPU_COLUMN_MASKS m_intelTileMasks;
+        VALAR_CPU_COLUMN_MASKS m_otherTileMasks;
+        VALAR_CPU_COLUMN_MASKS m_largeTileMasks;
+    };
+
+    static const VALAR_CPU_COLUMN_MASK_TABLES tables;
+
+    if (tileSize == INTEL_TILE_SIZE) {
+        return tables.m_intelTileMasks;
+    }
+
+    return (tileSize == OTHER_TILE_SIZE) ? tables.m_otherTileMasks : tables.m_largeTileMasks;
+}
+
+static bool IsSRGBColorFormat(Intel::VALAR_CPU_FORMAT colorFormat)
+{
+    return colorFormat == Intel::VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB || colorFormat == Intel::VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB;
+}
+
+void Intel::BuildUNORM8Table(Intel::VALAR_CPU_FORMAT colorFormat, Intel::VALAR_CPU_UNORM8_TABLE& table)
+{
+    for (uint32_t c = 0; c < 256; c++) {
+        if (IsSRGBColorFormat(colorFormat)) {
+            const double encoded = (double)c / 255.0;
+            const double linear = (encoded <= 0.04045) ? encoded / 12.92 : pow((encoded + 0.055) / 1.055, 2.4);
+
+            table.m_linear[c] = (float)linear;
+            table.m_linearFixed[c] = (uint32_t)(linear * VALAR_CPU_UNORM8_LINEAR_SCALE + 0.5);
+        } else {
+            // Same as squaring the value of a UNORM load in the shader.
+            const float unorm = (float)c / 255.0f;
+
+            table.m_linear[c] = unorm * unorm;
+            table.m_linearFixed[c] = c * c;
+        }
+    }
+}
+
+const Intel::VALAR_CPU_UNORM8_TABLE& Intel::GetUNORM8Table(Intel::VALAR_CPU_FORMAT colorFormat)
+{
+    struct VALAR_CPU_UNORM8_TABLES
+    {
+        VALAR_CPU_UNORM8_TABLES()
+        {
+            BuildUNORM8Table(VALAR_CPU_FORMAT_R8G8B8A8_UNORM, m_unormTable);
+            BuildUNORM8Table(VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB, m_srgbTable);
+        }
+
+        VALAR_CPU_UNORM8_TABLE m_unormTable;
+        VALAR_CPU_UNORM8_TABLE m_srgbTable;
+    };
+
+    static const VALAR_CPU_UNORM8_TABLES tables;
+
+    return IsSRGBColorFormat(colorFormat) ? tables.m_srgbTable : tables.m_unormTable;
+}
+
+uint32_t Intel::GetColorPixelSize(Intel::VALAR_CPU_FORMAT colorFormat)
+{
+    switch (colorFormat)
+    {
+    case VALAR_CPU_FORMAT_R32G32B32A32_FLOAT:
+        return 4 * sizeof(float);
+    case VALAR_CPU_FORMAT_R16G16B16A16_FLOAT:
+        return 4 * sizeof(uint16_t);
+    case VALAR_CPU_FORMAT_R8G8B8A8_UNORM:
+    case VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case VALAR_CPU_FORMAT_B8G8R8A8_UNORM:
+    case VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case VALAR_CPU_FORMAT_R10G10B10A2_UNORM:
+    case VALAR_CPU_FORMAT_R11G11B10_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+uint32_t Intel::GetValarRowPitch(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    if (desc.m_valarRowPitch != 0) {
+        return desc.m_valarRowPitch;
+    }
+
+    return (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+}
+
+// Without an explicit view the legacy buffer pointers are tightly packed images of the descriptor size.
+static Intel::VALAR_CPU_IMAGE_VIEW MakeImageView(const Intel::VALAR_CPU_IMAGE_VIEW& view, const void* data, uint32_t width, uint32_t height,
+    Intel::VALAR_CPU_FORMAT format, uint32_t pixelSize)
+{
+    Intel::VALAR_CPU_IMAGE_VIEW resolvedView = view;
+
+    if (view.m_data == nullptr) {
+        resolvedView.m_data = data;
+        resolvedView.m_width = width;
+        resolvedView.m_height = height;
+        resolvedView.m_format = format;
+        resolvedView.m_rowPitch = 0;
+    }
+
+    if (resolvedView.m_rowPitch == 0) {
+        resolvedView.m_rowPitch = resolvedView.m_width * pixelSize;
+    }
+
+    return resolvedView;
+}
+
+Intel::VALAR_CPU_FORMAT Intel::GetColorFormat(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    return (desc.m_colorView.m_data != nullptr) ? desc.m_colorView.m_format : desc.m_colorFormat;
+}
+
+// Picked once per call, so the tile kernels never branch on the mode flags of the descriptor.
+uint32_t Intel::GetTileKernelMode(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    uint32_t mode = desc.m_weberFechnerMode ? VALAR_CPU_KERNEL_MODE_WEBER_FECHNER : 0;
+
+    if (desc.m_useMotionVectors) {
+        mode |= VALAR_CPU_KERNEL_MODE_MOTION_VECTORS;
+        mode |= desc.m_useUpscaleMotionVectors ? VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS : 0;
+    }
+
+    return mode;
+}
+
+bool Intel::IsValidTileSize(uint32_t tileSize)
+{
+    return tileSize == INTEL_TILE_SIZE || tileSize == OTHER_TILE_SIZE || tileSize == LARGE_TILE_SIZE;
+}
+
+bool Intel::IsValidAmortizationPeriod(uint32_t amortizationPeriod)
+{
+    return amortizationPeriod == 1 || amortizationPeriod == 2 || amortizationPeriod == 4 || amortizationPeriod == 8 || amortizationPeriod == 16;
+}
+
+bool Intel::IsValidShadingRate(uint32_t shadingRate)
+{
+    return shadingRate == VALAR_SHADING_RATE_1X1 || shadingRate == VALAR_SHADING_RATE_1X2 || shadingRate == VALAR_SHADING_RATE_2X1 ||
+        shadingRate == VALAR_SHADING_RATE_2X2 || shadingRate == VALAR_SHADING_RATE_2X4 || shadingRate == VALAR_SHADING_RATE_4X2 ||
+        shadingRate == VALAR_SHADING_RATE_4X4;
+}
+
+Intel::VALAR_CPU_IMAGE_VIEW Intel::GetColorView(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    return MakeImageView(desc.m_colorView, desc.m_colorBuffer, desc.m_bufferWidth, desc.m_bufferHeight, desc.m_colorFormat, GetColorPixelSize(GetColorFormat(desc)));
+}
+
+Intel::VALAR_CPU_IMAGE_VIEW Intel::GetVelocityView(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    return MakeImageView(desc.m_velocityView, desc.m_velocityBuffer, desc.m_bufferWidth, desc.m_bufferHeight, VALAR_CPU_FORMAT_R32_UINT, sizeof(uint32_t));
+}
+
+Intel::VALAR_CPU_IMAGE_VIEW Intel::GetUpscaledVelocityView(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    return MakeImageView(desc.m_upscaledVelocityView, desc.m_upscaledVelocityBuffer, desc.m_upscaleWidth, desc.m_upscaleHeight,
+        VALAR_CPU_FORMAT_R32G32_FLOAT, 2 * sizeof(float));
+}
+
+float Intel::FetchLuminance(const Intel::VALAR_CPU_DESCRIPTOR& desc, int32_t x, int32_t y)
+{
+    return FetchLuminance(GetColorView(desc), x, y);
+}
+
+float Intel::FetchLuminance(const Intel::VALAR_CPU_IMAGE_VIEW& colorView, int32_t x, int32_t y)
+{
+    // Out of bounds UAV loads return zero on the GPU, the CPU path has to do the same.
+    if (x < 0 || y < 0 || (uint32_t)x >= colorView.m_width || (uint32_t)y >= colorView.m_height) {
+        return 0.0f;
+    }
+
+    const uint8_t* pixel = GetImageRow(colorView, (uint32_t)y) + (size_t)x * GetColorPixelSize(colorView.m_format);
+    const float* linear = GetUNORM8Table(colorView.m_format).m_linear;
+
+    switch (colorView.m_format)
+    {
+    case VALAR_CPU_FORMAT_R8G8B8A8_UNORM:
+    case VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB:
+        return RGBToLuminance(linear[pixel[0]], linear[pixel[1]], linear[pixel[2]]);
+    case VALAR_CPU_FORMAT_B8G8R8A8_UNORM:
+    case VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB:
+        return RGBToLuminance(linear[pixel[2]], linear[pixel[1]], linear[pixel[0]]);
+    case VALAR_CPU_FORMAT_R10G10B10A2_UNORM:
+        return LuminanceR10G10B10A2UNORM(*(const uint32_t*)pixel);
+    case VALAR_CPU_FORMAT_R11G11B10_FLOAT:
+        return LuminanceR11G11B10Float(*(const uint32_t*)pixel);
+    case VALAR_CPU_FORMAT_R16G16B16A16_FLOAT:
+        return LuminanceR16G16B16A16Float((const uint16_t*)pixel);
+    default:
+        return LuminanceR32G32B32A32Float((const float*)pixel);
+    }
+}
+
+float Intel::FetchUpscaledVelocity(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_IMAGE_VIEW& velocityView, uint32_t x, uint32_t y)
+{
+    const float upscaleRatioX = (float)desc.m_upscaleWidth / (float)desc.m_bufferWidth;
+    const float upscaleRatioY = (float)desc.m_upscaleHeight / (float)desc.m_bufferHeight;
+
+    const uint32_t ux = (uint32_t)((float)x * upscaleRatioX);
+    const uint32_t uy = (uint32_t)((float)y * upscaleRatioY);
+
+    if (ux >= desc.m_upscaleWidth || uy >= desc.m_upscaleHeight) {
+        return 0.0f;
+    }
+
+    const float* velocity = (const float*)GetImageRow(velocityView, uy) + (size_t)ux * 2;
+
+    return sqrtf(velocity[0] * velocity[0] + velocity[1] * velocity[1]);
+}
+
+float Intel::FetchVelocity(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t x, uint32_t y)
+{
+    if (desc.m_useUpscaleMotionVectors) {
+        return FetchUpscaledVelocity(desc, GetUpscaledVelocityView(desc), x, y);
+    }
+
+    if (x >= desc.m_bufferWidth || y >= desc.m_bufferHeight) {
+        return 0.0f;
+    }
+
+    const VALAR_CPU_IMAGE_VIEW velocityView = GetVelocityView(desc);
+
+    return PackedVelocityLength(((const uint32_t*)GetImageRow(velocityView, y))[x]);
+}
+
+// Motion vector of a pixel in native pixels, pointing to the position of the pixel in the previous frame.
+void Intel::FetchVelocityVector(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t x, uint32_t y, float& velocityX, float& velocityY)
+{
+    velocityX = 0.0f;
+    velocityY = 0.0f;
+
+    if (!desc.m_useMotionVectors) {
+        return;
+    }
+
+    if (desc.m_useUpscaleMotionVectors) {
+        const VALAR_CPU_IMAGE_VIEW velocityView = GetUpscaledVelocityView(desc);
+        const float upscaleRatioX = (float)desc.m_upscaleWidth / (float)desc.m_bufferWidth;
+        const float upscaleRatioY = (float)desc.m_upscaleHeight / (float)desc.m_bufferHeight;
+
+        const uint32_t ux = (uint32_t)((float)x * upscaleRatioX);
+        const uint32_t uy = (uint32_t)((float)y * upscaleRatioY);
+
+        if (ux < desc.m_upscaleWidth && uy < desc.m_upscaleHeight) {
+            const float* velocity = (const float*)GetImageRow(velocityView, uy) + (size_t)ux * 2;
+
+            // Upscaled motion vectors are in upscaled pixels.
+            velocityX = velocity[0] / upscaleRatioX;
+            velocityY = velocity[1] / upscaleRatioY;
+        }
+
+        return;
+    }
+
+    const VALAR_CPU_IMAGE_VIEW velocityView = GetVelocityView(desc);
+    const uint32_t velocity = ((const uint32_t*)GetImageRow(velocityView, y))[x];
+
+    velocityX = UnpackXY(velocity & 0x3FF);
+    velocityY = UnpackXY((velocity >> 10) & 0x3FF);
+}
+
+// Update order of a 4x4 block of tile groups. Any 16 / N consecutive entries spread evenly over the block, so every
+// frame of a period of N updates a checkerboard (N = 2) or a regular lattice of the groups.
+static constexpr uint32_t kBayerMatrix4x4[4][4] =
+{
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+bool Intel::IsAmortizedTileDue(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileX, uint32_t tileY)
+{
+    const uint32_t period = desc.m_amortizationPeriod;
+    if (period <= 1) {
+        return true;
+    }
+
+    // A group spans VALAR_AMORTIZATION_GROUP_WIDTH pixels of a tile row, so the due tiles form runs wide enough
+    // for the vectors of the tile kernels.
+    const uint32_t groupX = tileX * desc.m_shadingRateTileSize / VALAR_AMORTIZATION_GROUP_WIDTH;
+    const uint32_t phase = kBayerMatrix4x4[tileY % 4][groupX % 4] * period / 16;
+    if (phase == desc.m_frameIndex % period) {
+        return true;
+    }
+
+    if (!desc.m_useMotionVectors) {
+        return false;
+    }
+
+    // Fast tiles update every frame. The velocity is sampled at the centers of the tile quadrants, the same
+    // pixels as ValarCS.hlsli, so the CPU and GPU masks pick the same tiles.
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t x0 = tileX * tileSize + tileSize / 4;
+    const uint32_t y0 = tileY * tileSize + tileSize / 4;
+    const uint32_t x1 = x0 + tileSize / 2;
+    const uint32_t y1 = y0 + tileSize / 2;
+
+    const float velocityMax = fmaxf(fmaxf(FetchVelocity(desc, x0, y0), FetchVelocity(desc, x1, y0)),
+        fmaxf(FetchVelocity(desc, x0, y1), FetchVelocity(desc, x1, y1)));
+
+    return velocityMax > desc.m_amortizationVelocityBound;
+}
+
+float Intel::ComputeMinNeighborLuminance(const float neighborhood[][VALAR_CPU_MAX_TILE_SIZE], uint32_t tileSize, int32_t x, int32_t y)
+{
+    // Same neighbor set as ComputeMinNeighborLuminance in ValarCS.hlsli, where W aliases S.
+    // Neighbors outside of the tile are undefined groupshared reads on the GPU and are skipped here.
+    const int32_t offsets[8][2] = {
+        {  0, -1 }, {  1, -1 }, {  1,  0 }, {  1,  1 },
+        {  0,  1 }, { -1,  1 }, {  0,  1 }, { -1, -1 }
+    };
+
+    float minLuma = 10000.0f;
+
+    for (uint32_t i = 0; i < 8; i++) {
+        const int32_t nx = x + offsets[i][0];
+        const int32_t ny = y + offsets[i][1];
+
+        if (nx >= 0 && ny >= 0 && nx < (int32_t)tileSize && ny < (int32_t)tileSize) {
+            minLuma = fminf(minLuma, neighborhood[nx][ny]);
+        }
+    }
+
+    return minLuma;
+}
+
+// Sum of the size x size block at (x, y) of values indexed [x][y], in the order every CPU path reduces its tile sums:
+// (top left + bottom left) + (top right + bottom right) of the four quarters of a block, down to single values.
+// The order does not depend on the vector width or the thread count, and the sum of a tile is the same reduction of
+// the sums of its four quarter tiles.
+float Intel::SumTilePairwise(const float values[][VALAR_CPU_MAX_TILE_SIZE], uint32_t x, uint32_t y, uint32_t size)
+{
+    if (size == 1) {
+        return values[x][y];
+    }
+
+    const uint32_t half = size / 2;
+
+    return (SumTilePairwise(values, x, y, half) + SumTilePairwise(values, x, y + half, half)) +
+        (SumTilePairwise(values, x + half, y, half) + SumTilePairwise(values, x + half, y + half, half));
+}
+
+// Straight per tile port of ValarCS.hlsli, with the tile sums of SumTilePairwise. The mask is computed by the fused
+// span kernels, this is the reference they are validated against.
+void Intel::ComputeTileStatistics(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileX, uint32_t tileY, Intel::VALAR_TILE_STATISTICS& stats)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const int32_t baseX = (int32_t)(tileX * tileSize);
+    const int32_t baseY = (int32_t)(tileY * tileSize);
+
+    float neighborhood[VALAR_CPU_MAX_TILE_SIZE][VALAR_CPU_MAX_TILE_SIZE];
+    float lumaX[VALAR_CPU_MAX_TILE_SIZE][VALAR_CPU_MAX_TILE_SIZE];
+    float lumaY[VALAR_CPU_MAX_TILE_SIZE][VALAR_CPU_MAX_TILE_SIZE];
+
+    for (uint32_t y = 0; y < tileSize; y++) {
+        for (uint32_t x = 0; x < tileSize; x++) {
+            neighborhood[x][y] = FetchLuminance(desc, baseX + (int32_t)x, baseY + (int32_t)y);
+        }
+    }
+
+    stats.m_velocityMin = 10000.0f;
+
+    for (uint32_t y = 0; y < tileSize; y++) {
+        for (uint32_t x = 0; x < tileSize; x++) {
+            const int32_t px = baseX + (int32_t)x;
+            const int32_t py = baseY + (int32_t)y;
+
+            const float pixelLuma = neighborhood[x][y];
+            const float pixelLumaXMinusOne = (x > 0) ? neighborhood[x - 1][y] : FetchLuminance(desc, px - 1, py);
+            const float pixelLumaYMinusOne = (y > 0) ? neighborhood[x][y - 1] : FetchLuminance(desc, px, py - 1);
+
+            if (desc.m_weberFechnerMode) {
+                // Use Weber Fechner to create brightness sensitivity divisor.
+                const float minNeighborLuma = ComputeMinNeighborLuminance(neighborhood, tileSize, (int32_t)x, (int32_t)y);
+                const float brightnessSensitivity = desc.m_weberFechnerConstant * (1.0f - Saturate(minNeighborLuma * 50.0f - 2.5f));
+
+                lumaX[x][y] = fabsf(pixelLuma - pixelLumaXMinusOne) / (fminf(pixelLuma, pixelLumaXMinusOne) + brightnessSensitivity);
+                lumaY[x][y] = fabsf(pixelLuma - pixelLumaYMinusOne) / (fminf(pixelLuma, pixelLumaYMinusOne) + brightnessSensitivity);
+            } else {
+                // Satifying Equation 2. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
+                lumaX[x][y] = fabsf(pixelLuma - pixelLumaXMinusOne) * 0.5f;
+                lumaY[x][y] = fabsf(pixelLuma - pixelLumaYMinusOne) * 0.5f;
+            }
+
+            if (desc.m_useMotionVectors) {
+                stats.m_velocityMin = fminf(stats.m_velocityMin, FetchVelocity(desc, (uint32_t)px, (uint32_t)py));
+            }
+        }
+    }
+
+    stats.m_lumaSum = SumTilePairwise(neighborhood, 0, 0, tileSize);
+    stats.m_lumaSumX = SumTilePairwise(lumaX, 0, 0, tileSize);
+    stats.m_lumaSumY = SumTilePairwise(lumaY, 0, 0, tileSize);
+}
+
+// Relative slack for the rounding of the float tile sums and of the float rate decision, both only a few ulps.
+#define VALAR_CPU_UNORM8_SUM_SLACK 1e-5
+#define VALAR_CPU_UNORM8_COMPARE_SLACK 1e-5
+// Largest relative error of the fixed-point luminance weights, green with 40084 / 56049 for 0.715160.
+#define VALAR_CPU_UNORM8_WEIGHT_ERROR 2.7e-7
+
+static void ComputeVelocityError(const Intel::VALAR_CPU_DESCRIPTOR& desc, float velocityMin, float& velocityHError, float& velocityQError)
+{
+    velocityHError = Intel::ComputeVelocityHError(velocityMin, desc.m_useMotionVectors);
+    velocityQError = Intel::ComputeVelocityQError(velocityMin, desc.m_quarterRateShadingModifier, desc.m_useMotionVectors);
+}
+
+// Resolves (velocityError * avgError >= jndThreshold) for avgError and jndThreshold known to lie in the given
+// ranges. Returns false when the ranges overlap and the float path has to decide.
+static bool CompareErrorInterval(float velocityError, double avgErrorMin, double avgErrorMax, double jndThresholdMin, double jndThresholdMax, bool& result)
+{
+    const double productA = velocityError * avgErrorMin;
+    const double productB = velocityError * avgErrorMax;
+    const double productMin = (productA < productB) ? productA : productB;
+    const double productMax = (productA < productB) ? productB : productA;
+    const double slack = VALAR_CPU_UNORM8_COMPARE_SLACK * (fabs(productA) + fabs(productB) + fabs(jndThresholdMin) + fabs(jndThresholdMax));
+
+    if (productMin - slack >= jndThresholdMax) {
+        result = true;
+        return true;
+    }
+
+    if (productMax + slack < jndThresholdMin) {
+        result = false;
+        return true;
+    }
+
+    return false;
+}
+
+static uint8_t ResolveTileShadingRate(const Intel::VALAR_CPU_DESCRIPTOR& desc, bool fullRateCmpX, bool quarterRateCmpX, bool fullRateCmpY, bool quarterRateCmpY)
+{
+    const uint32_t xClass = Intel::GetShadingRateAxisClass(fullRateCmpX, quarterRateCmpX);
+    const uint32_t yClass = Intel::GetShadingRateAxisClass(fullRateCmpY, quarterRateCmpY);
+
+    return (uint8_t)Intel::LookupShadingRate(xClass, yClass, desc.m_allowQuarterRateShading);
+}
+
+uint8_t Intel::ComputeTileShadingRate(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_TILE_STATISTICS& stats)
+{
+    const float numPixels = (float)(desc.m_shadingRateTileSize * desc.m_shadingRateTileSize);
+
+    // Compute Average Luminance of Current Tile
+    const float avgTileLuma = stats.m_lumaSum / numPixels;
+    const float avgTileLumaX = stats.m_lumaSumX / numPixels;
+    const float avgTileLumaY = stats.m_lumaSumY / numPixels;
+
+    const float jndThreshold = Intel::ComputeJNDThreshold(desc.m_sensitivityThreshold, avgTileLuma, desc.m_environmentLuminance);
+
+    // Compute the MSE error for Luma X/Y derivatives
+    const float avgErrorX = sqrtf(avgTileLumaX);
+    const float avgErrorY = sqrtf(avgTileLumaY);
+
+    float velocityHError;
+    float velocityQError;
+    ComputeVelocityError(desc, stats.m_velocityMin, velocityHError, velocityQError);
+
+    const uint32_t xClass = Intel::ClassifyShadingRateAxis(avgErrorX, velocityHError, velocityQError, jndThreshold);
+    const uint32_t yClass = Intel::ClassifyShadingRateAxis(avgErrorY, velocityHError, velocityQError, jndThreshold);
+
+    return (uint8_t)Intel::LookupShadingRate(xClass, yClass, desc.m_allowQuarterRateShading);
+}
+
+bool Intel::ComputeTileShadingRateUNORM8(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_TILE_STATISTICS_UNORM8& stats, uint8_t& shadingRate)
+{
+    // Relative luminance error of the fixed-point weights, plus a few float ulps for the float path itself.
+    const double pixelRelativeError = VALAR_CPU_UNORM8_WEIGHT_ERROR + 1e-6;
+
+    // Absolute error of the truncating shift and, for sRGB, of the rounded decode table.
+    const double lumaUnit = (double)(1u << VALAR_CPU_UNORM8_LUMA_SHIFT) / ((double)VALAR_CPU_UNORM8_LINEAR_SCALE * VALAR_CPU_UNORM8_WEIGHT_SCALE);
+    const double pixelAbsoluteError = lumaUnit +
+        (IsSRGBColorFormat(GetColorFormat(desc)) ? 0.5 / VALAR_CPU_UNORM8_LINEAR_SCALE : 0.0);
+
+    const double numPixels = (double)(desc.m_shadingRateTileSize * desc.m_shadingRateTileSize);
+    const double pixelWeight = 1.0 / numPixels;
+    const double lumaSum = (double)stats.m_lumaSum * lumaUnit;
+    const double lumaDifferenceX = (double)stats.m_lumaDifferenceX * lumaUnit;
+    const double lumaDifferenceY = (double)stats.m_lumaDifferenceY * lumaUnit;
+
+    // Every pixel differs by at most pixelRelativeError * luma + pixelAbsoluteError from the float path, an absolute
+    // difference by the error of both of its pixels. The bounds are doubled to cover the error of the bound itself and
+    // widened by VALAR_CPU_UNORM8_SUM_SLACK for the rounding of the float sums.
+    const double lumaSumError = 2.0 * (pixelRelativeError * lumaSum + numPixels * pixelAbsoluteError) + VALAR_CPU_UNORM8_SUM_SLACK * lumaSum;
+    const double lumaSumXError = 0.5 * (2.0 * (pixelRelativeError * (2.0 * lumaSum + lumaDifferenceX) + 2.0 * numPixels * pixelAbsoluteError) +
+        VALAR_CPU_UNORM8_SUM_SLACK * lumaDifferenceX);
+    const double lumaSumYError = 0.5 * (2.0 * (pixelRelativeError * (2.0 * lumaSum + lumaDifferenceY) + 2.0 * numPixels * pixelAbsoluteError) +
+        VALAR_CPU_UNORM8_SUM_SLACK * lumaDifferenceY);
+
+    const double threshold = desc.m_sensitivityThreshold;
+    const double jndThresholdA = threshold * ((lumaSum - lumaSumError) * pixelWeight + desc.m_environmentLuminance);
+    const double jndThresholdB = threshold * ((lumaSum + lumaSumError) * pixelWeight + desc.m_environmentLuminance);
+    const double jndThresholdMin = (threshold < 0.0) ? jndThresholdB : jndThresholdA;
+    const double jndThresholdMax = (threshold < 0.0) ? jndThresholdA : jndThresholdB;
+
+    const double lumaSumXMin = 0.5 * lumaDifferenceX - lumaSumXError;
+    const double lumaSumYMin = 0.5 * lumaDifferenceY - lumaSumYError;
+
+    const double avgErrorXMin = (lumaSumXMin > 0.0) ? sqrt(lumaSumXMin * pixelWeight) : 0.0;
+    const double avgErrorXMax = sqrt((0.5 * lumaDifferenceX + lumaSumXError) * pixelWeight);
+    const double avgErrorYMin = (lumaSumYMin > 0.0) ? sqrt(lumaSumYMin * pixelWeight) : 0.0;
+    const double avgErrorYMax = sqrt((0.5 * lumaDifferenceY + lumaSumYError) * pixelWeight);
+
+    // The velocity is computed exactly as in the float path.
+    float velocityHError;
+    float velocityQError;
+    ComputeVelocityError(desc, stats.m_velocityMin, velocityHError, velocityQError);
+
+    // CompareErrorInterval tests error >= threshold, which rejects the quarter rate of Equation 14.
+    bool fullRateCmpX, fullRateCmpY, quarterRateRejectX, quarterRateRejectY;
+
+    if (!CompareErrorInterval(velocityHError, avgErrorXMin, avgErrorXMax, jndThresholdMin, jndThresholdMax, fullRateCmpX) ||
+        !CompareErrorInterval(velocityQError, avgErrorXMin, avgErrorXMax, jndThresholdMin, jndThresholdMax, quarterRateRejectX) ||
+        !CompareErrorInterval(velocityHError, avgErrorYMin, avgErrorYMax, jndThresholdMin, jndThresholdMax, fullRateCmpY) ||
+        !CompareErrorInterval(velocityQError, avgErrorYMin, avgErrorYMax, jndThresholdMin, jndThresholdMax, quarterRateRejectY)) {
+        return false;
+    }
+
+    shadingRate = ResolveTileShadingRate(desc, fullRateCmpX, !quarterRateRejectX, fullRateCmpY, !quarterRateRejectY);
+
+    return true;
+}
+
+static void ComputeTileRun(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, uint8_t* valarRow, uint32_t* shadingRateTileCount)
+{
+    const uint32_t tilesPerSpan = VALAR_CPU_SPAN_WIDTH / desc.m_shadingRateTileSize;
+    const Intel::VALAR_CPU_FORMAT colorFormat = Intel::GetColorFormat(desc);
+    const uint32_t mode = Intel::GetTileKernelMode(desc);
+    const uint32_t tileSizeIndex = Intel::GetTileSizeIndex(desc.m_shadingRateTileSize);
+    const Intel::VALAR_CPU_TILE_KERNEL tileKernel = desc.m_pOpaque->m_tileKernels.m_floatKernels[tileSizeIndex][colorFormat][mode];
+    const Intel::VALAR_CPU_TILE_KERNEL_UNORM8 tileKernelUNORM8 = desc.m_pOpaque->m_tileKernels.m_unorm8Kernels[tileSizeIndex][colorFormat][mode];
+
+    Intel::VALAR_TILE_STATISTICS stats[VALAR_CPU_SPAN_WIDTH / INTEL_TILE_SIZE];
+
+    // 8-bit color without Weber-Fechner mode runs in fixed-point. Tiles too close to a rate threshold for the
+    // fixed-point error bound are recomputed with the float kernel, so both paths produce the same mask.
+    if (tileKernelUNORM8 != nullptr) {
+        Intel::VALAR_TILE_STATISTICS_UNORM8 statsUNORM8[VALAR_CPU_SPAN_WIDTH / INTEL_TILE_SIZE];
+
+        for (uint32_t spanBegin = tileXBegin; spanBegin < tileXEnd; spanBegin += tilesPerSpan) {
+            const uint32_t spanEnd = (spanBegin + tilesPerSpan < tileXEnd) ? spanBegin + tilesPerSpan : tileXEnd;
+
+            tileKernelUNORM8(desc, tileY, spanBegin, spanEnd, statsUNORM8);
+
+            for (uint32_t tileX = spanBegin; tileX < spanEnd; tileX++) {
+                uint8_t shadingRate;
+
+                if (!Intel::ComputeTileShadingRateUNORM8(desc, statsUNORM8[tileX - spanBegin], shadingRate)) {
+                    tileKernel(desc, tileY, tileX, tileX + 1, stats);
+                    shadingRate = Intel::ComputeTileShadingRate(desc, stats[0]);
+                }
+
+                valarRow[tileX] = shadingRate;
+                shadingRateTileCount[shadingRate]++;
+            }
+        }
+
+        return;
+    }
+
+    // The fused kernels sweep the rows of up to VALAR_CPU_SPAN_WIDTH pixels at once, partial tiles on the
+    // right and bottom edges included.
+    for (uint32_t spanBegin = tileXBegin; spanBegin < tileXEnd; spanBegin += tilesPerSpan) {
+        const uint32_t spanEnd = (spanBegin + tilesPerSpan < tileXEnd) ? spanBegin + tilesPerSpan : tileXEnd;
+
+        tileKernel(desc, tileY, spanBegin, spanEnd, stats);
+
+        for (uint32_t tileX = spanBegin; tileX < spanEnd; tileX++) {
+            const uint8_t shadingRate = Intel::ComputeTileShadingRate(desc, stats[tileX - spanBegin]);
+
+            valarRow[tileX] = shadingRate;
+            shadingRateTileCount[shadingRate]++;
+        }
+    }
+}
+
+void Intel::ComputeTileSpan(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, uint8_t* valarRow, uint32_t* shadingRateTileCount)
+{
+    if (desc.m_amortizationPeriod <= 1) {
+        ComputeTileRun(desc, tileY, tileXBegin, tileXEnd, valarRow, shadingRateTileCount);
+        return;
+    }
+
+    if (tileXBegin >= tileXEnd) {
+        return;
+    }
+
+    // Runs of due tiles go through the tile kernels, the other tiles keep the rate of the previous mask. Every tile
+    // is tested once, the test of the tile ending a run is carried over to the next one.
+    uint32_t tileX = tileXBegin;
+    bool due = IsAmortizedTileDue(desc, tileX, tileY);
+
+    while (tileX < tileXEnd) {
+        const uint32_t runBegin = tileX;
+        const bool runDue = due;
+
+        for (tileX++; tileX < tileXEnd; tileX++) {
+            due = IsAmortizedTileDue(desc, tileX, tileY);
+            if (due != runDue) {
+                break;
+            }
+        }
+
+        if (runDue) {
+            ComputeTileRun(desc, tileY, runBegin, tileX, valarRow, shadingRateTileCount);
+        } else {
+            for (uint32_t x = runBegin; x < tileX; x++) {
+                CountPreviousShadingRate(valarRow[x], shadingRateTileCount);
+            }
+        }
+    }
+}
+
+void Intel::CountPreviousShadingRate(uint8_t shadingRate, uint32_t* shadingRateTileCount)
+{
+    // The previous mask is application memory, values outside of the rate range are not counted.
+    if (shadingRate < VALAR_CPU_SHADING_RATE_COUNT) {
+        shadingRateTileCount[shadingRate]++;
+    }
+}
+
+void Intel::AccumulateShadingRateTileCount(const Intel::VALAR_CPU_DESCRIPTOR& desc, const uint32_t* shadingRateTileCount)
+{
+    for (uint32_t i = 0; i < VALAR_CPU_SHADING_RATE_COUNT; i++) {
+        if (shadingRateTileCount[i] != 0) {
+            desc.m_pOpaque->m_shadingRateTileCount[i].fetch_add(shadingRateTileCount[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+// Finds the first span of tile row tileY at or after tileX covered by the union of the regions of interest.
+// Regions are few, the union is found by repeated scans instead of sorting.
+bool Intel::FindRegionOfInterestSpan(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileX, uint32_t& spanBegin, uint32_t& spanEnd)
+{
+    spanBegin = UINT32_MAX;
+
+    for (uint32_t i = 0; i < desc.m_regionOfInterestCount; i++) {
+        const Intel::VALAR_CPU_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+        if (tileY >= tileRect.m_top && tileY < tileRect.m_bottom && tileRect.m_right > tileX && tileRect.m_left < tileRect.m_right) {
+            const uint32_t left = (tileRect.m_left > tileX) ? tileRect.m_left : tileX;
+            spanBegin = (left < spanBegin) ? left : spanBegin;
+        }
+    }
+
+    if (spanBegin == UINT32_MAX) {
+        return false;
+    }
+
+    spanEnd = spanBegin;
+
+    for (bool grown = true; grown;) {
+        grown = false;
+
+        for (uint32_t i = 0; i < desc.m_regionOfInterestCount; i++) {
+            const Intel::VALAR_CPU_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+            if (tileY >= tileRect.m_top && tileY < tileRect.m_bottom && tileRect.m_left <= spanEnd && tileRect.m_right > spanEnd) {
+                spanEnd = tileRect.m_right;
+                grown = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Computes the tiles [tileXBegin, tileXEnd) of tile row tileY. With regions of interest only the spans inside of
+// them go through the tile kernels.
+static void ComputeRegionOfInterestTiles(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, uint8_t* valarRow, uint32_t* shadingRateTileCount)
+{
+    if (desc.m_regionOfInterestCount == 0) {
+        Intel::ComputeTileSpan(desc, tileY, tileXBegin, tileXEnd, valarRow, shadingRateTileCount);
+        return;
+    }
+
+    uint32_t tileX = tileXBegin;
+
+    while (tileX < tileXEnd) {
+        uint32_t spanBegin;
+        uint32_t spanEnd;
+
+        if (!Intel::FindRegionOfInterestSpan(desc, tileY, tileX, spanBegin, spanEnd)) {
+            spanBegin = tileXEnd;
+            spanEnd = tileXEnd;
+        }
+
+        spanBegin = (spanBegin < tileXEnd) ? spanBegin : tileXEnd;
+        spanEnd = (spanEnd < tileXEnd) ? spanEnd : tileXEnd;
+
+        // Tiles outside of the regions of interest are filled without reading the color buffer.
+        memset(valarRow + tileX, desc.m_outsideShadingRate, spanBegin - tileX);
+        shadingRateTileCount[desc.m_outsideShadingRate] += spanBegin - tileX;
+
+        if (spanBegin < spanEnd) {
+            Intel::ComputeTileSpan(desc, tileY, spanBegin, spanEnd, valarRow, shadingRateTileCount);
+        }
+
+        tileX = spanEnd;
+    }
+}
+
+static void ComputeTileRowJob(void* context, uint32_t tileY)
+{
+    const Intel::VALAR_CPU_DESCRIPTOR& desc = *(const Intel::VALAR_CPU_DESCRIPTOR*)context;
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    uint8_t* valarRow = desc.m_valarBuffer + (size_t)tileY * Intel::GetValarRowPitch(desc);
+
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+
+    ComputeRegionOfInterestTiles(desc, tileY, 0, tilesX, valarRow, shadingRateTileCount);
+    Intel::AccumulateShadingRateTileCount(desc, shadingRateTileCount);
+}
+
+void Intel::ComputeMask(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    // The async queue computes masks of the same opaque, one mask at a time owns the history and the tile counts.
+    std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+
+    // Without memory for the history the temporal mode computes every tile.
+    if (desc.m_temporalReuse && ComputeMaskTemporal(desc)) {
+        return;
+    }
+
+    // The statistics of a later temporal mask would be older than one frame.
+    desc.m_pOpaque->m_temporalHistory->m_isValid = false;
+
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    // Tile rows are independent, same as the thread groups of the VALAR_ComputeMask dispatch.
+    DispatchThreadPool(desc.m_pOpaque->m_threadPool, tilesY, ComputeTileRowJob, (void*)&desc);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(desc);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    if (desc.m_enabled) {
+        ComputeMask(desc);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskLPCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(desc);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    if (desc.m_LPSampleCount != 4 && desc.m_LPSampleCount != 8 && desc.m_LPSampleCount != 16) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_enabled) {
+        std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+
+        // Like ComputeMask, the statistics of a later temporal mask would be older than one frame.
+        desc.m_pOpaque->m_temporalHistory->m_isValid = false;
+
+        ComputeMaskLP(desc);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeTilesCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_TILE_RECT& tileRect)
+{
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(desc);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesX = (desc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    if (tileRect.m_left > tileRect.m_right || tileRect.m_top > tileRect.m_bottom ||
+        tileRect.m_right > tilesX || tileRect.m_bottom > tilesY) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    // The history is reprojected from whole masks, a rect at a time cannot keep it current.
+    if (desc.m_temporalReuse) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_enabled) {
+        // Like ComputeMask, the statistics of a later temporal mask would be older than one frame. Concurrent rects
+        // only hold the lock for the store.
+        {
+            std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+            desc.m_pOpaque->m_temporalHistory->m_isValid = false;
+        }
+
+        // Runs on the calling thread only, callers schedule disjoint rects on their own job system.
+        uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+
+        for (uint32_t tileY = tileRect.m_top; tileY < tileRect.m_bottom; tileY++) {
+            uint8_t* valarRow = desc.m_valarBuffer + (size_t)tileY * GetValarRowPitch(desc);
+            ComputeRegionOfInterestTiles(desc, tileY, tileRect.m_left, tileRect.m_right, valarRow, shadingRateTileCount);
+        }
+
+        AccumulateShadingRateTileCount(desc, shadingRateTileCount);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+struct VALAR_CPU_BATCH_JOB
+{
+    const Intel::VALAR_CPU_DESCRIPTOR*      m_views;
+    uint32_t                                m_viewCount;
+};
+
+static void ComputeBatchRowJob(void* context, uint32_t index)
+{
+    const VALAR_CPU_BATCH_JOB& job = *(const VALAR_CPU_BATCH_JOB*)context;
+
+    // The jobs are the tile rows of the first view, then of the next one, disabled views have none.
+    for (uint32_t view = 0; view < job.m_viewCount; view++) {
+        const Intel::VALAR_CPU_DESCRIPTOR& desc = job.m_views[view];
+        const uint32_t tilesY = desc.m_enabled ? (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize : 0;
+
+        if (index < tilesY) {
+            ComputeTileRowJob((void*)&desc, index);
+            return;
+        }
+
+        index -= tilesY;
+    }
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskBatchCPU(const Intel::VALAR_CPU_DESCRIPTOR* views, uint32_t viewCount)
+{
+    if (views == nullptr || viewCount == 0) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    uint32_t jobCount = 0;
+
+    for (uint32_t view = 0; view < viewCount; view++) {
+        VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(views[view]);
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
+        }
+
+        // The views run on the thread pool and count their tiles in the counters of one opaque.
+        if (views[view].m_pOpaque != views[0].m_pOpaque) {
+            return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+        }
+
+        // The reprojected statistics are kept for one mask per opaque.
+        if (views[view].m_temporalReuse) {
+            return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+        }
+
+        if (views[view].m_enabled) {
+            jobCount += (views[view].m_bufferHeight + views[view].m_shadingRateTileSize - 1) / views[view].m_shadingRateTileSize;
+        }
+    }
+
+    std::lock_guard<std::mutex> maskLock(views[0].m_pOpaque->m_maskLock);
+
+    // Like ComputeMask, unless every view is disabled and the history still matches the last mask.
+    if (jobCount > 0) {
+        views[0].m_pOpaque->m_temporalHistory->m_isValid = false;
+    }
+
+    VALAR_CPU_BATCH_JOB job = { views, viewCount };
+
+    // One pass of the thread pool of the first view over the tile rows of all views, the short views do not leave
+    // workers idle at the end of each one.
+    DispatchThreadPool(views[0].m_pOpaque->m_threadPool, jobCount, ComputeBatchRowJob, &job);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+struct VALAR_CPU_DIRTY_RECT_JOB
+{
+    const Intel::VALAR_CPU_DESCRIPTOR*      m_desc;
+    const Intel::VALAR_CPU_RECT*            m_dirtyRects;
+    uint32_t                                m_dirtyRectCount;
+};
+
+// Tiles reading the pixels of a dirty rect. A pixel is also the x - 1 and y - 1 neighbor of the gradients of the
+// pixels to its right and below, so the rect grows by one pixel to the right and bottom before it is mapped to tiles.
+static Intel::VALAR_CPU_TILE_RECT GetDirtyTileRect(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_RECT& dirtyRect)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesX = (desc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    Intel::VALAR_CPU_TILE_RECT tileRect;
+
+    if (dirtyRect.m_left >= dirtyRect.m_right || dirtyRect.m_top >= dirtyRect.m_bottom) {
+        return tileRect;
+    }
+
+    const uint32_t right = dirtyRect.m_right / tileSize + 1;
+    const uint32_t bottom = dirtyRect.m_bottom / tileSize + 1;
+
+    // Rects reaching past the color buffer are clipped, like the dirty regions of a window larger than the buffer.
+    tileRect.m_left = dirtyRect.m_left / tileSize;
+    tileRect.m_top = dirtyRect.m_top / tileSize;
+    tileRect.m_right = (right < tilesX) ? right : tilesX;
+    tileRect.m_bottom = (bottom < tilesY) ? bottom : tilesY;
+
+    return tileRect;
+}
+
+static void ComputeDirtyRowJob(void* context, uint32_t tileY)
+{
+    const VALAR_CPU_DIRTY_RECT_JOB& job = *(const VALAR_CPU_DIRTY_RECT_JOB*)context;
+    const Intel::VALAR_CPU_DESCRIPTOR& desc = *job.m_desc;
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    uint8_t* valarRow = desc.m_valarBuffer + (size_t)tileY * Intel::GetValarRowPitch(desc);
+
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+    uint32_t tileX = 0;
+
+    // Dirty rects are few, their union along the row is found by repeated scans instead of sorting.
+    while (tileX < tilesX) {
+        uint32_t spanBegin = tilesX;
+
+        for (uint32_t i = 0; i < job.m_dirtyRectCount; i++) {
+            const Intel::VALAR_CPU_TILE_RECT tileRect = GetDirtyTileRect(desc, job.m_dirtyRects[i]);
+
+            if (tileY >= tileRect.m_top && tileY < tileRect.m_bottom && tileRect.m_right > tileX) {
+                const uint32_t left = (tileRect.m_left > tileX) ? tileRect.m_left : tileX;
+                spanBegin = (left < spanBegin) ? left : spanBegin;
+            }
+        }
+
+        // Tiles outside of the dirty rects keep their rate and are counted as they are.
+        for (; tileX < spanBegin; tileX++) {
+            Intel::CountPreviousShadingRate(valarRow[tileX], shadingRateTileCount);
+        }
+
+        if (spanBegin == tilesX) {
+            break;
+        }
+
+        uint32_t spanEnd = spanBegin;
+
+        for (bool grown = true; grown;) {
+            grown = false;
+
+            for (uint32_t i = 0; i < job.m_dirtyRectCount; i++) {
+                const Intel::VALAR_CPU_TILE_RECT tileRect = GetDirtyTileRect(desc, job.m_dirtyRects[i]);
+
+                if (tileY >= tileRect.m_top && tileY < tileRect.m_bottom && tileRect.m_left <= spanEnd && tileRect.m_right > spanEnd) {
+                    spanEnd = tileRect.m_right;
+                    grown = true;
+                }
+            }
+        }
+
+        ComputeRegionOfInterestTiles(desc, tileY, spanBegin, spanEnd, valarRow, shadingRateTileCount);
+        Intel::InvalidateTemporalTiles(desc, tileY, spanBegin, spanEnd);
+        tileX = spanEnd;
+    }
+
+    Intel::AccumulateShadingRateTileCount(desc, shadingRateTileCount);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeDirtyRectsCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_RECT* dirtyRects, uint32_t dirtyRectCount)
+{
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(desc);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    if (dirtyRectCount > 0 && dirtyRects == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    for (uint32_t i = 0; i < dirtyRectCount; i++) {
+        if (dirtyRects[i].m_left > dirtyRects[i].m_right || dirtyRects[i].m_top > dirtyRects[i].m_bottom) {
+            return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+        }
+    }
+
+    if (desc.m_enabled) {
+        // The caller marked the rects as changed, amortization does not defer any of their tiles.
+        VALAR_CPU_DESCRIPTOR dirtyDesc = desc;
+        dirtyDesc.m_amortizationPeriod = 1;
+
+        VALAR_CPU_DIRTY_RECT_JOB job;
+        job.m_desc = &dirtyDesc;
+        job.m_dirtyRects = dirtyRects;
+        job.m_dirtyRectCount = dirtyRectCount;
+
+        const uint32_t tilesY = (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+
+        std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+        DispatchThreadPool(desc.m_pOpaque->m_threadPool, tilesY, ComputeDirtyRowJob, &job);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_PredictMaskCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint8_t* predictedMask)
+{
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(desc);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    // The latest mask in m_valarBuffer is read while the prediction is written.
+    if (predictedMask == nullptr || predictedMask == desc.m_valarBuffer) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    PredictMask(desc, predictedMask);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+struct VALAR_CPU_ROW_BAND_JOB
+{
+    const Intel::VALAR_CPU_DESCRIPTOR*      m_desc;
+    uint32_t                                m_tileRow;
+    uint32_t                                m_tilesX;
+    uint8_t*                                m_valarRow;
+};
+
+#define VALAR_CPU_ROW_BAND_TILES_PER_JOB 16
+
+static void ComputeRowBandJob(void* context, uint32_t index)
+{
+    const VALAR_CPU_ROW_BAND_JOB& job = *(const VALAR_CPU_ROW_BAND_JOB*)context;
+    const uint32_t tileXBegin = index * VALAR_CPU_ROW_BAND_TILES_PER_JOB;
+    const uint32_t tileXEnd = (tileXBegin + VALAR_CPU_ROW_BAND_TILES_PER_JOB < job.m_tilesX) ? tileXBegin + VALAR_CPU_ROW_BAND_TILES_PER_JOB : job.m_tilesX;
+
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+
+    ComputeRegionOfInterestTiles(*job.m_desc, job.m_tileRow, tileXBegin, tileXEnd, job.m_valarRow, shadingRateTileCount);
+    Intel::AccumulateShadingRateTileCount(*job.m_desc, shadingRateTileCount);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeRowBandCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_ROW_BAND& band, uint8_t* valarRow)
+{
+    if (band.m_colorRows == nullptr || valarRow == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    // Upscaled velocity rows do not line up with the color rows of a band.
+    if (desc.m_useMotionVectors && desc.m_useUpscaleMotionVectors) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t firstRow = (band.m_tileRow > 0) ? band.m_tileRow * tileSize - 1 : 0;
+
+    // The views of the band start at its first row, so the tile kernels address it in frame coordinates like a full
+    // color buffer. Only the rows inside of the band are ever read.
+    VALAR_CPU_DESCRIPTOR bandDesc = desc;
+    bandDesc.m_colorView = GetColorView(desc);
+    bandDesc.m_colorView.m_data = band.m_colorRows;
+    bandDesc.m_velocityView = GetVelocityView(desc);
+    bandDesc.m_velocityView.m_data = band.m_velocityRows;
+    bandDesc.m_velocityBuffer = nullptr;
+    bandDesc.m_valarBuffer = valarRow;
+
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(bandDesc);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    bandDesc.m_colorView.m_firstRow = firstRow;
+    bandDesc.m_velocityView.m_firstRow = firstRow;
+
+    const uint32_t tilesX = (desc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    if (band.m_tileRow >= tilesY) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_enabled) {
+        // Like VALAR_ComputeTilesCPU, concurrent bands only hold the lock for the store.
+        {
+            std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+            desc.m_pOpaque->m_temporalHistory->m_isValid = false;
+        }
+
+        VALAR_CPU_ROW_BAND_JOB job;
+        job.m_desc = &bandDesc;
+        job.m_tileRow = band.m_tileRow;
+        job.m_tilesX = tilesX;
+        job.m_valarRow = valarRow;
+
+        const uint32_t jobCount = (tilesX + VALAR_CPU_ROW_BAND_TILES_PER_JOB - 1) / VALAR_CPU_ROW_BAND_TILES_PER_JOB;
+        DispatchThreadPool(desc.m_pOpaque->m_threadPool, jobCount, ComputeRowBandJob, &job);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+// 8x8 tiles per span of the pyramid kernels, a multiple of the 4x4 8x8 tiles of a 32x32 tile.
+#define VALAR_CPU_PYRAMID_SPAN_TILES (VALAR_CPU_SPAN_WIDTH / INTEL_TILE_SIZE)
+
+struct VALAR_CPU_PYRAMID_JOB
+{
+    // Copies of the descriptor with the tile size of each level, the rate decisions read the pixel count from it.
+    Intel::VALAR_CPU_DESCRIPTOR             m_levelDescs[VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT];
+    const Intel::VALAR_CPU_MASK_PYRAMID*    m_pyramid;
+    // Level counted in the VALAR_FinalizeMaskCPU statistics, VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT for none.
+    uint32_t                                m_statisticsLevel;
+};
+
+// Sums the statistics of four quarter tiles in the order of SumTilePairwise, so the 16x16 and 32x32 levels match
+// direct passes over the larger tiles bit for bit.
+static void CombineTileStatistics(Intel::VALAR_TILE_STATISTICS& dst, const Intel::VALAR_TILE_STATISTICS& topLeft, const Intel::VALAR_TILE_STATISTICS& topRight,
+    const Intel::VALAR_TILE_STATISTICS& bottomLeft, const Intel::VALAR_TILE_STATISTICS& bottomRight)
+{
+    dst.m_lumaSum = (topLeft.m_lumaSum + bottomLeft.m_lumaSum) + (topRight.m_lumaSum + bottomRight.m_lumaSum);
+    dst.m_lumaSumX = (topLeft.m_lumaSumX + bottomLeft.m_lumaSumX) + (topRight.m_lumaSumX + bottomRight.m_lumaSumX);
+    dst.m_lumaSumY = (topLeft.m_lumaSumY + bottomLeft.m_lumaSumY) + (topRight.m_lumaSumY + bottomRight.m_lumaSumY);
+    dst.m_velocityMin = fminf(fminf(topLeft.m_velocityMin, bottomLeft.m_velocityMin), fminf(topRight.m_velocityMin, bottomRight.m_velocityMin));
+}
+
+static void CombineTileStatistics(Intel::VALAR_TILE_STATISTICS_UNORM8& dst, const Intel::VALAR_TILE_STATISTICS_UNORM8& topLeft, const Intel::VALAR_TILE_STATISTICS_UNORM8& topRight,
+    const Intel::VALAR_TILE_STATISTICS_UNORM8& bottomLeft, const Intel::VALAR_TILE_STATISTICS_UNORM8& bottomRight)
+{
+    dst.m_lumaSum = topLeft.m_lumaSum + topRight.m_lumaSum + bottomLeft.m_lumaSum + bottomRight.m_lumaSum;
+    dst.m_lumaDifferenceX = topLeft.m_lumaDifferenceX + topRight.m_lumaDifferenceX + bottomLeft.m_lumaDifferenceX + bottomRight.m_lumaDifferenceX;
+    dst.m_lumaDifferenceY = topLeft.m_lumaDifferenceY + topRight.m_lumaDifferenceY + bottomLeft.m_lumaDifferenceY + bottomRight.m_lumaDifferenceY;
+    dst.m_velocityMin = fminf(fminf(topLeft.m_velocityMin, bottomLeft.m_velocityMin), fminf(topRight.m_velocityMin, bottomRight.m_velocityMin));
+}
+
+static uint8_t ComputePyramidShadingRate(const Intel::VALAR_CPU_DESCRIPTOR& levelDesc, uint32_t, uint32_t, const Intel::VALAR_TILE_STATISTICS& stats)
+{
+    return Intel::ComputeTileShadingRate(levelDesc, stats);
+}
+
+// Same fallback as ComputeTileSpan, a tile too close to a threshold is recomputed by the float kernel of its tile size.
+static uint8_t ComputePyramidShadingRate(const Intel::VALAR_CPU_DESCRIPTOR& levelDesc, uint32_t tileX, uint32_t tileY, const Intel::VALAR_TILE_STATISTICS_UNORM8& stats)
+{
+    uint8_t shadingRate;
+
+    if (!Intel::ComputeTileShadingRateUNORM8(levelDesc, stats, shadingRate)) {
+        const Intel::VALAR_CPU_TILE_KERNEL tileKernel = levelDesc.m_pOpaque->m_tileKernels.m_floatKernels[Intel::GetTileSizeIndex(levelDesc.m_shadingRateTileSize)]
+            [Intel::GetColorFormat(levelDesc)][Intel::GetTileKernelMode(levelDesc)];
+
+        Intel::VALAR_TILE_STATISTICS floatStats;
+        tileKernel(levelDesc, tileY, tileX, tileX + 1, &floatStats);
+        shadingRate = Intel::ComputeTileShadingRate(levelDesc, floatStats);
+    }
+
+    return shadingRate;
+}
+
+// Writes the rates of tiles [levelXBegin, levelXEnd) of one row of a pyramid level and counts them for the statistics level.
+template <typename S>
+static void StorePyramidRow(const VALAR_CPU_PYRAMID_JOB& job, uint32_t level, uint32_t tileY, uint32_t levelXBegin, uint32_t levelXEnd,
+    const S* stats, uint32_t* shadingRateTileCount)
+{
+    const Intel::VALAR_CPU_DESCRIPTOR& levelDesc = job.m_levelDescs[level];
+    const uint32_t tileSize = levelDesc.m_shadingRateTileSize;
+    const uint32_t tilesX = (levelDesc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (levelDesc.m_bufferHeight + tileSize - 1) / tileSize;
+    uint8_t* valarBuffer = job.m_pyramid->m_valarBuffers[level];
+
+    // Tiles of the padded 32x32 grid past the right and bottom edges are only reduced, never stored.
+    if (valarBuffer == nullptr || tileY >= tilesY) {
+        return;
+    }
+
+    const uint32_t rowPitch = (job.m_pyramid->m_valarRowPitches[level] != 0) ? job.m_pyramid->m_valarRowPitches[level] : tilesX;
+    uint8_t* valarRow = valarBuffer + (size_t)tileY * rowPitch;
+
+    for (uint32_t tileX = levelXBegin; tileX < levelXEnd && tileX < tilesX; tileX++) {
+        const uint8_t shadingRate = ComputePyramidShadingRate(levelDesc, tileX, tileY, stats[tileX - levelXBegin]);
+
+        valarRow[tileX] = shadingRate;
+
+        if (level == job.m_statisticsLevel) {
+            shadingRateTileCount[shadingRate]++;
+        }
+    }
+}
+
+// Computes the 8x8 statistics of one row of 32x32 tiles once and reduces them 2x2 into the 16x16 and 32x32 levels.
+template <typename S, typename K>
+static void ComputePyramidRow(const VALAR_CPU_PYRAMID_JOB& job, uint32_t tileY32, K tileKernel)
+{
+    const Intel::VALAR_CPU_DESCRIPTOR& desc = job.m_levelDescs[0];
+    const uint32_t tilesX32 = (desc.m_bufferWidth + LARGE_TILE_SIZE - 1) / LARGE_TILE_SIZE;
+    const uint32_t tilesX8 = tilesX32 * (LARGE_TILE_SIZE / INTEL_TILE_SIZE);
+
+    S stats8[LARGE_TILE_SIZE / INTEL_TILE_SIZE][VALAR_CPU_PYRAMID_SPAN_TILES];
+    S stats16[LARGE_TILE_SIZE / OTHER_TILE_SIZE][VALAR_CPU_PYRAMID_SPAN_TILES / 2];
+    S stats32[VALAR_CPU_PYRAMID_SPAN_TILES / 4];
+
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+
+    for (uint32_t spanBegin = 0; spanBegin < tilesX8; spanBegin += VALAR_CPU_PYRAMID_SPAN_TILES) {
+        const uint32_t spanEnd = (spanBegin + VALAR_CPU_PYRAMID_SPAN_TILES < tilesX8) ? spanBegin + VALAR_CPU_PYRAMID_SPAN_TILES : tilesX8;
+        const uint32_t spanTiles = spanEnd - spanBegin;
+
+        // The kernels read past the right and bottom edges like the fused kernels of a partial tile, so the padded
+        // 8x8 tiles hold the same sums a direct pass over the larger tiles accumulates there.
+        for (uint32_t row = 0; row < LARGE_TILE_SIZE / INTEL_TILE_SIZE; row++) {
+            const uint32_t tileY8 = tileY32 * (LARGE_TILE_SIZE / INTEL_TILE_SIZE) + row;
+
+            tileKernel(desc, tileY8, spanBegin, spanEnd, stats8[row]);
+            StorePyramidRow(job, 0, tileY8, spanBegin, spanEnd, stats8[row], shadingRateTileCount);
+        }
+
+        for (uint32_t row = 0; row < LARGE_TILE_SIZE / OTHER_TILE_SIZE; row++) {
+            for (uint32_t tile = 0; tile < spanTiles / 2; tile++) {
+                CombineTileStatistics(stats16[row][tile], stats8[2 * row][2 * tile], stats8[2 * row][2 * tile + 1],
+                    stats8[2 * row + 1][2 * tile], stats8[2 * row + 1][2 * tile + 1]);
+            }
+
+            StorePyramidRow(job, 1, tileY32 * 2 + row, spanBegin / 2, spanEnd / 2, stats16[row], shadingRateTileCount);
+        }
+
+        for (uint32_t tile = 0; tile < spanTiles / 4; tile++) {
+            CombineTileStatistics(stats32[tile], stats16[0][2 * tile], stats16[0][2 * tile + 1], stats16[1][2 * tile], stats16[1][2 * tile + 1]);
+        }
+
+        StorePyramidRow(job, 2, tileY32, spanBegin / 4, spanEnd / 4, stats32, shadingRateTileCount);
+    }
+
+    Intel::AccumulateShadingRateTileCount(desc, shadingRateTileCount);
+}
+
+static void ComputePyramidRowJob(void* context, uint32_t tileY32)
+{
+    const VALAR_CPU_PYRAMID_JOB& job = *(const VALAR_CPU_PYRAMID_JOB*)context;
+    const Intel::VALAR_CPU_DESCRIPTOR& desc = job.m_levelDescs[0];
+    const Intel::VALAR_CPU_FORMAT colorFormat = Intel::GetColorFormat(desc);
+    const uint32_t mode = Intel::GetTileKernelMode(desc);
+    const uint32_t tileSizeIndex = Intel::GetTileSizeIndex(INTEL_TILE_SIZE);
+    const Intel::VALAR_CPU_TILE_KERNEL tileKernel = desc.m_pOpaque->m_tileKernels.m_floatKernels[tileSizeIndex][colorFormat][mode];
+    const Intel::VALAR_CPU_TILE_KERNEL_UNORM8 tileKernelUNORM8 = desc.m_pOpaque->m_tileKernels.m_unorm8Kernels[tileSizeIndex][colorFormat][mode];
+
+    if (tileKernelUNORM8 != nullptr) {
+        ComputePyramidRow<Intel::VALAR_TILE_STATISTICS_UNORM8>(job, tileY32, tileKernelUNORM8);
+    } else {
+        ComputePyramidRow<Intel::VALAR_TILE_STATISTICS>(job, tileY32, tileKernel);
+    }
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskPyramidCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_MASK_PYRAMID& pyramid)
+{
+    // The neighborhood minimum of Weber-Fechner mode stops at the tile borders, so its sums do not reduce.
+    if (desc.m_weberFechnerMode) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    // The regions of interest are rects of tiles of m_shadingRateTileSize, the levels have tiles of every size.
+    if (desc.m_regionOfInterestCount > 0) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    // The levels reduce the sums of every 8x8 tile, the due tiles of amortization only cover part of them.
+    if (desc.m_amortizationPeriod > 1) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    VALAR_CPU_PYRAMID_JOB job;
+    job.m_pyramid = &pyramid;
+    job.m_statisticsLevel = VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT;
+
+    bool hasMask = false;
+
+    for (uint32_t level = 0; level < VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT; level++) {
+        VALAR_CPU_DESCRIPTOR& levelDesc = job.m_levelDescs[level];
+
+        levelDesc = desc;
+        levelDesc.m_shadingRateTileSize = INTEL_TILE_SIZE << level;
+        levelDesc.m_valarBuffer = pyramid.m_valarBuffers[level];
+        levelDesc.m_valarRowPitch = pyramid.m_valarRowPitches[level];
+
+        if (pyramid.m_valarBuffers[level] == nullptr) {
+            continue;
+        }
+
+        VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(levelDesc);
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
+        }
+
+        if (levelDesc.m_shadingRateTileSize == desc.m_shadingRateTileSize) {
+            job.m_statisticsLevel = level;
+        }
+
+        hasMask = true;
+    }
+
+    if (!hasMask) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_enabled) {
+        const uint32_t tilesY32 = (desc.m_bufferHeight + LARGE_TILE_SIZE - 1) / LARGE_TILE_SIZE;
+
+        std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+
+        // Like ComputeMask, the statistics of a later temporal mask would be older than one frame.
+        desc.m_pOpaque->m_temporalHistory->m_isValid = false;
+
+        DispatchThreadPool(desc.m_pOpaque->m_threadPool, tilesY32, ComputePyramidRowJob, &job);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_FinalizeMaskCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, Intel::VALAR_CPU_MASK_STATISTICS* pStatistics)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    // Waits for the mask in progress, so its tiles are counted in a single frame.
+    std::lock_guard<std::mutex> maskLock(desc.m_pOpaque->m_maskLock);
+
+    VALAR_CPU_MASK_STATISTICS statistics;
+    float shadedTiles = 0.0f;
+
+    for (uint32_t i = 0; i < VALAR_CPU_SHADING_RATE_COUNT; i++) {
+        // Reset the counters for the next frame while reading them.
+        const uint32_t tileCount = desc.m_pOpaque->m_shadingRateTileCount[i].exchange(0, std::memory_order_relaxed);
+
+        // Coarse rate 0xXY shades one pixel out of (1 << X) * (1 << Y).
+        const uint32_t coarsePixelCount = (1u << (i >> 2)) * (1u << (i & 0x3));
+
+        statistics.m_shadingRateTileCount[i] = tileCount;
+        statistics.m_tileCount += tileCount;
+        shadedTiles += (float)tileCount / (float)coarsePixelCount;
+    }
+
+    statistics.m_shadingRateRatio = (statistics.m_tileCount > 0) ? shadedTiles / (float)statistics.m_tileCount : 1.0f;
+
+    if (pStatistics != nullptr) {
+        *pStatistics = statistics;
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskAsyncCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, Intel::VALAR_CPU_ASYNC_MASK& asyncMask)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized || desc.m_pOpaque->m_asyncQueue == nullptr) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    // The mask is written to a VALAR owned buffer, desc.m_valarBuffer is ignored.
+    return SubmitAsyncMask(desc.m_pOpaque->m_asyncQueue, desc, asyncMask);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_GetCompletedFenceValueCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint64_t& fenceValue)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized || desc.m_pOpaque->m_asyncQueue == nullptr) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    fenceValue = GetCompletedAsyncFenceValue(desc.m_pOpaque->m_asyncQueue);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_WaitForMaskCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_ASYNC_MASK& asyncMask)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized || desc.m_pOpaque->m_asyncQueue == nullptr) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    return WaitForAsyncFenceValue(desc.m_pOpaque->m_asyncQueue, asyncMask.m_fenceValue);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_GetAllocationCountCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint64_t& allocationCount)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    allocationCount = desc.m_pOpaque->m_allocationCount.load(std::memory_order_relaxed);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_SetWarmUpCompleteCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, bool isWarmUpComplete)
+{
+    if (desc.m_pOpaque == nullptr || !desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    desc.m_pOpaque->m_isWarmUpComplete.store(isWarmUpComplete, std::memory_order_relaxed);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_GetMaskFootprintCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t& rowPitch, uint32_t& sizeInBytes)
+{
+    if (desc.m_bufferWidth == 0 || desc.m_bufferHeight == 0) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (!IsValidTileSize(desc.m_shadingRateTileSize)) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesX = (desc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    // Same layout as GetCopyableFootprints reports for the R8_UINT mask texture, the last row is not padded.
+    rowPitch = (tilesX + VALAR_CPU_MASK_PITCH_ALIGNMENT - 1) & ~(VALAR_CPU_MASK_PITCH_ALIGNMENT - 1);
+    sizeInBytes = rowPitch * (tilesY - 1) + tilesX;
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
\ No newline at end of file
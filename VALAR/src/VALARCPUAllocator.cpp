@@ -0,0 +1,57 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+
+void* Intel::AllocateMemory(const Intel::VALAR_CPU_ALLOCATION_CALLBACKS& callbacks, size_t size, size_t alignment, Intel::VALAR_CPU_ALLOCATION_TAG tag)
+{
+    if (callbacks.m_allocate != nullptr) {
+        return callbacks.m_allocate(callbacks.m_userData, size, alignment, tag);
+    }
+
+    // new[] only guarantees the fundamental alignment, the block is padded and the pointer to its start is kept
+    // right below the aligned memory.
+    uint8_t* block = new (std::nothrow) uint8_t[size + alignment + sizeof(uint8_t*)];
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    const uintptr_t memory = ((uintptr_t)(block + sizeof(uint8_t*)) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((uint8_t**)memory)[-1] = block;
+
+    return (void*)memory;
+}
+
+void Intel::FreeMemory(const Intel::VALAR_CPU_ALLOCATION_CALLBACKS& callbacks, void* memory, Intel::VALAR_CPU_ALLOCATION_TAG tag)
+{
+    if (memory == nullptr) {
+        return;
+    }
+
+    if (callbacks.m_free != nullptr) {
+        callbacks.m_free(callbacks.m_userData, memory, tag);
+        return;
+    }
+
+    delete[] ((uint8_t**)memory)[-1];
+}
\ No newline at end of file
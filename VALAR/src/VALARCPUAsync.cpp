@@ -0,0 +1,188 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUAsync.h"
+
+static void AsyncQueueMain(Intel::VALAR_CPU_ASYNC_QUEUE* queue)
+{
+    for (;;) {
+        uint64_t fenceValue;
+        {
+            std::unique_lock<std::mutex> lock(queue->m_lock);
+            queue->m_submitCondition.wait(lock, [&] { return queue->m_shutdown || queue->m_submittedFenceValue > queue->m_completedFenceValue; });
+
+            // Pending jobs are drained before shutting down so no waiter is left behind.
+            if (queue->m_submittedFenceValue == queue->m_completedFenceValue) {
+                return;
+            }
+
+            fenceValue = queue->m_completedFenceValue + 1;
+        }
+
+        // The slot of an in flight job is never touched by SubmitAsyncMask, no lock needed while computing.
+        const Intel::VALAR_CPU_DESCRIPTOR& job = queue->m_jobs[fenceValue % queue->m_bufferCount];
+
+        const uint32_t slot = (uint32_t)(fenceValue % queue->m_bufferCount);
+        const uint32_t previousSlot = (uint32_t)((fenceValue - 1) % queue->m_bufferCount);
+        const size_t maskBufferSize = queue->m_maskBufferSizes[slot];
+
+        if (job.m_enabled) {
+            // Amortized masks keep the rates of the previous mask, which lives in the previous slot. A previous mask
+            // of another size is not reused, the mask starts at the full rate instead.
+            if (job.m_amortizationPeriod > 1 && previousSlot != slot) {
+                if (queue->m_maskBufferSizes[previousSlot] == maskBufferSize) {
+                    memcpy(job.m_valarBuffer, queue->m_maskBuffers[previousSlot], maskBufferSize);
+                } else {
+                    memset(job.m_valarBuffer, Intel::VALAR_SHADING_RATE_1X1, maskBufferSize);
+                }
+            }
+
+            Intel::ComputeMask(job);
+        } else {
+            // Slots are recycled, hand out a full rate mask instead of a stale one.
+            memset(job.m_valarBuffer, Intel::VALAR_SHADING_RATE_1X1, maskBufferSize);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue->m_lock);
+            queue->m_completedFenceValue = fenceValue;
+        }
+        queue->m_completeCondition.notify_all();
+    }
+}
+
+Intel::VALAR_CPU_ASYNC_QUEUE* Intel::CreateAsyncQueue(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, uint32_t bufferCount)
+{
+    VALAR_CPU_ASYNC_QUEUE* queue = AllocateArray<VALAR_CPU_ASYNC_QUEUE>(opaque, 1, VALAR_CPU_ALLOCATION_TAG_ASYNC_QUEUE);
+    if (queue == nullptr) {
+        return nullptr;
+    }
+
+    queue->m_bufferCount = bufferCount;
+    queue->m_thread = std::thread(AsyncQueueMain, queue);
+
+    return queue;
+}
+
+void Intel::DestroyAsyncQueue(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, Intel::VALAR_CPU_ASYNC_QUEUE* queue)
+{
+    if (queue == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue->m_lock);
+        queue->m_shutdown = true;
+    }
+    queue->m_submitCondition.notify_all();
+    queue->m_thread.join();
+
+    for (uint32_t i = 0; i < VALAR_CPU_MAX_ASYNC_MASK_BUFFER_COUNT; i++) {
+        FreeArray(opaque, queue->m_maskBuffers[i], queue->m_maskBufferSizes[i], VALAR_CPU_ALLOCATION_TAG_ASYNC_QUEUE);
+    }
+
+    FreeArray(opaque, queue, 1, VALAR_CPU_ALLOCATION_TAG_ASYNC_QUEUE);
+}
+
+Intel::VALAR_RETURN_CODE Intel::SubmitAsyncMask(Intel::VALAR_CPU_ASYNC_QUEUE* queue, const Intel::VALAR_CPU_DESCRIPTOR& desc, Intel::VALAR_CPU_ASYNC_MASK& asyncMask)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    if (tileSize == 0) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    const size_t maskBufferSize = (size_t)((desc.m_bufferWidth + tileSize - 1) / tileSize) * ((desc.m_bufferHeight + tileSize - 1) / tileSize);
+
+    std::unique_lock<std::mutex> lock(queue->m_lock);
+
+    const uint64_t fenceValue = queue->m_submittedFenceValue + 1;
+    const uint32_t slot = (uint32_t)(fenceValue % queue->m_bufferCount);
+
+    // Back pressure, the mask handed out m_bufferCount fences ago has to be complete before its slot is reused.
+    queue->m_completeCondition.wait(lock, [&] { return queue->m_completedFenceValue + queue->m_bufferCount >= fenceValue; });
+
+    if (maskBufferSize != queue->m_maskBufferSizes[slot]) {
+        // Resolution changes are rare. Only the slot being reused is resized, the masks still held by the caller stay
+        // valid until their own slot comes around. The queue is drained first, the pending job may still read this
+        // slot as its previous mask.
+        queue->m_completeCondition.wait(lock, [&] { return queue->m_completedFenceValue == queue->m_submittedFenceValue; });
+
+        FreeArray(*desc.m_pOpaque, queue->m_maskBuffers[slot], queue->m_maskBufferSizes[slot], VALAR_CPU_ALLOCATION_TAG_ASYNC_QUEUE);
+        queue->m_maskBuffers[slot] = AllocateArray<uint8_t>(*desc.m_pOpaque, maskBufferSize, VALAR_CPU_ALLOCATION_TAG_ASYNC_QUEUE);
+
+        if (queue->m_maskBuffers[slot] == nullptr) {
+            // The next submit retries the allocation.
+            queue->m_maskBufferSizes[slot] = 0;
+            return VALAR_RETURN_CODE_OUT_OF_MEMORY;
+        }
+
+        queue->m_maskBufferSizes[slot] = maskBufferSize;
+
+        // Amortized masks start from the full rate until every tile has been updated once.
+        memset(queue->m_maskBuffers[slot], Intel::VALAR_SHADING_RATE_1X1, maskBufferSize);
+    }
+
+    VALAR_CPU_DESCRIPTOR& job = queue->m_jobs[slot];
+    job = desc;
+    job.m_valarBuffer = queue->m_maskBuffers[slot];
+    job.m_valarRowPitch = 0;
+
+    VALAR_RETURN_CODE retCode = ValidateCPUDescriptor(job);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    queue->m_submittedFenceValue = fenceValue;
+    lock.unlock();
+    queue->m_submitCondition.notify_one();
+
+    asyncMask.m_fenceValue = fenceValue;
+    asyncMask.m_valarBuffer = job.m_valarBuffer;
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+uint64_t Intel::GetCompletedAsyncFenceValue(Intel::VALAR_CPU_ASYNC_QUEUE* queue)
+{
+    std::lock_guard<std::mutex> lock(queue->m_lock);
+
+    return queue->m_completedFenceValue;
+}
+
+Intel::VALAR_RETURN_CODE Intel::WaitForAsyncFenceValue(Intel::VALAR_CPU_ASYNC_QUEUE* queue, uint64_t fenceValue)
+{
+    std::unique_lock<std::mutex> lock(queue->m_lock);
+
+    if (fenceValue > queue->m_submittedFenceValue) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    queue->m_completeCondition.wait(lock, [&] { return queue->m_completedFenceValue >= fenceValue; });
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "VALARCPU.h"
+
+namespace Intel
+{
+    // Single consumer queue of mask jobs. Job and mask slots are indexed by fence value modulo
+    // the buffer count, a slot is reused once the job submitted m_bufferCount fences earlier completed.
+    // Each slot keeps its own size, so a resize only reallocates the slot being reused.
+    struct VALAR_CPU_ASYNC_QUEUE
+    {
+        std::thread                 m_thread;
+        std::mutex                  m_lock;
+        std::condition_variable     m_submitCondition;
+        std::condition_variable     m_completeCondition;
+
+        VALAR_CPU_DESCRIPTOR        m_jobs[VALAR_CPU_MAX_ASYNC_MASK_BUFFER_COUNT];
+        uint8_t*                    m_maskBuffers[VALAR_CPU_MAX_ASYNC_MASK_BUFFER_COUNT] = {};
+        size_t                      m_maskBufferSizes[VALAR_CPU_MAX_ASYNC_MASK_BUFFER_COUNT] = {};
+        uint32_t                    m_bufferCount = 0;
+
+        uint64_t                    m_submittedFenceValue = 0;
+        uint64_t                    m_completedFenceValue = 0;
+        bool                        m_shutdown = false;
+    };
+
+    VALAR_CPU_ASYNC_QUEUE* CreateAsyncQueue(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, uint32_t bufferCount);
+    void DestroyAsyncQueue(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, VALAR_CPU_ASYNC_QUEUE* queue);
+    VALAR_RETURN_CODE SubmitAsyncMask(VALAR_CPU_ASYNC_QUEUE* queue, const VALAR_CPU_DESCRIPTOR& desc, VALAR_CPU_ASYNC_MASK& asyncMask);
+    uint64_t GetCompletedAsyncFenceValue(VALAR_CPU_ASYNC_QUEUE* queue);
+    VALAR_RETURN_CODE WaitForAsyncFenceValue(VALAR_CPU_ASYNC_QUEUE* queue, uint64_t fenceValue);
+}
\ No newline at end of file
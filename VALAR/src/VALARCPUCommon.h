@@ -0,0 +1,122 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "ValarRateDecision.hlsli"
+
+namespace Intel
+{
+    // Scalar mirrors of the helpers in VRSCommon.hlsli and ValarCS.hlsli. These must stay
+    // bit-for-bit equivalent to the shader math so the CPU and GPU masks agree.
+
+    inline float Saturate(float x)
+    {
+        return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+    }
+
+    inline float RGBToLuminance(float r, float g, float b)
+    {
+        return r * 0.212671f + g * 0.715160f + b * 0.072169f;
+    }
+
+    // Equivalent of HLSL f16tof32, including denormals, infinities and NaNs.
+    inline float HalfToFloat(uint32_t half)
+    {
+        const uint32_t sign = (half & 0x8000u) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+        uint32_t bits = sign;
+
+        if (exponent == 0x1Fu) {
+            bits |= 0x7F800000u | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits |= ((exponent + 112u) << 23) | (mantissa << 13);
+        } else if (mantissa != 0) {
+            uint32_t normalizedExponent = 113u;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                normalizedExponent--;
+            }
+            bits |= (normalizedExponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // Linear luminance of one pixel of each color format. Channels are decoded like a typed load of the format
+    // and squared like the color * color of the shader. The 8-bit formats go through VALAR_CPU_UNORM8_TABLE.
+    inline float SquareUNORM(uint32_t value, float maxValue)
+    {
+        const float unorm = (float)value / maxValue;
+        return unorm * unorm;
+    }
+
+    inline float SquareHalf(uint32_t half)
+    {
+        const float value = HalfToFloat(half);
+        return value * value;
+    }
+
+    inline float LuminanceR32G32B32A32Float(const float* pixel)
+    {
+        return RGBToLuminance(pixel[0] * pixel[0], pixel[1] * pixel[1], pixel[2] * pixel[2]);
+    }
+
+    inline float LuminanceR16G16B16A16Float(const uint16_t* pixel)
+    {
+        return RGBToLuminance(SquareHalf(pixel[0]), SquareHalf(pixel[1]), SquareHalf(pixel[2]));
+    }
+
+    // The 11 and 10-bit floats share the 5-bit exponent of a half and only lack low mantissa bits and the sign.
+    inline float LuminanceR11G11B10Float(uint32_t pixel)
+    {
+        return RGBToLuminance(SquareHalf((pixel & 0x7FF) << 4), SquareHalf(((pixel >> 11) & 0x7FF) << 4), SquareHalf((pixel >> 22) << 5));
+    }
+
+    inline float LuminanceR10G10B10A2UNORM(uint32_t pixel)
+    {
+        return RGBToLuminance(SquareUNORM(pixel & 0x3FF, 1023.0f), SquareUNORM((pixel >> 10) & 0x3FF, 1023.0f), SquareUNORM((pixel >> 20) & 0x3FF, 1023.0f));
+    }
+
+    inline float UnpackXY(uint32_t x)
+    {
+        return HalfToFloat((x & 0x1FF) << 4 | (x >> 9) << 15) * 32768.0f;
+    }
+
+    inline float UnpackZ(uint32_t x)
+    {
+        return HalfToFloat((x & 0x7FF) << 2 | (x >> 11) << 15) * 128.0f;
+    }
+
+    inline float PackedVelocityLength(uint32_t velocity)
+    {
+        const float x = UnpackXY(velocity & 0x3FF);
+        const float y = UnpackXY((velocity >> 10) & 0x3FF);
+        const float z = UnpackZ(velocity >> 20);
+
+        return sqrtf(x * x + y * y + z * z);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+
+#if defined(VALAR_CPU_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(VALAR_CPU_ARM64) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#if defined(VALAR_CPU_X86)
+static void QueryCPUID(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+{
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, (int)leaf, (int)subleaf);
+    for (uint32_t i = 0; i < 4; i++) {
+        registers[i] = (uint32_t)values[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static uint64_t QueryXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+Intel::VALAR_RETURN_CODE Intel::CheckCPUFeatureSupport(Intel::VALAR_CPU_FEATURES& featureSupport)
+{
+    featureSupport.m_sse41Supported = false;
+    featureSupport.m_avx2Supported = false;
+    featureSupport.m_avx512Supported = false;
+    featureSupport.m_neonSupported = false;
+    featureSupport.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_SCALAR;
+
+#if defined(VALAR_CPU_X86)
+    uint32_t registers[4];
+
+    QueryCPUID(0, 0, registers);
+    const uint32_t maxLeaf = registers[0];
+
+    QueryCPUID(1, 0, registers);
+    featureSupport.m_sse41Supported = (registers[2] & (1u << 19)) != 0;
+    // The AVX2 kernels convert halves with F16C, which every AVX2 capable CPU implements.
+    const bool f16c = (registers[2] & (1u << 29)) != 0;
+
+    // AVX state has to be enabled by the OS (OSXSAVE + XCR0) before any VEX encoded code can run.
+    const bool osxsave = (registers[2] & (1u << 27)) != 0;
+    const bool avx = (registers[2] & (1u << 28)) != 0;
+    const uint64_t xcr0 = osxsave ? QueryXCR0() : 0;
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+    if (maxLeaf >= 7) {
+        QueryCPUID(7, 0, registers);
+        featureSupport.m_avx2Supported = avx && f16c && ymmEnabled && (registers[1] & (1u << 5)) != 0;
+        featureSupport.m_avx512Supported = featureSupport.m_avx2Supported && zmmEnabled && (registers[1] & (1u << 16)) != 0;
+    }
+#elif defined(VALAR_CPU_ARM64)
+#if defined(__linux__)
+    featureSupport.m_neonSupported = (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+    featureSupport.m_neonSupported = true;
+#endif
+#endif
+
+    if (featureSupport.m_avx512Supported) {
+        featureSupport.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_AVX512;
+    } else if (featureSupport.m_avx2Supported) {
+        featureSupport.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_AVX2;
+    } else if (featureSupport.m_sse41Supported) {
+        featureSupport.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_SSE41;
+    } else if (featureSupport.m_neonSupported) {
+        featureSupport.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_NEON;
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+void Intel::SelectTileKernels(Intel::VALAR_CPU_INSTRUCTION_SET instructionSet, Intel::VALAR_CPU_TILE_KERNELS& kernels)
+{
+    switch (instructionSet)
+    {
+#if defined(VALAR_CPU_X86)
+    case VALAR_CPU_INSTRUCTION_SET_SSE41:
+        GetTileKernelsSSE41(kernels);
+        break;
+    case VALAR_CPU_INSTRUCTION_SET_AVX2:
+        GetTileKernelsAVX2(kernels);
+        break;
+    case VALAR_CPU_INSTRUCTION_SET_AVX512:
+        GetTileKernelsAVX512(kernels);
+        break;
+#elif defined(VALAR_CPU_ARM64)
+    case VALAR_CPU_INSTRUCTION_SET_NEON:
+        GetTileKernelsNEON(kernels);
+        break;
+#endif
+    default:
+        GetTileKernelsScalar(kernels);
+        break;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,389 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <ucontext.h>
+#endif
+
+// swapcontext saves the signal mask with a system call on every switch. Where the compiler supports it, lanes are only
+// entered through their ucontext_t the first time and switch with __builtin_setjmp and __builtin_longjmp afterwards.
+#if !defined(_WIN32) && defined(__GNUC__) && defined(__x86_64__)
+#define VALAR_CPU_HLSL_BUILTIN_JUMP
+#endif
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUHLSL.h"
+
+enum VALAR_CPU_HLSL_LANE_STATE {
+    VALAR_CPU_HLSL_LANE_STATE_RUNNABLE,
+    VALAR_CPU_HLSL_LANE_STATE_BARRIER,
+    VALAR_CPU_HLSL_LANE_STATE_WAVE_INTRINSIC,
+    VALAR_CPU_HLSL_LANE_STATE_FINISHED
+};
+
+// Emulator running on this thread and the lane it switched to.
+static thread_local Intel::HLSL::VALAR_CPU_HLSL_EMULATOR* t_emulator = nullptr;
+static thread_local Intel::HLSL::VALAR_CPU_HLSL_LANE* t_lane = nullptr;
+
+#if defined(VALAR_CPU_HLSL_BUILTIN_JUMP)
+// Must not be in the function calling __builtin_setjmp.
+__attribute__((noinline)) static void JumpTo(void** jumpBuffer)
+{
+    __builtin_longjmp(jumpBuffer, 1);
+}
+
+__attribute__((noinline)) static void SwitchToLane(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator, Intel::HLSL::VALAR_CPU_HLSL_LANE& lane)
+{
+    t_lane = &lane;
+
+    if (__builtin_setjmp(emulator.m_schedulerJumpBuffer) == 0) {
+        if (lane.m_started) {
+            JumpTo(lane.m_jumpBuffer);
+        }
+
+        lane.m_started = true;
+        setcontext((ucontext_t*)lane.m_fiber);
+    }
+}
+
+__attribute__((noinline)) static void SwitchToScheduler(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator, Intel::HLSL::VALAR_CPU_HLSL_LANE& lane)
+{
+    if (__builtin_setjmp(lane.m_jumpBuffer) == 0) {
+        JumpTo(emulator.m_schedulerJumpBuffer);
+    }
+}
+#else
+static void SwitchToLane(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator, Intel::HLSL::VALAR_CPU_HLSL_LANE& lane)
+{
+    t_lane = &lane;
+
+#if defined(_WIN32)
+    SwitchToFiber(lane.m_fiber);
+#else
+    swapcontext((ucontext_t*)emulator.m_schedulerFiber, (ucontext_t*)lane.m_fiber);
+#endif
+}
+
+static void SwitchToScheduler(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator, Intel::HLSL::VALAR_CPU_HLSL_LANE& lane)
+{
+#if defined(_WIN32)
+    SwitchToFiber(emulator.m_schedulerFiber);
+#else
+    swapcontext((ucontext_t*)lane.m_fiber, (ucontext_t*)emulator.m_schedulerFiber);
+#endif
+}
+#endif
+
+static void RunShader(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator, const Intel::HLSL::VALAR_CPU_HLSL_LANE& lane)
+{
+    const Intel::HLSL::uint3 dispatchThreadID = emulator.m_groupID * emulator.m_numThreads + lane.m_groupThreadID;
+
+    emulator.m_entry(emulator.m_shader, emulator.m_groupID, lane.m_groupIndex, lane.m_groupThreadID, dispatchThreadID);
+}
+
+// Body of the fiber of a lane, runs the lane once for every group of every dispatch.
+static void RunLane(Intel::HLSL::VALAR_CPU_HLSL_LANE& lane)
+{
+    for (;;) {
+        Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator = *t_emulator;
+
+        RunShader(emulator, lane);
+
+        lane.m_state = VALAR_CPU_HLSL_LANE_STATE_FINISHED;
+        SwitchToScheduler(emulator, lane);
+    }
+}
+
+#if defined(_WIN32)
+static VOID CALLBACK RunLaneFiber(LPVOID lane)
+{
+    RunLane(*(Intel::HLSL::VALAR_CPU_HLSL_LANE*)lane);
+}
+#else
+static void RunLaneContext()
+{
+    RunLane(*t_lane);
+}
+#endif
+
+// Completes one wave intrinsic per wave, for the lanes waiting at the same line as the first waiting lane.
+static bool CompleteWaveIntrinsics(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator)
+{
+    Intel::HLSL::VALAR_CPU_HLSL_LANE* waveLanes[VALAR_CPU_MAX_WAVE_LANE_COUNT];
+    bool completed = false;
+
+    for (uint32_t waveBegin = 0; waveBegin < emulator.m_laneCount; waveBegin += emulator.m_waveLaneCount) {
+        const uint32_t waveEnd = (waveBegin + emulator.m_waveLaneCount < emulator.m_laneCount) ? waveBegin + emulator.m_waveLaneCount : emulator.m_laneCount;
+        uint32_t waveLaneCount = 0;
+
+        for (uint32_t i = waveBegin; i < waveEnd; i++) {
+            Intel::HLSL::VALAR_CPU_HLSL_LANE& lane = emulator.m_lanes[i];
+
+            if (lane.m_state == VALAR_CPU_HLSL_LANE_STATE_WAVE_INTRINSIC && (waveLaneCount == 0 ||
+                (lane.m_waveFunction == waveLanes[0]->m_waveFunction && lane.m_waveLine == waveLanes[0]->m_waveLine))) {
+                waveLanes[waveLaneCount++] = &lane;
+            }
+        }
+
+        if (waveLaneCount > 0) {
+            waveLanes[0]->m_waveFunction(waveLanes, waveLaneCount);
+
+            for (uint32_t i = 0; i < waveLaneCount; i++) {
+                waveLanes[i]->m_state = VALAR_CPU_HLSL_LANE_STATE_RUNNABLE;
+            }
+
+            emulator.m_statistics.m_waveIntrinsicCount++;
+            completed = true;
+        }
+    }
+
+    return completed;
+}
+
+// Runs every lane until it finishes or waits, then completes the wave intrinsics or, once all remaining lanes
+// wait at the barrier, the barrier.
+static void RunGroup(Intel::HLSL::VALAR_CPU_HLSL_EMULATOR& emulator)
+{
+    for (uint32_t i = 0; i < emulator.m_laneCount; i++) {
+        emulator.m_lanes[i].m_state = VALAR_CPU_HLSL_LANE_STATE_RUNNABLE;
+    }
+
+    // Single lane groups complete their barriers and wave intrinsics right away and need no fiber.
+    if (emulator.m_laneCount == 1) {
+        t_lane = &emulator.m_lanes[0];
+        RunShader(emulator, emulator.m_lanes[0]);
+        return;
+    }
+
+    for (;;) {
+        bool finished = true;
+
+        for (uint32_t i = 0; i < emulator.m_laneCount; i++) {
+            Intel::HLSL::VALAR_CPU_HLSL_LANE& lane = emulator.m_lanes[i];
+
+            if (lane.m_state == VALAR_CPU_HLSL_LANE_STATE_RUNNABLE) {
+                SwitchToLane(emulator, lane);
+            }
+
+            finished = finished && (lane.m_state == VALAR_CPU_HLSL_LANE_STATE_FINISHED);
+        }
+
+        if (finished) {
+            return;
+        }
+
+        if (!CompleteWaveIntrinsics(emulator)) {
+            for (uint32_t i = 0; i < emulator.m_laneCount; i++) {
+                Intel::HLSL::VALAR_CPU_HLSL_LANE& lane = emulator.m_lanes[i];
+
+                if (lane.m_state == VALAR_CPU_HLSL_LANE_STATE_BARRIER) {
+                    lane.m_state = VALAR_CPU_HLSL_LANE_STATE_RUNNABLE;
+                }
+            }
+
+            emulator.m_statistics.m_barrierCount++;
+        }
+    }
+}
+
+Intel::HLSL::VALAR_CPU_HLSL_EMULATOR* Intel::HLSL::CreateHLSLEmulator(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, const uint3& numThreads, uint32_t waveLaneCount)
+{
+    VALAR_CPU_HLSL_EMULATOR* emulator = AllocateArray<VALAR_CPU_HLSL_EMULATOR>(opaque, 1, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+    if (emulator == nullptr) {
+        return nullptr;
+    }
+
+    emulator->m_laneCount = numThreads.x * numThreads.y * numThreads.z;
+    emulator->m_waveLaneCount = waveLaneCount;
+    emulator->m_numThreads = numThreads;
+    emulator->m_lanes = AllocateArray<VALAR_CPU_HLSL_LANE>(opaque, emulator->m_laneCount, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+
+    if (emulator->m_lanes == nullptr) {
+        DestroyHLSLEmulator(opaque, emulator);
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < emulator->m_laneCount; i++) {
+        VALAR_CPU_HLSL_LANE& lane = emulator->m_lanes[i];
+
+        lane.m_groupIndex = i;
+        lane.m_groupThreadID = uint3(i % numThreads.x, (i / numThreads.x) % numThreads.y, i / (numThreads.x * numThreads.y));
+    }
+
+    if (emulator->m_laneCount == 1) {
+        return emulator;
+    }
+
+#if defined(_WIN32)
+    // Fibers allocate their stacks themselves.
+    for (uint32_t i = 0; i < emulator->m_laneCount; i++) {
+        emulator->m_lanes[i].m_fiber = CreateFiber(VALAR_CPU_HLSL_STACK_SIZE, RunLaneFiber, &emulator->m_lanes[i]);
+
+        if (emulator->m_lanes[i].m_fiber == nullptr) {
+            DestroyHLSLEmulator(opaque, emulator);
+            return nullptr;
+        }
+    }
+#else
+    ucontext_t* contexts = AllocateArray<ucontext_t>(opaque, emulator->m_laneCount + 1, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+    emulator->m_contexts = contexts;
+    emulator->m_stacks = (uint8_t*)AllocateMemory(opaque.m_allocationCallbacks, (size_t)emulator->m_laneCount * VALAR_CPU_HLSL_STACK_SIZE, 64,
+        VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+
+    if (contexts == nullptr || emulator->m_stacks == nullptr) {
+        DestroyHLSLEmulator(opaque, emulator);
+        return nullptr;
+    }
+
+    opaque.m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    emulator->m_schedulerFiber = &contexts[emulator->m_laneCount];
+
+    for (uint32_t i = 0; i < emulator->m_laneCount; i++) {
+        ucontext_t& context = contexts[i];
+
+        getcontext(&context);
+        context.uc_stack.ss_sp = emulator->m_stacks + (size_t)i * VALAR_CPU_HLSL_STACK_SIZE;
+        context.uc_stack.ss_size = VALAR_CPU_HLSL_STACK_SIZE;
+        context.uc_link = nullptr;
+        makecontext(&context, RunLaneContext, 0);
+
+        emulator->m_lanes[i].m_fiber = &context;
+    }
+#endif
+
+    return emulator;
+}
+
+void Intel::HLSL::DestroyHLSLEmulator(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, VALAR_CPU_HLSL_EMULATOR* emulator)
+{
+    if (emulator == nullptr) {
+        return;
+    }
+
+    if (emulator->m_lanes != nullptr) {
+#if defined(_WIN32)
+        for (uint32_t i = 0; i < emulator->m_laneCount; i++) {
+            if (emulator->m_lanes[i].m_fiber != nullptr) {
+                DeleteFiber(emulator->m_lanes[i].m_fiber);
+            }
+        }
+#endif
+        FreeArray(opaque, emulator->m_lanes, emulator->m_laneCount, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+    }
+
+#if !defined(_WIN32)
+    FreeArray(opaque, (ucontext_t*)emulator->m_contexts, emulator->m_laneCount + 1, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+
+    if (emulator->m_stacks != nullptr) {
+        FreeMemory(opaque.m_allocationCallbacks, emulator->m_stacks, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+    }
+#endif
+
+    FreeArray(opaque, emulator, 1, VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+}
+
+void Intel::HLSL::DispatchHLSL(VALAR_CPU_HLSL_EMULATOR* emulator, void* shader, VALAR_CPU_HLSL_ENTRY_FUNCTION entry, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    emulator->m_shader = shader;
+    emulator->m_entry = entry;
+    t_emulator = emulator;
+
+#if defined(_WIN32)
+    // The calling thread becomes the fiber of the scheduler for the dispatch.
+    const bool isFiber = IsThreadAFiber() != FALSE;
+    if (emulator->m_laneCount > 1) {
+        emulator->m_schedulerFiber = isFiber ? GetCurrentFiber() : ConvertThreadToFiber(nullptr);
+    }
+#endif
+
+    for (uint32_t z = 0; z < groupCountZ; z++) {
+        for (uint32_t y = 0; y < groupCountY; y++) {
+            for (uint32_t x = 0; x < groupCountX; x++) {
+                emulator->m_groupID = uint3(x, y, z);
+                RunGroup(*emulator);
+                emulator->m_statistics.m_groupCount++;
+            }
+        }
+    }
+
+#if defined(_WIN32)
+    if (emulator->m_laneCount > 1 && !isFiber) {
+        ConvertFiberToThread();
+    }
+#endif
+
+    t_emulator = nullptr;
+    t_lane = nullptr;
+}
+
+Intel::HLSL::VALAR_CPU_HLSL_LANE& Intel::HLSL::GetCurrentLane()
+{
+    return *t_lane;
+}
+
+void Intel::HLSL::WaitAtWaveIntrinsic(VALAR_CPU_HLSL_WAVE_FUNCTION function, uint32_t line)
+{
+    VALAR_CPU_HLSL_EMULATOR& emulator = *t_emulator;
+    VALAR_CPU_HLSL_LANE* lane = t_lane;
+
+    if (emulator.m_laneCount == 1) {
+        function(&lane, 1);
+        emulator.m_statistics.m_waveIntrinsicCount++;
+        return;
+    }
+
+    lane->m_waveFunction = function;
+    lane->m_waveLine = line;
+    lane->m_state = VALAR_CPU_HLSL_LANE_STATE_WAVE_INTRINSIC;
+    SwitchToScheduler(emulator, *lane);
+}
+
+void Intel::HLSL::GroupMemoryBarrierWithGroupSync()
+{
+    VALAR_CPU_HLSL_EMULATOR& emulator = *t_emulator;
+
+    if (emulator.m_laneCount == 1) {
+        emulator.m_statistics.m_barrierCount++;
+        return;
+    }
+
+    t_lane->m_state = VALAR_CPU_HLSL_LANE_STATE_BARRIER;
+    SwitchToScheduler(emulator, *t_lane);
+}
+
+uint32_t Intel::HLSL::WaveGetLaneCount()
+{
+    return t_emulator->m_waveLaneCount;
+}
+
+void Intel::HLSL::CountOutOfBoundsGroupSharedAccess()
+{
+    t_emulator->m_statistics.m_groupSharedOutOfBoundsCount++;
+}
+
+void Intel::HLSL::CountOutOfBoundsResourceAccess()
+{
+    t_emulator->m_statistics.m_resourceOutOfBoundsCount++;
+}
\ No newline at end of file
@@ -0,0 +1,498 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "VALARCPU.h"
+#include "VALARCPUCommon.h"
+
+// Stack of one emulated lane, the shader functions keep a few vectors on it.
+#define VALAR_CPU_HLSL_STACK_SIZE (32 * 1024)
+
+// C++ side of the bindings of ValarBindings.hlsli. The shaders are included into the body of a struct, their
+// resources, root constants and groupshared arrays become members of it.
+#define VALAR_HLSL_EMULATION
+#define VALAR_REGISTER(slot)
+#define VALAR_REGISTER_SPACE(slot, space)
+#define VALAR_SEMANTIC(semantic)
+#define VALAR_ROOT_SIGNATURE(rootSignature)
+#define VALAR_NUM_THREADS(x, y, z) enum { kNumThreadsX = (x), kNumThreadsY = (y), kNumThreadsZ = (z) };
+#define VALAR_CBUFFER_BEGIN(name, slot)
+#define VALAR_CBUFFER_END
+#define VALAR_GROUPSHARED(type, name, dimensions) Intel::HLSL::GroupShared<type dimensions> name
+#define VALAR_STATIC
+// Entry points do not use every system value.
+#define VALAR_UNUSED(x) (void)(x)
+
+// Wave intrinsics pass their line, lanes waiting at different lines are in different operations.
+#define WaveActiveSum(value) Intel::HLSL::WaveActiveSumAt((value), __LINE__)
+#define WaveActiveMin(value) Intel::HLSL::WaveActiveMinAt((value), __LINE__)
+#define WaveIsFirstLane() Intel::HLSL::WaveIsFirstLaneAt(__LINE__)
+
+namespace Intel
+{
+    struct VALAR_CPU_DESCRIPTOR_OPAQUE;
+
+    // CPU emulation of the HLSL used by the VALAR shaders. Every lane of a thread group runs on its own fiber and
+    // returns to the scheduler at GroupMemoryBarrierWithGroupSync and at the wave intrinsics, which complete once
+    // all lanes of the group wait. The lanes of a wave are WaveGetLaneCount consecutive SV_GroupIndex values, the
+    // active lanes of a wave intrinsic are the lanes of the wave waiting at its line. Static globals are shared by
+    // the lanes instead of per thread, the emulated shaders only use static const ones.
+    namespace HLSL
+    {
+        typedef uint32_t uint;
+
+        template <typename T, uint32_t N>
+        struct VectorComponents;
+
+        template <typename T>
+        struct VectorComponents<T, 2>
+        {
+            T x;
+            T y;
+
+            T& operator[](uint32_t i) { return (i == 0) ? x : y; }
+            const T& operator[](uint32_t i) const { return (i == 0) ? x : y; }
+        };
+
+        template <typename T>
+        struct VectorComponents<T, 3>
+        {
+            T x;
+            T y;
+            T z;
+
+            T& operator[](uint32_t i) { return (i == 0) ? x : ((i == 1) ? y : z); }
+            const T& operator[](uint32_t i) const { return (i == 0) ? x : ((i == 1) ? y : z); }
+        };
+
+        template <typename T>
+        struct VectorComponents<T, 4>
+        {
+            T x;
+            T y;
+            T z;
+            T w;
+
+            T& operator[](uint32_t i) { return (i == 0) ? x : ((i == 1) ? y : ((i == 2) ? z : w)); }
+            const T& operator[](uint32_t i) const { return (i == 0) ? x : ((i == 1) ? y : ((i == 2) ? z : w)); }
+        };
+
+        // floatN, intN and uintN. Components are converted like scalars, vectors of another component type convert
+        // implicitly and mixed operands promote to their common type, uint and float to float.
+        template <typename T, uint32_t N>
+        struct Vector : VectorComponents<T, N>
+        {
+            // Uninitialized like an HLSL local.
+            Vector() = default;
+
+            template <typename... C, typename = typename std::enable_if<sizeof...(C) == N>::type>
+            Vector(C... components)
+            {
+                const T values[N] = { static_cast<T>(components)... };
+
+                for (uint32_t i = 0; i < N; i++) {
+                    (*this)[i] = values[i];
+                }
+            }
+
+            template <typename U>
+            Vector(const Vector<U, N>& other)
+            {
+                for (uint32_t i = 0; i < N; i++) {
+                    (*this)[i] = static_cast<T>(other[i]);
+                }
+            }
+
+            Vector<T, 2> xy() const
+            {
+                return Vector<T, 2>(this->x, this->y);
+            }
+        };
+
+        typedef Vector<float, 2> float2;
+        typedef Vector<float, 3> float3;
+        typedef Vector<float, 4> float4;
+        typedef Vector<int32_t, 2> int2;
+        typedef Vector<int32_t, 3> int3;
+        typedef Vector<int32_t, 4> int4;
+        typedef Vector<uint32_t, 2> uint2;
+        typedef Vector<uint32_t, 3> uint3;
+        typedef Vector<uint32_t, 4> uint4;
+
+#define VALAR_HLSL_VECTOR_OPERATOR(op) \
+        template <typename T, typename U, uint32_t N> \
+        Vector<typename std::common_type<T, U>::type, N> operator op(const Vector<T, N>& a, const Vector<U, N>& b) \
+        { \
+            Vector<typename std::common_type<T, U>::type, N> result; \
+            for (uint32_t i = 0; i < N; i++) { \
+                result[i] = a[i] op b[i]; \
+            } \
+            return result; \
+        } \
+        \
+        template <typename T, typename U, uint32_t N, typename = typename std::enable_if<std::is_arithmetic<U>::value>::type> \
+        Vector<typename std::common_type<T, U>::type, N> operator op(const Vector<T, N>& a, U b) \
+        { \
+            Vector<typename std::common_type<T, U>::type, N> result; \
+            for (uint32_t i = 0; i < N; i++) { \
+                result[i] = a[i] op b; \
+            } \
+            return result; \
+        } \
+        \
+        template <typename T, typename U, uint32_t N, typename = typename std::enable_if<std::is_arithmetic<U>::value>::type> \
+        Vector<typename std::common_type<T, U>::type, N> operator op(U a, const Vector<T, N>& b) \
+        { \
+            Vector<typename std::common_type<T, U>::type, N> result; \
+            for (uint32_t i = 0; i < N; i++) { \
+                result[i] = a op b[i]; \
+            } \
+            return result; \
+        }
+
+        VALAR_HLSL_VECTOR_OPERATOR(+)
+        VALAR_HLSL_VECTOR_OPERATOR(-)
+        VALAR_HLSL_VECTOR_OPERATOR(*)
+        VALAR_HLSL_VECTOR_OPERATOR(/)
+
+#undef VALAR_HLSL_VECTOR_OPERATOR
+
+        // Intrinsics. mad is not fused, like the a * b + c of the CPU path, and min / max return the other
+        // operand of a NaN like the GPU. Literals without f suffix are doubles in C++, expressions using them are
+        // evaluated in double and rounded once.
+        inline float abs(float x) { return fabsf(x); }
+        inline int32_t abs(int32_t x) { return (x < 0) ? -x : x; }
+        inline float min(float a, float b) { return fminf(a, b); }
+        inline int32_t min(int32_t a, int32_t b) { return (a < b) ? a : b; }
+        inline uint32_t min(uint32_t a, uint32_t b) { return (a < b) ? a : b; }
+        inline float max(float a, float b) { return fmaxf(a, b); }
+        inline int32_t max(int32_t a, int32_t b) { return (a > b) ? a : b; }
+        inline uint32_t max(uint32_t a, uint32_t b) { return (a > b) ? a : b; }
+        inline float saturate(float x) { return Saturate(x); }
+        inline float sqrt(float x) { return sqrtf(x); }
+        inline float log2(float x) { return log2f(x); }
+        inline float f16tof32(uint32_t x) { return HalfToFloat(x & 0xFFFFu); }
+
+        template <typename A, typename B, typename C>
+        auto mad(A a, B b, C c) -> decltype(a * b + c)
+        {
+            return a * b + c;
+        }
+
+        template <uint32_t N>
+        float dot(const Vector<float, N>& a, const Vector<float, N>& b)
+        {
+            float result = a[0] * b[0];
+
+            for (uint32_t i = 1; i < N; i++) {
+                result += a[i] * b[i];
+            }
+
+            return result;
+        }
+
+        template <uint32_t N>
+        float length(const Vector<float, N>& v)
+        {
+            return sqrtf(dot(v, v));
+        }
+
+        struct VALAR_CPU_HLSL_LANE;
+
+        // Completes a wave intrinsic for the lanes waiting at it, in lane order.
+        typedef void (*VALAR_CPU_HLSL_WAVE_FUNCTION)(VALAR_CPU_HLSL_LANE* const* lanes, uint32_t laneCount);
+        typedef void (*VALAR_CPU_HLSL_ENTRY_FUNCTION)(void* shader, const uint3& groupID, uint32_t groupIndex, const uint3& groupThreadID, const uint3& dispatchThreadID);
+
+        struct VALAR_CPU_HLSL_LANE
+        {
+            // Operand and result of the wave intrinsic the lane waits at, large enough for a float4.
+            alignas(16) uint8_t                 m_waveValue[16];
+            alignas(16) uint8_t                 m_waveResult[16];
+            VALAR_CPU_HLSL_WAVE_FUNCTION        m_waveFunction = nullptr;
+            uint32_t                            m_waveLine = 0;
+            uint32_t                            m_state = 0;
+            uint32_t                            m_groupIndex = 0;
+            uint3                               m_groupThreadID;
+            // Windows fiber or ucontext_t of the lane, and where it resumes once started when switching with jumps.
+            void*                               m_fiber = nullptr;
+            void*                               m_jumpBuffer[5];
+            bool                                m_started = false;
+        };
+
+        // Runs the thread groups of the dispatches of one shader on the calling thread.
+        struct VALAR_CPU_HLSL_EMULATOR
+        {
+            VALAR_CPU_HLSL_LANE*                m_lanes = nullptr;
+            uint32_t                            m_laneCount = 0;
+            uint32_t                            m_waveLaneCount = 0;
+            uint3                               m_numThreads;
+            uint8_t*                            m_stacks = nullptr;
+            void*                               m_contexts = nullptr;
+            void*                               m_schedulerFiber = nullptr;
+            void*                               m_schedulerJumpBuffer[5];
+
+            void*                               m_shader = nullptr;
+            VALAR_CPU_HLSL_ENTRY_FUNCTION       m_entry = nullptr;
+            uint3                               m_groupID;
+            VALAR_CPU_SHADER_EMULATION_STATISTICS m_statistics;
+        };
+
+        VALAR_CPU_HLSL_EMULATOR* CreateHLSLEmulator(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, const uint3& numThreads, uint32_t waveLaneCount);
+        void DestroyHLSLEmulator(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, VALAR_CPU_HLSL_EMULATOR* emulator);
+        void DispatchHLSL(VALAR_CPU_HLSL_EMULATOR* emulator, void* shader, VALAR_CPU_HLSL_ENTRY_FUNCTION entry, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
+        VALAR_CPU_HLSL_LANE& GetCurrentLane();
+        void WaitAtWaveIntrinsic(VALAR_CPU_HLSL_WAVE_FUNCTION function, uint32_t line);
+        void CountOutOfBoundsGroupSharedAccess();
+        void CountOutOfBoundsResourceAccess();
+
+        void GroupMemoryBarrierWithGroupSync();
+        uint32_t WaveGetLaneCount();
+
+        template <typename T>
+        T GetWaveValue(const VALAR_CPU_HLSL_LANE& lane)
+        {
+            T value;
+            memcpy(&value, lane.m_waveValue, sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        void SetWaveResult(VALAR_CPU_HLSL_LANE* const* lanes, uint32_t laneCount, const T& result)
+        {
+            for (uint32_t i = 0; i < laneCount; i++) {
+                memcpy(lanes[i]->m_waveResult, &result, sizeof(T));
+            }
+        }
+
+        template <typename T>
+        void CompleteWaveActiveSum(VALAR_CPU_HLSL_LANE* const* lanes, uint32_t laneCount)
+        {
+            T sum = GetWaveValue<T>(*lanes[0]);
+
+            for (uint32_t i = 1; i < laneCount; i++) {
+                sum = sum + GetWaveValue<T>(*lanes[i]);
+            }
+
+            SetWaveResult(lanes, laneCount, sum);
+        }
+
+        template <typename T>
+        void CompleteWaveActiveMin(VALAR_CPU_HLSL_LANE* const* lanes, uint32_t laneCount)
+        {
+            T minimum = GetWaveValue<T>(*lanes[0]);
+
+            for (uint32_t i = 1; i < laneCount; i++) {
+                minimum = min(minimum, GetWaveValue<T>(*lanes[i]));
+            }
+
+            SetWaveResult(lanes, laneCount, minimum);
+        }
+
+        inline void CompleteWaveIsFirstLane(VALAR_CPU_HLSL_LANE* const* lanes, uint32_t laneCount)
+        {
+            for (uint32_t i = 0; i < laneCount; i++) {
+                lanes[i]->m_waveResult[0] = (i == 0) ? 1 : 0;
+            }
+        }
+
+        template <typename T>
+        T ExecuteWaveIntrinsic(T value, uint32_t line, VALAR_CPU_HLSL_WAVE_FUNCTION function)
+        {
+            static_assert(sizeof(T) <= sizeof(VALAR_CPU_HLSL_LANE::m_waveValue) && std::is_trivially_copyable<T>::value,
+                "Wave intrinsic operand too large");
+
+            VALAR_CPU_HLSL_LANE& lane = GetCurrentLane();
+            memcpy(lane.m_waveValue, &value, sizeof(T));
+
+            WaitAtWaveIntrinsic(function, line);
+
+            T result;
+            memcpy(&result, lane.m_waveResult, sizeof(T));
+            return result;
+        }
+
+        template <typename T>
+        T WaveActiveSumAt(T value, uint32_t line)
+        {
+            return ExecuteWaveIntrinsic(value, line, &CompleteWaveActiveSum<T>);
+        }
+
+        template <typename T>
+        T WaveActiveMinAt(T value, uint32_t line)
+        {
+            return ExecuteWaveIntrinsic(value, line, &CompleteWaveActiveMin<T>);
+        }
+
+        inline bool WaveIsFirstLaneAt(uint32_t line)
+        {
+            WaitAtWaveIntrinsic(&CompleteWaveIsFirstLane, line);
+            return GetCurrentLane().m_waveResult[0] != 0;
+        }
+
+        // groupshared T name[N] and T name[N][M]. Indices are 32-bit like on the GPU and a 2D access addresses the
+        // flat element i * M + j. Accesses with an index out of its dimension are counted, accesses outside of the
+        // array read zero and drop their stores.
+        template <typename A>
+        class GroupShared;
+
+        template <typename T, size_t N>
+        class GroupShared<T[N]>
+        {
+        public:
+            T& operator[](uint32_t i)
+            {
+                if (i >= N) {
+                    CountOutOfBoundsGroupSharedAccess();
+                    m_outside = T();
+                    return m_outside;
+                }
+
+                return m_elements[i];
+            }
+
+        private:
+            T                                   m_elements[N] = {};
+            T                                   m_outside = {};
+        };
+
+        template <typename T, size_t N, size_t M>
+        class GroupShared<T[N][M]>
+        {
+        public:
+            class Row
+            {
+            public:
+                Row(GroupShared& array, uint32_t i) : m_array(array), m_i(i) {}
+
+                T& operator[](uint32_t j) const
+                {
+                    return m_array.GetElement(m_i, j);
+                }
+
+            private:
+                GroupShared&                    m_array;
+                uint32_t                        m_i;
+            };
+
+            Row operator[](uint32_t i)
+            {
+                return Row(*this, i);
+            }
+
+            T& GetElement(uint32_t i, uint32_t j)
+            {
+                const uint32_t index = i * (uint32_t)M + j;
+
+                if (i >= N || j >= M) {
+                    CountOutOfBoundsGroupSharedAccess();
+                }
+
+                if (index >= N * M) {
+                    m_outside = T();
+                    return m_outside;
+                }
+
+                return m_elements[index];
+            }
+
+        private:
+            T                                   m_elements[N * M] = {};
+            T                                   m_outside = {};
+        };
+
+        // RWTexture2D<T> bound to CPU memory, texels are converted by the load and store functions of the format.
+        // Out of bounds loads return zero and out of bounds stores are dropped like on the GPU, both are counted.
+        // A texture without store function is read only, its stores are dropped.
+        template <typename T>
+        class RWTexture2D
+        {
+        public:
+            typedef T (*LOAD_FUNCTION)(const uint8_t* texel);
+            typedef void (*STORE_FUNCTION)(uint8_t* texel, const T& value);
+
+            class Texel
+            {
+            public:
+                Texel(const RWTexture2D& texture, uint8_t* texel) : m_texture(texture), m_texel(texel) {}
+
+                operator T() const
+                {
+                    return (m_texel != nullptr) ? m_texture.m_load(m_texel) : T();
+                }
+
+                const Texel& operator=(const T& value) const
+                {
+                    if (m_texel != nullptr && m_texture.m_store != nullptr) {
+                        m_texture.m_store(m_texel, value);
+                    }
+
+                    return *this;
+                }
+
+                template <typename U = T>
+                auto xy() const -> decltype(std::declval<U>().xy())
+                {
+                    return static_cast<T>(*this).xy();
+                }
+
+            private:
+                const RWTexture2D&              m_texture;
+                uint8_t*                        m_texel;
+            };
+
+            void Bind(const void* data, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t texelSize, LOAD_FUNCTION load, STORE_FUNCTION store)
+            {
+                m_data = (uint8_t*)data;
+                m_width = width;
+                m_height = height;
+                m_rowPitch = rowPitch;
+                m_texelSize = texelSize;
+                m_load = load;
+                m_store = store;
+            }
+
+            Texel operator[](const uint2& coord) const
+            {
+                if (m_data == nullptr || coord.x >= m_width || coord.y >= m_height) {
+                    CountOutOfBoundsResourceAccess();
+                    return Texel(*this, nullptr);
+                }
+
+                return Texel(*this, m_data + (size_t)coord.y * m_rowPitch + (size_t)coord.x * m_texelSize);
+            }
+
+        private:
+            uint8_t*                            m_data = nullptr;
+            uint32_t                            m_width = 0;
+            uint32_t                            m_height = 0;
+            uint32_t                            m_rowPitch = 0;
+            uint32_t                            m_texelSize = 0;
+            LOAD_FUNCTION                       m_load = nullptr;
+            STORE_FUNCTION                      m_store = nullptr;
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,636 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUHLSL.h"
+
+// VRSCommon.hlsli defines the limits of <cstdint> with other values, and swizzles are member functions.
+#pragma push_macro("UINT16_MAX")
+#pragma push_macro("UINT32_MAX")
+#undef UINT16_MAX
+#undef UINT32_MAX
+#define xy xy()
+
+namespace Intel
+{
+    namespace HLSL
+    {
+        // The shipped shaders, one struct per permutation. Batched permutations are not emulated.
+        struct Valar8x8CS
+        {
+#include "Valar8x8CS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8LumaCS
+        {
+#include "Valar8x8LumaCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8WFCS
+        {
+#include "Valar8x8WFCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8VelocityCS
+        {
+#include "Valar8x8VelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8WFVelocityCS
+        {
+#include "Valar8x8WFVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8UpscaledVelocityCS
+        {
+#include "Valar8x8UpscaledVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8WFUpscaledVelocityCS
+        {
+#include "Valar8x8WFUpscaledVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar8x8AmortizedCS
+        {
+#include "Valar8x8AmortizedCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16CS
+        {
+#include "Valar16x16CS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16LumaCS
+        {
+#include "Valar16x16LumaCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16WFCS
+        {
+#include "Valar16x16WFCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16VelocityCS
+        {
+#include "Valar16x16VelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16WFVelocityCS
+        {
+#include "Valar16x16WFVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16UpscaledVelocityCS
+        {
+#include "Valar16x16UpscaledVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16WFUpscaledVelocityCS
+        {
+#include "Valar16x16WFUpscaledVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar16x16AmortizedCS
+        {
+#include "Valar16x16AmortizedCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32CS
+        {
+#include "Valar32x32CS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32LumaCS
+        {
+#include "Valar32x32LumaCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32WFCS
+        {
+#include "Valar32x32WFCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32VelocityCS
+        {
+#include "Valar32x32VelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32WFVelocityCS
+        {
+#include "Valar32x32WFVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32UpscaledVelocityCS
+        {
+#include "Valar32x32UpscaledVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32WFUpscaledVelocityCS
+        {
+#include "Valar32x32WFUpscaledVelocityCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct Valar32x32AmortizedCS
+        {
+#include "Valar32x32AmortizedCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct ValarLPCS
+        {
+#include "ValarLPCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+
+        struct ValarDebugCS
+        {
+#include "ValarDebugCS.hlsl"
+#include "VALARCPUHLSLUndef.h"
+        };
+    }
+}
+
+#undef xy
+#pragma pop_macro("UINT32_MAX")
+#pragma pop_macro("UINT16_MAX")
+
+// FillShadingRate of the dispatches computing the mask, COMPUTE_SHADING_RATE of ValarCS.hlsli.
+#define VALAR_CPU_HLSL_COMPUTE_SHADING_RATE 0xFFFFFFFF
+
+typedef Intel::VALAR_RETURN_CODE (*VALAR_CPU_EMULATED_SHADER_FUNCTION)(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation);
+
+// Typed loads of the color formats, the sRGB formats are read through a UNORM view like on the GPU.
+static Intel::HLSL::float4 LoadColorR32G32B32A32Float(const uint8_t* texel)
+{
+    float color[4];
+    memcpy(color, texel, sizeof(color));
+
+    return Intel::HLSL::float4(color[0], color[1], color[2], color[3]);
+}
+
+static Intel::HLSL::float4 LoadColorR8G8B8A8UNORM(const uint8_t* texel)
+{
+    return Intel::HLSL::float4(texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f, texel[3] / 255.0f);
+}
+
+static Intel::HLSL::float4 LoadColorB8G8R8A8UNORM(const uint8_t* texel)
+{
+    return Intel::HLSL::float4(texel[2] / 255.0f, texel[1] / 255.0f, texel[0] / 255.0f, texel[3] / 255.0f);
+}
+
+static Intel::HLSL::float4 LoadColorR10G10B10A2UNORM(const uint8_t* texel)
+{
+    uint32_t pixel;
+    memcpy(&pixel, texel, sizeof(pixel));
+
+    return Intel::HLSL::float4((pixel & 0x3FF) / 1023.0f, ((pixel >> 10) & 0x3FF) / 1023.0f, ((pixel >> 20) & 0x3FF) / 1023.0f, (pixel >> 30) / 3.0f);
+}
+
+static Intel::HLSL::float4 LoadColorR11G11B10Float(const uint8_t* texel)
+{
+    uint32_t pixel;
+    memcpy(&pixel, texel, sizeof(pixel));
+
+    return Intel::HLSL::float4(Intel::HalfToFloat((pixel & 0x7FF) << 4), Intel::HalfToFloat(((pixel >> 11) & 0x7FF) << 4),
+        Intel::HalfToFloat((pixel >> 22) << 5), 1.0f);
+}
+
+static Intel::HLSL::float4 LoadColorR16G16B16A16Float(const uint8_t* texel)
+{
+    uint16_t color[4];
+    memcpy(color, texel, sizeof(color));
+
+    return Intel::HLSL::float4(Intel::HalfToFloat(color[0]), Intel::HalfToFloat(color[1]), Intel::HalfToFloat(color[2]), Intel::HalfToFloat(color[3]));
+}
+
+static Intel::HLSL::RWTexture2D<Intel::HLSL::float4>::LOAD_FUNCTION GetColorLoadFunction(Intel::VALAR_CPU_FORMAT colorFormat)
+{
+    switch (colorFormat)
+    {
+    case Intel::VALAR_CPU_FORMAT_R8G8B8A8_UNORM:
+    case Intel::VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB:
+        return LoadColorR8G8B8A8UNORM;
+    case Intel::VALAR_CPU_FORMAT_B8G8R8A8_UNORM:
+    case Intel::VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB:
+        return LoadColorB8G8R8A8UNORM;
+    case Intel::VALAR_CPU_FORMAT_R10G10B10A2_UNORM:
+        return LoadColorR10G10B10A2UNORM;
+    case Intel::VALAR_CPU_FORMAT_R11G11B10_FLOAT:
+        return LoadColorR11G11B10Float;
+    case Intel::VALAR_CPU_FORMAT_R16G16B16A16_FLOAT:
+        return LoadColorR16G16B16A16Float;
+    default:
+        return LoadColorR32G32B32A32Float;
+    }
+}
+
+static Intel::HLSL::float4 LoadFloat4(const uint8_t* texel)
+{
+    return LoadColorR32G32B32A32Float(texel);
+}
+
+static void StoreFloat4(uint8_t* texel, const Intel::HLSL::float4& value)
+{
+    const float color[4] = { value.x, value.y, value.z, value.w };
+    memcpy(texel, color, sizeof(color));
+}
+
+static Intel::HLSL::float2 LoadFloat2(const uint8_t* texel)
+{
+    float velocity[2];
+    memcpy(velocity, texel, sizeof(velocity));
+
+    return Intel::HLSL::float2(velocity[0], velocity[1]);
+}
+
+static uint32_t LoadUINT32(const uint8_t* texel)
+{
+    uint32_t value;
+    memcpy(&value, texel, sizeof(value));
+
+    return value;
+}
+
+// The mask is an R8_UINT texture.
+static uint32_t LoadUINT8(const uint8_t* texel)
+{
+    return *texel;
+}
+
+static void StoreUINT8(uint8_t* texel, const uint32_t& value)
+{
+    *texel = (uint8_t)value;
+}
+
+static void BindShadingRateBuffer(Intel::HLSL::RWTexture2D<uint32_t>& texture, const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+
+    texture.Bind(desc.m_valarBuffer, tilesX, tilesY, Intel::GetValarRowPitch(desc), 1, LoadUINT8, StoreUINT8);
+}
+
+static void BindColorBuffer(Intel::HLSL::RWTexture2D<Intel::HLSL::float4>& texture, const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    const Intel::VALAR_CPU_IMAGE_VIEW colorView = Intel::GetColorView(desc);
+
+    texture.Bind(colorView.m_data, colorView.m_width, colorView.m_height, colorView.m_rowPitch, Intel::GetColorPixelSize(colorView.m_format),
+        GetColorLoadFunction(colorView.m_format), nullptr);
+}
+
+// Only the velocity input of the descriptor is bound, the other one reads zero like an unbound UAV.
+template <typename S>
+static auto BindVelocityBuffers(S& shader, const Intel::VALAR_CPU_DESCRIPTOR& desc, int) -> decltype(shader.VelocityBuffer, void())
+{
+    if (!desc.m_useMotionVectors) {
+        return;
+    }
+
+    if (desc.m_useUpscaleMotionVectors) {
+        const Intel::VALAR_CPU_IMAGE_VIEW velocityView = Intel::GetUpscaledVelocityView(desc);
+        shader.UpscaledVelocityBuffer.Bind(velocityView.m_data, velocityView.m_width, velocityView.m_height, velocityView.m_rowPitch,
+            2 * sizeof(float), LoadFloat2, nullptr);
+    } else {
+        const Intel::VALAR_CPU_IMAGE_VIEW velocityView = Intel::GetVelocityView(desc);
+        shader.VelocityBuffer.Bind(velocityView.m_data, velocityView.m_width, velocityView.m_height, velocityView.m_rowPitch,
+            sizeof(uint32_t), LoadUINT32, nullptr);
+    }
+}
+
+// Permutations without motion vectors declare no velocity buffers.
+template <typename S>
+static void BindVelocityBuffers(S&, const Intel::VALAR_CPU_DESCRIPTOR&, long)
+{
+}
+
+// The root constants shared by the mask and LP shaders, the same values as VALAR_ComputeMask.
+template <typename S>
+static void SetRootConstants(S& shader, const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    shader.TextureSize = Intel::HLSL::uint2(desc.m_bufferWidth, desc.m_bufferHeight);
+    shader.ShadingRateTileSize = desc.m_shadingRateTileSize;
+    shader.SensitivityThreshold = desc.m_sensitivityThreshold;
+    shader.EnvLuma = desc.m_environmentLuminance;
+    shader.K = desc.m_quarterRateShadingModifier;
+    shader.WeberFechnerConstant = desc.m_weberFechnerConstant;
+    shader.UseWeberFechner = desc.m_weberFechnerMode;
+    shader.UseMotionVectors = desc.m_useMotionVectors;
+    shader.AllowQuarterRate = desc.m_allowQuarterRateShading;
+    shader.UpscaledSize = Intel::HLSL::uint2(desc.m_upscaleWidth, desc.m_upscaleHeight);
+    shader.UseUpscaledMotionVectors = desc.m_useUpscaleMotionVectors;
+}
+
+template <typename S>
+static void InvokeShader(void* shader, const Intel::HLSL::uint3& groupID, uint32_t groupIndex, const Intel::HLSL::uint3& groupThreadID,
+    const Intel::HLSL::uint3& dispatchThreadID)
+{
+    ((S*)shader)->main(groupID, groupIndex, groupThreadID, dispatchThreadID);
+}
+
+// Allocates a shader and an emulator for its thread group size, nothing when one of them fails.
+template <typename S>
+static bool CreateEmulatedShader(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, const Intel::VALAR_CPU_SHADER_EMULATION& emulation, S*& shader,
+    Intel::HLSL::VALAR_CPU_HLSL_EMULATOR*& emulator)
+{
+    shader = Intel::AllocateArray<S>(opaque, 1, Intel::VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+    emulator = Intel::HLSL::CreateHLSLEmulator(opaque, Intel::HLSL::uint3(S::kNumThreadsX, S::kNumThreadsY, S::kNumThreadsZ), emulation.m_waveLaneCount);
+
+    if (shader == nullptr || emulator == nullptr) {
+        Intel::HLSL::DestroyHLSLEmulator(opaque, emulator);
+        Intel::FreeArray(opaque, shader, 1, Intel::VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+        return false;
+    }
+
+    return true;
+}
+
+template <typename S>
+static void DestroyEmulatedShader(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, const Intel::VALAR_CPU_SHADER_EMULATION& emulation, S* shader,
+    Intel::HLSL::VALAR_CPU_HLSL_EMULATOR* emulator)
+{
+    if (emulation.m_pStatistics != nullptr) {
+        *emulation.m_pStatistics = emulator->m_statistics;
+    }
+
+    Intel::HLSL::DestroyHLSLEmulator(opaque, emulator);
+    Intel::FreeArray(opaque, shader, 1, Intel::VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION);
+}
+
+// Fills the tiles outside of the regions of interest like VALAR_ComputeMask, with one fill dispatch per gap of
+// each tile row.
+template <typename S>
+static void DispatchOutsideRegionsOfInterest(const Intel::VALAR_CPU_DESCRIPTOR& desc, S& shader, Intel::HLSL::VALAR_CPU_HLSL_EMULATOR* emulator,
+    uint32_t tilesX, uint32_t tilesY)
+{
+    shader.FillShadingRate = desc.m_outsideShadingRate;
+
+    for (uint32_t tileY = 0; tileY < tilesY; tileY++) {
+        for (uint32_t tileX = 0; tileX < tilesX;) {
+            uint32_t spanBegin;
+            uint32_t spanEnd;
+
+            if (!Intel::FindRegionOfInterestSpan(desc, tileY, tileX, spanBegin, spanEnd)) {
+                spanBegin = tilesX;
+                spanEnd = tilesX;
+            }
+
+            if (spanBegin > tileX) {
+                shader.TileOffset = Intel::HLSL::uint2(tileX, tileY);
+                Intel::HLSL::DispatchHLSL(emulator, &shader, InvokeShader<S>, spanBegin - tileX, 1, 1);
+            }
+
+            tileX = spanEnd;
+        }
+    }
+
+    shader.FillShadingRate = VALAR_CPU_HLSL_COMPUTE_SHADING_RATE;
+}
+
+template <typename S>
+static Intel::VALAR_RETURN_CODE ComputeMaskEmulated(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation)
+{
+    Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque = *desc.m_pOpaque;
+    S* shader;
+    Intel::HLSL::VALAR_CPU_HLSL_EMULATOR* emulator;
+
+    if (!CreateEmulatedShader(opaque, emulation, shader, emulator)) {
+        return Intel::VALAR_RETURN_CODE_OUT_OF_MEMORY;
+    }
+
+    SetRootConstants(*shader, desc);
+    shader->FrameIndex = desc.m_frameIndex;
+    shader->AmortizationPeriod = desc.m_amortizationPeriod;
+    shader->AmortizationVelocityBound = desc.m_amortizationVelocityBound;
+    shader->TileOffset = Intel::HLSL::uint2(0, 0);
+    shader->FillShadingRate = VALAR_CPU_HLSL_COMPUTE_SHADING_RATE;
+
+    BindShadingRateBuffer(shader->VRSShadingRateBuffer, desc);
+    BindColorBuffer(shader->ColorBuffer, desc);
+    BindVelocityBuffers(*shader, desc, 0);
+
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+
+    if (desc.m_regionOfInterestCount == 0) {
+        Intel::HLSL::DispatchHLSL(emulator, shader, InvokeShader<S>, tilesX, tilesY, 1);
+    } else {
+        DispatchOutsideRegionsOfInterest(desc, *shader, emulator, tilesX, tilesY);
+
+        for (uint32_t i = 0; i < desc.m_regionOfInterestCount; i++) {
+            const Intel::VALAR_CPU_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+            if (tileRect.m_left == tileRect.m_right || tileRect.m_top == tileRect.m_bottom) {
+                continue;
+            }
+
+            shader->TileOffset = Intel::HLSL::uint2(tileRect.m_left, tileRect.m_top);
+            Intel::HLSL::DispatchHLSL(emulator, shader, InvokeShader<S>, tileRect.m_right - tileRect.m_left, tileRect.m_bottom - tileRect.m_top, 1);
+        }
+    }
+
+    DestroyEmulatedShader(opaque, emulation, shader, emulator);
+
+    return Intel::VALAR_RETURN_CODE_SUCCESS;
+}
+
+// Same choice as GetValarPipelineState, the specialized permutations are indexed by VALAR_CPU_KERNEL_MODE.
+static VALAR_CPU_EMULATED_SHADER_FUNCTION GetEmulatedValarShader(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation)
+{
+    static const VALAR_CPU_EMULATED_SHADER_FUNCTION kGenericShaders[VALAR_CPU_TILE_SIZE_COUNT] =
+    {
+        ComputeMaskEmulated<Intel::HLSL::Valar8x8CS>,
+        ComputeMaskEmulated<Intel::HLSL::Valar16x16CS>,
+        ComputeMaskEmulated<Intel::HLSL::Valar32x32CS>
+    };
+
+    static const VALAR_CPU_EMULATED_SHADER_FUNCTION kAmortizedShaders[VALAR_CPU_TILE_SIZE_COUNT] =
+    {
+        ComputeMaskEmulated<Intel::HLSL::Valar8x8AmortizedCS>,
+        ComputeMaskEmulated<Intel::HLSL::Valar16x16AmortizedCS>,
+        ComputeMaskEmulated<Intel::HLSL::Valar32x32AmortizedCS>
+    };
+
+    static const VALAR_CPU_EMULATED_SHADER_FUNCTION kSpecializedShaders[VALAR_CPU_TILE_SIZE_COUNT][VALAR_CPU_KERNEL_MODE_COUNT] =
+    {
+        {
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8LumaCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8WFCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8VelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8WFVelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8LumaCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8WFCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8UpscaledVelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar8x8WFUpscaledVelocityCS>
+        },
+        {
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16LumaCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16WFCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16VelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16WFVelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16LumaCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16WFCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16UpscaledVelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar16x16WFUpscaledVelocityCS>
+        },
+        {
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32LumaCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32WFCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32VelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32WFVelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32LumaCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32WFCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32UpscaledVelocityCS>,
+            ComputeMaskEmulated<Intel::HLSL::Valar32x32WFUpscaledVelocityCS>
+        }
+    };
+
+    const uint32_t tileSizeIndex = Intel::GetTileSizeIndex(desc.m_shadingRateTileSize);
+
+    // The amortized shader reads the modes from the root constants.
+    if (desc.m_amortizationPeriod > 1) {
+        return kAmortizedShaders[tileSizeIndex];
+    }
+
+    if (emulation.m_genericShader) {
+        return kGenericShaders[tileSizeIndex];
+    }
+
+    return kSpecializedShaders[tileSizeIndex][Intel::GetTileKernelMode(desc)];
+}
+
+static Intel::VALAR_RETURN_CODE ValidateShaderEmulation(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation)
+{
+    const uint32_t waveLaneCount = emulation.m_waveLaneCount;
+
+    if (waveLaneCount < VALAR_CPU_MIN_WAVE_LANE_COUNT || waveLaneCount > VALAR_CPU_MAX_WAVE_LANE_COUNT || (waveLaneCount & (waveLaneCount - 1)) != 0) {
+        return Intel::VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    return Intel::ValidateCPUDescriptor(desc);
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskEmulatedCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation)
+{
+    VALAR_RETURN_CODE retCode = ValidateShaderEmulation(desc, emulation);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+        return retCode;
+    }
+
+    if (desc.m_enabled) {
+        retCode = GetEmulatedValarShader(desc, emulation)(desc, emulation);
+    }
+
+    return retCode;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskLPEmulatedCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation)
+{
+    VALAR_RETURN_CODE retCode = ValidateShaderEmulation(desc, emulation);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS || !desc.m_enabled) {
+        return retCode;
+    }
+
+    HLSL::ValarLPCS* shader;
+    HLSL::VALAR_CPU_HLSL_EMULATOR* emulator;
+
+    if (!CreateEmulatedShader(*desc.m_pOpaque, emulation, shader, emulator)) {
+        return VALAR_RETURN_CODE_OUT_OF_MEMORY;
+    }
+
+    SetRootConstants(*shader, desc);
+    BindShadingRateBuffer(shader->VRSShadingRateBuffer, desc);
+    BindColorBuffer(shader->ColorBuffer, desc);
+    BindVelocityBuffers(*shader, desc, 0);
+
+    // One thread per tile in groups of 8x8 tiles, the threads past the last tile store out of bounds.
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+
+    HLSL::DispatchHLSL(emulator, shader, InvokeShader<HLSL::ValarLPCS>, (tilesX + 7) / 8, (tilesY + 7) / 8, 1);
+
+    DestroyEmulatedShader(*desc.m_pOpaque, emulation, shader, emulator);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_DebugOverlayEmulatedCPU(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_SHADER_EMULATION& emulation)
+{
+    VALAR_RETURN_CODE retCode = ValidateShaderEmulation(desc, emulation);
+    if (retCode != VALAR_RETURN_CODE_SUCCESS || !desc.m_enabled) {
+        return retCode;
+    }
+
+    if (emulation.m_overlayBuffer == nullptr || desc.m_upscaleWidth == 0 || desc.m_upscaleHeight == 0) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    HLSL::ValarDebugCS* shader;
+    HLSL::VALAR_CPU_HLSL_EMULATOR* emulator;
+
+    if (!CreateEmulatedShader(*desc.m_pOpaque, emulation, shader, emulator)) {
+        return VALAR_RETURN_CODE_OUT_OF_MEMORY;
+    }
+
+    shader->NativeWidth = desc.m_bufferWidth;
+    shader->NativeHeight = desc.m_bufferHeight;
+    shader->UpscaledWidth = desc.m_upscaleWidth;
+    shader->UpscaledHeight = desc.m_upscaleHeight;
+    shader->ShadingRateTileSize = desc.m_shadingRateTileSize;
+    shader->DrawGrid = emulation.m_debugGrid;
+
+    BindShadingRateBuffer(shader->VRSShadingRateBuffer, desc);
+    shader->ColorBuffer.Bind(emulation.m_overlayBuffer, desc.m_upscaleWidth, desc.m_upscaleHeight, desc.m_upscaleWidth * 4 * sizeof(float),
+        4 * sizeof(float), LoadFloat4, StoreFloat4);
+
+    // One group of one thread per upscaled pixel, like VALAR_DebugOverlay.
+    HLSL::DispatchHLSL(emulator, shader, InvokeShader<HLSL::ValarDebugCS>, desc.m_upscaleWidth, desc.m_upscaleHeight, 1);
+
+    DestroyEmulatedShader(*desc.m_pOpaque, emulation, shader, emulator);
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
\ No newline at end of file
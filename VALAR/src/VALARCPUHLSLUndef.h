@@ -0,0 +1,52 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Included by VALARCPUHLSLShaders.cpp after every emulated shader, so the next one is preprocessed like its own
+// compilation unit. Lists every macro of the shaders and their permutations, no include guard.
+#undef TILE_SIZE
+#undef NUM_THREADS
+#undef VALAR_STATIC_MODE
+#undef VALAR_AMORTIZED
+#undef VALAR_BATCHED
+
+#undef UINT16_MAX
+#undef UINT32_MAX
+#undef D3D12_SHADING_RATE_X_AXIS_SHIFT
+#undef D3D12_SHADING_RATE_VALID_MASK
+#undef D3D12_MAKE_COARSE_SHADING_RATE
+#undef D3D12_GET_COARSE_SHADING_RATE_X_AXIS
+#undef D3D12_GET_COARSE_SHADING_RATE_Y_AXIS
+#undef VALAR_MAX_BATCH_VIEW_COUNT
+#undef VRSShadingRateBuffer
+
+#undef VRS_RootSig
+#undef COMPUTE_SHADING_RATE
+#undef VALAR_MODE_WEBER_FECHNER
+#undef VALAR_MODE_MOTION_VECTORS
+#undef VALAR_MODE_UPSCALED_MOTION_VECTORS
+#undef USE_VELOCITY
+#undef USE_WEBER_FECHNER
+#undef WEBER_FECHNER_ENABLED
+#undef MOTION_VECTORS_ENABLED
+#undef UPSCALED_MOTION_VECTORS_ENABLED
+#undef ColorBuffer
+#undef VelocityBuffer
+#undef UpscaledVelocityBuffer
+#undef AMORTIZATION_GROUP_WIDTH
\ No newline at end of file
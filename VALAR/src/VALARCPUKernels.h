@@ -0,0 +1,498 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+// Generic fused SIMD kernel shared by the per instruction set translation units. Each of
+// VALARCPUKernelsScalar.cpp, VALARCPUKernelsSSE41.cpp, VALARCPUKernelsAVX2.cpp,
+// VALARCPUKernelsAVX512.cpp and VALARCPUKernelsNEON.cpp defines a small vector wrapper and
+// instantiates the kernel with it and every color format loader of VALARCPULoaders.h while compiling
+// for that instruction set. The kernel lives in an anonymous namespace so every translation unit
+// keeps its own copy and no ISA specific code can leak into another one.
+//
+// A vector wrapper V provides:
+//   kWidth                              number of float lanes
+//   Float                               float vector type
+//   Set1, Load, Store                   broadcast and unaligned load / store
+//   Add, Sub, Mul, Div, Min, Max, Abs   lane-wise arithmetic
+//   PairwiseAdd(a, b)                   sums of the adjacent lanes 2i and 2i + 1 of a, then of b
+//   Luma(color)                         luminance of kWidth consecutive RGBA32F pixels
+//   PackedVelocityLength(velocity)      length of kWidth consecutive packed R32_UINT velocities
+//   Int                                 int32 vector type with kWidth lanes
+//   Set1Int, LoadInt, StoreInt          broadcast and unaligned load / store
+//   LoadDeinterleavedInt(p, even, odd)  unaligned load of 2 * kWidth int32, split into even and odd elements
+//   AddInt, MulInt, AbsDiffInt, AndInt  lane-wise arithmetic, add and multiply wrap around in 32 bits
+//   SquareInt                           lane-wise square of values below 2^15
+//   ShiftLeftInt<n>, ShiftRightInt<n>   lane-wise logical shifts
+//   IntToFloat                          lane-wise conversion of values below 2^24
+//   HalfToFloat                         lane-wise f16tof32 of the low 16 bits, the upper 16 bits have to be zero
+
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARCPULoaders.h"
+
+namespace Intel
+{
+    namespace
+    {
+        // Converts one row of the span to luminance. dst[-1] receives the pixel left of the span and
+        // rows or columns outside of the color buffer are zero, the same as out of bounds UAV loads.
+        template <typename V, typename L>
+        void ConvertLuminanceRow(const VALAR_CPU_DESCRIPTOR& desc, int32_t y, uint32_t spanX, uint32_t spanWidth, uint32_t colorWidth, float* dst)
+        {
+            if (y < 0 || (uint32_t)y >= desc.m_bufferHeight) {
+                memset(dst - 1, 0, (1 + spanWidth + VALAR_CPU_LINE_PADDING) * sizeof(float));
+                return;
+            }
+
+            const VALAR_CPU_IMAGE_VIEW colorView = GetColorView(desc);
+            const uint8_t* color = GetImageRow(colorView, (uint32_t)y) + (size_t)spanX * L::kPixelSize;
+            const float* linear = GetUNORM8Table(colorView.m_format).m_linear;
+
+            dst[-1] = (spanX > 0) ? L::LumaScalar(color - L::kPixelSize, linear) : 0.0f;
+
+            uint32_t x = 0;
+            for (; x + V::kWidth <= colorWidth; x += V::kWidth) {
+                V::Store(dst + x, L::Luma(color + (size_t)x * L::kPixelSize, linear));
+            }
+            for (; x < colorWidth; x++) {
+                dst[x] = L::LumaScalar(color + (size_t)x * L::kPixelSize, linear);
+            }
+
+            memset(dst + colorWidth, 0, (spanWidth - colorWidth + VALAR_CPU_LINE_PADDING) * sizeof(float));
+        }
+
+        // Folds the velocity length of one row of the span into the per column minimum.
+        template <typename V, bool kUpscaled>
+        void AccumulateVelocityRow(const VALAR_CPU_DESCRIPTOR& desc, int32_t y, uint32_t spanX, uint32_t spanWidth, uint32_t colorWidth, float* velocityMin)
+        {
+            if (kUpscaled) {
+                // Upscaled velocity is addressed through a float scale per pixel, fetched as in the reference.
+                const VALAR_CPU_IMAGE_VIEW velocityView = GetUpscaledVelocityView(desc);
+
+                for (uint32_t x = 0; x < spanWidth; x++) {
+                    velocityMin[x] = fminf(velocityMin[x], FetchUpscaledVelocity(desc, velocityView, spanX + x, (uint32_t)y));
+                }
+                return;
+            }
+
+            uint32_t x = 0;
+
+            if ((uint32_t)y < desc.m_bufferHeight) {
+                const VALAR_CPU_IMAGE_VIEW velocityView = GetVelocityView(desc);
+                const uint32_t* velocity = (const uint32_t*)GetImageRow(velocityView, (uint32_t)y) + spanX;
+
+                for (; x + V::kWidth <= colorWidth; x += V::kWidth) {
+                    V::Store(velocityMin + x, V::Min(V::Load(velocityMin + x), V::PackedVelocityLength(velocity + x)));
+                }
+                for (; x < colorWidth; x++) {
+                    velocityMin[x] = fminf(velocityMin[x], PackedVelocityLength(velocity[x]));
+                }
+            }
+
+            // Out of bounds velocity loads return zero.
+            for (; x < spanWidth; x++) {
+                velocityMin[x] = 0.0f;
+            }
+        }
+
+        // Fixed order reduction of one per pixel term of a span to its tile sums, see SumTilePairwise. Rows are
+        // written to GetRow and added one after the other. Level l holds the row of 2^l x 2^l block sums waiting for
+        // the row below it, which starts at 2 * VALAR_CPU_SPAN_WIDTH - 2 * (VALAR_CPU_SPAN_WIDTH >> l) plus the
+        // padding of the levels above. Every add sees the same two operands for all vector widths.
+        template <typename V, uint32_t kTileSize>
+        struct VALAR_CPU_PAIRWISE_SUM
+        {
+            static const uint32_t kLevelCount = (kTileSize == INTEL_TILE_SIZE) ? 3 : ((kTileSize == OTHER_TILE_SIZE) ? 4 : 5);
+
+            alignas(64) float       m_pending[2 * VALAR_CPU_SPAN_WIDTH + kLevelCount * VALAR_CPU_LINE_PADDING];
+            // Second row of the pair of a level, combined in place.
+            alignas(64) float       m_second[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+            alignas(64) float       m_sums[VALAR_CPU_SPAN_WIDTH / kTileSize + VALAR_CPU_LINE_PADDING];
+
+            void Clear()
+            {
+                // The padding lanes are reduced along with the row, zero keeps them finite.
+                memset(this, 0, sizeof(*this));
+            }
+
+            float* GetPendingRow(uint32_t level)
+            {
+                return m_pending + 2 * VALAR_CPU_SPAN_WIDTH - 2 * (VALAR_CPU_SPAN_WIDTH >> level) + level * VALAR_CPU_LINE_PADDING;
+            }
+
+            float* GetRow(uint32_t row)
+            {
+                return (row & 1) ? m_second : GetPendingRow(0);
+            }
+
+            void AddRow(uint32_t row, uint32_t spanWidth)
+            {
+                if ((row & 1) == 0) {
+                    return;
+                }
+
+                // Each level adds the rows of a pair, then the columns of a pair. The output is the pending row
+                // of the next level, or its second row that is reduced right away.
+                uint32_t width = spanWidth;
+
+                for (uint32_t level = 0; level < kLevelCount; level++) {
+                    const bool isLastLevel = (level + 1 == kLevelCount);
+                    const bool isSecondRow = (((row + 1) >> (level + 1)) & 1) == 0;
+                    const float* pending = GetPendingRow(level);
+                    float* output = isLastLevel ? m_sums : (isSecondRow ? m_second : GetPendingRow(level + 1));
+
+                    for (uint32_t x = 0; x < width; x += 2 * V::kWidth) {
+                        const typename V::Float low = V::Add(V::Load(pending + x), V::Load(m_second + x));
+                        const typename V::Float high = V::Add(V::Load(pending + x + V::kWidth), V::Load(m_second + x + V::kWidth));
+
+                        V::Store(output + x / 2, V::PairwiseAdd(low, high));
+                    }
+
+                    if (!isSecondRow) {
+                        return;
+                    }
+
+                    width /= 2;
+                }
+            }
+        };
+
+        // Computes the statistics of the tiles [tileXBegin, tileXEnd) of one tile row in a single sweep over
+        // the color rows. Only three luminance line buffers are live, and the per pixel terms of every row are
+        // reduced to tile sums in the fixed order of VALAR_CPU_PAIRWISE_SUM, so all vector widths produce identical
+        // sums. kMode holds the VALAR_CPU_KERNEL_MODE flags, the work of the disabled modes is compiled out. The row
+        // and column loops run kTileSize times and unroll per tile size.
+        template <typename V, typename L, uint32_t kTileSize, uint32_t kMode>
+        void ComputeTileSpanStatisticsSIMD(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, VALAR_TILE_STATISTICS* stats)
+        {
+            typedef typename V::Float VF;
+
+            const uint32_t tileSize = kTileSize;
+            const uint32_t spanX = tileXBegin * tileSize;
+            const uint32_t spanWidth = (tileXEnd - tileXBegin) * tileSize;
+            const uint32_t colorWidth = (spanX + spanWidth <= desc.m_bufferWidth) ? spanWidth :
+                ((desc.m_bufferWidth > spanX) ? desc.m_bufferWidth - spanX : 0);
+            const int32_t baseY = (int32_t)(tileY * tileSize);
+
+            alignas(64) float lumaRows[3][1 + VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+            VALAR_CPU_PAIRWISE_SUM<V, kTileSize> lumaSum;
+            VALAR_CPU_PAIRWISE_SUM<V, kTileSize> lumaSumX;
+            VALAR_CPU_PAIRWISE_SUM<V, kTileSize> lumaSumY;
+            alignas(64) float velocityMin[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+
+            float* above = lumaRows[0] + 1;
+            float* current = lumaRows[1] + 1;
+            float* below = lumaRows[2] + 1;
+
+            ConvertLuminanceRow<V, L>(desc, baseY - 1, spanX, spanWidth, colorWidth, above);
+            ConvertLuminanceRow<V, L>(desc, baseY, spanX, spanWidth, colorWidth, current);
+
+            lumaSum.Clear();
+            lumaSumX.Clear();
+            lumaSumY.Clear();
+
+            if (kMode & VALAR_CPU_KERNEL_MODE_MOTION_VECTORS) {
+                for (uint32_t x = 0; x < spanWidth; x++) {
+                    velocityMin[x] = 10000.0f;
+                }
+            }
+
+            const VALAR_CPU_COLUMN_MASKS& masks = GetColumnMasks(tileSize);
+            const VF half = V::Set1(0.5f);
+            const VF weberFechnerConstant = V::Set1(desc.m_weberFechnerConstant);
+
+            for (uint32_t row = 0; row < tileSize; row++) {
+                const int32_t y = baseY + (int32_t)row;
+                float* rowLuma = lumaSum.GetRow(row);
+                float* rowLumaX = lumaSumX.GetRow(row);
+                float* rowLumaY = lumaSumY.GetRow(row);
+
+                if (kMode & VALAR_CPU_KERNEL_MODE_WEBER_FECHNER) {
+                    if (row + 1 < tileSize) {
+                        ConvertLuminanceRow<V, L>(desc, y + 1, spanX, spanWidth, colorWidth, below);
+                    }
+
+                    // Rows outside of the tile read the 10000 sentinel and drop out of the minimum,
+                    // the column masks do the same for the left and right tile borders.
+                    const float* minAbove = (row == 0) ? masks.m_sentinel + 1 : above;
+                    const float* minBelow = (row + 1 == tileSize) ? masks.m_sentinel + 1 : below;
+
+                    for (uint32_t x = 0; x < spanWidth; x += V::kWidth) {
+                        const VF pixelLuma = V::Load(current + x);
+                        const VF pixelLumaXMinusOne = V::Load(current + x - 1);
+                        const VF pixelLumaYMinusOne = V::Load(above + x);
+                        const VF leftMask = V::Load(masks.m_left + x);
+                        const VF rightMask = V::Load(masks.m_right + x);
+
+                        // Same neighbor set as ComputeMinNeighborLuminance: N, NE, E, SE, S, SW, NW.
+                        VF minNeighborLuma = V::Min(V::Load(minAbove + x), V::Load(minBelow + x));
+                        minNeighborLuma = V::Min(minNeighborLuma, V::Max(V::Load(minAbove + x + 1), rightMask));
+                        minNeighborLuma = V::Min(minNeighborLuma, V::Max(V::Load(current + x + 1), rightMask));
+                        minNeighborLuma = V::Min(minNeighborLuma, V::Max(V::Load(minBelow + x + 1), rightMask));
+                        minNeighborLuma = V::Min(minNeighborLuma, V::Max(V::Load(minBelow + x - 1), leftMask));
+                        minNeighborLuma = V::Min(minNeighborLuma, V::Max(V::Load(minAbove + x - 1), leftMask));
+
+                        const VF saturated = V::Min(V::Max(V::Sub(V::Mul(minNeighborLuma, V::Set1(50.0f)), V::Set1(2.5f)), V::Set1(0.0f)), V::Set1(1.0f));
+                        const VF brightnessSensitivity = V::Mul(weberFechnerConstant, V::Sub(V::Set1(1.0f), saturated));
+
+                        V::Store(rowLuma + x, pixelLuma);
+                        V::Store(rowLumaX + x, V::Div(V::Abs(V::Sub(pixelLuma, pixelLumaXMinusOne)),
+                            V::Add(V::Min(pixelLuma, pixelLumaXMinusOne), brightnessSensitivity)));
+                        V::Store(rowLumaY + x, V::Div(V::Abs(V::Sub(pixelLuma, pixelLumaYMinusOne)),
+                            V::Add(V::Min(pixelLuma, pixelLumaYMinusOne), brightnessSensitivity)));
+                    }
+                } else {
+                    for (uint32_t x = 0; x < spanWidth; x += V::kWidth) {
+                        const VF pixelLuma = V::Load(current + x);
+
+                        V::Store(rowLuma + x, pixelLuma);
+                        V::Store(rowLumaX + x, V::Mul(V::Abs(V::Sub(pixelLuma, V::Load(current + x - 1))), half));
+                        V::Store(rowLumaY + x, V::Mul(V::Abs(V::Sub(pixelLuma, V::Load(above + x))), half));
+                    }
+                }
+
+                lumaSum.AddRow(row, spanWidth);
+                lumaSumX.AddRow(row, spanWidth);
+                lumaSumY.AddRow(row, spanWidth);
+
+                if (kMode & VALAR_CPU_KERNEL_MODE_MOTION_VECTORS) {
+                    AccumulateVelocityRow<V, (kMode & VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS) != 0>(desc, y, spanX, spanWidth, colorWidth, velocityMin);
+                }
+
+                float* previous = above;
+                above = current;
+                current = below;
+                below = previous;
+
+                if (!(kMode & VALAR_CPU_KERNEL_MODE_WEBER_FECHNER) && row + 1 < tileSize) {
+                    ConvertLuminanceRow<V, L>(desc, y + 1, spanX, spanWidth, colorWidth, current);
+                }
+            }
+
+            for (uint32_t tile = 0; tile < tileXEnd - tileXBegin; tile++) {
+                VALAR_TILE_STATISTICS& tileStats = stats[tile];
+                const uint32_t column = tile * tileSize;
+
+                tileStats.m_lumaSum = lumaSum.m_sums[tile];
+                tileStats.m_lumaSumX = lumaSumX.m_sums[tile];
+                tileStats.m_lumaSumY = lumaSumY.m_sums[tile];
+                tileStats.m_velocityMin = 10000.0f;
+
+                // The minimum only moves with motion vectors, which saves the fminf calls otherwise.
+                if (kMode & VALAR_CPU_KERNEL_MODE_MOTION_VECTORS) {
+                    for (uint32_t x = column; x < column + tileSize; x++) {
+                        tileStats.m_velocityMin = fminf(tileStats.m_velocityMin, velocityMin[x]);
+                    }
+                }
+            }
+        }
+
+        // Fixed-point version of ConvertLuminanceRow for the 8-bit color formats.
+        template <typename V, typename L>
+        void ConvertLuminanceRowUNORM8(const VALAR_CPU_DESCRIPTOR& desc, int32_t y, uint32_t spanX, uint32_t spanWidth, uint32_t colorWidth, int32_t* dst)
+        {
+            if (y < 0 || (uint32_t)y >= desc.m_bufferHeight) {
+                memset(dst - 1, 0, (1 + spanWidth + VALAR_CPU_LINE_PADDING) * sizeof(int32_t));
+                return;
+            }
+
+            const VALAR_CPU_IMAGE_VIEW colorView = GetColorView(desc);
+            const uint8_t* color = GetImageRow(colorView, (uint32_t)y) + (size_t)spanX * L::kPixelSize;
+            const uint32_t* linearFixed = GetUNORM8Table(colorView.m_format).m_linearFixed;
+
+            dst[-1] = (spanX > 0) ? L::LumaFixedScalar(color - L::kPixelSize, linearFixed) : 0;
+
+            uint32_t x = 0;
+            for (; x + V::kWidth <= colorWidth; x += V::kWidth) {
+                V::StoreInt(dst + x, L::LumaFixed(color + (size_t)x * L::kPixelSize, linearFixed));
+            }
+            for (; x < colorWidth; x++) {
+                dst[x] = L::LumaFixedScalar(color + (size_t)x * L::kPixelSize, linearFixed);
+            }
+
+            memset(dst + colorWidth, 0, (spanWidth - colorWidth + VALAR_CPU_LINE_PADDING) * sizeof(int32_t));
+        }
+
+        // Fixed-point version of ComputeTileSpanStatisticsSIMD for the 8-bit color formats without Weber-Fechner
+        // mode. Luminance and absolute differences are exact integers, so every vector width produces the same
+        // sums and the rounding is confined to the conversion, see ComputeTileShadingRateUNORM8.
+        template <typename V, typename L, uint32_t kTileSize, uint32_t kMode>
+        void ComputeTileSpanStatisticsUNORM8SIMD(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, VALAR_TILE_STATISTICS_UNORM8* stats)
+        {
+            typedef typename V::Int VI;
+
+            const uint32_t tileSize = kTileSize;
+            const uint32_t spanX = tileXBegin * tileSize;
+            const uint32_t spanWidth = (tileXEnd - tileXBegin) * tileSize;
+            const uint32_t colorWidth = (spanX + spanWidth <= desc.m_bufferWidth) ? spanWidth :
+                ((desc.m_bufferWidth > spanX) ? desc.m_bufferWidth - spanX : 0);
+            const int32_t baseY = (int32_t)(tileY * tileSize);
+
+            alignas(64) int32_t lumaRows[2][1 + VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+            alignas(64) int32_t lumaSum[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+            alignas(64) int32_t lumaDifferenceX[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+            alignas(64) int32_t lumaDifferenceY[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+            alignas(64) float velocityMin[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+
+            int32_t* above = lumaRows[0] + 1;
+            int32_t* current = lumaRows[1] + 1;
+
+            ConvertLuminanceRowUNORM8<V, L>(desc, baseY - 1, spanX, spanWidth, colorWidth, above);
+
+            const size_t accumulatorSize = (spanWidth + VALAR_CPU_LINE_PADDING) * sizeof(int32_t);
+            memset(lumaSum, 0, accumulatorSize);
+            memset(lumaDifferenceX, 0, accumulatorSize);
+            memset(lumaDifferenceY, 0, accumulatorSize);
+
+            if (kMode & VALAR_CPU_KERNEL_MODE_MOTION_VECTORS) {
+                for (uint32_t x = 0; x < spanWidth; x++) {
+                    velocityMin[x] = 10000.0f;
+                }
+            }
+
+            for (uint32_t row = 0; row < tileSize; row++) {
+                const int32_t y = baseY + (int32_t)row;
+
+                ConvertLuminanceRowUNORM8<V, L>(desc, y, spanX, spanWidth, colorWidth, current);
+
+                for (uint32_t x = 0; x < spanWidth; x += V::kWidth) {
+                    const VI pixelLuma = V::LoadInt(current + x);
+
+                    V::StoreInt(lumaSum + x, V::AddInt(V::LoadInt(lumaSum + x), pixelLuma));
+                    V::StoreInt(lumaDifferenceX + x, V::AddInt(V::LoadInt(lumaDifferenceX + x), V::AbsDiffInt(pixelLuma, V::LoadInt(current + x - 1))));
+                    V::StoreInt(lumaDifferenceY + x, V::AddInt(V::LoadInt(lumaDifferenceY + x), V::AbsDiffInt(pixelLuma, V::LoadInt(above + x))));
+                }
+
+                if (kMode & VALAR_CPU_KERNEL_MODE_MOTION_VECTORS) {
+                    AccumulateVelocityRow<V, (kMode & VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS) != 0>(desc, y, spanX, spanWidth, colorWidth, velocityMin);
+                }
+
+                int32_t* previous = above;
+                above = current;
+                current = previous;
+            }
+
+            for (uint32_t tile = 0; tile < tileXEnd - tileXBegin; tile++) {
+                VALAR_TILE_STATISTICS_UNORM8& tileStats = stats[tile];
+                const uint32_t column = tile * tileSize;
+
+                tileStats.m_lumaSum = 0;
+                tileStats.m_lumaDifferenceX = 0;
+                tileStats.m_lumaDifferenceY = 0;
+                tileStats.m_velocityMin = 10000.0f;
+
+                // Column sums of 32 rows can exceed INT32_MAX, the wrapping adds keep them exact as uint32_t.
+                for (uint32_t x = column; x < column + tileSize; x++) {
+                    tileStats.m_lumaSum += (uint32_t)lumaSum[x];
+                    tileStats.m_lumaDifferenceX += (uint32_t)lumaDifferenceX[x];
+                    tileStats.m_lumaDifferenceY += (uint32_t)lumaDifferenceY[x];
+                }
+
+                // The minimum only moves with motion vectors, which saves the fminf calls otherwise.
+                if (kMode & VALAR_CPU_KERNEL_MODE_MOTION_VECTORS) {
+                    for (uint32_t x = column; x < column + tileSize; x++) {
+                        tileStats.m_velocityMin = fminf(tileStats.m_velocityMin, velocityMin[x]);
+                    }
+                }
+            }
+        }
+
+        // Specializes both kernels of a color format for every mode, indexed by the VALAR_CPU_KERNEL_MODE flags.
+        // Upscaled motion vectors without motion vectors are never selected and share the kernels without velocity.
+        template <typename V, typename L, uint32_t kTileSize>
+        void FillModeKernels(VALAR_CPU_TILE_KERNEL* kernels)
+        {
+            static constexpr VALAR_CPU_TILE_KERNEL kKernels[VALAR_CPU_KERNEL_MODE_COUNT] =
+            {
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, 0>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_WEBER_FECHNER>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_MOTION_VECTORS>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_WEBER_FECHNER | VALAR_CPU_KERNEL_MODE_MOTION_VECTORS>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, 0>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_WEBER_FECHNER>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_MOTION_VECTORS | VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS>,
+                ComputeTileSpanStatisticsSIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_WEBER_FECHNER | VALAR_CPU_KERNEL_MODE_MOTION_VECTORS | VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS>
+            };
+
+            memcpy(kernels, kKernels, sizeof(kKernels));
+        }
+
+        // The fixed-point kernel has no Weber-Fechner mode, those modes stay null and run the float kernel.
+        template <typename V, typename L, uint32_t kTileSize>
+        void FillModeKernelsUNORM8(VALAR_CPU_TILE_KERNEL_UNORM8* kernels)
+        {
+            static constexpr VALAR_CPU_TILE_KERNEL_UNORM8 kKernels[VALAR_CPU_KERNEL_MODE_COUNT] =
+            {
+                ComputeTileSpanStatisticsUNORM8SIMD<V, L, kTileSize, 0>,
+                nullptr,
+                ComputeTileSpanStatisticsUNORM8SIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_MOTION_VECTORS>,
+                nullptr,
+                ComputeTileSpanStatisticsUNORM8SIMD<V, L, kTileSize, 0>,
+                nullptr,
+                ComputeTileSpanStatisticsUNORM8SIMD<V, L, kTileSize, VALAR_CPU_KERNEL_MODE_MOTION_VECTORS | VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS>,
+                nullptr
+            };
+
+            memcpy(kernels, kKernels, sizeof(kKernels));
+        }
+
+        // Specializes both kernels for every color format and mode of one tile size, the fixed-point kernel only
+        // exists for the 8-bit formats.
+        template <typename V, uint32_t kTileSize>
+        void FillTileSizeKernels(VALAR_CPU_TILE_KERNELS& kernels)
+        {
+            typedef VALAR_UNORM8_LOADER<V, 0, 2, false> R8G8B8A8_UNORM;
+            typedef VALAR_UNORM8_LOADER<V, 0, 2, true> R8G8B8A8_UNORM_SRGB;
+            typedef VALAR_UNORM8_LOADER<V, 2, 0, false> B8G8R8A8_UNORM;
+            typedef VALAR_UNORM8_LOADER<V, 2, 0, true> B8G8R8A8_UNORM_SRGB;
+
+            VALAR_CPU_TILE_KERNEL (&floatKernels)[VALAR_CPU_COLOR_FORMAT_COUNT][VALAR_CPU_KERNEL_MODE_COUNT] = kernels.m_floatKernels[GetTileSizeIndex(kTileSize)];
+            VALAR_CPU_TILE_KERNEL_UNORM8 (&unorm8Kernels)[VALAR_CPU_COLOR_FORMAT_COUNT][VALAR_CPU_KERNEL_MODE_COUNT] = kernels.m_unorm8Kernels[GetTileSizeIndex(kTileSize)];
+
+            FillModeKernels<V, VALAR_R32G32B32A32_FLOAT_LOADER<V>, kTileSize>(floatKernels[VALAR_CPU_FORMAT_R32G32B32A32_FLOAT]);
+            FillModeKernels<V, R8G8B8A8_UNORM, kTileSize>(floatKernels[VALAR_CPU_FORMAT_R8G8B8A8_UNORM]);
+            FillModeKernels<V, R8G8B8A8_UNORM_SRGB, kTileSize>(floatKernels[VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB]);
+            FillModeKernels<V, B8G8R8A8_UNORM, kTileSize>(floatKernels[VALAR_CPU_FORMAT_B8G8R8A8_UNORM]);
+            FillModeKernels<V, B8G8R8A8_UNORM_SRGB, kTileSize>(floatKernels[VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB]);
+            FillModeKernels<V, VALAR_R10G10B10A2_UNORM_LOADER<V>, kTileSize>(floatKernels[VALAR_CPU_FORMAT_R10G10B10A2_UNORM]);
+            FillModeKernels<V, VALAR_R11G11B10_FLOAT_LOADER<V>, kTileSize>(floatKernels[VALAR_CPU_FORMAT_R11G11B10_FLOAT]);
+            FillModeKernels<V, VALAR_R16G16B16A16_FLOAT_LOADER<V>, kTileSize>(floatKernels[VALAR_CPU_FORMAT_R16G16B16A16_FLOAT]);
+
+            memset(unorm8Kernels, 0, sizeof(unorm8Kernels));
+
+            FillModeKernelsUNORM8<V, R8G8B8A8_UNORM, kTileSize>(unorm8Kernels[VALAR_CPU_FORMAT_R8G8B8A8_UNORM]);
+            FillModeKernelsUNORM8<V, R8G8B8A8_UNORM_SRGB, kTileSize>(unorm8Kernels[VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB]);
+            FillModeKernelsUNORM8<V, B8G8R8A8_UNORM, kTileSize>(unorm8Kernels[VALAR_CPU_FORMAT_B8G8R8A8_UNORM]);
+            FillModeKernelsUNORM8<V, B8G8R8A8_UNORM_SRGB, kTileSize>(unorm8Kernels[VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB]);
+        }
+
+        template <typename V>
+        void FillTileKernels(VALAR_CPU_TILE_KERNELS& kernels)
+        {
+            FillTileSizeKernels<V, INTEL_TILE_SIZE>(kernels);
+            FillTileSizeKernels<V, OTHER_TILE_SIZE>(kernels);
+            FillTileSizeKernels<V, LARGE_TILE_SIZE>(kernels);
+        }
+    }
+}
\ No newline at end of file
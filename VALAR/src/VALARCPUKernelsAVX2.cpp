@@ -0,0 +1,171 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+
+#if defined(VALAR_CPU_X86)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,f16c"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,f16c")
+#endif
+
+#include "VALARCPUKernels.h"
+
+namespace Intel
+{
+    namespace
+    {
+        struct VALAR_AVX2_VECTOR
+        {
+            static const uint32_t kWidth = 8;
+
+            typedef __m256 Float;
+
+            static Float Set1(float x) { return _mm256_set1_ps(x); }
+            static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+            static void Store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+
+            static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+            static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+            static Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+            static Float Abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+            static Float PairwiseAdd(Float a, Float b)
+            {
+                // The in-lane add leaves the pairs of a in quarters 0 and 2, those of b in quarters 1 and 3.
+                const __m256 sums = _mm256_hadd_ps(a, b);
+                return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sums), _MM_SHUFFLE(3, 1, 2, 0)));
+            }
+
+            static __m256 LoadPixelPair(const float* low, const float* high)
+            {
+                return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+            }
+
+            static Float Luma(const float* color)
+            {
+                // Pixel i of both groups of four shares a register so the in-lane transpose keeps pixel order.
+                const __m256 p0 = LoadPixelPair(color, color + 16);
+                const __m256 p1 = LoadPixelPair(color + 4, color + 20);
+                const __m256 p2 = LoadPixelPair(color + 8, color + 24);
+                const __m256 p3 = LoadPixelPair(color + 12, color + 28);
+
+                const __m256 t0 = _mm256_unpacklo_ps(p0, p1);
+                const __m256 t1 = _mm256_unpacklo_ps(p2, p3);
+                const __m256 t2 = _mm256_unpackhi_ps(p0, p1);
+                const __m256 t3 = _mm256_unpackhi_ps(p2, p3);
+
+                const __m256 r = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+                const __m256 g = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+                const __m256 b = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+                return _mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(_mm256_mul_ps(r, r), _mm256_set1_ps(0.212671f)),
+                    _mm256_mul_ps(_mm256_mul_ps(g, g), _mm256_set1_ps(0.715160f))),
+                    _mm256_mul_ps(_mm256_mul_ps(b, b), _mm256_set1_ps(0.072169f)));
+            }
+
+            static __m256 HalfToFloat(__m256i half)
+            {
+                // Narrow the 32-bit lanes to 16 bits, the in-lane pack leaves the halves in quarters 0 and 2.
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(half, half), _MM_SHUFFLE(3, 1, 2, 0));
+                return _mm256_cvtph_ps(_mm256_castsi256_si128(packed));
+            }
+
+            static __m256 UnpackXY(__m256i x)
+            {
+                const __m256i half = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x1FF)), 4), _mm256_slli_epi32(_mm256_srli_epi32(x, 9), 15));
+                return _mm256_mul_ps(HalfToFloat(half), _mm256_set1_ps(32768.0f));
+            }
+
+            static __m256 UnpackZ(__m256i x)
+            {
+                const __m256i half = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x7FF)), 2), _mm256_slli_epi32(_mm256_srli_epi32(x, 11), 15));
+                return _mm256_mul_ps(HalfToFloat(half), _mm256_set1_ps(128.0f));
+            }
+
+            static Float PackedVelocityLength(const uint32_t* velocity)
+            {
+                const __m256i packed = _mm256_loadu_si256((const __m256i*)velocity);
+
+                const __m256 x = UnpackXY(_mm256_and_si256(packed, _mm256_set1_epi32(0x3FF)));
+                const __m256 y = UnpackXY(_mm256_and_si256(_mm256_srli_epi32(packed, 10), _mm256_set1_epi32(0x3FF)));
+                const __m256 z = UnpackZ(_mm256_srli_epi32(packed, 20));
+
+                return _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+            }
+
+            typedef __m256i Int;
+
+            static Int Set1Int(int32_t x) { return _mm256_set1_epi32(x); }
+            static Int LoadInt(const int32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+            static void StoreInt(int32_t* p, Int v) { _mm256_storeu_si256((__m256i*)p, v); }
+
+            static void LoadDeinterleavedInt(const int32_t* p, Int& even, Int& odd)
+            {
+                const __m256 low = _mm256_loadu_ps((const float*)p);
+                const __m256 high = _mm256_loadu_ps((const float*)(p + 8));
+
+                // The in-lane shuffle leaves the 64-bit quarters in 0, 2, 1, 3 order.
+                even = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+                odd = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+            }
+
+            static Int AddInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+            static Int MulInt(Int a, Int b) { return _mm256_mullo_epi32(a, b); }
+            static Int SquareInt(Int a) { return _mm256_madd_epi16(a, a); }
+            static Int AbsDiffInt(Int a, Int b) { return _mm256_abs_epi32(_mm256_sub_epi32(a, b)); }
+            static Int AndInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+
+            template <int n> static Int ShiftLeftInt(Int a) { return _mm256_slli_epi32(a, n); }
+            template <int n> static Int ShiftRightInt(Int a) { return _mm256_srli_epi32(a, n); }
+
+            static Float IntToFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+        };
+    }
+}
+
+void Intel::GetTileKernelsAVX2(Intel::VALAR_CPU_TILE_KERNELS& kernels)
+{
+    FillTileKernels<VALAR_AVX2_VECTOR>(kernels);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+
+#if defined(VALAR_CPU_X86)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// The shift intrinsics of GCC 12 pass _mm512_undefined_epi32 as their merge source, which it reports as uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include "VALARCPUKernels.h"
+
+namespace Intel
+{
+    namespace
+    {
+        struct VALAR_AVX512_VECTOR
+        {
+            static const uint32_t kWidth = 16;
+
+            typedef __m512 Float;
+
+            static Float Set1(float x) { return _mm512_set1_ps(x); }
+            static Float Load(const float* p) { return _mm512_loadu_ps(p); }
+            static void Store(float* p, Float v) { _mm512_storeu_ps(p, v); }
+
+            static Float Add(Float a, Float b) { return _mm512_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+            static Float Div(Float a, Float b) { return _mm512_div_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm512_min_ps(a, b); }
+            static Float Max(Float a, Float b) { return _mm512_max_ps(a, b); }
+            static Float Abs(Float a) { return _mm512_abs_ps(a); }
+
+            static Float PairwiseAdd(Float a, Float b)
+            {
+                const __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+                const __m512i odd = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+                return _mm512_add_ps(_mm512_permutex2var_ps(a, even, b), _mm512_permutex2var_ps(a, odd, b));
+            }
+
+            static Float Luma(const float* color)
+            {
+                const __m512 g0 = _mm512_loadu_ps(color);
+                const __m512 g1 = _mm512_loadu_ps(color + 16);
+                const __m512 g2 = _mm512_loadu_ps(color + 32);
+                const __m512 g3 = _mm512_loadu_ps(color + 48);
+
+                // Gather pixel i of every group of four into one register, then transpose within each 128-bit lane.
+                const __m512 t0 = _mm512_shuffle_f32x4(g0, g1, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m512 t1 = _mm512_shuffle_f32x4(g0, g1, _MM_SHUFFLE(3, 1, 3, 1));
+                const __m512 t2 = _mm512_shuffle_f32x4(g2, g3, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m512 t3 = _mm512_shuffle_f32x4(g2, g3, _MM_SHUFFLE(3, 1, 3, 1));
+
+                const __m512 p0 = _mm512_shuffle_f32x4(t0, t2, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m512 p1 = _mm512_shuffle_f32x4(t1, t3, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m512 p2 = _mm512_shuffle_f32x4(t0, t2, _MM_SHUFFLE(3, 1, 3, 1));
+                const __m512 p3 = _mm512_shuffle_f32x4(t1, t3, _MM_SHUFFLE(3, 1, 3, 1));
+
+                const __m512 u0 = _mm512_unpacklo_ps(p0, p1);
+                const __m512 u1 = _mm512_unpacklo_ps(p2, p3);
+                const __m512 u2 = _mm512_unpackhi_ps(p0, p1);
+                const __m512 u3 = _mm512_unpackhi_ps(p2, p3);
+
+                const __m512 r = _mm512_shuffle_ps(u0, u1, _MM_SHUFFLE(1, 0, 1, 0));
+                const __m512 g = _mm512_shuffle_ps(u0, u1, _MM_SHUFFLE(3, 2, 3, 2));
+                const __m512 b = _mm512_shuffle_ps(u2, u3, _MM_SHUFFLE(1, 0, 1, 0));
+
+                return _mm512_add_ps(_mm512_add_ps(
+                    _mm512_mul_ps(_mm512_mul_ps(r, r), _mm512_set1_ps(0.212671f)),
+                    _mm512_mul_ps(_mm512_mul_ps(g, g), _mm512_set1_ps(0.715160f))),
+                    _mm512_mul_ps(_mm512_mul_ps(b, b), _mm512_set1_ps(0.072169f)));
+            }
+
+            static __m512 HalfToFloat(__m512i half)
+            {
+                return _mm512_cvtph_ps(_mm512_cvtepi32_epi16(half));
+            }
+
+            static __m512 UnpackXY(__m512i x)
+            {
+                const __m512i half = _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(x, _mm512_set1_epi32(0x1FF)), 4), _mm512_slli_epi32(_mm512_srli_epi32(x, 9), 15));
+                return _mm512_mul_ps(HalfToFloat(half), _mm512_set1_ps(32768.0f));
+            }
+
+            static __m512 UnpackZ(__m512i x)
+            {
+                const __m512i half = _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(x, _mm512_set1_epi32(0x7FF)), 2), _mm512_slli_epi32(_mm512_srli_epi32(x, 11), 15));
+                return _mm512_mul_ps(HalfToFloat(half), _mm512_set1_ps(128.0f));
+            }
+
+            static Float PackedVelocityLength(const uint32_t* velocity)
+            {
+                const __m512i packed = _mm512_loadu_si512((const void*)velocity);
+
+                const __m512 x = UnpackXY(_mm512_and_si512(packed, _mm512_set1_epi32(0x3FF)));
+                const __m512 y = UnpackXY(_mm512_and_si512(_mm512_srli_epi32(packed, 10), _mm512_set1_epi32(0x3FF)));
+                const __m512 z = UnpackZ(_mm512_srli_epi32(packed, 20));
+
+                return _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, x), _mm512_mul_ps(y, y)), _mm512_mul_ps(z, z)));
+            }
+
+            typedef __m512i Int;
+
+            static Int Set1Int(int32_t x) { return _mm512_set1_epi32(x); }
+            static Int LoadInt(const int32_t* p) { return _mm512_loadu_si512((const void*)p); }
+            static void StoreInt(int32_t* p, Int v) { _mm512_storeu_si512((void*)p, v); }
+
+            static void LoadDeinterleavedInt(const int32_t* p, Int& even, Int& odd)
+            {
+                const __m512i low = _mm512_loadu_si512((const void*)p);
+                const __m512i high = _mm512_loadu_si512((const void*)(p + 16));
+
+                even = _mm512_permutex2var_epi32(low, _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30), high);
+                odd = _mm512_permutex2var_epi32(low, _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31), high);
+            }
+
+            static Int AddInt(Int a, Int b) { return _mm512_add_epi32(a, b); }
+            static Int MulInt(Int a, Int b) { return _mm512_mullo_epi32(a, b); }
+            // vpmaddwd on zmm needs AVX512BW, so squares use vpmulld as well.
+            static Int SquareInt(Int a) { return _mm512_mullo_epi32(a, a); }
+            static Int AbsDiffInt(Int a, Int b) { return _mm512_abs_epi32(_mm512_sub_epi32(a, b)); }
+            static Int AndInt(Int a, Int b) { return _mm512_and_si512(a, b); }
+
+            template <int n> static Int ShiftLeftInt(Int a) { return _mm512_slli_epi32(a, n); }
+            template <int n> static Int ShiftRightInt(Int a) { return _mm512_srli_epi32(a, n); }
+
+            static Float IntToFloat(Int a) { return _mm512_cvtepi32_ps(a); }
+        };
+    }
+}
+
+void Intel::GetTileKernelsAVX512(Intel::VALAR_CPU_TILE_KERNELS& kernels)
+{
+    FillTileKernels<VALAR_AVX512_VECTOR>(kernels);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+#endif
\ No newline at end of file
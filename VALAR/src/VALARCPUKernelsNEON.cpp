@@ -0,0 +1,132 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+
+#if defined(VALAR_CPU_ARM64)
+
+#include <arm_neon.h>
+
+#include "VALARCPUKernels.h"
+
+namespace Intel
+{
+    namespace
+    {
+        struct VALAR_NEON_VECTOR
+        {
+            static const uint32_t kWidth = 4;
+
+            typedef float32x4_t Float;
+
+            static Float Set1(float x) { return vdupq_n_f32(x); }
+            static Float Load(const float* p) { return vld1q_f32(p); }
+            static void Store(float* p, Float v) { vst1q_f32(p, v); }
+
+            static Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+            static Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+            static Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+            static Float Div(Float a, Float b) { return vdivq_f32(a, b); }
+            static Float Min(Float a, Float b) { return vminq_f32(a, b); }
+            static Float Max(Float a, Float b) { return vmaxq_f32(a, b); }
+            static Float Abs(Float a) { return vabsq_f32(a); }
+            static Float PairwiseAdd(Float a, Float b) { return vpaddq_f32(a, b); }
+
+            static Float Luma(const float* color)
+            {
+                const float32x4x4_t pixels = vld4q_f32(color);
+
+                return vaddq_f32(vaddq_f32(
+                    vmulq_f32(vmulq_f32(pixels.val[0], pixels.val[0]), vdupq_n_f32(0.212671f)),
+                    vmulq_f32(vmulq_f32(pixels.val[1], pixels.val[1]), vdupq_n_f32(0.715160f))),
+                    vmulq_f32(vmulq_f32(pixels.val[2], pixels.val[2]), vdupq_n_f32(0.072169f)));
+            }
+
+            static float32x4_t HalfToFloat(uint32x4_t half)
+            {
+                return vcvt_f32_f16(vreinterpret_f16_u16(vmovn_u32(half)));
+            }
+
+            static float32x4_t UnpackXY(uint32x4_t x)
+            {
+                const uint32x4_t half = vorrq_u32(vshlq_n_u32(vandq_u32(x, vdupq_n_u32(0x1FF)), 4), vshlq_n_u32(vshrq_n_u32(x, 9), 15));
+                return vmulq_f32(HalfToFloat(half), vdupq_n_f32(32768.0f));
+            }
+
+            static float32x4_t UnpackZ(uint32x4_t x)
+            {
+                const uint32x4_t half = vorrq_u32(vshlq_n_u32(vandq_u32(x, vdupq_n_u32(0x7FF)), 2), vshlq_n_u32(vshrq_n_u32(x, 11), 15));
+                return vmulq_f32(HalfToFloat(half), vdupq_n_f32(128.0f));
+            }
+
+            static Float PackedVelocityLength(const uint32_t* velocity)
+            {
+                const uint32x4_t packed = vld1q_u32(velocity);
+
+                const float32x4_t x = UnpackXY(vandq_u32(packed, vdupq_n_u32(0x3FF)));
+                const float32x4_t y = UnpackXY(vandq_u32(vshrq_n_u32(packed, 10), vdupq_n_u32(0x3FF)));
+                const float32x4_t z = UnpackZ(vshrq_n_u32(packed, 20));
+
+                return vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(x, x), vmulq_f32(y, y)), vmulq_f32(z, z)));
+            }
+
+            typedef uint32x4_t Int;
+
+            static Int Set1Int(int32_t x) { return vdupq_n_u32((uint32_t)x); }
+            static Int LoadInt(const int32_t* p) { return vld1q_u32((const uint32_t*)p); }
+            static void StoreInt(int32_t* p, Int v) { vst1q_u32((uint32_t*)p, v); }
+
+            static void LoadDeinterleavedInt(const int32_t* p, Int& even, Int& odd)
+            {
+                const uint32x4x2_t pairs = vld2q_u32((const uint32_t*)p);
+
+                even = pairs.val[0];
+                odd = pairs.val[1];
+            }
+
+            static Int AddInt(Int a, Int b) { return vaddq_u32(a, b); }
+            static Int MulInt(Int a, Int b) { return vmulq_u32(a, b); }
+            static Int SquareInt(Int a) { return vmulq_u32(a, a); }
+            // Luminance is below 2^31, so the unsigned difference is the signed one.
+            static Int AbsDiffInt(Int a, Int b) { return vabdq_u32(a, b); }
+            static Int AndInt(Int a, Int b) { return vandq_u32(a, b); }
+
+            template <int n> static Int ShiftLeftInt(Int a) { return vshlq_n_u32(a, n); }
+            // vshrq_n_u32 does not take a shift of zero, a negative vshlq_u32 does.
+            template <int n> static Int ShiftRightInt(Int a) { return vshlq_u32(a, vdupq_n_s32(-n)); }
+
+            static Float IntToFloat(Int a) { return vcvtq_f32_u32(a); }
+        };
+    }
+}
+
+void Intel::GetTileKernelsNEON(Intel::VALAR_CPU_TILE_KERNELS& kernels)
+{
+    FillTileKernels<VALAR_NEON_VECTOR>(kernels);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,160 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+
+#if defined(VALAR_CPU_X86)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+#include "VALARCPUKernels.h"
+
+namespace Intel
+{
+    namespace
+    {
+        struct VALAR_SSE41_VECTOR
+        {
+            static const uint32_t kWidth = 4;
+
+            typedef __m128 Float;
+
+            static Float Set1(float x) { return _mm_set1_ps(x); }
+            static Float Load(const float* p) { return _mm_loadu_ps(p); }
+            static void Store(float* p, Float v) { _mm_storeu_ps(p, v); }
+
+            static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+            static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+            static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+            static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+            static Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+            static Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+            static Float Abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+            static Float PairwiseAdd(Float a, Float b) { return _mm_hadd_ps(a, b); }
+
+            static Float Luma(const float* color)
+            {
+                __m128 r = _mm_loadu_ps(color);
+                __m128 g = _mm_loadu_ps(color + 4);
+                __m128 b = _mm_loadu_ps(color + 8);
+                __m128 a = _mm_loadu_ps(color + 12);
+
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+
+                return _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_mul_ps(r, r), _mm_set1_ps(0.212671f)),
+                    _mm_mul_ps(_mm_mul_ps(g, g), _mm_set1_ps(0.715160f))),
+                    _mm_mul_ps(_mm_mul_ps(b, b), _mm_set1_ps(0.072169f)));
+            }
+
+            static __m128 HalfToFloat(__m128i half)
+            {
+                const __m128i shiftedExponent = _mm_set1_epi32(0x7C00 << 13);
+
+                __m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+                const __m128i exponent = _mm_and_si128(bits, shiftedExponent);
+
+                bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+                bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpeq_epi32(exponent, shiftedExponent), _mm_set1_epi32((128 - 16) << 23)));
+
+                const __m128 denormal = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+                const __m128 result = _mm_blendv_ps(_mm_castsi128_ps(bits), denormal, _mm_castsi128_ps(_mm_cmpeq_epi32(exponent, _mm_setzero_si128())));
+
+                return _mm_or_ps(result, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16)));
+            }
+
+            static __m128 UnpackXY(__m128i x)
+            {
+                const __m128i half = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x1FF)), 4), _mm_slli_epi32(_mm_srli_epi32(x, 9), 15));
+                return _mm_mul_ps(HalfToFloat(half), _mm_set1_ps(32768.0f));
+            }
+
+            static __m128 UnpackZ(__m128i x)
+            {
+                const __m128i half = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x7FF)), 2), _mm_slli_epi32(_mm_srli_epi32(x, 11), 15));
+                return _mm_mul_ps(HalfToFloat(half), _mm_set1_ps(128.0f));
+            }
+
+            static Float PackedVelocityLength(const uint32_t* velocity)
+            {
+                const __m128i packed = _mm_loadu_si128((const __m128i*)velocity);
+
+                const __m128 x = UnpackXY(_mm_and_si128(packed, _mm_set1_epi32(0x3FF)));
+                const __m128 y = UnpackXY(_mm_and_si128(_mm_srli_epi32(packed, 10), _mm_set1_epi32(0x3FF)));
+                const __m128 z = UnpackZ(_mm_srli_epi32(packed, 20));
+
+                return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+            }
+
+            typedef __m128i Int;
+
+            static Int Set1Int(int32_t x) { return _mm_set1_epi32(x); }
+            static Int LoadInt(const int32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+            static void StoreInt(int32_t* p, Int v) { _mm_storeu_si128((__m128i*)p, v); }
+
+            static void LoadDeinterleavedInt(const int32_t* p, Int& even, Int& odd)
+            {
+                const __m128 low = _mm_loadu_ps((const float*)p);
+                const __m128 high = _mm_loadu_ps((const float*)(p + 4));
+
+                even = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+                odd = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+
+            static Int AddInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+            static Int MulInt(Int a, Int b) { return _mm_mullo_epi32(a, b); }
+            static Int SquareInt(Int a) { return _mm_madd_epi16(a, a); }
+            static Int AbsDiffInt(Int a, Int b) { return _mm_abs_epi32(_mm_sub_epi32(a, b)); }
+            static Int AndInt(Int a, Int b) { return _mm_and_si128(a, b); }
+
+            template <int n> static Int ShiftLeftInt(Int a) { return _mm_slli_epi32(a, n); }
+            template <int n> static Int ShiftRightInt(Int a) { return _mm_srli_epi32(a, n); }
+
+            static Float IntToFloat(Int a) { return _mm_cvtepi32_ps(a); }
+        };
+    }
+}
+
+void Intel::GetTileKernelsSSE41(Intel::VALAR_CPU_TILE_KERNELS& kernels)
+{
+    FillTileKernels<VALAR_SSE41_VECTOR>(kernels);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARCPUKernels.h"
+
+namespace Intel
+{
+    namespace
+    {
+        // Single lane wrapper, the fallback when no supported instruction set is available.
+        struct VALAR_SCALAR_VECTOR
+        {
+            static const uint32_t kWidth = 1;
+
+            typedef float Float;
+
+            static Float Set1(float x) { return x; }
+            static Float Load(const float* p) { return *p; }
+            static void Store(float* p, Float v) { *p = v; }
+
+            static Float Add(Float a, Float b) { return a + b; }
+            static Float Sub(Float a, Float b) { return a - b; }
+            static Float Mul(Float a, Float b) { return a * b; }
+            static Float Div(Float a, Float b) { return a / b; }
+            static Float Min(Float a, Float b) { return (a < b) ? a : b; }
+            static Float Max(Float a, Float b) { return (a > b) ? a : b; }
+            static Float Abs(Float a) { return fabsf(a); }
+            static Float PairwiseAdd(Float a, Float b) { return a + b; }
+
+            static Float Luma(const float* color)
+            {
+                return RGBToLuminance(color[0] * color[0], color[1] * color[1], color[2] * color[2]);
+            }
+
+            static Float PackedVelocityLength(const uint32_t* velocity)
+            {
+                return Intel::PackedVelocityLength(*velocity);
+            }
+
+            typedef int32_t Int;
+
+            static Int Set1Int(int32_t x) { return x; }
+            static Int LoadInt(const int32_t* p) { return *p; }
+            static void StoreInt(int32_t* p, Int v) { *p = v; }
+
+            static void LoadDeinterleavedInt(const int32_t* p, Int& even, Int& odd)
+            {
+                even = p[0];
+                odd = p[1];
+            }
+
+            static Int AddInt(Int a, Int b) { return (Int)((uint32_t)a + (uint32_t)b); }
+            static Int MulInt(Int a, Int b) { return (Int)((uint32_t)a * (uint32_t)b); }
+            static Int SquareInt(Int a) { return a * a; }
+            static Int AbsDiffInt(Int a, Int b) { return (a > b) ? a - b : b - a; }
+            static Int AndInt(Int a, Int b) { return a & b; }
+
+            template <int n> static Int ShiftLeftInt(Int a) { return (Int)((uint32_t)a << n); }
+            template <int n> static Int ShiftRightInt(Int a) { return (Int)((uint32_t)a >> n); }
+
+            static Float IntToFloat(Int a) { return (float)a; }
+            static Float HalfToFloat(Int half) { return Intel::HalfToFloat((uint32_t)half); }
+        };
+    }
+}
+
+void Intel::GetTileKernelsScalar(Intel::VALAR_CPU_TILE_KERNELS& kernels)
+{
+    FillTileKernels<VALAR_SCALAR_VECTOR>(kernels);
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARCPUThreadPool.h"
+
+// R2 sequence increments, rotate the sample positions of every stratum by a new low discrepancy offset each frame.
+#define VALAR_CPU_LP_R2_ALPHA_X 0.7548776662
+#define VALAR_CPU_LP_R2_ALPHA_Y 0.5698402910
+
+// Per mask state of the LP sample pattern, resolved once instead of per sample.
+struct VALAR_CPU_LP_PATTERN
+{
+    Intel::VALAR_CPU_IMAGE_VIEW             m_colorView;
+    uint32_t                                m_quadCount;
+    uint32_t                                m_stratumSize;
+    float                                   m_frameOffsetX;
+    float                                   m_frameOffsetY;
+};
+
+// Fraction of a non-negative value small enough for an int32_t.
+static float Fraction(float x)
+{
+    return x - (float)(int32_t)x;
+}
+
+// Interleaved gradient noise, a cheap blue noise like offset that decorrelates the strata of neighboring tiles.
+static float InterleavedGradientNoise(float x, float y)
+{
+    return Fraction(52.9829189f * Fraction(0.06711056f * x + 0.00583715f * y));
+}
+
+static VALAR_CPU_LP_PATTERN MakeLPPattern(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    VALAR_CPU_LP_PATTERN pattern;
+    pattern.m_colorView = Intel::GetColorView(desc);
+    pattern.m_quadCount = desc.m_LPSampleCount / 4;
+    pattern.m_stratumSize = (pattern.m_quadCount == 1) ? desc.m_shadingRateTileSize : desc.m_shadingRateTileSize / 2;
+
+    // The frame offsets keep their precision for any frame index in double.
+    const double frameIndex = (double)desc.m_frameIndex;
+    pattern.m_frameOffsetX = (float)(frameIndex * VALAR_CPU_LP_R2_ALPHA_X - floor(frameIndex * VALAR_CPU_LP_R2_ALPHA_X));
+    pattern.m_frameOffsetY = (float)(frameIndex * VALAR_CPU_LP_R2_ALPHA_Y - floor(frameIndex * VALAR_CPU_LP_R2_ALPHA_Y));
+
+    return pattern;
+}
+
+// Top left pixel of the 2x2 sample quad of stratum (stratumX, stratumY) of a tile. One quad covers the whole tile
+// and sits at its centroid like ValarLPCS.hlsl, two quads take the diagonal quadrants and four quads every quadrant.
+static void GetLPQuadPosition(const Intel::VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_LP_PATTERN& pattern, uint32_t tileX, uint32_t tileY,
+    uint32_t stratumX, uint32_t stratumY, int32_t& x, int32_t& y)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t stratumSize = pattern.m_stratumSize;
+    uint32_t offsetX = stratumSize / 2;
+    uint32_t offsetY = stratumSize / 2;
+
+    if (desc.m_LPRotateSamples) {
+        // Cranley-Patterson rotation of a noise offset, the quad stays inside of its stratum. The vertical offset
+        // only varies per stratum row, so a tile row still reads 2 pixel rows per stratum row from memory.
+        const float noiseX = (float)(tileX * (tileSize / stratumSize) + stratumX);
+        const float noiseY = (float)(tileY * (tileSize / stratumSize) + stratumY);
+        const float u = Fraction(InterleavedGradientNoise(noiseX, noiseY) + pattern.m_frameOffsetX);
+        const float v = Fraction(InterleavedGradientNoise(0.0f, noiseY) + pattern.m_frameOffsetY);
+
+        offsetX = (uint32_t)(u * (float)(stratumSize - 1));
+        offsetY = (uint32_t)(v * (float)(stratumSize - 1));
+    }
+
+    x = (int32_t)(tileX * tileSize + stratumX * stratumSize + offsetX);
+    y = (int32_t)(tileY * tileSize + stratumY * stratumSize + offsetY);
+}
+
+// Port of ValarLPCS.hlsl generalized to m_LPSampleCount samples, taken as 2x2 quads so every quad adds one X and
+// one Y difference per row and column. Like the shader it only chooses between the full and the half rate.
+static uint8_t ComputeTileShadingRateLP(const Intel::VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_LP_PATTERN& pattern, uint32_t tileX, uint32_t tileY)
+{
+    float lumaSum = 0.0f;
+    float lumaDifferenceX = 0.0f;
+    float lumaDifferenceY = 0.0f;
+    float velocityMin = 10000.0f;
+
+    for (uint32_t quad = 0; quad < pattern.m_quadCount; quad++) {
+        // Strata (0, 0) and (1, 1) first, so two quads sample the diagonal.
+        const uint32_t stratumX = (quad == 1 || quad == 3) ? 1 : 0;
+        const uint32_t stratumY = (quad == 1 || quad == 2) ? 1 : 0;
+
+        int32_t x;
+        int32_t y;
+        GetLPQuadPosition(desc, pattern, tileX, tileY, stratumX, stratumY, x, y);
+
+        const float luma1 = Intel::FetchLuminance(pattern.m_colorView, x, y);
+        const float luma2 = Intel::FetchLuminance(pattern.m_colorView, x + 1, y);
+        const float luma3 = Intel::FetchLuminance(pattern.m_colorView, x, y + 1);
+        const float luma4 = Intel::FetchLuminance(pattern.m_colorView, x + 1, y + 1);
+
+        lumaSum += luma1 + luma2 + luma3 + luma4;
+        lumaDifferenceX += fabsf(luma2 - luma1) + fabsf(luma4 - luma3);
+        lumaDifferenceY += fabsf(luma3 - luma1) + fabsf(luma4 - luma2);
+
+        if (desc.m_useMotionVectors) {
+            velocityMin = fminf(velocityMin, Intel::FetchVelocity(desc, (uint32_t)x, (uint32_t)y));
+        }
+    }
+
+    // The shader sums the two differences of its quad, more quads are averaged to the same scale.
+    const float avgTileLuma = lumaSum / (float)desc.m_LPSampleCount;
+    const float avgTileLumaX = lumaDifferenceX / (float)pattern.m_quadCount;
+    const float avgTileLumaY = lumaDifferenceY / (float)pattern.m_quadCount;
+
+    // The shader halves the sensitivity threshold for its 4 samples. The scale grows with the square root of the
+    // sample count, the rate at which the sampling error of the differences falls, and would reach 2 for 64 samples,
+    // where the doubled X/Y terms of the LP estimate match the full mask of an 8x8 tile.
+    const float jndScale = sqrtf((float)desc.m_LPSampleCount) / 4.0f;
+    const float jndThreshold = Intel::ComputeJNDThreshold(desc.m_sensitivityThreshold * jndScale, avgTileLuma, desc.m_environmentLuminance);
+
+    const float avgErrorX = sqrtf(avgTileLumaX);
+    const float avgErrorY = sqrtf(avgTileLumaY);
+
+    const float velocityHError = Intel::ComputeVelocityHError(velocityMin, desc.m_useMotionVectors);
+
+    // Like ValarLPCS.hlsl, 4 samples are too few to shade at a quarter rate.
+    const uint32_t xClass = Intel::GetShadingRateAxisClass(velocityHError * avgErrorX >= jndThreshold, false);
+    const uint32_t yClass = Intel::GetShadingRateAxisClass(velocityHError * avgErrorY >= jndThreshold, false);
+
+    return (uint8_t)Intel::LookupShadingRate(xClass, yClass, false);
+}
+
+static void ComputeTileSpanLP(const Intel::VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_LP_PATTERN& pattern, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd,
+    uint8_t* valarRow, uint32_t* shadingRateTileCount)
+{
+    for (uint32_t tileX = tileXBegin; tileX < tileXEnd; tileX++) {
+        if (!Intel::IsAmortizedTileDue(desc, tileX, tileY)) {
+            Intel::CountPreviousShadingRate(valarRow[tileX], shadingRateTileCount);
+            continue;
+        }
+
+        const uint8_t shadingRate = ComputeTileShadingRateLP(desc, pattern, tileX, tileY);
+
+        valarRow[tileX] = shadingRate;
+        shadingRateTileCount[shadingRate]++;
+    }
+}
+
+static void ComputeTileRowLPJob(void* context, uint32_t tileY)
+{
+    const Intel::VALAR_CPU_DESCRIPTOR& desc = *(const Intel::VALAR_CPU_DESCRIPTOR*)context;
+    const uint32_t tilesX = (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+    const VALAR_CPU_LP_PATTERN pattern = MakeLPPattern(desc);
+    uint8_t* valarRow = desc.m_valarBuffer + (size_t)tileY * Intel::GetValarRowPitch(desc);
+
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+
+    // Like the full mask, tiles outside of the regions of interest are filled without sampling the color buffer.
+    uint32_t tileX = 0;
+
+    if (desc.m_regionOfInterestCount == 0) {
+        ComputeTileSpanLP(desc, pattern, tileY, 0, tilesX, valarRow, shadingRateTileCount);
+        tileX = tilesX;
+    }
+
+    while (tileX < tilesX) {
+        uint32_t spanBegin;
+        uint32_t spanEnd;
+
+        if (!Intel::FindRegionOfInterestSpan(desc, tileY, tileX, spanBegin, spanEnd)) {
+            spanBegin = tilesX;
+            spanEnd = tilesX;
+        }
+
+        memset(valarRow + tileX, desc.m_outsideShadingRate, spanBegin - tileX);
+        shadingRateTileCount[desc.m_outsideShadingRate] += spanBegin - tileX;
+
+        ComputeTileSpanLP(desc, pattern, tileY, spanBegin, spanEnd, valarRow, shadingRateTileCount);
+        tileX = spanEnd;
+    }
+
+    Intel::AccumulateShadingRateTileCount(desc, shadingRateTileCount);
+}
+
+void Intel::ComputeMaskLP(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    DispatchThreadPool(desc.m_pOpaque->m_threadPool, tilesY, ComputeTileRowLPJob, (void*)&desc);
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+// Color format loaders of the fused kernels. ComputeTileSpanStatisticsSIMD and ComputeTileSpanStatisticsUNORM8SIMD
+// take a loader L as a second template parameter next to the vector wrapper V, so every kernel is specialized for
+// one color format and its inner loops carry no format branch. FillTileKernels builds the table of all
+// specializations of one instruction set.
+//
+// A loader provides:
+//   kPixelSize                          bytes per pixel
+//   Luma(color, linear)                 luminance of kWidth consecutive pixels
+//   LumaScalar(pixel, linear)           luminance of one pixel, identical to FetchLuminance and to every lane of Luma
+// and the loaders of the 8-bit formats additionally:
+//   LumaFixed(color, linearFixed)       fixed-point luminance of kWidth consecutive pixels
+//   LumaFixedScalar(pixel, linearFixed) fixed-point luminance of one pixel, identical to every lane of LumaFixed
+// linear and linearFixed point into the VALAR_CPU_UNORM8_TABLE of the format and are unused by the other formats.
+
+#include <cstdint>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+
+namespace Intel
+{
+    namespace
+    {
+        // Same order of operations as RGBToLuminance.
+        template <typename V>
+        typename V::Float WeightLuminance(typename V::Float r, typename V::Float g, typename V::Float b)
+        {
+            return V::Add(V::Add(V::Mul(r, V::Set1(0.212671f)), V::Mul(g, V::Set1(0.715160f))), V::Mul(b, V::Set1(0.072169f)));
+        }
+
+        // Squared UNORM channel at bit kShift, see SquareUNORM.
+        template <typename V, int kShift>
+        typename V::Float SquareUNORMChannel(typename V::Int pixels, uint32_t maxValue)
+        {
+            const typename V::Int value = V::AndInt(V::template ShiftRightInt<kShift>(pixels), V::Set1Int((int32_t)maxValue));
+            const typename V::Float unorm = V::Div(V::IntToFloat(value), V::Set1((float)maxValue));
+
+            return V::Mul(unorm, unorm);
+        }
+
+        template <typename V>
+        typename V::Float SquareHalfChannel(typename V::Int half)
+        {
+            const typename V::Float value = V::HalfToFloat(half);
+            return V::Mul(value, value);
+        }
+
+        template <typename V>
+        struct VALAR_R32G32B32A32_FLOAT_LOADER
+        {
+            static const uint32_t kPixelSize = 16;
+
+            static typename V::Float Luma(const uint8_t* color, const float*)
+            {
+                return V::Luma((const float*)color);
+            }
+
+            static float LumaScalar(const uint8_t* pixel, const float*)
+            {
+                return LuminanceR32G32B32A32Float((const float*)pixel);
+            }
+        };
+
+        template <typename V>
+        struct VALAR_R16G16B16A16_FLOAT_LOADER
+        {
+            static const uint32_t kPixelSize = 8;
+
+            static typename V::Float Luma(const uint8_t* color, const float*)
+            {
+                typename V::Int rg;
+                typename V::Int ba;
+                V::LoadDeinterleavedInt((const int32_t*)color, rg, ba);
+
+                const typename V::Int halfMask = V::Set1Int(0xFFFF);
+
+                return WeightLuminance<V>(SquareHalfChannel<V>(V::AndInt(rg, halfMask)), SquareHalfChannel<V>(V::template ShiftRightInt<16>(rg)),
+                    SquareHalfChannel<V>(V::AndInt(ba, halfMask)));
+            }
+
+            static float LumaScalar(const uint8_t* pixel, const float*)
+            {
+                return LuminanceR16G16B16A16Float((const uint16_t*)pixel);
+            }
+        };
+
+        template <typename V>
+        struct VALAR_R11G11B10_FLOAT_LOADER
+        {
+            static const uint32_t kPixelSize = 4;
+
+            static typename V::Float Luma(const uint8_t* color, const float*)
+            {
+                const typename V::Int pixels = V::LoadInt((const int32_t*)color);
+                const typename V::Int channelMask = V::Set1Int(0x7FF);
+
+                // Aligning the mantissa turns the channels into halves, see LuminanceR11G11B10Float.
+                const typename V::Int r = V::template ShiftLeftInt<4>(V::AndInt(pixels, channelMask));
+                const typename V::Int g = V::template ShiftLeftInt<4>(V::AndInt(V::template ShiftRightInt<11>(pixels), channelMask));
+                const typename V::Int b = V::template ShiftLeftInt<5>(V::template ShiftRightInt<22>(pixels));
+
+                return WeightLuminance<V>(SquareHalfChannel<V>(r), SquareHalfChannel<V>(g), SquareHalfChannel<V>(b));
+            }
+
+            static float LumaScalar(const uint8_t* pixel, const float*)
+            {
+                return LuminanceR11G11B10Float(*(const uint32_t*)pixel);
+            }
+        };
+
+        template <typename V>
+        struct VALAR_R10G10B10A2_UNORM_LOADER
+        {
+            static const uint32_t kPixelSize = 4;
+
+            static typename V::Float Luma(const uint8_t* color, const float*)
+            {
+                const typename V::Int pixels = V::LoadInt((const int32_t*)color);
+
+                return WeightLuminance<V>(SquareUNORMChannel<V, 0>(pixels, 1023), SquareUNORMChannel<V, 10>(pixels, 1023),
+                    SquareUNORMChannel<V, 20>(pixels, 1023));
+            }
+
+            static float LumaScalar(const uint8_t* pixel, const float*)
+            {
+                return LuminanceR10G10B10A2UNORM(*(const uint32_t*)pixel);
+            }
+        };
+
+        // 8-bit formats with red and blue at byte kRed and kBlue. The square law is computed in registers, the sRGB
+        // curve has no cheap closed form and goes through the table one lane at a time.
+        template <typename V, int kRed, int kBlue, bool kSRGB>
+        struct VALAR_UNORM8_LOADER
+        {
+            static const uint32_t kPixelSize = 4;
+
+            static float LumaScalar(const uint8_t* pixel, const float* linear)
+            {
+                return RGBToLuminance(linear[pixel[kRed]], linear[pixel[1]], linear[pixel[kBlue]]);
+            }
+
+            static int32_t LumaFixedScalar(const uint8_t* pixel, const uint32_t* linearFixed)
+            {
+                return (int32_t)((linearFixed[pixel[kRed]] * VALAR_CPU_UNORM8_WEIGHT_R + linearFixed[pixel[1]] * VALAR_CPU_UNORM8_WEIGHT_G +
+                    linearFixed[pixel[kBlue]] * VALAR_CPU_UNORM8_WEIGHT_B) >> VALAR_CPU_UNORM8_LUMA_SHIFT);
+            }
+
+            static typename V::Float Luma(const uint8_t* color, const float* linear)
+            {
+                if (kSRGB) {
+                    alignas(64) float luma[V::kWidth];
+                    for (uint32_t i = 0; i < V::kWidth; i++) {
+                        luma[i] = LumaScalar(color + i * 4, linear);
+                    }
+                    return V::Load(luma);
+                }
+
+                const typename V::Int pixels = V::LoadInt((const int32_t*)color);
+
+                return WeightLuminance<V>(SquareUNORMChannel<V, kRed * 8>(pixels, 255), SquareUNORMChannel<V, 8>(pixels, 255),
+                    SquareUNORMChannel<V, kBlue * 8>(pixels, 255));
+            }
+
+            static typename V::Int LumaFixed(const uint8_t* color, const uint32_t* linearFixed)
+            {
+                if (kSRGB) {
+                    alignas(64) int32_t luma[V::kWidth];
+                    for (uint32_t i = 0; i < V::kWidth; i++) {
+                        luma[i] = LumaFixedScalar(color + i * 4, linearFixed);
+                    }
+                    return V::LoadInt(luma);
+                }
+
+                const typename V::Int pixels = V::LoadInt((const int32_t*)color);
+                const typename V::Int channelMask = V::Set1Int(0xFF);
+
+                // c * c is the square law in VALAR_CPU_UNORM8_LINEAR_SCALE units.
+                const typename V::Int r = V::SquareInt(V::AndInt(V::template ShiftRightInt<kRed * 8>(pixels), channelMask));
+                const typename V::Int g = V::SquareInt(V::AndInt(V::template ShiftRightInt<8>(pixels), channelMask));
+                const typename V::Int b = V::SquareInt(V::AndInt(V::template ShiftRightInt<kBlue * 8>(pixels), channelMask));
+
+                const typename V::Int luma = V::AddInt(V::AddInt(V::MulInt(r, V::Set1Int(VALAR_CPU_UNORM8_WEIGHT_R)),
+                    V::MulInt(g, V::Set1Int(VALAR_CPU_UNORM8_WEIGHT_G))), V::MulInt(b, V::Set1Int(VALAR_CPU_UNORM8_WEIGHT_B)));
+
+                return V::template ShiftRightInt<VALAR_CPU_UNORM8_LUMA_SHIFT>(luma);
+            }
+        };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <new>
+
+#define INTEL_TILE_SIZE 8
+#define OTHER_TILE_SIZE 16
+#define LARGE_TILE_SIZE 32
+#define VALAR_CPU_MAX_TILE_SIZE LARGE_TILE_SIZE
+// Number of supported tile sizes, see GetTileSizeIndex.
+#define VALAR_CPU_TILE_SIZE_COUNT 3
+// Pixels per tile group of the amortized updates, the tiles of a group are re-evaluated in the same frame.
+#define VALAR_AMORTIZATION_GROUP_WIDTH 32
+
+// Pixels per span processed by the fused tile kernels, the line buffers of a span live on the stack.
+#define VALAR_CPU_SPAN_WIDTH 512
+// Floats of padding after every line buffer, covers the last vector of a span and its x + 1 neighbor.
+#define VALAR_CPU_LINE_PADDING 32
+
+// Fixed-point luminance of the 8-bit color formats. Channels are linearized to VALAR_CPU_UNORM8_LINEAR_SCALE
+// units, which holds the square law exactly, and weighted in 1 / VALAR_CPU_UNORM8_WEIGHT_SCALE units. That scale
+// has the smallest weight rounding error of all scales that keep the weighted sum in 32 bits. The shift keeps the
+// column sums of a 32x32 tile in 32 bits.
+#define VALAR_CPU_UNORM8_LINEAR_SCALE 65025
+#define VALAR_CPU_UNORM8_WEIGHT_SCALE 56049
+#define VALAR_CPU_UNORM8_WEIGHT_R 11920
+#define VALAR_CPU_UNORM8_WEIGHT_G 40084
+#define VALAR_CPU_UNORM8_WEIGHT_B 4045
+#define VALAR_CPU_UNORM8_LUMA_SHIFT 5
+
+#define VALAR_CPU_COLOR_FORMAT_COUNT (VALAR_CPU_FORMAT_R16G16B16A16_FLOAT + 1)
+
+// Mode flags the tile kernels are specialized on, combined they index the kernels of a color format.
+#define VALAR_CPU_KERNEL_MODE_WEBER_FECHNER 0x1
+#define VALAR_CPU_KERNEL_MODE_MOTION_VECTORS 0x2
+#define VALAR_CPU_KERNEL_MODE_UPSCALED_MOTION_VECTORS 0x4
+#define VALAR_CPU_KERNEL_MODE_COUNT 8
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VALAR_CPU_X86
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define VALAR_CPU_ARM64
+#endif
+
+namespace Intel
+{
+    struct VALAR_TILE_STATISTICS
+    {
+        float                       m_lumaSum;
+        float                       m_lumaSumX;
+        float                       m_lumaSumY;
+        float                       m_velocityMin;
+    };
+
+    // Statistics of the fixed-point path, luminance in VALAR_CPU_UNORM8 units and plain absolute differences
+    // without the 0.5 factor of the float path.
+    struct VALAR_TILE_STATISTICS_UNORM8
+    {
+        uint64_t                    m_lumaSum;
+        uint64_t                    m_lumaDifferenceX;
+        uint64_t                    m_lumaDifferenceY;
+        float                       m_velocityMin;
+    };
+
+    struct VALAR_CPU_THREAD_POOL;
+    struct VALAR_CPU_ASYNC_QUEUE;
+    struct VALAR_CPU_TEMPORAL_HISTORY;
+
+    // Computes the statistics of the tiles [tileXBegin, tileXEnd) of tile row tileY, at most VALAR_CPU_SPAN_WIDTH pixels wide.
+    typedef void (*VALAR_CPU_TILE_KERNEL)(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, VALAR_TILE_STATISTICS* stats);
+    // Same for the fixed-point path of the 8-bit color formats, only used without Weber-Fechner mode.
+    typedef void (*VALAR_CPU_TILE_KERNEL_UNORM8)(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, VALAR_TILE_STATISTICS_UNORM8* stats);
+
+    // Tile kernels of one instruction set, specialized per tile size, color format and mode, see GetTileSizeIndex
+    // and GetTileKernelMode. m_unorm8Kernels is null for the formats and modes without a fixed-point path.
+    struct VALAR_CPU_TILE_KERNELS
+    {
+        VALAR_CPU_TILE_KERNEL       m_floatKernels[VALAR_CPU_TILE_SIZE_COUNT][VALAR_CPU_COLOR_FORMAT_COUNT][VALAR_CPU_KERNEL_MODE_COUNT];
+        VALAR_CPU_TILE_KERNEL_UNORM8 m_unorm8Kernels[VALAR_CPU_TILE_SIZE_COUNT][VALAR_CPU_COLOR_FORMAT_COUNT][VALAR_CPU_KERNEL_MODE_COUNT];
+    };
+
+    // Index of a supported tile size in the per tile size tables, 8, 16 and 32 map to 0, 1 and 2.
+    inline uint32_t GetTileSizeIndex(uint32_t tileSize)
+    {
+        return (tileSize == INTEL_TILE_SIZE) ? 0 : ((tileSize == OTHER_TILE_SIZE) ? 1 : 2);
+    }
+
+    // First byte of image row y of a view, y must not be above the first row of the view.
+    inline const uint8_t* GetImageRow(const VALAR_CPU_IMAGE_VIEW& view, uint32_t y)
+    {
+        return (const uint8_t*)view.m_data + (size_t)(y - view.m_firstRow) * view.m_rowPitch;
+    }
+
+    struct VALAR_CPU_DESCRIPTOR_OPAQUE
+    {
+        VALAR_CPU_TILE_KERNELS      m_tileKernels{};
+        VALAR_CPU_FEATURES          m_featureSupport{};
+        VALAR_CPU_THREAD_POOL*      m_threadPool = nullptr;
+        VALAR_CPU_ASYNC_QUEUE*      m_asyncQueue = nullptr;
+        // Statistics of the previous mask, read by ComputeMaskTemporal.
+        VALAR_CPU_TEMPORAL_HISTORY* m_temporalHistory = nullptr;
+        // Frame wide tile counts, accumulated by concurrent tile jobs and consumed by VALAR_FinalizeMaskCPU.
+        std::atomic<uint32_t>       m_shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+        // Serializes the whole masks of the calling thread and of the async queue, which share the history and the
+        // tile counts above, with VALAR_FinalizeMaskCPU.
+        std::mutex                  m_maskLock;
+        // Allocator of everything above, and the number of allocations made through it since VALAR_InitializeCPU.
+        VALAR_CPU_ALLOCATION_CALLBACKS m_allocationCallbacks{};
+        std::atomic<uint64_t>       m_allocationCount{};
+        // Set by VALAR_SetWarmUpCompleteCPU, debug builds assert that nothing is allocated while it is set.
+        std::atomic<bool>           m_isWarmUpComplete{};
+        bool                        m_isInitialized = false;
+    };
+
+    void* AllocateMemory(const VALAR_CPU_ALLOCATION_CALLBACKS& callbacks, size_t size, size_t alignment, VALAR_CPU_ALLOCATION_TAG tag);
+    void FreeMemory(const VALAR_CPU_ALLOCATION_CALLBACKS& callbacks, void* memory, VALAR_CPU_ALLOCATION_TAG tag);
+
+    // Constructs count default initialized objects in memory of the VALAR allocator, returns nullptr when it fails.
+    template <typename T>
+    T* AllocateArray(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, size_t count, VALAR_CPU_ALLOCATION_TAG tag)
+    {
+        // The shader emulation is a test tool and allocates its thread groups per dispatch.
+        assert((tag == VALAR_CPU_ALLOCATION_TAG_SHADER_EMULATION || !opaque.m_isWarmUpComplete.load(std::memory_order_relaxed)) &&
+            "VALAR allocated memory after its warm-up");
+
+        T* objects = (T*)AllocateMemory(opaque.m_allocationCallbacks, sizeof(T) * count, alignof(T), tag);
+        if (objects == nullptr) {
+            return nullptr;
+        }
+
+        opaque.m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < count; i++) {
+            new (&objects[i]) T();
+        }
+
+        return objects;
+    }
+
+    template <typename T>
+    void FreeArray(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, T* objects, size_t count, VALAR_CPU_ALLOCATION_TAG tag)
+    {
+        if (objects == nullptr) {
+            return;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            objects[i].~T();
+        }
+
+        FreeMemory(opaque.m_allocationCallbacks, objects, tag);
+    }
+
+    // Per column masks for the Weber-Fechner neighborhood of a span. Columns on the left (m_left) or right
+    // (m_right) border of a tile hold 10000 so their outside neighbors drop out of the minimum, all other
+    // columns hold -FLT_MAX. m_sentinel is a luminance row of 10000 used for the rows above and below a tile.
+    struct VALAR_CPU_COLUMN_MASKS
+    {
+        alignas(64) float           m_left[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+        alignas(64) float           m_right[VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+        alignas(64) float           m_sentinel[1 + VALAR_CPU_SPAN_WIDTH + VALAR_CPU_LINE_PADDING];
+    };
+
+    // Linearization table of an 8-bit color format, indexed by channel value.
+    struct VALAR_CPU_UNORM8_TABLE
+    {
+        float                       m_linear[256];
+        uint32_t                    m_linearFixed[256];
+    };
+
+    VALAR_RETURN_CODE CheckCPUFeatureSupport(VALAR_CPU_FEATURES& featureSupport);
+    void SelectTileKernels(VALAR_CPU_INSTRUCTION_SET instructionSet, VALAR_CPU_TILE_KERNELS& kernels);
+    void BuildColumnMasks(uint32_t tileSize, VALAR_CPU_COLUMN_MASKS& masks);
+    const VALAR_CPU_COLUMN_MASKS& GetColumnMasks(uint32_t tileSize);
+    void BuildUNORM8Table(VALAR_CPU_FORMAT colorFormat, VALAR_CPU_UNORM8_TABLE& table);
+    const VALAR_CPU_UNORM8_TABLE& GetUNORM8Table(VALAR_CPU_FORMAT colorFormat);
+    uint32_t GetColorPixelSize(VALAR_CPU_FORMAT colorFormat);
+    VALAR_CPU_FORMAT GetColorFormat(const VALAR_CPU_DESCRIPTOR& desc);
+    uint32_t GetTileKernelMode(const VALAR_CPU_DESCRIPTOR& desc);
+    bool IsValidTileSize(uint32_t tileSize);
+    bool IsValidAmortizationPeriod(uint32_t amortizationPeriod);
+    bool IsValidShadingRate(uint32_t shadingRate);
+    uint32_t GetValarRowPitch(const VALAR_CPU_DESCRIPTOR& desc);
+    VALAR_CPU_IMAGE_VIEW GetColorView(const VALAR_CPU_DESCRIPTOR& desc);
+    VALAR_CPU_IMAGE_VIEW GetVelocityView(const VALAR_CPU_DESCRIPTOR& desc);
+    VALAR_CPU_IMAGE_VIEW GetUpscaledVelocityView(const VALAR_CPU_DESCRIPTOR& desc);
+    VALAR_RETURN_CODE ValidateCPUDescriptor(const VALAR_CPU_DESCRIPTOR& desc);
+    float FetchLuminance(const VALAR_CPU_DESCRIPTOR& desc, int32_t x, int32_t y);
+    float FetchLuminance(const VALAR_CPU_IMAGE_VIEW& colorView, int32_t x, int32_t y);
+    float FetchUpscaledVelocity(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_IMAGE_VIEW& velocityView, uint32_t x, uint32_t y);
+    float FetchVelocity(const VALAR_CPU_DESCRIPTOR& desc, uint32_t x, uint32_t y);
+    void FetchVelocityVector(const VALAR_CPU_DESCRIPTOR& desc, uint32_t x, uint32_t y, float& velocityX, float& velocityY);
+    float ComputeMinNeighborLuminance(const float neighborhood[][VALAR_CPU_MAX_TILE_SIZE], uint32_t tileSize, int32_t x, int32_t y);
+    float SumTilePairwise(const float values[][VALAR_CPU_MAX_TILE_SIZE], uint32_t x, uint32_t y, uint32_t size);
+    void ComputeTileStatistics(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileX, uint32_t tileY, VALAR_TILE_STATISTICS& stats);
+    uint8_t ComputeTileShadingRate(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_TILE_STATISTICS& stats);
+    bool ComputeTileShadingRateUNORM8(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_TILE_STATISTICS_UNORM8& stats, uint8_t& shadingRate);
+    bool IsAmortizedTileDue(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileX, uint32_t tileY);
+    bool FindRegionOfInterestSpan(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileX, uint32_t& spanBegin, uint32_t& spanEnd);
+    void CountPreviousShadingRate(uint8_t shadingRate, uint32_t* shadingRateTileCount);
+    void ComputeTileSpan(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd, uint8_t* valarRow, uint32_t* shadingRateTileCount);
+    void ComputeMask(const VALAR_CPU_DESCRIPTOR& desc);
+    void ComputeMaskLP(const VALAR_CPU_DESCRIPTOR& desc);
+    bool ComputeMaskTemporal(const VALAR_CPU_DESCRIPTOR& desc);
+    void PredictMask(const VALAR_CPU_DESCRIPTOR& desc, uint8_t* predictedMask);
+    void AccumulateShadingRateTileCount(const VALAR_CPU_DESCRIPTOR& desc, const uint32_t* shadingRateTileCount);
+
+    void GetTileKernelsScalar(VALAR_CPU_TILE_KERNELS& kernels);
+#if defined(VALAR_CPU_X86)
+    void GetTileKernelsSSE41(VALAR_CPU_TILE_KERNELS& kernels);
+    void GetTileKernelsAVX2(VALAR_CPU_TILE_KERNELS& kernels);
+    void GetTileKernelsAVX512(VALAR_CPU_TILE_KERNELS& kernels);
+#elif defined(VALAR_CPU_ARM64)
+    void GetTileKernelsNEON(VALAR_CPU_TILE_KERNELS& kernels);
+#endif
+}
\ No newline at end of file
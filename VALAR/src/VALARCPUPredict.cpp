@@ -0,0 +1,103 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+
+// Marks the tiles of a predicted mask no tile has been splatted to.
+#define VALAR_CPU_PREDICTED_HOLE 0xFF
+
+// Per axis minimum of two rates, at least as fine as both. The rates of the API stay closed under it.
+static uint8_t GetFinerShadingRate(uint8_t shadingRateA, uint8_t shadingRateB)
+{
+    const uint8_t rateX = ((shadingRateA >> 2) < (shadingRateB >> 2)) ? (shadingRateA >> 2) : (shadingRateB >> 2);
+    const uint8_t rateY = ((shadingRateA & 0x3) < (shadingRateB & 0x3)) ? (shadingRateA & 0x3) : (shadingRateB & 0x3);
+
+    return (uint8_t)((rateX << 2) | rateY);
+}
+
+void Intel::PredictMask(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint8_t* predictedMask)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesX = (desc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+    const uint32_t rowPitch = GetValarRowPitch(desc);
+
+    for (uint32_t tileY = 0; tileY < tilesY; tileY++) {
+        memset(predictedMask + (size_t)tileY * rowPitch, VALAR_CPU_PREDICTED_HOLE, tilesX);
+    }
+
+    for (uint32_t tileY = 0; tileY < tilesY; tileY++) {
+        const uint8_t* valarRow = desc.m_valarBuffer + (size_t)tileY * rowPitch;
+
+        for (uint32_t tileX = 0; tileX < tilesX; tileX++) {
+            const uint32_t centerX = (tileX * tileSize + tileSize / 2 < desc.m_bufferWidth) ? tileX * tileSize + tileSize / 2 : desc.m_bufferWidth - 1;
+            const uint32_t centerY = (tileY * tileSize + tileSize / 2 < desc.m_bufferHeight) ? tileY * tileSize + tileSize / 2 : desc.m_bufferHeight - 1;
+
+            float velocityX;
+            float velocityY;
+            FetchVelocityVector(desc, centerX, centerY, velocityX, velocityY);
+
+            // Motion vectors point to the previous frame, at constant velocity the tile moves the other way.
+            const float nextLeft = (float)(tileX * tileSize) - velocityX;
+            const float nextTop = (float)(tileY * tileSize) - velocityY;
+
+            // Every tile the moved tile overlaps receives its rate, tiles leaving the frame are dropped.
+            const float firstX = floorf(nextLeft / (float)tileSize);
+            const float firstY = floorf(nextTop / (float)tileSize);
+            const float lastX = ceilf((nextLeft + (float)tileSize) / (float)tileSize) - 1.0f;
+            const float lastY = ceilf((nextTop + (float)tileSize) / (float)tileSize) - 1.0f;
+
+            if (lastX < 0.0f || lastY < 0.0f || firstX >= (float)tilesX || firstY >= (float)tilesY) {
+                continue;
+            }
+
+            const uint32_t beginX = (firstX > 0.0f) ? (uint32_t)firstX : 0;
+            const uint32_t beginY = (firstY > 0.0f) ? (uint32_t)firstY : 0;
+            const uint32_t endX = (lastX + 1.0f < (float)tilesX) ? (uint32_t)lastX + 1 : tilesX;
+            const uint32_t endY = (lastY + 1.0f < (float)tilesY) ? (uint32_t)lastY + 1 : tilesY;
+
+            for (uint32_t targetY = beginY; targetY < endY; targetY++) {
+                uint8_t* predictedRow = predictedMask + (size_t)targetY * rowPitch;
+
+                for (uint32_t targetX = beginX; targetX < endX; targetX++) {
+                    // Where tiles land on the same target, the finest rate wins.
+                    predictedRow[targetX] = (predictedRow[targetX] == VALAR_CPU_PREDICTED_HOLE) ? valarRow[tileX] :
+                        GetFinerShadingRate(predictedRow[targetX], valarRow[tileX]);
+                }
+            }
+        }
+    }
+
+    // Holes are disoccluded or entering content whose detail is unknown, they shade at the full rate.
+    for (uint32_t tileY = 0; tileY < tilesY; tileY++) {
+        uint8_t* predictedRow = predictedMask + (size_t)tileY * rowPitch;
+
+        for (uint32_t tileX = 0; tileX < tilesX; tileX++) {
+            if (predictedRow[tileX] == VALAR_CPU_PREDICTED_HOLE) {
+                predictedRow[tileX] = VALAR_SHADING_RATE_1X1;
+            }
+        }
+    }
+}
\ No newline at end of file
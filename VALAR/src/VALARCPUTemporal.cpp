@@ -0,0 +1,236 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARCPUThreadPool.h"
+#include "VALARCPUTemporal.h"
+
+Intel::VALAR_CPU_TEMPORAL_HISTORY* Intel::CreateTemporalHistory(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque)
+{
+    return AllocateArray<VALAR_CPU_TEMPORAL_HISTORY>(opaque, 1, VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY);
+}
+
+static void FreeTemporalTiles(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, Intel::VALAR_CPU_TEMPORAL_HISTORY& history)
+{
+    const size_t tileCount = (size_t)history.m_tilesX * history.m_tilesY;
+
+    Intel::FreeArray(opaque, history.m_tiles[0], tileCount, Intel::VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY);
+    Intel::FreeArray(opaque, history.m_tiles[1], tileCount, Intel::VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY);
+    history.m_tiles[0] = nullptr;
+    history.m_tiles[1] = nullptr;
+    history.m_tilesX = 0;
+    history.m_tilesY = 0;
+    history.m_tileSize = 0;
+    history.m_isValid = false;
+}
+
+void Intel::DestroyTemporalHistory(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, Intel::VALAR_CPU_TEMPORAL_HISTORY* history)
+{
+    if (history == nullptr) {
+        return;
+    }
+
+    FreeTemporalTiles(opaque, *history);
+    FreeArray(opaque, history, 1, VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY);
+}
+
+// Keeps the next temporal mask from reprojecting the statistics of tiles recomputed outside of the temporal mode.
+void Intel::InvalidateTemporalTiles(const Intel::VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd)
+{
+    VALAR_CPU_TEMPORAL_HISTORY& history = *desc.m_pOpaque->m_temporalHistory;
+
+    if (!history.m_isValid || history.m_tileSize != desc.m_shadingRateTileSize || tileY >= history.m_tilesY) {
+        return;
+    }
+
+    VALAR_CPU_TEMPORAL_TILE* tiles = history.m_tiles[history.m_current] + (size_t)tileY * history.m_tilesX;
+    const uint32_t tileXLimit = (tileXEnd < history.m_tilesX) ? tileXEnd : history.m_tilesX;
+
+    // The age test of ReprojectTile rejects these tiles whatever m_temporalMaxAge the next mask uses.
+    for (uint32_t tileX = tileXBegin; tileX < tileXLimit; tileX++) {
+        tiles[tileX].m_age = UINT32_MAX - 1;
+    }
+}
+
+// Looks up the tile of the previous mask the content of tile (tileX, tileY) moved from, and fills the current
+// state of the tile. Returns whether the statistics of that tile can be reused.
+static bool ReprojectTile(const Intel::VALAR_CPU_DESCRIPTOR& desc, const Intel::VALAR_CPU_TEMPORAL_HISTORY& history,
+    const Intel::VALAR_CPU_IMAGE_VIEW& colorView, uint32_t tileX, uint32_t tileY, Intel::VALAR_CPU_TEMPORAL_TILE& tile)
+{
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    // A 2x2 grid of samples in 8x8 tiles, a 4x4 grid in larger tiles. Samples outside of a partial tile load zero in both frames.
+    const uint32_t sampleStep = (tileSize / 4 < 4) ? 4 : tileSize / 4;
+    float lumaSum = 0.0f;
+    float lumaSquareSum = 0.0f;
+
+    for (uint32_t y = tileY * tileSize + sampleStep / 2; y < (tileY + 1) * tileSize; y += sampleStep) {
+        for (uint32_t x = tileX * tileSize + sampleStep / 2; x < (tileX + 1) * tileSize; x += sampleStep) {
+            const float luma = Intel::FetchLuminance(colorView, (int32_t)x, (int32_t)y);
+            lumaSum += luma;
+            lumaSquareSum += luma * luma;
+        }
+    }
+
+    const float sampleCount = (float)((tileSize / sampleStep) * (tileSize / sampleStep));
+    tile.m_sampleLuma = lumaSum / sampleCount;
+    tile.m_sampleContrast = sqrtf(lumaSquareSum / sampleCount);
+
+    const uint32_t centerX = (tileX * tileSize + tileSize / 2 < desc.m_bufferWidth) ? tileX * tileSize + tileSize / 2 : desc.m_bufferWidth - 1;
+    const uint32_t centerY = (tileY * tileSize + tileSize / 2 < desc.m_bufferHeight) ? tileY * tileSize + tileSize / 2 : desc.m_bufferHeight - 1;
+    Intel::FetchVelocityVector(desc, centerX, centerY, tile.m_velocityX, tile.m_velocityY);
+
+    if (!history.m_isValid) {
+        return false;
+    }
+
+    // Content moving in from outside of the frame is disoccluded.
+    const float previousX = (float)centerX + 0.5f + tile.m_velocityX;
+    const float previousY = (float)centerY + 0.5f + tile.m_velocityY;
+
+    if (!(previousX >= 0.0f && previousY >= 0.0f && previousX < (float)desc.m_bufferWidth && previousY < (float)desc.m_bufferHeight)) {
+        return false;
+    }
+
+    const uint32_t previousTileX = (uint32_t)previousX / tileSize;
+    const uint32_t previousTileY = (uint32_t)previousY / tileSize;
+
+    // The statistics of border tiles miss the neighbors outside of the frame, they only match another border tile in place.
+    const bool isBorderTile = tileX == 0 || tileY == 0 || tileX + 1 == history.m_tilesX || tileY + 1 == history.m_tilesY;
+    const bool isPreviousBorderTile = previousTileX == 0 || previousTileY == 0 || previousTileX + 1 == history.m_tilesX || previousTileY + 1 == history.m_tilesY;
+    if ((isBorderTile || isPreviousBorderTile) && (previousTileX != tileX || previousTileY != tileY)) {
+        return false;
+    }
+
+    const Intel::VALAR_CPU_TEMPORAL_TILE& previous = history.m_tiles[history.m_current ^ 1][(size_t)previousTileY * history.m_tilesX + previousTileX];
+
+    if (previous.m_age + 1 >= desc.m_temporalMaxAge) {
+        return false;
+    }
+
+    // Diverging motion vectors mark a disocclusion, the previous tile held another surface.
+    if (fabsf(tile.m_velocityX - previous.m_velocityX) + fabsf(tile.m_velocityY - previous.m_velocityY) > desc.m_temporalVelocityTolerance) {
+        return false;
+    }
+
+    // The mean catches brightness changes, the root mean square changes of detail with the same mean.
+    if (fabsf(tile.m_sampleLuma - previous.m_sampleLuma) > desc.m_temporalLumaTolerance * (previous.m_sampleLuma + desc.m_environmentLuminance) ||
+        fabsf(tile.m_sampleContrast - previous.m_sampleContrast) > desc.m_temporalLumaTolerance * (previous.m_sampleContrast + desc.m_environmentLuminance)) {
+        return false;
+    }
+
+    tile.m_stats = previous.m_stats;
+    tile.m_age = previous.m_age + 1;
+
+    return true;
+}
+
+static void ComputeTemporalRowJob(void* context, uint32_t tileY)
+{
+    const Intel::VALAR_CPU_DESCRIPTOR& desc = *(const Intel::VALAR_CPU_DESCRIPTOR*)context;
+    const Intel::VALAR_CPU_TEMPORAL_HISTORY& history = *desc.m_pOpaque->m_temporalHistory;
+    const Intel::VALAR_CPU_IMAGE_VIEW colorView = Intel::GetColorView(desc);
+    const uint32_t tilesX = history.m_tilesX;
+    const uint32_t tilesPerSpan = VALAR_CPU_SPAN_WIDTH / desc.m_shadingRateTileSize;
+    Intel::VALAR_CPU_TEMPORAL_TILE* tiles = history.m_tiles[history.m_current] + (size_t)tileY * tilesX;
+    uint8_t* valarRow = desc.m_valarBuffer + (size_t)tileY * Intel::GetValarRowPitch(desc);
+
+    // Recomputed tiles take the float kernels, the fixed-point statistics of the 8-bit formats are not kept.
+    const Intel::VALAR_CPU_TILE_KERNEL tileKernel = desc.m_pOpaque->m_tileKernels.m_floatKernels[Intel::GetTileSizeIndex(desc.m_shadingRateTileSize)]
+        [Intel::GetColorFormat(desc)][Intel::GetTileKernelMode(desc)];
+
+    Intel::VALAR_TILE_STATISTICS stats[VALAR_CPU_SPAN_WIDTH / INTEL_TILE_SIZE];
+    bool isReused[VALAR_CPU_SPAN_WIDTH / INTEL_TILE_SIZE];
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+
+    for (uint32_t spanBegin = 0; spanBegin < tilesX; spanBegin += tilesPerSpan) {
+        const uint32_t spanEnd = (spanBegin + tilesPerSpan < tilesX) ? spanBegin + tilesPerSpan : tilesX;
+
+        for (uint32_t tileX = spanBegin; tileX < spanEnd; tileX++) {
+            isReused[tileX - spanBegin] = ReprojectTile(desc, history, colorView, tileX, tileY, tiles[tileX]);
+        }
+
+        // Runs of rejected tiles go through the tile kernels like a full mask.
+        for (uint32_t tileX = spanBegin; tileX < spanEnd;) {
+            if (isReused[tileX - spanBegin]) {
+                tileX++;
+                continue;
+            }
+
+            const uint32_t runBegin = tileX;
+
+            while (tileX < spanEnd && !isReused[tileX - spanBegin]) {
+                tileX++;
+            }
+
+            tileKernel(desc, tileY, runBegin, tileX, stats);
+
+            for (uint32_t runTileX = runBegin; runTileX < tileX; runTileX++) {
+                tiles[runTileX].m_stats = stats[runTileX - runBegin];
+                tiles[runTileX].m_age = 0;
+            }
+        }
+
+        for (uint32_t tileX = spanBegin; tileX < spanEnd; tileX++) {
+            const uint8_t shadingRate = Intel::ComputeTileShadingRate(desc, tiles[tileX].m_stats);
+
+            valarRow[tileX] = shadingRate;
+            shadingRateTileCount[shadingRate]++;
+        }
+    }
+
+    Intel::AccumulateShadingRateTileCount(desc, shadingRateTileCount);
+}
+
+bool Intel::ComputeMaskTemporal(const Intel::VALAR_CPU_DESCRIPTOR& desc)
+{
+    VALAR_CPU_TEMPORAL_HISTORY& history = *desc.m_pOpaque->m_temporalHistory;
+    const uint32_t tileSize = desc.m_shadingRateTileSize;
+    const uint32_t tilesX = (desc.m_bufferWidth + tileSize - 1) / tileSize;
+    const uint32_t tilesY = (desc.m_bufferHeight + tileSize - 1) / tileSize;
+
+    if (tilesX != history.m_tilesX || tilesY != history.m_tilesY || tileSize != history.m_tileSize) {
+        // Resizes are rare, the first mask at a new size computes every tile.
+        FreeTemporalTiles(*desc.m_pOpaque, history);
+        history.m_tiles[0] = AllocateArray<VALAR_CPU_TEMPORAL_TILE>(*desc.m_pOpaque, (size_t)tilesX * tilesY, VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY);
+        history.m_tiles[1] = AllocateArray<VALAR_CPU_TEMPORAL_TILE>(*desc.m_pOpaque, (size_t)tilesX * tilesY, VALAR_CPU_ALLOCATION_TAG_TEMPORAL_HISTORY);
+
+        if (history.m_tiles[0] == nullptr || history.m_tiles[1] == nullptr) {
+            return false;
+        }
+
+        history.m_tilesX = tilesX;
+        history.m_tilesY = tilesY;
+        history.m_tileSize = tileSize;
+        history.m_isValid = false;
+    }
+
+    history.m_current ^= 1;
+
+    DispatchThreadPool(desc.m_pOpaque->m_threadPool, tilesY, ComputeTemporalRowJob, (void*)&desc);
+
+    history.m_isValid = true;
+
+    return true;
+}
\ No newline at end of file
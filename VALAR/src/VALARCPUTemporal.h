@@ -0,0 +1,58 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <cstdint>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+
+namespace Intel
+{
+    // Per tile state of the temporal mode, kept from one mask to the next.
+    struct VALAR_CPU_TEMPORAL_TILE
+    {
+        VALAR_TILE_STATISTICS       m_stats;
+        // Mean and root mean square luminance of a sample grid, compared against the reprojected tile of the next frame.
+        float                       m_sampleLuma;
+        float                       m_sampleContrast;
+        // Motion vector at the tile center, pointing to the tile position in the previous frame.
+        float                       m_velocityX;
+        float                       m_velocityY;
+        // Frames since the statistics were computed from the pixels.
+        uint32_t                    m_age;
+    };
+
+    // Tiles of the previous and the current mask, swapped after every temporal mask. The history is dropped when
+    // the mask size changes or a mask is computed without the temporal mode.
+    struct VALAR_CPU_TEMPORAL_HISTORY
+    {
+        VALAR_CPU_TEMPORAL_TILE*    m_tiles[2] = {};
+        uint32_t                    m_tilesX = 0;
+        uint32_t                    m_tilesY = 0;
+        uint32_t                    m_tileSize = 0;
+        uint32_t                    m_current = 0;
+        bool                        m_isValid = false;
+    };
+
+    VALAR_CPU_TEMPORAL_HISTORY* CreateTemporalHistory(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque);
+    void DestroyTemporalHistory(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, VALAR_CPU_TEMPORAL_HISTORY* history);
+    void InvalidateTemporalTiles(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileY, uint32_t tileXBegin, uint32_t tileXEnd);
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUThreadPool.h"
+
+static void SetThreadCore(std::thread& thread, uint32_t core)
+{
+#if defined(_WIN32)
+    if (core < 64) {
+        SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)1 << core);
+    }
+#elif defined(__linux__)
+    if (core < CPU_SETSIZE) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(core, &cpuSet);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet);
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+static bool PopWork(Intel::VALAR_CPU_WORK_RANGE& range, uint32_t& index)
+{
+    std::lock_guard<std::mutex> lock(range.m_lock);
+
+    if (range.m_begin >= range.m_end) {
+        return false;
+    }
+
+    index = range.m_begin++;
+
+    return true;
+}
+
+static bool StealWork(Intel::VALAR_CPU_THREAD_POOL* pool, uint32_t participant)
+{
+    const uint32_t participantCount = pool->m_workerCount + 1;
+
+    for (uint32_t i = 1; i < participantCount; i++) {
+        Intel::VALAR_CPU_WORK_RANGE& victim = pool->m_ranges[(participant + i) % participantCount];
+
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        {
+            std::lock_guard<std::mutex> lock(victim.m_lock);
+
+            if (victim.m_begin >= victim.m_end) {
+                continue;
+            }
+
+            const uint32_t remaining = victim.m_end - victim.m_begin;
+
+            // Take the back half, the victim keeps working through the front of its range.
+            begin = victim.m_end - (remaining + 1) / 2;
+            end = victim.m_end;
+            victim.m_end = begin;
+        }
+
+        Intel::VALAR_CPU_WORK_RANGE& own = pool->m_ranges[participant];
+        std::lock_guard<std::mutex> lock(own.m_lock);
+        own.m_begin = begin;
+        own.m_end = end;
+
+        return true;
+    }
+
+    return false;
+}
+
+static void RunParticipant(Intel::VALAR_CPU_THREAD_POOL* pool, uint32_t participant)
+{
+    const Intel::VALAR_CPU_THREAD_POOL_JOB job = pool->m_job;
+    void* context = pool->m_context;
+
+    do {
+        uint32_t index;
+        while (PopWork(pool->m_ranges[participant], index)) {
+            job(context, index);
+        }
+    } while (StealWork(pool, participant));
+}
+
+static void WorkerMain(Intel::VALAR_CPU_THREAD_POOL* pool, uint32_t participant)
+{
+    uint64_t generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->m_lock);
+            pool->m_wakeCondition.wait(lock, [&] { return pool->m_shutdown || pool->m_generation != generation; });
+
+            if (pool->m_shutdown) {
+                return;
+            }
+
+            generation = pool->m_generation;
+        }
+
+        RunParticipant(pool, participant);
+
+        {
+            std::lock_guard<std::mutex> lock(pool->m_lock);
+            if (--pool->m_activeWorkers == 0) {
+                pool->m_doneCondition.notify_one();
+            }
+        }
+    }
+}
+
+Intel::VALAR_CPU_THREAD_POOL* Intel::CreateThreadPool(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, uint32_t workerCount, const uint32_t* workerCores)
+{
+    VALAR_CPU_THREAD_POOL* pool = AllocateArray<VALAR_CPU_THREAD_POOL>(opaque, 1, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+    if (pool == nullptr) {
+        return nullptr;
+    }
+
+    // Participant 0 is the thread calling DispatchThreadPool, workers are participants 1..N.
+    pool->m_workerCount = workerCount;
+    pool->m_ranges = AllocateArray<VALAR_CPU_WORK_RANGE>(opaque, workerCount + 1, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+    pool->m_workers = (workerCount > 0) ? AllocateArray<std::thread>(opaque, workerCount, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL) : nullptr;
+
+    if (pool->m_ranges == nullptr || (workerCount > 0 && pool->m_workers == nullptr)) {
+        FreeArray(opaque, pool->m_workers, workerCount, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+        FreeArray(opaque, pool->m_ranges, workerCount + 1, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+        FreeArray(opaque, pool, 1, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < workerCount; i++) {
+        pool->m_workers[i] = std::thread(WorkerMain, pool, i + 1);
+
+        if (workerCores != nullptr) {
+            SetThreadCore(pool->m_workers[i], workerCores[i]);
+        }
+    }
+
+    return pool;
+}
+
+void Intel::DestroyThreadPool(Intel::VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, Intel::VALAR_CPU_THREAD_POOL* pool)
+{
+    if (pool == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->m_lock);
+        pool->m_shutdown = true;
+    }
+    pool->m_wakeCondition.notify_all();
+
+    for (uint32_t i = 0; i < pool->m_workerCount; i++) {
+        pool->m_workers[i].join();
+    }
+
+    FreeArray(opaque, pool->m_workers, pool->m_workerCount, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+    FreeArray(opaque, pool->m_ranges, pool->m_workerCount + 1, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+    FreeArray(opaque, pool, 1, VALAR_CPU_ALLOCATION_TAG_THREAD_POOL);
+}
+
+void Intel::DispatchThreadPool(Intel::VALAR_CPU_THREAD_POOL* pool, uint32_t count, Intel::VALAR_CPU_THREAD_POOL_JOB job, void* context)
+{
+    if (pool == nullptr || pool->m_workerCount == 0 || count <= 1) {
+        for (uint32_t i = 0; i < count; i++) {
+            job(context, i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatchLock(pool->m_dispatchLock);
+
+    // Seed every participant with a contiguous slice, stealing evens out the imbalance.
+    const uint32_t participantCount = pool->m_workerCount + 1;
+    for (uint32_t i = 0; i < participantCount; i++) {
+        std::lock_guard<std::mutex> lock(pool->m_ranges[i].m_lock);
+        pool->m_ranges[i].m_begin = (uint32_t)(((uint64_t)count * i) / participantCount);
+        pool->m_ranges[i].m_end = (uint32_t)(((uint64_t)count * (i + 1)) / participantCount);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->m_lock);
+        pool->m_job = job;
+        pool->m_context = context;
+        pool->m_activeWorkers = pool->m_workerCount;
+        pool->m_generation++;
+    }
+    pool->m_wakeCondition.notify_all();
+
+    RunParticipant(pool, 0);
+
+    std::unique_lock<std::mutex> lock(pool->m_lock);
+    pool->m_doneCondition.wait(lock, [&] { return pool->m_activeWorkers == 0; });
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace Intel
+{
+    struct VALAR_CPU_DESCRIPTOR_OPAQUE;
+
+    typedef void (*VALAR_CPU_THREAD_POOL_JOB)(void* context, uint32_t index);
+
+    // Range of job indices owned by one participant. The owner pops from the front and
+    // idle participants steal the back half, so ranges are padded to keep them on separate cache lines.
+    struct VALAR_CPU_WORK_RANGE
+    {
+        std::mutex                  m_lock;
+        uint32_t                    m_begin = 0;
+        uint32_t                    m_end = 0;
+        uint8_t                     m_padding[64];
+    };
+
+    struct VALAR_CPU_THREAD_POOL
+    {
+        std::thread*                m_workers = nullptr;
+        VALAR_CPU_WORK_RANGE*       m_ranges = nullptr;
+        uint32_t                    m_workerCount = 0;
+
+        // Serializes dispatches from the calling thread and the async mask thread.
+        std::mutex                  m_dispatchLock;
+        std::mutex                  m_lock;
+        std::condition_variable     m_wakeCondition;
+        std::condition_variable     m_doneCondition;
+        uint64_t                    m_generation = 0;
+        uint32_t                    m_activeWorkers = 0;
+        bool                        m_shutdown = false;
+
+        VALAR_CPU_THREAD_POOL_JOB   m_job = nullptr;
+        void*                       m_context = nullptr;
+    };
+
+    VALAR_CPU_THREAD_POOL* CreateThreadPool(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, uint32_t workerCount, const uint32_t* workerCores);
+    void DestroyThreadPool(VALAR_CPU_DESCRIPTOR_OPAQUE& opaque, VALAR_CPU_THREAD_POOL* pool);
+    void DispatchThreadPool(VALAR_CPU_THREAD_POOL* pool, uint32_t count, VALAR_CPU_THREAD_POOL_JOB job, void* context);
+}
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include <wrl.h>
 #include <d3d12.h>
 #include <cassert>
+#include <climits>
 
 #include "VALAR.h"
 #include "VALAROpaque.h"
@@ -30,10 +31,122 @@
 #ifdef USE_EMBEDED_SHADERS
     #include "Valar8x8CS.h"
     #include "Valar16x16CS.h"
+    #include "Valar32x32CS.h"
     #include "ValarDebugCS.h"
     #include "ValarLPCS.h"
+    #include "Valar8x8LumaCS.h"
+    #include "Valar8x8VelocityCS.h"
+    #include "Valar8x8UpscaledVelocityCS.h"
+    #include "Valar8x8WFCS.h"
+    #include "Valar8x8WFVelocityCS.h"
+    #include "Valar8x8WFUpscaledVelocityCS.h"
+    #include "Valar16x16LumaCS.h"
+    #include "Valar16x16VelocityCS.h"
+    #include "Valar16x16UpscaledVelocityCS.h"
+    #include "Valar16x16WFCS.h"
+    #include "Valar16x16WFVelocityCS.h"
+    #include "Valar16x16WFUpscaledVelocityCS.h"
+    #include "Valar32x32LumaCS.h"
+    #include "Valar32x32VelocityCS.h"
+    #include "Valar32x32UpscaledVelocityCS.h"
+    #include "Valar32x32WFCS.h"
+    #include "Valar32x32WFVelocityCS.h"
+    #include "Valar32x32WFUpscaledVelocityCS.h"
+    #include "Valar8x8AmortizedCS.h"
+    #include "Valar16x16AmortizedCS.h"
+    #include "Valar32x32AmortizedCS.h"
+    #include "Valar8x8BatchedCS.h"
+    #include "Valar16x16BatchedCS.h"
+    #include "Valar32x32BatchedCS.h"
 #endif
 
+// Specialized permutation for every combination of VALAR_SHADER_MODE flags. Upscaled motion vectors without
+// motion vectors are never selected and share the permutations without velocity.
+static constexpr Intel::VALAR_SHADER_PERMUTATIONS kValar8x8Permutations[VALAR_SHADER_MODE_COUNT] =
+{
+    Intel::VALAR_SHADER_8X8_LUMA,
+    Intel::VALAR_SHADER_8X8_WF,
+    Intel::VALAR_SHADER_8X8_VELOCITY,
+    Intel::VALAR_SHADER_8X8_WF_VELOCITY,
+    Intel::VALAR_SHADER_8X8_LUMA,
+    Intel::VALAR_SHADER_8X8_WF,
+    Intel::VALAR_SHADER_8X8_UPSCALED_VELOCITY,
+    Intel::VALAR_SHADER_8X8_WF_UPSCALED_VELOCITY
+};
+
+static constexpr Intel::VALAR_SHADER_PERMUTATIONS kValar16x16Permutations[VALAR_SHADER_MODE_COUNT] =
+{
+    Intel::VALAR_SHADER_16X16_LUMA,
+    Intel::VALAR_SHADER_16X16_WF,
+    Intel::VALAR_SHADER_16X16_VELOCITY,
+    Intel::VALAR_SHADER_16X16_WF_VELOCITY,
+    Intel::VALAR_SHADER_16X16_LUMA,
+    Intel::VALAR_SHADER_16X16_WF,
+    Intel::VALAR_SHADER_16X16_UPSCALED_VELOCITY,
+    Intel::VALAR_SHADER_16X16_WF_UPSCALED_VELOCITY
+};
+
+static constexpr Intel::VALAR_SHADER_PERMUTATIONS kValar32x32Permutations[VALAR_SHADER_MODE_COUNT] =
+{
+    Intel::VALAR_SHADER_32X32_LUMA,
+    Intel::VALAR_SHADER_32X32_WF,
+    Intel::VALAR_SHADER_32X32_VELOCITY,
+    Intel::VALAR_SHADER_32X32_WF_VELOCITY,
+    Intel::VALAR_SHADER_32X32_LUMA,
+    Intel::VALAR_SHADER_32X32_WF,
+    Intel::VALAR_SHADER_32X32_UPSCALED_VELOCITY,
+    Intel::VALAR_SHADER_32X32_WF_UPSCALED_VELOCITY
+};
+
+// The shaders are compiled per tile size, TILE_SIZE sizes the thread group and the groupshared tile of ValarCS.hlsli.
+static const Intel::VALAR_SHADER_PERMUTATIONS* GetValarPermutations(UINT tileSize)
+{
+    if (tileSize == INTEL_TILE_SIZE) {
+        return kValar8x8Permutations;
+    }
+
+    return (tileSize == LARGE_TILE_SIZE) ? kValar32x32Permutations : kValar16x16Permutations;
+}
+
+static Intel::VALAR_SHADER_PERMUTATIONS GetGenericValarShader(UINT tileSize)
+{
+    if (tileSize == INTEL_TILE_SIZE) {
+        return Intel::VALAR_SHADER_8X8;
+    }
+
+    return (tileSize == LARGE_TILE_SIZE) ? Intel::VALAR_SHADER_32X32 : Intel::VALAR_SHADER_16X16;
+}
+
+static Intel::VALAR_SHADER_PERMUTATIONS GetAmortizedValarShader(UINT tileSize)
+{
+    if (tileSize == INTEL_TILE_SIZE) {
+        return Intel::VALAR_SHADER_8X8_AMORTIZED;
+    }
+
+    return (tileSize == LARGE_TILE_SIZE) ? Intel::VALAR_SHADER_32X32_AMORTIZED : Intel::VALAR_SHADER_16X16_AMORTIZED;
+}
+
+static Intel::VALAR_SHADER_PERMUTATIONS GetBatchedValarShader(UINT tileSize)
+{
+    if (tileSize == INTEL_TILE_SIZE) {
+        return Intel::VALAR_SHADER_8X8_BATCHED;
+    }
+
+    return (tileSize == LARGE_TILE_SIZE) ? Intel::VALAR_SHADER_32X32_BATCHED : Intel::VALAR_SHADER_16X16_BATCHED;
+}
+
+static bool IsValidAmortizationPeriod(UINT amortizationPeriod)
+{
+    return amortizationPeriod == 1 || amortizationPeriod == 2 || amortizationPeriod == 4 || amortizationPeriod == 8 || amortizationPeriod == 16;
+}
+
+static bool IsValidShadingRate(UINT shadingRate)
+{
+    return shadingRate == Intel::VALAR_SHADING_RATE_1X1 || shadingRate == Intel::VALAR_SHADING_RATE_1X2 || shadingRate == Intel::VALAR_SHADING_RATE_2X1 ||
+        shadingRate == Intel::VALAR_SHADING_RATE_2X2 || shadingRate == Intel::VALAR_SHADING_RATE_2X4 || shadingRate == Intel::VALAR_SHADING_RATE_4X2 ||
+        shadingRate == Intel::VALAR_SHADING_RATE_4X4;
+}
+
 Intel::VALAR_DESCRIPTOR::VALAR_DESCRIPTOR()
 {
     static VALAR_DESCRIPTOR_OPAQUE opaque;
@@ -77,16 +190,19 @@ const Intel::VALAR_RETURN_CODE Intel::VALAR_Initialize(Intel::VALAR_DESCRIPTOR &
             return retCode;
         }
 
-        if (desc.m_hwFeatures.m_shadingRateTileSize == INTEL_TILE_SIZE) {
-            retCode = LoadShader(desc, VALAR_SHADER_8X8);
-            if (retCode != VALAR_RETURN_CODE_SUCCESS) {
-                return retCode;
-            }
-        } else {
-            retCode = LoadShader(desc, VALAR_SHADER_16X16);
-            if (retCode != VALAR_RETURN_CODE_SUCCESS) {
-                return retCode;
-            }
+        retCode = CreateVALARBatchRootSignature(desc);
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
+        }
+
+        retCode = LoadShader(desc, GetGenericValarShader(desc.m_hwFeatures.m_shadingRateTileSize));
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
+        }
+
+        retCode = LoadSpecializedShaders(desc, desc.m_hwFeatures.m_shadingRateTileSize);
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
         }
 
         retCode = LoadShader(desc, VALAR_DEBUG_SHADER);
@@ -165,7 +281,7 @@ Intel::VALAR_RETURN_CODE Intel::CheckHardwareSupport(Intel::VALAR_DESCRIPTOR& de
      descRange[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 4, 0);
      descRange[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 13, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
 
-     rootParams[0].InitAsConstants(13, 0);
+     rootParams[0].InitAsConstants(19, 0);
      rootParams[1].InitAsDescriptorTable(1, &descRange[0]);
      rootSignatureDesc.Init_1_1(_countof(rootParams), rootParams, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
 
@@ -220,6 +336,45 @@ Intel::VALAR_RETURN_CODE Intel::CheckHardwareSupport(Intel::VALAR_DESCRIPTOR& de
      return VALAR_RETURN_CODE_SUCCESS;
  }
 
+ // Batched root signature, the descriptor table holds VALAR_MAX_BATCH_VIEW_COUNT masks, then as many color buffers,
+ // velocity buffers and upscaled velocity buffers. Slot i of every block belongs to view i.
+ Intel::VALAR_RETURN_CODE Intel::CreateVALARBatchRootSignature(Intel::VALAR_DESCRIPTOR& desc)
+ {
+     ComPtr<ID3DBlob> signature, errors;
+
+     CD3DX12_DESCRIPTOR_RANGE1 descRange[4] = {};
+     CD3DX12_ROOT_PARAMETER1 rootParams[2] = {};
+     D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+
+     featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+
+     if (FAILED(desc.m_device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData)))) {
+         featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+     }
+
+     for (UINT space = 0; space < _countof(descRange); space++) {
+         descRange[space].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, VALAR_MAX_BATCH_VIEW_COUNT, 0, space + 1);
+     }
+
+     rootParams[0].InitAsConstants(19, 0);
+     rootParams[1].InitAsDescriptorTable(_countof(descRange), descRange);
+     rootSignatureDesc.Init_1_1(_countof(rootParams), rootParams, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+     if (FAILED(D3D12SerializeVersionedRootSignature(&rootSignatureDesc, &signature, &errors))) {
+         return VALAR_RETURN_CODE_ROOTSIG_FAIL;
+     }
+
+     auto sig = desc.m_pOpaque->m_valarBatchRootSignature.Get();
+
+     if (FAILED(desc.m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&sig)))) {
+         return VALAR_RETURN_CODE_ROOTSIG_FAIL;
+     }
+     desc.m_pOpaque->m_valarBatchRootSignature = sig;
+
+     return VALAR_RETURN_CODE_SUCCESS;
+ }
+
  Intel::VALAR_RETURN_CODE Intel::CreateVALARDebugRootSignature(Intel::VALAR_DESCRIPTOR& desc)
  {
      ComPtr<ID3DBlob> signature, errors;
@@ -281,6 +436,106 @@ Intel::VALAR_RETURN_CODE Intel::LoadShader(Intel::VALAR_DESCRIPTOR& desc, VALAR_
         pComputeShaderData = (UINT8*)g_valarLPByteCode;
         computeShaderDataLength = sizeof(g_valarLPByteCode) / sizeof(const unsigned char);
         break;
+    case VALAR_SHADER_8X8_LUMA:
+        pComputeShaderData = (UINT8*)g_valar8x8LumaByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8LumaByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar8x8VelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8VelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_UPSCALED_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar8x8UpscaledVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8UpscaledVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_WF:
+        pComputeShaderData = (UINT8*)g_valar8x8WFByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8WFByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_WF_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar8x8WFVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8WFVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_WF_UPSCALED_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar8x8WFUpscaledVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8WFUpscaledVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_LUMA:
+        pComputeShaderData = (UINT8*)g_valar16x16LumaByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16LumaByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar16x16VelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16VelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_UPSCALED_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar16x16UpscaledVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16UpscaledVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_WF:
+        pComputeShaderData = (UINT8*)g_valar16x16WFByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16WFByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_WF_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar16x16WFVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16WFVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_WF_UPSCALED_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar16x16WFUpscaledVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16WFUpscaledVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32:
+        pComputeShaderData = (UINT8*)g_valar32x32ByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32ByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_LUMA:
+        pComputeShaderData = (UINT8*)g_valar32x32LumaByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32LumaByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar32x32VelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32VelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_UPSCALED_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar32x32UpscaledVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32UpscaledVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_WF:
+        pComputeShaderData = (UINT8*)g_valar32x32WFByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32WFByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_WF_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar32x32WFVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32WFVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_WF_UPSCALED_VELOCITY:
+        pComputeShaderData = (UINT8*)g_valar32x32WFUpscaledVelocityByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32WFUpscaledVelocityByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_AMORTIZED:
+        pComputeShaderData = (UINT8*)g_valar8x8AmortizedByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8AmortizedByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_AMORTIZED:
+        pComputeShaderData = (UINT8*)g_valar16x16AmortizedByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16AmortizedByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_AMORTIZED:
+        pComputeShaderData = (UINT8*)g_valar32x32AmortizedByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32AmortizedByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_8X8_BATCHED:
+        pComputeShaderData = (UINT8*)g_valar8x8BatchedByteCode;
+        computeShaderDataLength = sizeof(g_valar8x8BatchedByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_16X16_BATCHED:
+        pComputeShaderData = (UINT8*)g_valar16x16BatchedByteCode;
+        computeShaderDataLength = sizeof(g_valar16x16BatchedByteCode) / sizeof(const unsigned char);
+        break;
+    case VALAR_SHADER_32X32_BATCHED:
+        pComputeShaderData = (UINT8*)g_valar32x32BatchedByteCode;
+        computeShaderDataLength = sizeof(g_valar32x32BatchedByteCode) / sizeof(const unsigned char);
+        break;
     }
 #else
     if (desc.m_shaderBlobs[permutation] == nullptr)
@@ -299,6 +554,9 @@ Intel::VALAR_RETURN_CODE Intel::LoadShader(Intel::VALAR_DESCRIPTOR& desc, VALAR_
     {
         psoDesc.pRootSignature = desc.m_pOpaque->m_valarLPRootSignature.Get();
     }
+    else if (permutation == VALAR_SHADER_8X8_BATCHED || permutation == VALAR_SHADER_16X16_BATCHED || permutation == VALAR_SHADER_32X32_BATCHED) {
+        psoDesc.pRootSignature = desc.m_pOpaque->m_valarBatchRootSignature.Get();
+    }
     else {
         psoDesc.pRootSignature = desc.m_pOpaque->m_valarRootSignature.Get();
     }
@@ -312,6 +570,85 @@ Intel::VALAR_RETURN_CODE Intel::LoadShader(Intel::VALAR_DESCRIPTOR& desc, VALAR_
     return VALAR_RETURN_CODE_SUCCESS;
 }
 
+Intel::VALAR_RETURN_CODE Intel::LoadSpecializedShaders(Intel::VALAR_DESCRIPTOR& desc, UINT tileSize)
+{
+    const VALAR_SHADER_PERMUTATIONS* permutations = GetValarPermutations(tileSize);
+
+    for (UINT mode = 0; mode < VALAR_SHADER_MODE_COUNT; mode++) {
+        const VALAR_SHADER_PERMUTATIONS permutation = permutations[mode];
+
+        // Modes sharing a permutation load it once.
+        if (desc.m_pOpaque->m_valarShaderPermutations[permutation] != nullptr) {
+            continue;
+        }
+
+#ifndef USE_EMBEDED_SHADERS
+        // Custom shader blobs may leave out the specialized permutations, the generic shader runs instead.
+        if (desc.m_shaderBlobs[permutation] == nullptr) {
+            continue;
+        }
+#endif
+
+        VALAR_RETURN_CODE retCode = LoadShader(desc, permutation);
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
+        }
+    }
+
+    const VALAR_SHADER_PERMUTATIONS amortizedPermutation = GetAmortizedValarShader(tileSize);
+
+#ifndef USE_EMBEDED_SHADERS
+    // Without the amortized shader every tile is updated every frame.
+    if (desc.m_shaderBlobs[amortizedPermutation] != nullptr)
+#endif
+    {
+        VALAR_RETURN_CODE retCode = LoadShader(desc, amortizedPermutation);
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            return retCode;
+        }
+    }
+
+    const VALAR_SHADER_PERMUTATIONS batchedPermutation = GetBatchedValarShader(tileSize);
+
+#ifndef USE_EMBEDED_SHADERS
+    // Without the batched shader VALAR_ComputeMaskBatch is not supported.
+    if (desc.m_shaderBlobs[batchedPermutation] == nullptr) {
+        return VALAR_RETURN_CODE_SUCCESS;
+    }
+#endif
+
+    return LoadShader(desc, batchedPermutation);
+}
+
+// Picks the permutation once per dispatch, so the shader never branches on the mode flags of the root constants.
+ID3D12PipelineState* Intel::GetValarPipelineState(const Intel::VALAR_DESCRIPTOR& desc)
+{
+    const UINT tileSize = desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize;
+
+    // The amortized shader reads the modes from the root constants, its early out saves more than specialization.
+    if (desc.m_amortizationPeriod > 1) {
+        ID3D12PipelineState* amortizedPipelineState = desc.m_pOpaque->m_valarShaderPermutations[GetAmortizedValarShader(tileSize)].Get();
+        if (amortizedPipelineState != nullptr) {
+            return amortizedPipelineState;
+        }
+    }
+
+    UINT mode = desc.m_weberFechnerMode ? VALAR_SHADER_MODE_WEBER_FECHNER : 0;
+    if (desc.m_useMotionVectors) {
+        mode |= VALAR_SHADER_MODE_MOTION_VECTORS;
+        mode |= desc.m_useUpscaleMotionVectors ? VALAR_SHADER_MODE_UPSCALED_MOTION_VECTORS : 0;
+    }
+
+    const VALAR_SHADER_PERMUTATIONS permutation = GetValarPermutations(tileSize)[mode];
+    ID3D12PipelineState* pipelineState = desc.m_pOpaque->m_valarShaderPermutations[permutation].Get();
+
+    if (pipelineState == nullptr) {
+        pipelineState = desc.m_pOpaque->m_valarShaderPermutations[GetGenericValarShader(tileSize)].Get();
+    }
+
+    return pipelineState;
+}
+
 
 const Intel::VALAR_RETURN_CODE Intel::VALAR_Release(const Intel::VALAR_DESCRIPTOR& desc)
 {
@@ -323,10 +660,11 @@ const Intel::VALAR_RETURN_CODE Intel::VALAR_Release(const Intel::VALAR_DESCRIPTO
         VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarRootSignature);
         VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarLPRootSignature);
         VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarDebugRootSignature);
-        VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarShaderPermutations[VALAR_SHADER_8X8]);
-        VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarShaderPermutations[VALAR_SHADER_16X16]);
-        VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarShaderPermutations[VALAR_DEBUG_SHADER]);
-        VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarShaderPermutations[VALAR_LP_SHADER]);
+        VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarBatchRootSignature);
+
+        for (UINT permutation = 0; permutation < VALAR_SHADER_COUNT; permutation++) {
+            VALAR_SAFE_RELEASE(desc.m_pOpaque->m_valarShaderPermutations[permutation]);
+        }
 
         desc.m_pOpaque->m_isInitialized = false;
         retCode = VALAR_RETURN_CODE_SUCCESS;
@@ -393,6 +731,83 @@ const Intel::VALAR_RETURN_CODE Intel::VALAR_DebugOverlay(const VALAR_DESCRIPTOR&
     return VALAR_RETURN_CODE_SUCCESS;
 }
 
+// Finds the first span of the tile rows [tileY, tileYEnd) at or after tileX covered by the union of the regions of
+// interest, the rows have no region edge between them. Regions are few, the union is found by repeated scans.
+static bool FindRegionOfInterestSpan(const Intel::VALAR_DESCRIPTOR& desc, UINT tileY, UINT tileYEnd, UINT tileX, UINT& spanBegin, UINT& spanEnd)
+{
+    spanBegin = UINT_MAX;
+
+    for (UINT i = 0; i < desc.m_regionOfInterestCount; i++) {
+        const Intel::VALAR_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+        if (tileRect.m_top <= tileY && tileRect.m_bottom >= tileYEnd && tileRect.m_right > tileX && tileRect.m_left < tileRect.m_right) {
+            const UINT left = (tileRect.m_left > tileX) ? tileRect.m_left : tileX;
+            spanBegin = (left < spanBegin) ? left : spanBegin;
+        }
+    }
+
+    if (spanBegin == UINT_MAX) {
+        return false;
+    }
+
+    spanEnd = spanBegin;
+
+    for (bool grown = true; grown;) {
+        grown = false;
+
+        for (UINT i = 0; i < desc.m_regionOfInterestCount; i++) {
+            const Intel::VALAR_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+            if (tileRect.m_top <= tileY && tileRect.m_bottom >= tileYEnd && tileRect.m_left <= spanEnd && tileRect.m_right > spanEnd) {
+                spanEnd = tileRect.m_right;
+                grown = true;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Fills the tiles outside of the regions of interest with m_outsideShadingRate. The outside is split into bands of
+// rows between region edges and into the gaps between the regions of each band, one fill dispatch per gap. Fill
+// groups return before loading any pixel, and never touch the regions, which keep their rate in amortized masks.
+static void DispatchOutsideRegionsOfInterest(const Intel::VALAR_DESCRIPTOR& desc, Intel::VALAR_ROOT_CONSTANTS constants, UINT tilesX, UINT tilesY)
+{
+    constants.m_fillShadingRate = desc.m_outsideShadingRate;
+
+    for (UINT tileY = 0; tileY < tilesY;) {
+        UINT tileYEnd = tilesY;
+
+        for (UINT i = 0; i < desc.m_regionOfInterestCount; i++) {
+            const Intel::VALAR_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+            tileYEnd = (tileRect.m_top > tileY && tileRect.m_top < tileYEnd) ? tileRect.m_top : tileYEnd;
+            tileYEnd = (tileRect.m_bottom > tileY && tileRect.m_bottom < tileYEnd) ? tileRect.m_bottom : tileYEnd;
+        }
+
+        for (UINT tileX = 0; tileX < tilesX;) {
+            UINT spanBegin;
+            UINT spanEnd;
+
+            if (!FindRegionOfInterestSpan(desc, tileY, tileYEnd, tileX, spanBegin, spanEnd)) {
+                spanBegin = tilesX;
+                spanEnd = tilesX;
+            }
+
+            if (spanBegin > tileX) {
+                constants.m_tileOffsetX = tileX;
+                constants.m_tileOffsetY = tileY;
+                desc.m_commandList->SetComputeRoot32BitConstants(0, 19, &constants, 0);
+                desc.m_commandList->Dispatch(spanBegin - tileX, tileYEnd - tileY, 1);
+            }
+
+            tileX = spanEnd;
+        }
+
+        tileY = tileYEnd;
+    }
+}
+
 const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMask(const Intel::VALAR_DESCRIPTOR& desc)
 {
     if (!desc.m_hwFeatures.m_vrsTier2Support) {
@@ -411,6 +826,10 @@ const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMask(const Intel::VALAR_DESCR
         return VALAR_RETURN_CODE_INVALID_ARGUMENT;
     }
 
+    if (!IsValidAmortizationPeriod(desc.m_amortizationPeriod)) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
     if (desc.m_pOpaque->m_device == nullptr) {
         return VALAR_RETURN_CODE_INVALID_DEVICE;
     }
@@ -419,6 +838,23 @@ const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMask(const Intel::VALAR_DESCR
         return VALAR_RETURN_CODE_NOT_INITIALIZED;
     }
 
+    const UINT tilesX = (UINT)ceilf((float)desc.m_bufferWidth / (float)desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize);
+    const UINT tilesY = (UINT)ceilf((float)desc.m_bufferHeight / (float)desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize);
+
+    if (desc.m_regionOfInterestCount > 0) {
+        if (desc.m_regionsOfInterest == nullptr || !IsValidShadingRate(desc.m_outsideShadingRate)) {
+            return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+        }
+
+        for (UINT i = 0; i < desc.m_regionOfInterestCount; i++) {
+            const VALAR_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+            if (tileRect.m_left > tileRect.m_right || tileRect.m_top > tileRect.m_bottom || tileRect.m_right > tilesX || tileRect.m_bottom > tilesY) {
+                return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+            }
+        }
+    }
+
     if (desc.m_enabled) {
         auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(desc.m_valarBuffer,
             D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE,
@@ -443,26 +879,193 @@ const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMask(const Intel::VALAR_DESCR
             desc.m_allowQuarterRateShading,
             desc.m_upscaleWidth,
             desc.m_upscaleHeight,
-            desc.m_useUpscaleMotionVectors
+            desc.m_useUpscaleMotionVectors,
+            desc.m_frameIndex,
+            desc.m_amortizationPeriod,
+            desc.m_amortizationVelocityBound,
+            0,
+            0,
+            VALAR_COMPUTE_SHADING_RATE
         };
 
-        desc.m_commandList->SetComputeRoot32BitConstants(0, 13, &constants, 0);
         desc.m_commandList->SetComputeRootDescriptorTable(1, desc.m_uavHeap->GetGPUDescriptorHandleForHeapStart());
 
-        if (desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize == INTEL_TILE_SIZE) {
-            desc.m_commandList->SetPipelineState(desc.m_pOpaque->m_valarShaderPermutations[VALAR_SHADER_8X8].Get());
-        } else if (desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize == OTHER_TILE_SIZE) {
-            desc.m_commandList->SetPipelineState(desc.m_pOpaque->m_valarShaderPermutations[VALAR_SHADER_16X16].Get());
+        assert(desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize == INTEL_TILE_SIZE ||
+            desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize == OTHER_TILE_SIZE ||
+            desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize == LARGE_TILE_SIZE);
+
+        desc.m_commandList->SetPipelineState(GetValarPipelineState(desc));
+
+        if (desc.m_regionOfInterestCount == 0) {
+            desc.m_commandList->SetComputeRoot32BitConstants(0, 19, &constants, 0);
+            desc.m_commandList->Dispatch(tilesX, tilesY, 1);
         } else {
-            assert(false);
+            DispatchOutsideRegionsOfInterest(desc, constants, tilesX, tilesY);
+
+            for (UINT i = 0; i < desc.m_regionOfInterestCount; i++) {
+                const VALAR_TILE_RECT& tileRect = desc.m_regionsOfInterest[i];
+
+                if (tileRect.m_left == tileRect.m_right || tileRect.m_top == tileRect.m_bottom) {
+                    continue;
+                }
+
+                constants.m_tileOffsetX = tileRect.m_left;
+                constants.m_tileOffsetY = tileRect.m_top;
+                desc.m_commandList->SetComputeRoot32BitConstants(0, 19, &constants, 0);
+                desc.m_commandList->Dispatch(tileRect.m_right - tileRect.m_left, tileRect.m_bottom - tileRect.m_top, 1);
+            }
+        }
+
+        barrier = CD3DX12_RESOURCE_BARRIER::Transition(desc.m_valarBuffer,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE);
+        desc.m_commandList->ResourceBarrier(1, &barrier);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_ComputeMaskBatch(const Intel::VALAR_DESCRIPTOR& desc, ID3D12Resource* const* valarBuffers, UINT viewCount)
+{
+    if (!desc.m_hwFeatures.m_vrsTier2Support) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    if (desc.m_commandList == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_uavHeap == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (valarBuffers == nullptr || viewCount == 0 || viewCount > VALAR_MAX_BATCH_VIEW_COUNT) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    for (UINT view = 0; view < viewCount; view++) {
+        if (valarBuffers[view] == nullptr) {
+            return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+        }
+    }
+
+    if (desc.m_pOpaque->m_device == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_DEVICE;
+    }
+
+    if (!desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    const UINT tileSize = desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize;
+    ID3D12PipelineState* pipelineState = desc.m_pOpaque->m_valarShaderPermutations[GetBatchedValarShader(tileSize)].Get();
+
+    if (pipelineState == nullptr) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    if (desc.m_enabled) {
+        // The views share one barrier batch, one binding and one dispatch.
+        D3D12_RESOURCE_BARRIER barriers[VALAR_MAX_BATCH_VIEW_COUNT];
+
+        for (UINT view = 0; view < viewCount; view++) {
+            barriers[view] = CD3DX12_RESOURCE_BARRIER::Transition(valarBuffers[view],
+                D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE,
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         }
+        desc.m_commandList->ResourceBarrier(viewCount, barriers);
+
+        ID3D12DescriptorHeap* ppHeapsCompute[] = { desc.m_uavHeap };
+        desc.m_commandList->SetDescriptorHeaps(_countof(ppHeapsCompute), ppHeapsCompute);
+        desc.m_commandList->SetComputeRootSignature(desc.m_pOpaque->m_valarBatchRootSignature.Get());
+
+        // The batched shader updates every tile of every view, amortization and regions of interest do not apply.
+        VALAR_ROOT_CONSTANTS constants =
+        {
+            desc.m_bufferWidth,
+            desc.m_bufferHeight,
+            tileSize,
+            desc.m_sensitivityThreshold,
+            desc.m_environmentLuminance,
+            desc.m_quarterRateShadingModifier,
+            desc.m_weberFechnerConstant,
+            desc.m_weberFechnerMode,
+            desc.m_useMotionVectors,
+            desc.m_allowQuarterRateShading,
+            desc.m_upscaleWidth,
+            desc.m_upscaleHeight,
+            desc.m_useUpscaleMotionVectors,
+            desc.m_frameIndex,
+            1,
+            desc.m_amortizationVelocityBound,
+            0,
+            0,
+            VALAR_COMPUTE_SHADING_RATE
+        };
+
+        desc.m_commandList->SetComputeRoot32BitConstants(0, 19, &constants, 0);
+        desc.m_commandList->SetComputeRootDescriptorTable(1, desc.m_uavHeap->GetGPUDescriptorHandleForHeapStart());
+        desc.m_commandList->SetPipelineState(pipelineState);
 
         desc.m_commandList->Dispatch(
-            (UINT)ceilf((float)desc.m_bufferWidth / (float)desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize),
-            (UINT)ceilf((float)desc.m_bufferHeight / (float)desc.m_pOpaque->m_featureSupport.m_shadingRateTileSize), 1);
+            (UINT)ceilf((float)desc.m_bufferWidth / (float)tileSize),
+            (UINT)ceilf((float)desc.m_bufferHeight / (float)tileSize), viewCount);
+
+        for (UINT view = 0; view < viewCount; view++) {
+            barriers[view] = CD3DX12_RESOURCE_BARRIER::Transition(valarBuffers[view],
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE);
+        }
+        desc.m_commandList->ResourceBarrier(viewCount, barriers);
+    }
+
+    return VALAR_RETURN_CODE_SUCCESS;
+}
+
+const Intel::VALAR_RETURN_CODE Intel::VALAR_UploadMask(const Intel::VALAR_DESCRIPTOR& desc, ID3D12Resource* uploadBuffer, UINT64 uploadOffset)
+{
+    if (!desc.m_hwFeatures.m_vrsTier2Support) {
+        return VALAR_RETURN_CODE_NOT_SUPPORTED;
+    }
+
+    if (desc.m_commandList == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_valarBuffer == nullptr || uploadBuffer == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (uploadOffset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT != 0) {
+        return VALAR_RETURN_CODE_INVALID_ARGUMENT;
+    }
+
+    if (desc.m_pOpaque->m_device == nullptr) {
+        return VALAR_RETURN_CODE_INVALID_DEVICE;
+    }
+
+    if (!desc.m_pOpaque->m_isInitialized) {
+        return VALAR_RETURN_CODE_NOT_INITIALIZED;
+    }
+
+    if (desc.m_enabled) {
+        // The upload buffer holds the mask in the placed footprint of m_valarBuffer, as written by the CPU
+        // engine with the row pitch of VALAR_GetMaskFootprintCPU.
+        const D3D12_RESOURCE_DESC maskDesc = desc.m_valarBuffer->GetDesc();
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+        desc.m_pOpaque->m_device->GetCopyableFootprints(&maskDesc, 0, 1, uploadOffset, &footprint, nullptr, nullptr, nullptr);
+
+        auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(desc.m_valarBuffer,
+            D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE,
+            D3D12_RESOURCE_STATE_COPY_DEST);
+        desc.m_commandList->ResourceBarrier(1, &barrier);
+
+        const CD3DX12_TEXTURE_COPY_LOCATION dst(desc.m_valarBuffer, 0);
+        const CD3DX12_TEXTURE_COPY_LOCATION src(uploadBuffer, footprint);
+        desc.m_commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
 
         barrier = CD3DX12_RESOURCE_BARRIER::Transition(desc.m_valarBuffer,
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            D3D12_RESOURCE_STATE_COPY_DEST,
             D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE);
         desc.m_commandList->ResourceBarrier(1, &barrier);
     }
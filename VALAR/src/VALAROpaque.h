@@ -25,6 +25,16 @@ using namespace Microsoft::WRL;
 
 #define INTEL_TILE_SIZE 8
 #define OTHER_TILE_SIZE 16
+#define LARGE_TILE_SIZE 32
+
+// Mode flags of the specialized VALAR shaders, the VALAR_MODE flags of ValarCS.hlsli.
+#define VALAR_SHADER_MODE_WEBER_FECHNER 0x1
+#define VALAR_SHADER_MODE_MOTION_VECTORS 0x2
+#define VALAR_SHADER_MODE_UPSCALED_MOTION_VECTORS 0x4
+#define VALAR_SHADER_MODE_COUNT 8
+
+// Fill rate of the dispatches computing the mask, the COMPUTE_SHADING_RATE of ValarCS.hlsli.
+#define VALAR_COMPUTE_SHADING_RATE 0xFFFFFFFF
 
 namespace Intel
 {
@@ -34,6 +44,7 @@ namespace Intel
         ComPtr<ID3D12RootSignature> m_valarRootSignature;
         ComPtr<ID3D12RootSignature> m_valarLPRootSignature;
         ComPtr<ID3D12RootSignature> m_valarDebugRootSignature;
+        ComPtr<ID3D12RootSignature> m_valarBatchRootSignature;
         ComPtr<ID3D12PipelineState> m_valarShaderPermutations[VALAR_SHADER_COUNT];
         VALAR_HARDWARE_FEATURES     m_featureSupport{};
         bool                        m_isInitialized = false;
@@ -54,6 +65,12 @@ namespace Intel
         UINT                        m_upscaledWidth;
         UINT                        m_upscaledHeight;
         UINT                        m_useHighResMotionVectors;          
+        UINT                        m_frameIndex;
+        UINT                        m_amortizationPeriod;
+        float                       m_amortizationVelocityBound;
+        UINT                        m_tileOffsetX;
+        UINT                        m_tileOffsetY;
+        UINT                        m_fillShadingRate;
     };
 
     struct VALAR_DEBUG_CONSTANTS
@@ -73,5 +90,8 @@ namespace Intel
     VALAR_RETURN_CODE CreateVALARRootSignature(VALAR_DESCRIPTOR& desc);
     VALAR_RETURN_CODE CreateVALARLPRootSignature(VALAR_DESCRIPTOR& desc);
     VALAR_RETURN_CODE CreateVALARDebugRootSignature(VALAR_DESCRIPTOR& desc);
+    VALAR_RETURN_CODE CreateVALARBatchRootSignature(VALAR_DESCRIPTOR& desc);
     VALAR_RETURN_CODE LoadShader(VALAR_DESCRIPTOR& desc, VALAR_SHADER_PERMUTATIONS permutation);
+    VALAR_RETURN_CODE LoadSpecializedShaders(VALAR_DESCRIPTOR& desc, UINT tileSize);
+    ID3D12PipelineState* GetValarPipelineState(const VALAR_DESCRIPTOR& desc);
 }
\ No newline at end of file
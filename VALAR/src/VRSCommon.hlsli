@@ -18,6 +18,8 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
 // OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include "ValarBindings.hlsli"
+
 #define UINT16_MAX 65536
 #define UINT32_MAX 4294967295
 #define D3D12_SHADING_RATE_X_AXIS_SHIFT 2
@@ -26,7 +28,17 @@
 #define D3D12_GET_COARSE_SHADING_RATE_X_AXIS(x) (((x) >> D3D12_SHADING_RATE_X_AXIS_SHIFT) & D3D12_SHADING_RATE_VALID_MASK)
 #define D3D12_GET_COARSE_SHADING_RATE_Y_AXIS(y) ((y) & D3D12_SHADING_RATE_VALID_MASK)
 
-RWTexture2D<uint> VRSShadingRateBuffer : register(u0);
+#ifdef VALAR_BATCHED
+// Batched dispatches run one view per SV_GroupID.z, which indexes the UAV arrays of the views.
+#define VALAR_MAX_BATCH_VIEW_COUNT 8
+
+VALAR_STATIC uint ViewIndex;
+
+RWTexture2D<uint> VRSShadingRateBuffers[VALAR_MAX_BATCH_VIEW_COUNT] VALAR_REGISTER_SPACE(u0, space1);
+#define VRSShadingRateBuffer VRSShadingRateBuffers[ViewIndex]
+#else
+RWTexture2D<uint> VRSShadingRateBuffer VALAR_REGISTER(u0);
+#endif
 
 enum ShadingRates
 {
@@ -0,0 +1,5 @@
+#define TILE_SIZE 16
+#define NUM_THREADS 256
+#define VALAR_STATIC_MODE (VALAR_MODE_MOTION_VECTORS | VALAR_MODE_UPSCALED_MOTION_VECTORS)
+
+#include "ValarCS.hlsli"
\ No newline at end of file
@@ -0,0 +1,5 @@
+#define TILE_SIZE 32
+#define NUM_THREADS 1024
+#define VALAR_AMORTIZED
+
+#include "ValarCS.hlsli"
\ No newline at end of file
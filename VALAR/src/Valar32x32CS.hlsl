@@ -0,0 +1,4 @@
+#define TILE_SIZE 32
+#define NUM_THREADS 1024
+
+#include "ValarCS.hlsli"
\ No newline at end of file
@@ -0,0 +1,5 @@
+#define TILE_SIZE 8
+#define NUM_THREADS 64
+#define VALAR_AMORTIZED
+
+#include "ValarCS.hlsli"
\ No newline at end of file
@@ -0,0 +1,34 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Binding syntax of the VALAR shaders. Compiled as C++ by VALARCPUHLSL.h, which defines VALAR_HLSL_EMULATION
+// and its own version of these macros.
+#ifndef VALAR_HLSL_EMULATION
+#define VALAR_REGISTER(slot) : register(slot)
+#define VALAR_REGISTER_SPACE(slot, space) : register(slot, space)
+#define VALAR_SEMANTIC(semantic) : semantic
+#define VALAR_ROOT_SIGNATURE(rootSignature) [RootSignature(rootSignature)]
+#define VALAR_NUM_THREADS(x, y, z) [numthreads(x, y, z)]
+#define VALAR_CBUFFER_BEGIN(name, slot) cbuffer name : register(slot) {
+#define VALAR_CBUFFER_END }
+#define VALAR_GROUPSHARED(type, name, dimensions) groupshared type name dimensions
+#define VALAR_STATIC static
+#define VALAR_UNUSED(x)
+#endif
\ No newline at end of file
@@ -1,4 +1,3 @@
-#pragma once
 // Copyright (C) 2022 Intel Corporation
 
 // Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -20,13 +19,25 @@
 // OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "VRSCommon.hlsli"
+#include "ValarRateDecision.hlsli"
 
+#ifdef VALAR_BATCHED
+// Masks, color buffers, velocity buffers and upscaled velocity buffers of the views, VALAR_MAX_BATCH_VIEW_COUNT each.
 #define VRS_RootSig \
     "RootFlags(0), " \
-    "RootConstants(b0, num32BitConstants=13), " \
+    "RootConstants(b0, num32BitConstants=19), " \
+    "DescriptorTable(UAV(u0, space = 1, numDescriptors = 8), UAV(u0, space = 2, numDescriptors = 8), " \
+    "UAV(u0, space = 3, numDescriptors = 8), UAV(u0, space = 4, numDescriptors = 8))," \
+
+#else
+#define VRS_RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants=19), " \
     "DescriptorTable(UAV(u0, numDescriptors = 4))," \
 
-cbuffer CB0 : register(b0) {
+#endif
+
+VALAR_CBUFFER_BEGIN(CB0, b0)
     uint2 TextureSize;
     uint ShadingRateTileSize;
     float SensitivityThreshold;
@@ -40,24 +51,64 @@ cbuffer CB0 : register(b0) {
     // Intel XeSS Support
     uint2 UpscaledSize;
     bool UseUpscaledMotionVectors;
-}
 
+    // Amortized Updates
+    uint FrameIndex;
+    uint AmortizationPeriod;
+    float AmortizationVelocityBound;
+
+    // Regions of Interest
+    uint2 TileOffset;
+    uint FillShadingRate;
+VALAR_CBUFFER_END
+
+// FillShadingRate of the dispatches computing the mask.
+#define COMPUTE_SHADING_RATE 0xFFFFFFFF
+
+#define VALAR_MODE_WEBER_FECHNER 0x1
+#define VALAR_MODE_MOTION_VECTORS 0x2
+#define VALAR_MODE_UPSCALED_MOTION_VECTORS 0x4
+
+// Specialized permutations define VALAR_STATIC_MODE as the VALAR_MODE flags they are compiled for. The disabled
+// modes are compiled out, the neighborhood pass and the velocity loads included. Without it the modes are read
+// from the root constants.
+#ifdef VALAR_STATIC_MODE
+#if (VALAR_STATIC_MODE & VALAR_MODE_MOTION_VECTORS)
 #define USE_VELOCITY
+#endif
+#if (VALAR_STATIC_MODE & VALAR_MODE_WEBER_FECHNER)
 #define USE_WEBER_FECHNER
-#define BRANCHLESS
-
-#define H_SLOPE ((0.0468f - 1.0f) / (16.0f - 0.0f))
-#define Q_SLOPE ((0.1629f - K) / (16.0f - 0.0f))
-#define H_INTERCEPT 1.0f
-#define Q_INTERCEPT K
+#endif
+#define WEBER_FECHNER_ENABLED ((VALAR_STATIC_MODE & VALAR_MODE_WEBER_FECHNER) != 0)
+#define MOTION_VECTORS_ENABLED ((VALAR_STATIC_MODE & VALAR_MODE_MOTION_VECTORS) != 0)
+#define UPSCALED_MOTION_VECTORS_ENABLED ((VALAR_STATIC_MODE & VALAR_MODE_UPSCALED_MOTION_VECTORS) != 0)
+#else
+#define USE_VELOCITY
+#define USE_WEBER_FECHNER
+#define WEBER_FECHNER_ENABLED UseWeberFechner
+#define MOTION_VECTORS_ENABLED UseMotionVectors
+#define UPSCALED_MOTION_VECTORS_ENABLED UseUpscaledMotionVectors
+#endif
 
-RWTexture2D<float4> ColorBuffer : register(u1);
+#ifdef VALAR_BATCHED
+RWTexture2D<float4> ColorBuffers[VALAR_MAX_BATCH_VIEW_COUNT] VALAR_REGISTER_SPACE(u0, space2);
+#define ColorBuffer ColorBuffers[ViewIndex]
+#else
+RWTexture2D<float4> ColorBuffer VALAR_REGISTER(u1);
+#endif
 float4 FetchColor(int2 st) { return ColorBuffer[st]; }
 
 #ifdef USE_VELOCITY
-RWTexture2D<uint> VelocityBuffer : register(u2);
-RWTexture2D<float2> UpscaledVelocityBuffer : register(u3);
-groupshared float waveVelocityMin[NUM_THREADS];
+#ifdef VALAR_BATCHED
+RWTexture2D<uint> VelocityBuffers[VALAR_MAX_BATCH_VIEW_COUNT] VALAR_REGISTER_SPACE(u0, space3);
+RWTexture2D<float2> UpscaledVelocityBuffers[VALAR_MAX_BATCH_VIEW_COUNT] VALAR_REGISTER_SPACE(u0, space4);
+#define VelocityBuffer VelocityBuffers[ViewIndex]
+#define UpscaledVelocityBuffer UpscaledVelocityBuffers[ViewIndex]
+#else
+RWTexture2D<uint> VelocityBuffer VALAR_REGISTER(u2);
+RWTexture2D<float2> UpscaledVelocityBuffer VALAR_REGISTER(u3);
+#endif
+VALAR_GROUPSHARED(float, waveVelocityMin, [NUM_THREADS]);
 #endif
 
 float UnpackXY(uint x)
@@ -75,13 +126,69 @@ float3 UnpackVelocity(uint Velocity)
     return float3(UnpackXY(Velocity & 0x3FF), UnpackXY((Velocity >> 10) & 0x3FF), UnpackZ(Velocity >> 20));
 }
 
-groupshared float waveLumaSum[NUM_THREADS];
-groupshared float waveLumaSumX[NUM_THREADS];
-groupshared float waveLumaSumY[NUM_THREADS];
+#ifdef VALAR_AMORTIZED
+
+// Pixels per tile group, the tiles of a group are re-evaluated in the same frame.
+#define AMORTIZATION_GROUP_WIDTH 32
+
+// Update order of a 4x4 block of tile groups, every frame of a period of N updates a checkerboard (N = 2) or a
+// regular lattice of the groups.
+VALAR_STATIC const uint BayerMatrix4x4[16] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
+
+#ifdef USE_VELOCITY
+float FetchVelocityLength(uint2 PixelCoord)
+{
+    if (UPSCALED_MOTION_VECTORS_ENABLED)
+    {
+        const float2 upscaleRatio = float2((float)UpscaledSize.x / (float)TextureSize.x,
+            (float)UpscaledSize.y / (float)TextureSize.y);
+
+        const uint2 uPixelCoord =
+            float2((float)PixelCoord.x * upscaleRatio.x, (float)PixelCoord.y * upscaleRatio.y);
+
+        return length(UpscaledVelocityBuffer[uPixelCoord].xy);
+    }
+
+    return length(UnpackVelocity(VelocityBuffer[PixelCoord]));
+}
+#endif
+
+// Same tiles as IsAmortizedTileDue of the CPU path. Tiles faster than AmortizationVelocityBound at any of the
+// centers of their quadrants are re-evaluated every frame.
+bool IsTileDue(uint2 Tile)
+{
+    const uint groupX = Tile.x * TILE_SIZE / AMORTIZATION_GROUP_WIDTH;
+    const uint phase = BayerMatrix4x4[(Tile.y % 4) * 4 + groupX % 4] * AmortizationPeriod / 16;
+
+    if (AmortizationPeriod <= 1 || phase == FrameIndex % AmortizationPeriod)
+    {
+        return true;
+    }
+
+#ifdef USE_VELOCITY
+    if (MOTION_VECTORS_ENABLED)
+    {
+        const uint2 p0 = Tile * TILE_SIZE + TILE_SIZE / 4;
+        const uint2 p1 = p0 + TILE_SIZE / 2;
+
+        const float velocityMax = max(max(FetchVelocityLength(p0), FetchVelocityLength(uint2(p1.x, p0.y))),
+            max(FetchVelocityLength(uint2(p0.x, p1.y)), FetchVelocityLength(p1)));
+
+        return velocityMax > AmortizationVelocityBound;
+    }
+#endif
+
+    return false;
+}
+#endif
+
+VALAR_GROUPSHARED(float, waveLumaSum, [NUM_THREADS]);
+VALAR_GROUPSHARED(float, waveLumaSumX, [NUM_THREADS]);
+VALAR_GROUPSHARED(float, waveLumaSumY, [NUM_THREADS]);
 
 #ifdef USE_WEBER_FECHNER
 
-groupshared float neighborhood[TILE_SIZE][TILE_SIZE];
+VALAR_GROUPSHARED(float, neighborhood, [TILE_SIZE][TILE_SIZE]);
 
 float ComputeMinNeighborLuminance(uint2 PixelCoord)
 {
@@ -125,11 +232,39 @@ float ComputeMinNeighborLuminance(uint2 PixelCoord)
 }
 #endif
 
-[RootSignature(VRS_RootSig)]
-[numthreads(TILE_SIZE, TILE_SIZE, 1)]
-void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID)
+VALAR_ROOT_SIGNATURE(VRS_RootSig)
+VALAR_NUM_THREADS(TILE_SIZE, TILE_SIZE, 1)
+void main(uint3 Gid VALAR_SEMANTIC(SV_GroupID), uint GI VALAR_SEMANTIC(SV_GroupIndex), uint3 GTid VALAR_SEMANTIC(SV_GroupThreadID),
+    uint3 DTid VALAR_SEMANTIC(SV_DispatchThreadID))
 {
-    const uint2 PixelCoord = DTid.xy;
+    VALAR_UNUSED(DTid);
+
+#ifdef VALAR_BATCHED
+    ViewIndex = Gid.z;
+#endif
+
+    // Groups of a region of interest dispatch start at its first tile.
+    const uint2 Tile = Gid.xy + TileOffset;
+
+    // Fill dispatches write the rate outside of the regions of interest without reading the color buffer.
+    if (FillShadingRate != COMPUTE_SHADING_RATE)
+    {
+        if (GI == 0)
+        {
+            SetShadingRate(Tile, FillShadingRate);
+        }
+        return;
+    }
+
+#ifdef VALAR_AMORTIZED
+    // The whole group returns before any barrier, the tile keeps the rate of the previous mask.
+    if (!IsTileDue(Tile))
+    {
+        return;
+    }
+#endif
+
+    const uint2 PixelCoord = Tile * TILE_SIZE + GTid.xy;
     const int waveLaneCount = WaveGetLaneCount();
 
     // Fetch Colors from Color Buffer UAV
@@ -152,7 +287,7 @@ void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Group
 #endif
 
 #ifdef USE_WEBER_FECHNER
-    if (UseWeberFechner)
+    if (WEBER_FECHNER_ENABLED)
     {
         neighborhood[GTid.x][GTid.y] = pixelLuma;
 
@@ -185,9 +320,9 @@ void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Group
 #endif
 
 #ifdef USE_VELOCITY
-    if (UseMotionVectors)
+    if (MOTION_VECTORS_ENABLED)
     {
-        if (UseUpscaledMotionVectors)
+        if (UPSCALED_MOTION_VECTORS_ENABLED)
         {
             const float2 upscaleRatio = float2((float)UpscaledSize.x / (float)TextureSize.x,
                 (float)UpscaledSize.y / (float)TextureSize.y);
@@ -227,11 +362,10 @@ void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Group
         float totalTileLuma = 0;
         float totalTileLumaX = 0;
         float totalTileLumaY = 0;
-#ifdef USE_VELOCITY
         float minTileVelocity = 10000;
-#endif
 
-        for (int i = 0; i < (NUM_THREADS / waveLaneCount); i++)
+        // One entry per wave, a wave wider than the group still wrote the first one.
+        for (int i = 0; i < (NUM_THREADS + waveLaneCount - 1) / waveLaneCount; i++)
         {
             totalTileLuma += waveLumaSum[i];
             totalTileLumaX += waveLumaSumX[i];
@@ -246,99 +380,19 @@ void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Group
         const float avgTileLumaX = totalTileLumaX / (float)NUM_THREADS;
         const float avgTileLumaY = totalTileLumaY / (float)NUM_THREADS;
 
-        // Satifying Equation 15 http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        const float jnd_threshold = SensitivityThreshold * (avgTileLuma + EnvLuma);
+        const float jnd_threshold = ComputeJNDThreshold(SensitivityThreshold, avgTileLuma, EnvLuma);
 
         // Compute the MSE error for Luma X/Y derivatives
         const float avgErrorX = sqrt(avgTileLumaX);
         const float avgErrorY = sqrt(avgTileLumaY);
 
         // Motion Vector based velocity compensation.
-        float velocityHError = 1.0;
-        float velocityQError = K;
-
-#ifdef BRANCHLESS
-#ifdef USE_VELOCITY
-        // Satifying Equation 20. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        // velocityHError = pow(1.0 / (1.0 + pow(1.05 * minTileVelocity, 3.10)), 0.35);
-        velocityHError = mad(1.0f, (float)(!UseMotionVectors),
-            mad(H_SLOPE, minTileVelocity, H_INTERCEPT) * (float)UseMotionVectors);
-
-        // Satifying Equation 21. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        // velocityQError = K * pow(1.0 / (1.0 + pow(0.55 * minTileVelocity, 2.41)), 0.49);
-        velocityQError = mad(K, (float)(!UseMotionVectors),
-            mad(Q_SLOPE, minTileVelocity, Q_INTERCEPT) * (float)UseMotionVectors);
-#endif
-        const bool fullRateCmpX = ((velocityHError * avgErrorX) >= jnd_threshold);
-        const bool quarterRateCmpX = ((velocityQError * avgErrorX) < jnd_threshold);
-
-        const bool fullRateCmpY = ((velocityHError * avgErrorY) >= jnd_threshold);
-        const bool quarterRateCmpY = ((velocityQError * avgErrorY) < jnd_threshold);
-
-        const uint rate2x = D3D12_AXIS_SHADING_RATE_2X;
-        const uint rate4x = mad(D3D12_AXIS_SHADING_RATE_2X, (uint)(!AllowQuarterRate), (D3D12_AXIS_SHADING_RATE_4X * (uint)(AllowQuarterRate)));
-
-        uint xRate = mad(
-            rate2x, (int)(!(fullRateCmpX || quarterRateCmpX)), (uint)(rate4x * quarterRateCmpX));
-
-        uint yRate = mad(
-            rate2x, (uint)(!(fullRateCmpY || quarterRateCmpY)), (uint)(rate4x * quarterRateCmpY));
-#else
-#ifdef USE_VELOCITY
-        if (UseMotionVectors)
-        {
-            // Satifying Equation 20. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-            // velocityHError = pow(1.0 / (1.0 + pow(1.05 * minTileVelocity, 3.10)), 0.35);
-            velocityHError = mad(H_SLOPE, minTileVelocity, H_INTERCEPT);
-
-            // Satifying Equation 21. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-            // velocityQError = K * pow(1.0 / (1.0 + pow(0.55 * minTileVelocity, 2.41)), 0.49);
-            velocityQError = K * mad(Q_SLOPE, minTileVelocity, Q_INTERCEPT);
-        }
-#endif
+        const float velocityHError = ComputeVelocityHError(minTileVelocity, MOTION_VECTORS_ENABLED);
+        const float velocityQError = ComputeVelocityQError(minTileVelocity, K, MOTION_VECTORS_ENABLED);
 
-        uint xRate = D3D12_AXIS_SHADING_RATE_2X;
-        uint yRate = D3D12_AXIS_SHADING_RATE_2X;
-
-        // Satifying Equation 16. For X http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        if ((velocityHError * avgErrorX) >= jnd_threshold)
-        {
-            xRate = D3D12_AXIS_SHADING_RATE_1X;
-        }
-        // Satifying Equation 14. For Qurter Rate Shading for X
-        // http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        else if ((velocityQError * avgErrorX) < jnd_threshold)
-        {
-            if (AllowQuarterRate)
-            {
-                xRate = D3D12_AXIS_SHADING_RATE_4X;
-            }
-        }
-
-        // Satifying Equation 16 For Y http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        if ((velocityHError * avgErrorY) >= jnd_threshold)
-        {
-            // Logic to Prevent Invalid 4x1 shading Rate, converts to 4X2.
-            yRate = (xRate == D3D12_AXIS_SHADING_RATE_4X ? D3D12_AXIS_SHADING_RATE_2X
-                : D3D12_AXIS_SHADING_RATE_1X);
-        }
-        // Satifying Equation 14 For Qurter Rate Shading for Y
-        // http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        else if ((velocityQError * avgErrorY) < jnd_threshold)
-        {
-            if (AllowQuarterRate)
-            {
-                // Logic to Prevent 4x4 Shading Rate and invalid 1X4, converts to 4x2 or 1x2.
-                yRate = (xRate == D3D12_AXIS_SHADING_RATE_1X ? D3D12_AXIS_SHADING_RATE_2X
-                    : D3D12_AXIS_SHADING_RATE_4X);
-            }
-        }
-#endif
-        if (yRate == D3D12_AXIS_SHADING_RATE_1X && xRate == D3D12_AXIS_SHADING_RATE_4X)
-            xRate = D3D12_AXIS_SHADING_RATE_2X;
-        else if (yRate == D3D12_AXIS_SHADING_RATE_4X && xRate == D3D12_AXIS_SHADING_RATE_1X)
-            yRate = D3D12_AXIS_SHADING_RATE_2X;
+        const uint xClass = ClassifyShadingRateAxis(avgErrorX, velocityHError, velocityQError, jnd_threshold);
+        const uint yClass = ClassifyShadingRateAxis(avgErrorY, velocityHError, velocityQError, jnd_threshold);
 
-        SetShadingRate(Gid.xy, D3D12_MAKE_COARSE_SHADING_RATE(xRate, yRate));
+        SetShadingRate(Tile, LookupShadingRate(xClass, yClass, AllowQuarterRate));
     }
 }
\ No newline at end of file
@@ -18,6 +18,8 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
 // OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include "ValarBindings.hlsli"
+
 #define VRS_RootSig \
     "RootFlags(0), " \
     "RootConstants(b0, num32BitConstants=6), " \
@@ -34,7 +36,7 @@ enum ShadingRates
     SHADING_RATE_4X4 = 0xa,
 };
 
-cbuffer CB0 : register(b0) {
+VALAR_CBUFFER_BEGIN(CB0, b0)
     uint NativeWidth;
     uint NativeHeight;
    
@@ -43,12 +45,12 @@ cbuffer CB0 : register(b0) {
 
     uint ShadingRateTileSize;
     bool DrawGrid;
-}
+VALAR_CBUFFER_END
 
-RWTexture2D<uint> VRSShadingRateBuffer : register(u0);
+RWTexture2D<uint> VRSShadingRateBuffer VALAR_REGISTER(u0);
 uint GetShadingRate(int2 st) { return VRSShadingRateBuffer[st]; }
 
-RWTexture2D<float4> ColorBuffer : register(u1);
+RWTexture2D<float4> ColorBuffer VALAR_REGISTER(u1);
 void SetColor(int2 st, float4 rgb) { ColorBuffer[st] = rgb; }
 
 bool IsTileEdge(uint2 PixelCoord)
@@ -71,10 +73,15 @@ bool IsIndicatorPosition(uint2 PixelCoord, uint TileSize)
         (PixelCoord.x % TileSize == 3 && PixelCoord.y % TileSize == 3));
 }
 
-[numthreads(1, 1, 1)]
-[RootSignature(VRS_RootSig)]
-void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID)
+VALAR_NUM_THREADS(1, 1, 1)
+VALAR_ROOT_SIGNATURE(VRS_RootSig)
+void main(uint3 Gid VALAR_SEMANTIC(SV_GroupID), uint GI VALAR_SEMANTIC(SV_GroupIndex), uint3 GTid VALAR_SEMANTIC(SV_GroupThreadID),
+    uint3 DTid VALAR_SEMANTIC(SV_DispatchThreadID))
 {
+    VALAR_UNUSED(Gid);
+    VALAR_UNUSED(GI);
+    VALAR_UNUSED(GTid);
+
     float2 upscaleRatio = float2(
         (float)NativeWidth / (float)UpscaledWidth,
         (float)NativeHeight / (float)UpscaledHeight);
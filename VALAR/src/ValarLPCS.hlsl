@@ -19,13 +19,14 @@
 // OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "VRSCommon.hlsli"
+#include "ValarRateDecision.hlsli"
 
 #define VRS_RootSig \
     "RootFlags(0), " \
     "RootConstants(b0, num32BitConstants=13), " \
     "DescriptorTable(UAV(u0, numDescriptors = 4))," \
 
-cbuffer CB0 : register(b0) {
+VALAR_CBUFFER_BEGIN(CB0, b0)
     uint2 TextureSize;
     uint ShadingRateTileSize;
     float SensitivityThreshold;
@@ -39,22 +40,16 @@ cbuffer CB0 : register(b0) {
     // Intel XeSS Support
     uint2 UpscaledSize;
     bool UseUpscaledMotionVectors;
-}
+VALAR_CBUFFER_END
 
 #define USE_VELOCITY
-//#define BRANCHLESS
-
-#define H_SLOPE ((0.0468f - 1.0f) / (16.0f - 0.0f))
-#define Q_SLOPE ((0.1629f - K) / (16.0f - 0.0f))
-#define H_INTERCEPT 1.0f
-#define Q_INTERCEPT K
 
-RWTexture2D<float4> ColorBuffer : register(u1);
+RWTexture2D<float4> ColorBuffer VALAR_REGISTER(u1);
 float4 FetchColor(int2 st) { return ColorBuffer[st]; }
 
 #ifdef USE_VELOCITY
-RWTexture2D<uint> VelocityBuffer : register(u2);
-RWTexture2D<float2> UpscaledVelocityBuffer : register(u3);
+RWTexture2D<uint> VelocityBuffer VALAR_REGISTER(u2);
+RWTexture2D<float2> UpscaledVelocityBuffer VALAR_REGISTER(u3);
 
 float UnpackXY(uint x)
 {
@@ -73,10 +68,15 @@ float3 UnpackVelocity(uint Velocity)
 
 #endif
 
-[RootSignature(VRS_RootSig)]
-[numthreads(8, 8, 1)]
-void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID)
+VALAR_ROOT_SIGNATURE(VRS_RootSig)
+VALAR_NUM_THREADS(8, 8, 1)
+void main(uint3 Gid VALAR_SEMANTIC(SV_GroupID), uint GI VALAR_SEMANTIC(SV_GroupIndex), uint3 GTid VALAR_SEMANTIC(SV_GroupThreadID),
+    uint3 DTid VALAR_SEMANTIC(SV_DispatchThreadID))
 {
+    VALAR_UNUSED(Gid);
+    VALAR_UNUSED(GI);
+    VALAR_UNUSED(GTid);
+
     uint3 tileIndex = (DTid * ShadingRateTileSize) + (ShadingRateTileSize / 2.0f);
 
     float velocity = 0.0f;
@@ -95,17 +95,12 @@ void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Group
     const float avgTileLumaX = ((abs(centroidLuma2 - centroidLuma1)) + (abs(centroidLuma4 - centroidLuma3)));
     const float avgTileLumaY = ((abs(centroidLuma3 - centroidLuma1)) + (abs(centroidLuma4 - centroidLuma2)));
 
-    // Satifying Equation 15 http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    const float jnd_threshold = (SensitivityThreshold / 2.0f) * (avgTileLuma + EnvLuma);
+    const float jnd_threshold = ComputeJNDThreshold(SensitivityThreshold / 2.0f, avgTileLuma, EnvLuma);
 
     // Compute the MSE error for Luma X/Y derivatives
     const float avgErrorX = sqrt(avgTileLumaX);
     const float avgErrorY = sqrt(avgTileLumaY);
 
-    // Motion Vector based velocity compensation.
-    float velocityHError = 1.0;
-    float velocityQError = K;
-
 #ifdef USE_VELOCITY
     if (UseMotionVectors) {
         if (UseUpscaledMotionVectors) {
@@ -121,83 +116,13 @@ void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Group
         }
     }
 #endif
-#ifdef BRANCHLESS
-#ifdef USE_VELOCITY
-    // Satifying Equation 20. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    // velocityHError = pow(1.0 / (1.0 + pow(1.05 * minTileVelocity, 3.10)), 0.35);
-    velocityHError = mad(1.0f, (float)(!UseMotionVectors),
-        mad(H_SLOPE, velocity, H_INTERCEPT) * (float)UseMotionVectors);
-
-    // Satifying Equation 21. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    // velocityQError = K * pow(1.0 / (1.0 + pow(0.55 * minTileVelocity, 2.41)), 0.49);
-    velocityQError = mad(K, (float)(!UseMotionVectors),
-        mad(Q_SLOPE, velocity, Q_INTERCEPT) * (float)UseMotionVectors);
-#endif
-    const bool fullRateCmpX = ((velocityHError * avgErrorX) >= jnd_threshold);
-    const bool quarterRateCmpX = ((velocityQError * avgErrorX) < jnd_threshold);
-
-    const bool fullRateCmpY = ((velocityHError * avgErrorY) >= jnd_threshold);
-    const bool quarterRateCmpY = ((velocityQError * avgErrorY) < jnd_threshold);
-
-    const uint rate2x = D3D12_AXIS_SHADING_RATE_2X;
-    const uint rate4x = mad(D3D12_AXIS_SHADING_RATE_2X, (uint)(!AllowQuarterRate), 
-                           (D3D12_AXIS_SHADING_RATE_4X * (uint)(AllowQuarterRate)));
 
-    uint xRate = mad(
-        rate2x, (int)(!(fullRateCmpX || quarterRateCmpX)), (uint)(rate4x * quarterRateCmpX));
-
-    uint yRate = mad(
-        rate2x, (uint)(!(fullRateCmpY || quarterRateCmpY)), (uint)(rate4x * quarterRateCmpY));
-#else
-#ifdef USE_VELOCITY
-    if (UseMotionVectors) {
-        // Satifying Equation 20. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        // velocityHError = pow(1.0 / (1.0 + pow(1.05 * minTileVelocity, 3.10)), 0.35);
-        velocityHError = mad(H_SLOPE, velocity, H_INTERCEPT);
-
-        // Satifying Equation 21. http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-        // velocityQError = K * pow(1.0 / (1.0 + pow(0.55 * minTileVelocity, 2.41)), 0.49);
-        velocityQError = K * mad(Q_SLOPE, velocity, Q_INTERCEPT);
-    }
-#endif
-
-    uint xRate = D3D12_AXIS_SHADING_RATE_2X;
-    uint yRate = D3D12_AXIS_SHADING_RATE_2X;
+    // Motion Vector based velocity compensation.
+    const float velocityHError = ComputeVelocityHError(velocity, UseMotionVectors);
 
-    // Satifying Equation 16. For X http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    if ((velocityHError * avgErrorX) >= jnd_threshold) {
-        xRate = D3D12_AXIS_SHADING_RATE_1X;
-    }
-    // Satifying Equation 14. For Qurter Rate Shading for X
-    // http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    /*else if ((velocityQError * avgErrorX) < jnd_threshold) {
-        if (AllowQuarterRate) {
-            xRate = D3D12_AXIS_SHADING_RATE_4X;
-        }
-    }*/
+    // 4 samples are too few to shade at a quarter rate, every tile is shaded at 1X or 2X per axis.
+    const uint xClass = GetShadingRateAxisClass((velocityHError * avgErrorX) >= jnd_threshold, false);
+    const uint yClass = GetShadingRateAxisClass((velocityHError * avgErrorY) >= jnd_threshold, false);
 
-    // Satifying Equation 16 For Y http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    if ((velocityHError * avgErrorY) >= jnd_threshold) {
-        // Logic to Prevent Invalid 4x1 shading Rate, converts to 4X2.
-        yRate = (xRate == D3D12_AXIS_SHADING_RATE_4X ? D3D12_AXIS_SHADING_RATE_2X
-            : D3D12_AXIS_SHADING_RATE_1X);
-    }
-    // Satifying Equation 14 For Qurter Rate Shading for Y
-    // http://leiy.cc/publications/nas/nas-pacmcgit.pdf
-    //else if ((velocityQError * avgErrorY) < jnd_threshold) {
-    //    if (AllowQuarterRate) {
-    //        // Logic to Prevent 4x4 Shading Rate and invalid 1X4, converts to 4x2 or 1x2.
-    //        yRate = (xRate == D3D12_AXIS_SHADING_RATE_1X ? D3D12_AXIS_SHADING_RATE_2X
-    //            : D3D12_AXIS_SHADING_RATE_4X);
-    //    }
-    //}
-#endif
-    if (yRate == D3D12_AXIS_SHADING_RATE_1X && 
-        xRate == D3D12_AXIS_SHADING_RATE_4X)
-        xRate = D3D12_AXIS_SHADING_RATE_2X;
-    else if (yRate == D3D12_AXIS_SHADING_RATE_4X && 
-        xRate == D3D12_AXIS_SHADING_RATE_1X)
-        yRate = D3D12_AXIS_SHADING_RATE_2X;
-
-    SetShadingRate(DTid.xy, D3D12_MAKE_COARSE_SHADING_RATE(xRate, yRate));
+    SetShadingRate(DTid.xy, LookupShadingRate(xClass, yClass, false));
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef VALAR_RATE_DECISION_HLSLI
+#define VALAR_RATE_DECISION_HLSLI
+
+// Shading rate decision of a tile, shared by the shaders and the CPU engine. Compiles as HLSL and as C++, where
+// VALARCPUCommon.h includes it in namespace Intel. The HLSL emulation includes it before the shaders, so the
+// include guard keeps it out of the shader structs.
+
+#ifdef __cplusplus
+#include <cstdint>
+
+#define VALAR_RATE_UINT uint32_t
+#define VALAR_RATE_FUNCTION inline
+#define VALAR_RATE_TABLE constexpr uint32_t
+
+namespace Intel
+{
+#else
+#define VALAR_RATE_UINT uint
+#define VALAR_RATE_FUNCTION
+#define VALAR_RATE_TABLE static const uint
+#endif
+
+// Linearized velocity error curves of Equations 20 and 21, http://leiy.cc/publications/nas/nas-pacmcgit.pdf
+// velocityHError = pow(1.0 / (1.0 + pow(1.05 * velocity, 3.10)), 0.35);
+// velocityQError = K * pow(1.0 / (1.0 + pow(0.55 * velocity, 2.41)), 0.49);
+#define VALAR_H_SLOPE ((0.0468f - 1.0f) / (16.0f - 0.0f))
+#define VALAR_H_INTERCEPT 1.0f
+#define VALAR_Q_SLOPE(K) ((0.1629f - (K)) / (16.0f - 0.0f))
+
+// Per axis classes of a tile, the quarter class is shaded at 2X unless quarter rates are allowed.
+#define VALAR_RATE_CLASS_FULL 0
+#define VALAR_RATE_CLASS_HALF 1
+#define VALAR_RATE_CLASS_QUARTER 2
+#define VALAR_RATE_CLASS_COUNT 3
+
+// Satifying Equation 15 http://leiy.cc/publications/nas/nas-pacmcgit.pdf
+VALAR_RATE_FUNCTION float ComputeJNDThreshold(float sensitivityThreshold, float avgTileLuma, float environmentLuminance)
+{
+    return sensitivityThreshold * (avgTileLuma + environmentLuminance);
+}
+
+VALAR_RATE_FUNCTION float ComputeVelocityHError(float velocity, bool useMotionVectors)
+{
+    return useMotionVectors ? VALAR_H_SLOPE * velocity + VALAR_H_INTERCEPT : 1.0f;
+}
+
+VALAR_RATE_FUNCTION float ComputeVelocityQError(float velocity, float K, bool useMotionVectors)
+{
+    return useMotionVectors ? VALAR_Q_SLOPE(K) * velocity + K : K;
+}
+
+// fullRateCmp satisfies Equation 16 and quarterRateCmp Equation 14. A tile passing both ends up in the quarter class.
+VALAR_RATE_FUNCTION VALAR_RATE_UINT GetShadingRateAxisClass(bool fullRateCmp, bool quarterRateCmp)
+{
+    return (VALAR_RATE_UINT)quarterRateCmp * VALAR_RATE_CLASS_QUARTER + (VALAR_RATE_UINT)(!(fullRateCmp || quarterRateCmp));
+}
+
+VALAR_RATE_FUNCTION VALAR_RATE_UINT ClassifyShadingRateAxis(float avgError, float velocityHError, float velocityQError, float jndThreshold)
+{
+    return GetShadingRateAxisClass((velocityHError * avgError) >= jndThreshold, (velocityQError * avgError) < jndThreshold);
+}
+
+// D3D12 shading rates indexed by (xClass * VALAR_RATE_CLASS_COUNT + yClass) * 2 + allowQuarterRate. The invalid 4x1
+// and 1x4 rates are clamped to 2x1 and 1x2, 4x4 is kept.
+VALAR_RATE_TABLE ShadingRateTable[VALAR_RATE_CLASS_COUNT * VALAR_RATE_CLASS_COUNT * 2] =
+{
+    0x0, 0x0,   0x1, 0x1,   0x1, 0x1,
+    0x4, 0x4,   0x5, 0x5,   0x5, 0x6,
+    0x4, 0x4,   0x5, 0x9,   0x5, 0xa
+};
+
+VALAR_RATE_FUNCTION VALAR_RATE_UINT LookupShadingRate(VALAR_RATE_UINT xClass, VALAR_RATE_UINT yClass, bool allowQuarterRate)
+{
+    return ShadingRateTable[(xClass * VALAR_RATE_CLASS_COUNT + yClass) * 2 + (VALAR_RATE_UINT)allowQuarterRate];
+}
+
+#ifdef __cplusplus
+// Derives a table entry from the axis rates, so the table cannot drift from the rules above.
+constexpr uint32_t ResolveShadingRateClasses(uint32_t xClass, uint32_t yClass, bool allowQuarterRate)
+{
+    const uint32_t rate4x = allowQuarterRate ? 2 : 1;
+    uint32_t xRate = (xClass == VALAR_RATE_CLASS_QUARTER) ? rate4x : xClass;
+    uint32_t yRate = (yClass == VALAR_RATE_CLASS_QUARTER) ? rate4x : yClass;
+
+    if (yRate == 0 && xRate == 2) {
+        xRate = 1;
+    } else if (yRate == 2 && xRate == 0) {
+        yRate = 1;
+    }
+
+    return (xRate << 2) | yRate;
+}
+
+constexpr bool IsShadingRateTableValid()
+{
+    for (uint32_t i = 0; i < VALAR_RATE_CLASS_COUNT * VALAR_RATE_CLASS_COUNT * 2; i++) {
+        if (ShadingRateTable[i] != ResolveShadingRateClasses(i / (VALAR_RATE_CLASS_COUNT * 2), (i / 2) % VALAR_RATE_CLASS_COUNT, (i % 2) != 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(IsShadingRateTableValid(), "ShadingRateTable does not match the clamped axis rates");
+}
+#endif
+
+#undef VALAR_RATE_UINT
+#undef VALAR_RATE_FUNCTION
+#undef VALAR_RATE_TABLE
+
+#endif
\ No newline at end of file
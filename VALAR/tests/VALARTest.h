@@ -0,0 +1,327 @@
+// Copyright (C) 2022 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+
+// Records a failed check and continues, so one run reports every failing case of a test.
+#define VALAR_TEST_CHECK(condition) Intel::Test::Check((condition), #condition, __FILE__, __LINE__)
+
+// Mode flags of the test descriptors, the same bits as VALAR_CPU_KERNEL_MODE.
+#define VALAR_TEST_MODE_WEBER_FECHNER 0x1
+#define VALAR_TEST_MODE_MOTION_VECTORS 0x2
+#define VALAR_TEST_MODE_UPSCALED_MOTION_VECTORS 0x4
+#define VALAR_TEST_MODE_COUNT 8
+
+namespace Intel
+{
+    namespace Test
+    {
+        typedef enum TEST_PATTERN {
+            // Blocks of noise, flat color, gradients and faint noise, every rate shows up.
+            TEST_PATTERN_MIXED,
+            TEST_PATTERN_BLACK,
+            TEST_PATTERN_WHITE,
+            // Single pixel checkerboard, the largest derivatives on both axes.
+            TEST_PATTERN_CHECKERBOARD,
+            // Rows alternate between black and white, the luminance only changes along Y.
+            TEST_PATTERN_HORIZONTAL_STRIPES,
+            // Columns alternate between black and white, the luminance only changes along X.
+            TEST_PATTERN_VERTICAL_STRIPES,
+            TEST_PATTERN_COUNT
+        } TEST_PATTERN;
+
+        // Color, velocity and upscaled velocity inputs of a test. The upscaled velocity is twice the size of the
+        // color buffer, the color pixels are stored in 4 byte words so every format is aligned.
+        struct TEST_IMAGE
+        {
+            uint32_t                    m_width = 0;
+            uint32_t                    m_height = 0;
+            VALAR_CPU_FORMAT            m_colorFormat = VALAR_CPU_FORMAT_R32G32B32A32_FLOAT;
+            std::vector<uint32_t>       m_color;
+            std::vector<uint32_t>       m_velocity;
+            std::vector<float>          m_upscaledVelocity;
+        };
+
+        inline uint32_t& GetFailureCount()
+        {
+            static uint32_t failureCount = 0;
+            return failureCount;
+        }
+
+        inline bool Check(bool condition, const char* expression, const char* file, int line)
+        {
+            if (!condition) {
+                printf("%s(%d): check failed: %s\n", file, line, expression);
+                GetFailureCount()++;
+            }
+
+            return condition;
+        }
+
+        // Exit code of a test.
+        inline int FinishTest(const char* testName)
+        {
+            printf("%s: %u failed checks\n", testName, GetFailureCount());
+
+            return (GetFailureCount() == 0) ? 0 : 1;
+        }
+
+        // Binary16 like float with a 5 bit exponent and mantissaBits mantissa bits, for values in [0, 1].
+        inline uint32_t EncodeSmallFloat(float value, uint32_t mantissaBits)
+        {
+            if (value <= 0.0f) {
+                return 0;
+            }
+
+            int exponent;
+            const float mantissa = frexpf(value, &exponent);
+            const int biasedExponent = exponent - 1 + 15;
+
+            if (biasedExponent <= 0) {
+                return (uint32_t)(value * (float)(1 << 14) * (float)(1u << mantissaBits));
+            }
+
+            return ((uint32_t)biasedExponent << mantissaBits) | (uint32_t)((mantissa * 2.0f - 1.0f) * (float)(1u << mantissaBits));
+        }
+
+        inline uint32_t GetColorWordCount(VALAR_CPU_FORMAT colorFormat)
+        {
+            switch (colorFormat)
+            {
+            case VALAR_CPU_FORMAT_R32G32B32A32_FLOAT:
+                return 4;
+            case VALAR_CPU_FORMAT_R16G16B16A16_FLOAT:
+                return 2;
+            default:
+                return 1;
+            }
+        }
+
+        // Stores channels in [0, 1] as a pixel of colorFormat.
+        inline void EncodeColor(VALAR_CPU_FORMAT colorFormat, const float channels[4], uint32_t* pixel)
+        {
+            uint32_t unorm8[4];
+            for (uint32_t i = 0; i < 4; i++) {
+                unorm8[i] = (uint32_t)(channels[i] * 255.0f + 0.5f);
+            }
+
+            switch (colorFormat)
+            {
+            case VALAR_CPU_FORMAT_R32G32B32A32_FLOAT:
+                memcpy(pixel, channels, 4 * sizeof(float));
+                break;
+            case VALAR_CPU_FORMAT_R8G8B8A8_UNORM:
+            case VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB:
+                pixel[0] = unorm8[0] | (unorm8[1] << 8) | (unorm8[2] << 16) | (unorm8[3] << 24);
+                break;
+            case VALAR_CPU_FORMAT_B8G8R8A8_UNORM:
+            case VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB:
+                pixel[0] = unorm8[2] | (unorm8[1] << 8) | (unorm8[0] << 16) | (unorm8[3] << 24);
+                break;
+            case VALAR_CPU_FORMAT_R10G10B10A2_UNORM:
+                pixel[0] = (uint32_t)(channels[0] * 1023.0f + 0.5f) | ((uint32_t)(channels[1] * 1023.0f + 0.5f) << 10) |
+                    ((uint32_t)(channels[2] * 1023.0f + 0.5f) << 20) | ((uint32_t)(channels[3] * 3.0f + 0.5f) << 30);
+                break;
+            case VALAR_CPU_FORMAT_R11G11B10_FLOAT:
+                pixel[0] = EncodeSmallFloat(channels[0], 6) | (EncodeSmallFloat(channels[1], 6) << 11) | (EncodeSmallFloat(channels[2], 5) << 22);
+                break;
+            case VALAR_CPU_FORMAT_R16G16B16A16_FLOAT:
+                pixel[0] = EncodeSmallFloat(channels[0], 10) | (EncodeSmallFloat(channels[1], 10) << 16);
+                pixel[1] = EncodeSmallFloat(channels[2], 10) | (EncodeSmallFloat(channels[3], 10) << 16);
+                break;
+            default:
+                break;
+            }
+        }
+
+        inline float GetPatternLevel(TEST_PATTERN pattern, uint32_t x, uint32_t y, std::mt19937& random)
+        {
+            switch (pattern)
+            {
+            case TEST_PATTERN_MIXED:
+                switch ((x / 24 + y / 24) % 4)
+                {
+                case 0:
+                    return (float)(random() % 256) / 255.0f;
+                case 1:
+                    return 0.3f;
+                case 2:
+                    return (float)((x + 2 * y) % 256) / 255.0f;
+                default:
+                    return (float)(20 + random() % 4) / 255.0f;
+                }
+            case TEST_PATTERN_BLACK:
+                return 0.0f;
+            case TEST_PATTERN_WHITE:
+                return 1.0f;
+            case TEST_PATTERN_CHECKERBOARD:
+                return (float)((x + y) & 1);
+            case TEST_PATTERN_HORIZONTAL_STRIPES:
+                return (float)(y & 1);
+            case TEST_PATTERN_VERTICAL_STRIPES:
+                return (float)(x & 1);
+            default:
+                return 0.0f;
+            }
+        }
+
+        // Packed R32_UINT velocity with half float X and Y of up to 64 pixels, and random Z.
+        inline uint32_t MakeRandomVelocity(std::mt19937& random)
+        {
+            return (random() % 64) | ((random() % 64) << 10) | ((random() % 256) << 20);
+        }
+
+        inline TEST_IMAGE MakeTestImage(uint32_t width, uint32_t height, VALAR_CPU_FORMAT colorFormat, TEST_PATTERN pattern, uint32_t seed)
+        {
+            TEST_IMAGE image;
+            image.m_width = width;
+            image.m_height = height;
+            image.m_colorFormat = colorFormat;
+
+            const uint32_t wordCount = GetColorWordCount(colorFormat);
+            std::mt19937 random(seed);
+
+            image.m_color.resize((size_t)width * height * wordCount);
+            for (uint32_t y = 0; y < height; y++) {
+                for (uint32_t x = 0; x < width; x++) {
+                    // Slightly different channels, so the luminance weights of every channel matter.
+                    const float level = GetPatternLevel(pattern, x, y, random);
+                    const float channels[4] = { level, level * 0.9f, level * 0.8f, 1.0f };
+
+                    EncodeColor(colorFormat, channels, &image.m_color[((size_t)y * width + x) * wordCount]);
+                }
+            }
+
+            image.m_velocity.resize((size_t)width * height);
+            for (uint32_t& velocity : image.m_velocity) {
+                velocity = (pattern == TEST_PATTERN_MIXED) ? MakeRandomVelocity(random) : 0;
+            }
+
+            image.m_upscaledVelocity.resize((size_t)4 * width * height * 2);
+            for (float& velocity : image.m_upscaledVelocity) {
+                velocity = (pattern == TEST_PATTERN_MIXED) ? (float)(random() % 1024) / 256.0f : 0.0f;
+            }
+
+            return image;
+        }
+
+        // Descriptor reading image, mode is a combination of the VALAR_TEST_MODE flags.
+        inline VALAR_CPU_DESCRIPTOR MakeTestDescriptor(const TEST_IMAGE& image, uint32_t tileSize, uint32_t mode)
+        {
+            VALAR_CPU_DESCRIPTOR desc;
+            desc.m_shadingRateTileSize = tileSize;
+            desc.m_bufferWidth = image.m_width;
+            desc.m_bufferHeight = image.m_height;
+            desc.m_upscaleWidth = 2 * image.m_width;
+            desc.m_upscaleHeight = 2 * image.m_height;
+            desc.m_colorFormat = image.m_colorFormat;
+            desc.m_colorBuffer = image.m_color.data();
+            desc.m_velocityBuffer = image.m_velocity.data();
+            desc.m_upscaledVelocityBuffer = image.m_upscaledVelocity.data();
+            desc.m_weberFechnerMode = (mode & VALAR_TEST_MODE_WEBER_FECHNER) != 0;
+            desc.m_useMotionVectors = (mode & VALAR_TEST_MODE_MOTION_VECTORS) != 0;
+            desc.m_useUpscaleMotionVectors = (mode & VALAR_TEST_MODE_UPSCALED_MOTION_VECTORS) != 0;
+
+            // Upscaled motion vectors replace the packed ones, they need the motion vector mode as well.
+            if (desc.m_useUpscaleMotionVectors) {
+                desc.m_useMotionVectors = true;
+            }
+
+            return desc;
+        }
+
+        inline uint32_t GetTileCountX(const VALAR_CPU_DESCRIPTOR& desc)
+        {
+            return (desc.m_bufferWidth + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+        }
+
+        inline uint32_t GetTileCountY(const VALAR_CPU_DESCRIPTOR& desc)
+        {
+            return (desc.m_bufferHeight + desc.m_shadingRateTileSize - 1) / desc.m_shadingRateTileSize;
+        }
+
+        inline size_t CountDifferences(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+        {
+            if (a.size() != b.size()) {
+                return (a.size() > b.size()) ? a.size() : b.size();
+            }
+
+            size_t differenceCount = 0;
+            for (size_t i = 0; i < a.size(); i++) {
+                differenceCount += (a[i] != b[i]) ? 1 : 0;
+            }
+
+            return differenceCount;
+        }
+
+        // Statistics of every tile from the float tile kernels of an initialized descriptor, in spans like ComputeTileRun.
+        inline std::vector<VALAR_TILE_STATISTICS> ComputeKernelStatistics(const VALAR_CPU_DESCRIPTOR& desc)
+        {
+            const uint32_t tilesX = GetTileCountX(desc);
+            const uint32_t tilesY = GetTileCountY(desc);
+            const uint32_t tilesPerSpan = VALAR_CPU_SPAN_WIDTH / desc.m_shadingRateTileSize;
+            const VALAR_CPU_TILE_KERNEL tileKernel =
+                desc.m_pOpaque->m_tileKernels.m_floatKernels[GetTileSizeIndex(desc.m_shadingRateTileSize)][GetColorFormat(desc)][GetTileKernelMode(desc)];
+
+            std::vector<VALAR_TILE_STATISTICS> stats((size_t)tilesX * tilesY);
+            for (uint32_t tileY = 0; tileY < tilesY; tileY++) {
+                for (uint32_t spanBegin = 0; spanBegin < tilesX; spanBegin += tilesPerSpan) {
+                    const uint32_t spanEnd = (spanBegin + tilesPerSpan < tilesX) ? spanBegin + tilesPerSpan : tilesX;
+                    tileKernel(desc, tileY, spanBegin, spanEnd, &stats[(size_t)tileY * tilesX + spanBegin]);
+                }
+            }
+
+            return stats;
+        }
+
+        // Initializes a copy of desc with the given instruction set and worker threads, computes its mask with
+        // VALAR_ComputeMaskCPU and releases it again. Returns an empty mask when the instruction set is not supported.
+        inline std::vector<uint8_t> ComputeTestMask(const VALAR_CPU_DESCRIPTOR& desc, VALAR_CPU_INSTRUCTION_SET instructionSet, uint32_t workerThreadCount)
+        {
+            VALAR_CPU_DESCRIPTOR maskDesc = desc;
+            maskDesc.m_instructionSet = instructionSet;
+            maskDesc.m_workerThreadCount = workerThreadCount;
+            maskDesc.m_pOpaque = nullptr;
+
+            if (VALAR_InitializeCPU(maskDesc) != VALAR_RETURN_CODE_SUCCESS) {
+                return std::vector<uint8_t>();
+            }
+
+            std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+            maskDesc.m_valarBuffer = mask.data();
+            maskDesc.m_valarRowPitch = 0;
+
+            VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+
+            return mask;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Heap of the allocation callbacks, fails the allocation with index m_failingAllocation.
+struct TEST_HEAP
+{
+    std::map<void*, VALAR_CPU_ALLOCATION_TAG> m_blocks;
+    uint64_t                                m_allocationCount = 0;
+    uint64_t                                m_failingAllocation = UINT64_MAX;
+    uint32_t                                m_errorCount = 0;
+};
+
+static void* TestAllocate(void* userData, size_t size, size_t alignment, VALAR_CPU_ALLOCATION_TAG tag)
+{
+    TEST_HEAP& heap = *(TEST_HEAP*)userData;
+
+    if (heap.m_allocationCount++ == heap.m_failingAllocation) {
+        return nullptr;
+    }
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        heap.m_errorCount++;
+        return nullptr;
+    }
+
+    alignment = (alignment < sizeof(void*)) ? sizeof(void*) : alignment;
+    void* memory = nullptr;
+
+    if (posix_memalign(&memory, alignment, size) != 0) {
+        return nullptr;
+    }
+
+    heap.m_blocks[memory] = tag;
+
+    return memory;
+}
+
+static void TestFree(void* userData, void* memory, VALAR_CPU_ALLOCATION_TAG tag)
+{
+    TEST_HEAP& heap = *(TEST_HEAP*)userData;
+    const auto block = heap.m_blocks.find(memory);
+
+    // Blocks are freed once, with the tag they were allocated with.
+    if (block == heap.m_blocks.end() || block->second != tag) {
+        heap.m_errorCount++;
+        return;
+    }
+
+    heap.m_blocks.erase(block);
+    free(memory);
+}
+
+// One frame of every mask path that keeps its memory across frames.
+static void ComputeFrame(const VALAR_CPU_DESCRIPTOR& desc, std::vector<uint8_t>& pyramidMask)
+{
+    VALAR_CPU_DESCRIPTOR temporalDesc = desc;
+    temporalDesc.m_temporalReuse = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(temporalDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_TILE_RECT tileRect;
+    tileRect.m_right = GetTileCountX(desc);
+    tileRect.m_bottom = GetTileCountY(desc);
+    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(desc, tileRect) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_RECT dirtyRect;
+    dirtyRect.m_right = 20;
+    dirtyRect.m_bottom = 20;
+    VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, &dirtyRect, 1) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(&desc, 1) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_MASK_PYRAMID pyramid;
+    pyramid.m_valarBuffers[0] = pyramidMask.data();
+    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_ASYNC_MASK asyncMask;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(temporalDesc, asyncMask) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+// After a warm-up frame no path allocates, with and without callbacks, and every block goes back to the callbacks.
+static void TestWarmUp()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 1);
+
+    for (uint32_t useCallbacks = 0; useCallbacks < 2; useCallbacks++) {
+        TEST_HEAP heap;
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, VALAR_TEST_MODE_MOTION_VECTORS);
+        desc.m_workerThreadCount = 3;
+        desc.m_asyncMaskBufferCount = 2;
+
+        if (useCallbacks) {
+            desc.m_allocationCallbacks.m_allocate = TestAllocate;
+            desc.m_allocationCallbacks.m_free = TestFree;
+            desc.m_allocationCallbacks.m_userData = &heap;
+        }
+
+        uint64_t allocationCount = 0;
+        VALAR_TEST_CHECK(VALAR_GetAllocationCountCPU(desc, allocationCount) == VALAR_RETURN_CODE_NOT_INITIALIZED);
+        VALAR_TEST_CHECK(VALAR_SetWarmUpCompleteCPU(desc, true) == VALAR_RETURN_CODE_NOT_INITIALIZED);
+
+        if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+            continue;
+        }
+
+        std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+        std::vector<uint8_t> pyramidMask(mask.size());
+        desc.m_valarBuffer = mask.data();
+
+        // Every async mask buffer is allocated by the first mask that uses it.
+        for (uint32_t frame = 0; frame < desc.m_asyncMaskBufferCount; frame++) {
+            ComputeFrame(desc, pyramidMask);
+        }
+
+        // Debug builds assert on any allocation from here on.
+        VALAR_TEST_CHECK(VALAR_SetWarmUpCompleteCPU(desc, true) == VALAR_RETURN_CODE_SUCCESS);
+
+        uint64_t warmAllocationCount = 0;
+        VALAR_TEST_CHECK(VALAR_GetAllocationCountCPU(desc, warmAllocationCount) == VALAR_RETURN_CODE_SUCCESS);
+
+        for (uint32_t frame = 0; frame < 4; frame++) {
+            ComputeFrame(desc, pyramidMask);
+        }
+
+        VALAR_TEST_CHECK(VALAR_GetAllocationCountCPU(desc, allocationCount) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(allocationCount == warmAllocationCount);
+
+        if (useCallbacks) {
+            VALAR_TEST_CHECK(heap.m_allocationCount == allocationCount);
+        }
+
+        // A new mask size allocates again, around the first frame at that size.
+        VALAR_TEST_CHECK(VALAR_SetWarmUpCompleteCPU(desc, false) == VALAR_RETURN_CODE_SUCCESS);
+
+        VALAR_CPU_DESCRIPTOR smallDesc = desc;
+        smallDesc.m_bufferWidth = 100;
+        smallDesc.m_bufferHeight = 60;
+        ComputeFrame(smallDesc, pyramidMask);
+
+        VALAR_TEST_CHECK(VALAR_GetAllocationCountCPU(desc, allocationCount) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(allocationCount > warmAllocationCount);
+
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(heap.m_blocks.empty());
+        VALAR_TEST_CHECK(heap.m_errorCount == 0);
+    }
+}
+
+// Every failing allocation is reported without leaking the allocations before it.
+static void TestFailingAllocations()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 2);
+
+    for (uint64_t failingAllocation = 0; failingAllocation < 12; failingAllocation++) {
+        TEST_HEAP heap;
+        heap.m_failingAllocation = failingAllocation;
+
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+        desc.m_workerThreadCount = 2;
+        desc.m_asyncMaskBufferCount = 2;
+        desc.m_temporalReuse = true;
+        desc.m_allocationCallbacks.m_allocate = TestAllocate;
+        desc.m_allocationCallbacks.m_free = TestFree;
+        desc.m_allocationCallbacks.m_userData = &heap;
+
+        const VALAR_RETURN_CODE retCode = VALAR_InitializeCPU(desc);
+
+        if (retCode != VALAR_RETURN_CODE_SUCCESS) {
+            VALAR_TEST_CHECK(retCode == VALAR_RETURN_CODE_OUT_OF_MEMORY);
+            VALAR_TEST_CHECK(desc.m_pOpaque == nullptr);
+            VALAR_TEST_CHECK(heap.m_blocks.empty());
+            continue;
+        }
+
+        std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+        desc.m_valarBuffer = mask.data();
+
+        // Without its history the temporal mode computes every tile.
+        VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+        // A failed async buffer is allocated again by the next submit.
+        VALAR_CPU_ASYNC_MASK asyncMask;
+        VALAR_RETURN_CODE asyncRetCode = VALAR_ComputeMaskAsyncCPU(desc, asyncMask);
+        if (asyncRetCode == VALAR_RETURN_CODE_OUT_OF_MEMORY) {
+            asyncRetCode = VALAR_ComputeMaskAsyncCPU(desc, asyncMask);
+        }
+
+        if (VALAR_TEST_CHECK(asyncRetCode == VALAR_RETURN_CODE_SUCCESS)) {
+            VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS);
+        }
+
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(heap.m_blocks.empty());
+        VALAR_TEST_CHECK(heap.m_errorCount == 0);
+    }
+
+    // Only one of the two callbacks.
+    VALAR_CPU_DESCRIPTOR desc;
+    desc.m_allocationCallbacks.m_allocate = TestAllocate;
+    VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+}
+
+int main()
+{
+    TestWarmUp();
+    TestFailingAllocations();
+
+    return FinishTest("VALARTestAllocation");
+}
\ No newline at end of file
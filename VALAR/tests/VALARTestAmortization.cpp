@@ -0,0 +1,249 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+static const uint32_t kAmortizationPeriods[] = { 2, 4, 8, 16 };
+
+static VALAR_RETURN_CODE ComputeAmortizedMask(const VALAR_CPU_DESCRIPTOR& desc, bool lowPrecision)
+{
+    return lowPrecision ? VALAR_ComputeMaskLPCPU(desc) : VALAR_ComputeMaskCPU(desc);
+}
+
+// Tile counts of the rates in mask, the values outside of the rate range are not counted like FinalizeMask does.
+static bool CheckStatistics(const VALAR_CPU_DESCRIPTOR& desc, const std::vector<uint8_t>& mask)
+{
+    uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+    for (uint8_t shadingRate : mask) {
+        if (shadingRate < VALAR_CPU_SHADING_RATE_COUNT) {
+            shadingRateTileCount[shadingRate]++;
+        }
+    }
+
+    VALAR_CPU_MASK_STATISTICS statistics;
+    if (!VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS)) {
+        return false;
+    }
+
+    bool equal = true;
+    for (uint32_t i = 0; i < VALAR_CPU_SHADING_RATE_COUNT; i++) {
+        equal = equal && statistics.m_shadingRateTileCount[i] == shadingRateTileCount[i];
+    }
+
+    return VALAR_TEST_CHECK(equal);
+}
+
+// Over one period of a static image every tile is recomputed exactly once, the others keep the rate of the
+// previous frame, and the mask ends as the full mask. The statistics count the kept tiles with their previous rate.
+static void TestStaticImage()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 21);
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t lowPrecision = 0; lowPrecision < 2; lowPrecision++) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, 0);
+            desc.m_workerThreadCount = 3;
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            const size_t tileCount = (size_t)GetTileCountX(desc) * GetTileCountY(desc);
+            std::vector<uint8_t> fullMask(tileCount, 0xEE);
+            desc.m_valarBuffer = fullMask.data();
+            VALAR_TEST_CHECK(ComputeAmortizedMask(desc, lowPrecision != 0) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+
+            for (uint32_t period : kAmortizationPeriods) {
+                std::vector<uint8_t> mask(tileCount, 0xEE);
+                std::vector<uint32_t> updateCount(tileCount, 0);
+                desc.m_valarBuffer = mask.data();
+                desc.m_amortizationPeriod = period;
+
+                for (uint32_t frame = 0; frame < period; frame++) {
+                    desc.m_frameIndex = 5 * period + 3 + frame;
+                    const std::vector<uint8_t> previousMask = mask;
+
+                    if (!VALAR_TEST_CHECK(ComputeAmortizedMask(desc, lowPrecision != 0) == VALAR_RETURN_CODE_SUCCESS)) {
+                        break;
+                    }
+
+                    size_t dueCount = 0;
+                    size_t wrongCount = 0;
+                    for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                        for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                            const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                            if (IsAmortizedTileDue(desc, tileX, tileY)) {
+                                dueCount++;
+                                updateCount[i]++;
+                                wrongCount += (mask[i] != fullMask[i]) ? 1 : 0;
+                            } else {
+                                wrongCount += (mask[i] != previousMask[i]) ? 1 : 0;
+                            }
+                        }
+                    }
+
+                    if (!VALAR_TEST_CHECK(wrongCount == 0)) {
+                        printf("    tile size %u LP %u period %u frame %u: %zu tiles differ\n", tileSize, lowPrecision, period, frame, wrongCount);
+                    }
+
+                    VALAR_TEST_CHECK(dueCount > 0 && dueCount < tileCount);
+                    CheckStatistics(desc, mask);
+                }
+
+                size_t missedCount = 0;
+                for (uint32_t count : updateCount) {
+                    missedCount += (count != 1) ? 1 : 0;
+                }
+
+                VALAR_TEST_CHECK(missedCount == 0);
+                VALAR_TEST_CHECK(CountDifferences(mask, fullMask) == 0);
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// With motion vectors the tiles faster than the velocity bound are recomputed every frame on top of the due tiles.
+static void TestVelocityBound()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 22);
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t lowPrecision = 0; lowPrecision < 2; lowPrecision++) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            const size_t tileCount = (size_t)GetTileCountX(desc) * GetTileCountY(desc);
+            std::vector<uint8_t> fullMask(tileCount, 0xEE);
+            desc.m_valarBuffer = fullMask.data();
+            VALAR_TEST_CHECK(ComputeAmortizedMask(desc, lowPrecision != 0) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+
+            std::vector<uint8_t> mask(tileCount, 0xEE);
+            desc.m_valarBuffer = mask.data();
+            desc.m_amortizationPeriod = 8;
+            desc.m_frameIndex = 3;
+
+            // Every tile moves faster than a negative bound.
+            desc.m_amortizationVelocityBound = -1.0f;
+            VALAR_TEST_CHECK(ComputeAmortizedMask(desc, lowPrecision != 0) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(CountDifferences(mask, fullMask) == 0);
+            CheckStatistics(desc, mask);
+
+            // No tile moves faster than an unreachable bound, only the due tiles of the Bayer order are recomputed.
+            std::fill(mask.begin(), mask.end(), (uint8_t)0xEE);
+            desc.m_amortizationVelocityBound = 1.0e30f;
+            VALAR_TEST_CHECK(ComputeAmortizedMask(desc, lowPrecision != 0) == VALAR_RETURN_CODE_SUCCESS);
+
+            VALAR_CPU_DESCRIPTOR orderDesc = desc;
+            orderDesc.m_useMotionVectors = false;
+
+            size_t wrongCount = 0;
+            for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                    const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                    const uint8_t expected = IsAmortizedTileDue(orderDesc, tileX, tileY) ? fullMask[i] : (uint8_t)0xEE;
+                    wrongCount += (mask[i] != expected) ? 1 : 0;
+                }
+            }
+
+            VALAR_TEST_CHECK(wrongCount == 0);
+            CheckStatistics(desc, mask);
+
+            // The default bound recomputes some of the random motion vectors of up to 64 pixels, and not all tiles.
+            std::fill(mask.begin(), mask.end(), (uint8_t)0xEE);
+            desc.m_amortizationVelocityBound = 2.0f;
+            VALAR_TEST_CHECK(ComputeAmortizedMask(desc, lowPrecision != 0) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+
+            size_t forcedCount = 0;
+            wrongCount = 0;
+            for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                    const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                    const bool due = IsAmortizedTileDue(desc, tileX, tileY);
+                    forcedCount += (due && !IsAmortizedTileDue(orderDesc, tileX, tileY)) ? 1 : 0;
+                    wrongCount += (mask[i] != (due ? fullMask[i] : (uint8_t)0xEE)) ? 1 : 0;
+                }
+            }
+
+            VALAR_TEST_CHECK(wrongCount == 0);
+            VALAR_TEST_CHECK(forcedCount > 0);
+            VALAR_TEST_CHECK(CountDifferences(mask, fullMask) != 0);
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+static void TestInvalidPeriods()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    desc.m_valarBuffer = mask.data();
+
+    const uint32_t periods[] = { 0, 3, 12, 32 };
+    for (uint32_t period : periods) {
+        VALAR_CPU_DESCRIPTOR invalidDesc = desc;
+        invalidDesc.m_amortizationPeriod = period;
+        VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+        VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    }
+
+    // Amortized tiles have no statistics for temporal reuse.
+    VALAR_CPU_DESCRIPTOR temporalDesc = desc;
+    temporalDesc.m_amortizationPeriod = 4;
+    temporalDesc.m_temporalReuse = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(temporalDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), 0xEE)) == 0);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestStaticImage();
+    TestVelocityBound();
+    TestInvalidPeriods();
+
+    return FinishTest("VALARTestAmortization");
+}
\ No newline at end of file
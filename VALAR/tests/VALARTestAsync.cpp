@@ -0,0 +1,279 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static bool IsAsyncMaskEqual(const VALAR_CPU_ASYNC_MASK& asyncMask, const std::vector<uint8_t>& mask)
+{
+    return asyncMask.m_valarBuffer != nullptr && memcmp(asyncMask.m_valarBuffer, mask.data(), mask.size()) == 0;
+}
+
+// Async masks match the synchronous ones, and a disabled descriptor hands out a full rate mask.
+static void TestAsyncMasks()
+{
+    const uint32_t bufferCounts[] = { 1, 2, 3 };
+    const TEST_IMAGE images[] = {
+        MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 1),
+        MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 2),
+        MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_CHECKERBOARD, 3),
+    };
+
+    std::vector<uint8_t> masks[3];
+    for (uint32_t i = 0; i < 3; i++) {
+        masks[i] = ComputeTestMask(MakeTestDescriptor(images[i], 8, VALAR_TEST_MODE_MOTION_VECTORS), VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+    }
+
+    for (uint32_t bufferCount : bufferCounts) {
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(images[0], 8, VALAR_TEST_MODE_MOTION_VECTORS);
+        desc.m_workerThreadCount = 2;
+        desc.m_asyncMaskBufferCount = bufferCount;
+
+        if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+            continue;
+        }
+
+        for (uint32_t frame = 0; frame < 12; frame++) {
+            const uint32_t image = frame % 3;
+            desc.m_colorBuffer = images[image].m_color.data();
+            desc.m_velocityBuffer = images[image].m_velocity.data();
+
+            VALAR_CPU_ASYNC_MASK asyncMask;
+            if (!VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS)) {
+                break;
+            }
+
+            VALAR_TEST_CHECK(asyncMask.m_fenceValue == frame + 1);
+            VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(IsAsyncMaskEqual(asyncMask, masks[image]));
+        }
+
+        desc.m_enabled = false;
+
+        VALAR_CPU_ASYNC_MASK disabledMask;
+        VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(desc, disabledMask) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, disabledMask) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(IsAsyncMaskEqual(disabledMask, std::vector<uint8_t>(masks[0].size(), VALAR_SHADING_RATE_1X1)));
+
+        // Fences that were never submitted are rejected.
+        VALAR_CPU_ASYNC_MASK futureMask;
+        futureMask.m_fenceValue = disabledMask.m_fenceValue + 1;
+        VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, futureMask) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+        uint64_t completedFenceValue = 0;
+        VALAR_TEST_CHECK(VALAR_GetCompletedFenceValueCPU(desc, completedFenceValue) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(completedFenceValue == disabledMask.m_fenceValue);
+
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+    }
+}
+
+// A handle stays valid for m_asyncMaskBufferCount submits, also when the mask size changes in between.
+static void TestAsyncResize()
+{
+    const TEST_IMAGE largeImage = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 4);
+    const TEST_IMAGE smallImage = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 5);
+    const VALAR_CPU_DESCRIPTOR largeDesc = MakeTestDescriptor(largeImage, 8, 0);
+    const VALAR_CPU_DESCRIPTOR smallDesc = MakeTestDescriptor(smallImage, 8, 0);
+    const std::vector<uint8_t> largeMask = ComputeTestMask(largeDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+    const std::vector<uint8_t> smallMask = ComputeTestMask(smallDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+    VALAR_CPU_DESCRIPTOR desc = largeDesc;
+    desc.m_workerThreadCount = 2;
+    desc.m_asyncMaskBufferCount = 3;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    // Large, large, small, small, large: every submit after the first two reuses a slot of the other size.
+    const VALAR_CPU_DESCRIPTOR* frameDescs[] = { &largeDesc, &largeDesc, &smallDesc, &smallDesc, &largeDesc };
+    const std::vector<uint8_t>* frameMasks[] = { &largeMask, &largeMask, &smallMask, &smallMask, &largeMask };
+    VALAR_CPU_ASYNC_MASK asyncMasks[5];
+
+    for (uint32_t frame = 0; frame < 5; frame++) {
+        VALAR_CPU_DESCRIPTOR frameDesc = *frameDescs[frame];
+        frameDesc.m_pOpaque = desc.m_pOpaque;
+
+        if (!VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(frameDesc, asyncMasks[frame]) == VALAR_RETURN_CODE_SUCCESS)) {
+            break;
+        }
+
+        VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(frameDesc, asyncMasks[frame]) == VALAR_RETURN_CODE_SUCCESS);
+
+        // The last m_asyncMaskBufferCount handles, including the ones of the other size, are still intact.
+        for (uint32_t previousFrame = (frame >= 2) ? frame - 2 : 0; previousFrame <= frame; previousFrame++) {
+            VALAR_TEST_CHECK(IsAsyncMaskEqual(asyncMasks[previousFrame], *frameMasks[previousFrame]));
+        }
+    }
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+// Amortized async masks continue from the previous mask, or from the full rate after a size change.
+static void TestAsyncAmortization()
+{
+    const TEST_IMAGE largeImage = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 6);
+    const TEST_IMAGE smallImage = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 7);
+    const TEST_IMAGE* frameImages[] = { &largeImage, &largeImage, &smallImage, &smallImage };
+
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(largeImage, 8, 0);
+    desc.m_workerThreadCount = 2;
+    desc.m_asyncMaskBufferCount = 2;
+    desc.m_amortizationPeriod = 4;
+
+    VALAR_CPU_DESCRIPTOR syncDesc = desc;
+    syncDesc.m_asyncMaskBufferCount = 0;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(syncDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+        VALAR_ReleaseCPU(desc);
+        return;
+    }
+
+    std::vector<uint8_t> syncMask;
+
+    for (uint32_t frame = 0; frame < 4; frame++) {
+        const TEST_IMAGE& image = *frameImages[frame];
+        const VALAR_CPU_DESCRIPTOR imageDesc = MakeTestDescriptor(image, 8, 0);
+
+        // The synchronous mask starts at the full rate whenever the size changes, like the async slots.
+        if (frame == 0 || frameImages[frame - 1] != &image) {
+            syncMask.assign((size_t)GetTileCountX(imageDesc) * GetTileCountY(imageDesc), VALAR_SHADING_RATE_1X1);
+        }
+
+        desc.m_bufferWidth = syncDesc.m_bufferWidth = image.m_width;
+        desc.m_bufferHeight = syncDesc.m_bufferHeight = image.m_height;
+        desc.m_colorBuffer = syncDesc.m_colorBuffer = image.m_color.data();
+        desc.m_frameIndex = syncDesc.m_frameIndex = frame;
+        syncDesc.m_valarBuffer = syncMask.data();
+
+        VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(syncDesc) == VALAR_RETURN_CODE_SUCCESS);
+
+        VALAR_CPU_ASYNC_MASK asyncMask;
+        if (!VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS)) {
+            break;
+        }
+
+        VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(IsAsyncMaskEqual(asyncMask, syncMask));
+    }
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(syncDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+// Async temporal masks run next to synchronous masks and finalize steps of the same descriptor. The masks match
+// the ones computed from scratch, and every finalize step counts whole masks only.
+static void TestAsyncConcurrentMasks()
+{
+    const TEST_IMAGE images[] = {
+        MakeTestImage(320, 184, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 8),
+        MakeTestImage(320, 184, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 9),
+    };
+
+    std::vector<uint8_t> masks[2];
+    for (uint32_t i = 0; i < 2; i++) {
+        masks[i] = ComputeTestMask(MakeTestDescriptor(images[i], 8, VALAR_TEST_MODE_MOTION_VECTORS), VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+    }
+
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(images[0], 8, VALAR_TEST_MODE_MOTION_VECTORS);
+    desc.m_workerThreadCount = 2;
+    desc.m_asyncMaskBufferCount = 3;
+    desc.m_temporalReuse = true;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    const uint32_t tileCount = (uint32_t)masks[0].size();
+    const uint32_t frameCount = 64;
+    uint32_t countedTiles = 0;
+    uint32_t syncFailureCount = 0;
+
+    // The calling thread computes synchronous masks of the second image while the async queue computes the first.
+    std::thread syncThread([&] {
+        VALAR_CPU_DESCRIPTOR syncDesc = desc;
+        std::vector<uint8_t> syncMask(tileCount);
+
+        syncDesc.m_colorBuffer = images[1].m_color.data();
+        syncDesc.m_velocityBuffer = images[1].m_velocity.data();
+        syncDesc.m_valarBuffer = syncMask.data();
+
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            // The failure count of VALAR_TEST_CHECK belongs to the main thread.
+            if (VALAR_ComputeMaskCPU(syncDesc) != VALAR_RETURN_CODE_SUCCESS || CountDifferences(syncMask, masks[1]) != 0) {
+                syncFailureCount++;
+            }
+        }
+    });
+
+    VALAR_CPU_ASYNC_MASK asyncMasks[frameCount];
+
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        if (!VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(desc, asyncMasks[frame]) == VALAR_RETURN_CODE_SUCCESS)) {
+            break;
+        }
+
+        VALAR_CPU_MASK_STATISTICS statistics;
+        VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(statistics.m_tileCount % tileCount == 0);
+        countedTiles += statistics.m_tileCount;
+
+        if (frame >= 2) {
+            VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMasks[frame - 2]) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(IsAsyncMaskEqual(asyncMasks[frame - 2], masks[0]));
+        }
+    }
+
+    syncThread.join();
+    VALAR_TEST_CHECK(syncFailureCount == 0);
+
+    VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMasks[frameCount - 1]) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(IsAsyncMaskEqual(asyncMasks[frameCount - 1], masks[0]));
+
+    VALAR_CPU_MASK_STATISTICS statistics;
+    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+    countedTiles += statistics.m_tileCount;
+    VALAR_TEST_CHECK(countedTiles == 2 * frameCount * tileCount);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestAsyncMasks();
+    TestAsyncResize();
+    TestAsyncAmortization();
+    TestAsyncConcurrentMasks();
+
+    return FinishTest("VALARTestAsync");
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUTemporal.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Views of different sizes, formats and parameters match separate masks, and count the same tiles.
+static void TestBatchViews()
+{
+    const uint32_t viewCount = 5;
+    const TEST_IMAGE images[viewCount] = {
+        MakeTestImage(640, 360, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 1),
+        MakeTestImage(333, 197, VALAR_CPU_FORMAT_R8G8B8A8_UNORM, TEST_PATTERN_MIXED, 2),
+        MakeTestImage(100, 60, VALAR_CPU_FORMAT_R16G16B16A16_FLOAT, TEST_PATTERN_MIXED, 3),
+        MakeTestImage(256, 256, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_CHECKERBOARD, 4),
+        MakeTestImage(7, 5, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 5),
+    };
+
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(images[0], 8, 0);
+    desc.m_workerThreadCount = 3;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    VALAR_CPU_TILE_RECT regionOfInterest;
+    regionOfInterest.m_left = 2;
+    regionOfInterest.m_top = 1;
+    regionOfInterest.m_right = 9;
+    regionOfInterest.m_bottom = 6;
+
+    VALAR_CPU_DESCRIPTOR views[viewCount];
+    std::vector<uint8_t> masks[viewCount];
+    std::vector<uint8_t> batchMasks[viewCount];
+
+    for (uint32_t view = 0; view < viewCount; view++) {
+        views[view] = MakeTestDescriptor(images[view], (view == 2) ? 16 : 8, (view == 1) ? VALAR_TEST_MODE_MOTION_VECTORS : VALAR_TEST_MODE_WEBER_FECHNER);
+        views[view].m_pOpaque = desc.m_pOpaque;
+
+        masks[view].assign((size_t)GetTileCountX(views[view]) * GetTileCountY(views[view]), VALAR_SHADING_RATE_1X1);
+        batchMasks[view] = masks[view];
+    }
+
+    views[1].m_regionsOfInterest = &regionOfInterest;
+    views[1].m_regionOfInterestCount = 1;
+    views[1].m_outsideShadingRate = VALAR_SHADING_RATE_4X4;
+    views[2].m_amortizationPeriod = 4;
+    views[3].m_enabled = false;
+
+    for (uint32_t frame = 0; frame < 4; frame++) {
+        for (uint32_t view = 0; view < viewCount; view++) {
+            views[view].m_frameIndex = frame;
+            views[view].m_valarBuffer = masks[view].data();
+            VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(views[view]) == VALAR_RETURN_CODE_SUCCESS);
+        }
+
+        VALAR_CPU_MASK_STATISTICS statistics;
+        VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+
+        for (uint32_t view = 0; view < viewCount; view++) {
+            views[view].m_valarBuffer = batchMasks[view].data();
+        }
+
+        VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(views, viewCount) == VALAR_RETURN_CODE_SUCCESS);
+
+        VALAR_CPU_MASK_STATISTICS batchStatistics;
+        VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &batchStatistics) == VALAR_RETURN_CODE_SUCCESS);
+
+        for (uint32_t view = 0; view < viewCount; view++) {
+            VALAR_TEST_CHECK(CountDifferences(masks[view], batchMasks[view]) == 0);
+        }
+
+        VALAR_TEST_CHECK(batchStatistics.m_tileCount == statistics.m_tileCount);
+        VALAR_TEST_CHECK(memcmp(batchStatistics.m_shadingRateTileCount, statistics.m_shadingRateTileCount, sizeof(statistics.m_shadingRateTileCount)) == 0);
+    }
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+// Views of another opaque or in temporal mode are rejected, disabled views keep the temporal history.
+static void TestBatchValidation()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 6);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+    VALAR_CPU_DESCRIPTOR otherDesc = desc;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(otherDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+        VALAR_ReleaseCPU(desc);
+        return;
+    }
+
+    std::vector<uint8_t> masks[2];
+    for (std::vector<uint8_t>& mask : masks) {
+        mask.assign((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    }
+
+    VALAR_CPU_DESCRIPTOR views[2] = { desc, desc };
+    views[0].m_valarBuffer = masks[0].data();
+    views[1].m_valarBuffer = masks[1].data();
+
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(views, 0) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(nullptr, 2) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_CPU_DESCRIPTOR invalidViews[2] = { views[0], views[1] };
+    invalidViews[1].m_pOpaque = otherDesc.m_pOpaque;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(invalidViews, 2) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidViews[1] = views[1];
+    invalidViews[1].m_temporalReuse = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(invalidViews, 2) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    // Nothing is written by rejected batches.
+    VALAR_TEST_CHECK(masks[0][0] == 0xEE && masks[1][0] == 0xEE);
+
+    VALAR_CPU_DESCRIPTOR temporalDesc = views[0];
+    temporalDesc.m_temporalReuse = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(temporalDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(desc.m_pOpaque->m_temporalHistory->m_isValid);
+
+    views[0].m_enabled = false;
+    views[1].m_enabled = false;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(views, 2) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(desc.m_pOpaque->m_temporalHistory->m_isValid);
+
+    views[1].m_enabled = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(views, 2) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(!desc.m_pOpaque->m_temporalHistory->m_isValid);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(otherDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestBatchViews();
+    TestBatchValidation();
+
+    return FinishTest("VALARTestBatch");
+}
\ No newline at end of file
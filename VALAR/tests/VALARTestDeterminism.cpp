@@ -0,0 +1,232 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+
+static const VALAR_CPU_INSTRUCTION_SET kInstructionSets[] = {
+    VALAR_CPU_INSTRUCTION_SET_SCALAR,
+    VALAR_CPU_INSTRUCTION_SET_SSE41,
+    VALAR_CPU_INSTRUCTION_SET_AVX2,
+    VALAR_CPU_INSTRUCTION_SET_AVX512,
+    VALAR_CPU_INSTRUCTION_SET_NEON,
+};
+
+// Float image with luminances over six orders of magnitude, the rounding of its tile sums depends on the order
+// they are added in.
+static TEST_IMAGE MakeHighDynamicRangeImage(uint32_t width, uint32_t height, uint32_t seed)
+{
+    TEST_IMAGE image = MakeTestImage(width, height, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, seed);
+    std::mt19937 random(seed);
+
+    for (size_t pixel = 0; pixel < (size_t)width * height; pixel++) {
+        const float scale = powf(10.0f, (float)(random() % 600) / 100.0f - 3.0f);
+
+        for (uint32_t channel = 0; channel < 3; channel++) {
+            float value;
+            memcpy(&value, &image.m_color[pixel * 4 + channel], sizeof(value));
+            value = value * scale + (float)(random() % 1000) * 1e-6f;
+            memcpy(&image.m_color[pixel * 4 + channel], &value, sizeof(value));
+        }
+    }
+
+    return image;
+}
+
+// Computes the mask of desc and returns it with its statistics.
+static std::vector<uint8_t> ComputeMaskWithStatistics(const VALAR_CPU_DESCRIPTOR& desc, VALAR_CPU_MASK_STATISTICS& statistics)
+{
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    VALAR_CPU_DESCRIPTOR maskDesc = desc;
+    maskDesc.m_valarBuffer = mask.data();
+
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(maskDesc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+
+    return mask;
+}
+
+// The kernel statistics of every instruction set are the statistics of the per tile reference, bit for bit, and
+// the reference sums in the pairwise order of SumTilePairwise.
+static void TestTileSums()
+{
+    const TEST_IMAGE image = MakeHighDynamicRangeImage(333, 197, 51);
+    size_t orderDependentTileCount = 0;
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            for (VALAR_CPU_INSTRUCTION_SET instructionSet : kInstructionSets) {
+                VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+                desc.m_instructionSet = instructionSet;
+                desc.m_workerThreadCount = 0;
+
+                // Instruction sets of other CPUs are skipped.
+                if (VALAR_InitializeCPU(desc) != VALAR_RETURN_CODE_SUCCESS) {
+                    continue;
+                }
+
+                const std::vector<VALAR_TILE_STATISTICS> stats = ComputeKernelStatistics(desc);
+                size_t differenceCount = 0;
+
+                for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                    for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                        VALAR_TILE_STATISTICS reference;
+                        ComputeTileStatistics(desc, tileX, tileY, reference);
+                        differenceCount += (memcmp(&stats[(size_t)tileY * GetTileCountX(desc) + tileX], &reference, sizeof(reference)) != 0) ? 1 : 0;
+
+                        if (instructionSet != VALAR_CPU_INSTRUCTION_SET_SCALAR || mode != 0) {
+                            continue;
+                        }
+
+                        float luma[VALAR_CPU_MAX_TILE_SIZE][VALAR_CPU_MAX_TILE_SIZE];
+                        float rowMajorSum = 0.0f;
+                        for (uint32_t y = 0; y < tileSize; y++) {
+                            for (uint32_t x = 0; x < tileSize; x++) {
+                                luma[x][y] = FetchLuminance(desc, (int32_t)(tileX * tileSize + x), (int32_t)(tileY * tileSize + y));
+                                rowMajorSum += luma[x][y];
+                            }
+                        }
+
+                        const float pairwiseSum = SumTilePairwise(luma, 0, 0, tileSize);
+                        VALAR_TEST_CHECK(memcmp(&reference.m_lumaSum, &pairwiseSum, sizeof(pairwiseSum)) == 0);
+                        orderDependentTileCount += (rowMajorSum != pairwiseSum) ? 1 : 0;
+                    }
+                }
+
+                if (!VALAR_TEST_CHECK(differenceCount == 0)) {
+                    printf("    tile size %u mode %u instruction set %u: %zu tiles differ\n", tileSize, mode, (uint32_t)instructionSet, differenceCount);
+                }
+
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+        }
+    }
+
+    // Otherwise the image would not tell the orders apart.
+    VALAR_TEST_CHECK(orderDependentTileCount > 0);
+}
+
+// Masks and statistics do not depend on the worker threads, nor on how the mask is split into tile rects, dirty
+// rects or batched views.
+static void TestSplits()
+{
+    const TEST_IMAGE image = MakeHighDynamicRangeImage(333, 197, 52);
+    const uint32_t workerThreadCounts[] = { 1, 2, 3, 5, VALAR_CPU_WORKER_THREAD_COUNT_AUTO };
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+            desc.m_workerThreadCount = 0;
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            VALAR_CPU_MASK_STATISTICS statistics;
+            const std::vector<uint8_t> mask = ComputeMaskWithStatistics(desc, statistics);
+
+            for (uint32_t workerThreadCount : workerThreadCounts) {
+                VALAR_CPU_DESCRIPTOR workerDesc = MakeTestDescriptor(image, tileSize, mode);
+                workerDesc.m_workerThreadCount = workerThreadCount;
+
+                if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(workerDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+                    continue;
+                }
+
+                VALAR_CPU_MASK_STATISTICS workerStatistics;
+                VALAR_TEST_CHECK(CountDifferences(ComputeMaskWithStatistics(workerDesc, workerStatistics), mask) == 0);
+                VALAR_TEST_CHECK(memcmp(&workerStatistics, &statistics, sizeof(statistics)) == 0);
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(workerDesc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+
+            std::vector<uint8_t> splitMask(mask.size(), 0xEE);
+            desc.m_valarBuffer = splitMask.data();
+            std::mt19937 random(tileSize + mode);
+
+            // Tile rects of random widths and heights.
+            for (uint32_t top = 0; top < GetTileCountY(desc);) {
+                const uint32_t bottom = std::min(top + 1 + (uint32_t)(random() % 3), GetTileCountY(desc));
+
+                for (uint32_t left = 0; left < GetTileCountX(desc);) {
+                    const uint32_t right = std::min(left + 1 + (uint32_t)(random() % 7), GetTileCountX(desc));
+                    const VALAR_CPU_TILE_RECT tileRect = { left, top, right, bottom };
+                    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(desc, tileRect) == VALAR_RETURN_CODE_SUCCESS);
+                    left = right;
+                }
+
+                top = bottom;
+            }
+
+            VALAR_CPU_MASK_STATISTICS splitStatistics;
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &splitStatistics) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(CountDifferences(splitMask, mask) == 0);
+            VALAR_TEST_CHECK(memcmp(&splitStatistics, &statistics, sizeof(statistics)) == 0);
+
+            // Overlapping pixel rects of random sizes.
+            std::vector<VALAR_CPU_RECT> dirtyRects;
+            for (uint32_t top = 0; top < image.m_height; top += 23) {
+                for (uint32_t left = 0; left < image.m_width; left += 41) {
+                    const VALAR_CPU_RECT dirtyRect = { left, top, left + 41 + (uint32_t)(random() % 9), top + 23 + (uint32_t)(random() % 5) };
+                    dirtyRects.push_back(dirtyRect);
+                }
+            }
+
+            std::fill(splitMask.begin(), splitMask.end(), (uint8_t)0xEE);
+            VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, dirtyRects.data(), (uint32_t)dirtyRects.size()) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &splitStatistics) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(CountDifferences(splitMask, mask) == 0);
+            VALAR_TEST_CHECK(memcmp(&splitStatistics, &statistics, sizeof(statistics)) == 0);
+
+            std::vector<uint8_t> viewMask(mask.size(), 0xEE);
+            VALAR_CPU_DESCRIPTOR views[2] = { desc, desc };
+            views[1].m_valarBuffer = viewMask.data();
+
+            std::fill(splitMask.begin(), splitMask.end(), (uint8_t)0xEE);
+            VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(views, 2) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(CountDifferences(splitMask, mask) == 0);
+            VALAR_TEST_CHECK(CountDifferences(viewMask, mask) == 0);
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+int main()
+{
+    TestTileSums();
+    TestSplits();
+
+    return FinishTest("VALARTestDeterminism");
+}
\ No newline at end of file
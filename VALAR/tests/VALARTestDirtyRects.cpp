@@ -0,0 +1,219 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Copy of image with random colors inside of the rects. Pixels on the sample grid of the temporal mode, every 4th
+// pixel starting at 2, keep their color when keepSampleGrid is set.
+static TEST_IMAGE ChangeRects(const TEST_IMAGE& image, const std::vector<VALAR_CPU_RECT>& rects, bool keepSampleGrid, uint32_t seed)
+{
+    const uint32_t wordCount = GetColorWordCount(image.m_colorFormat);
+    std::mt19937 random(seed);
+    TEST_IMAGE changedImage = image;
+
+    for (const VALAR_CPU_RECT& rect : rects) {
+        for (uint32_t y = rect.m_top; y < rect.m_bottom && y < image.m_height; y++) {
+            for (uint32_t x = rect.m_left; x < rect.m_right && x < image.m_width; x++) {
+                if (keepSampleGrid && x % 4 == 2 && y % 4 == 2) {
+                    continue;
+                }
+
+                const float level = (float)(random() % 256) / 255.0f;
+                const float channels[4] = { level, level * 0.9f, level * 0.8f, 1.0f };
+
+                EncodeColor(image.m_colorFormat, channels, &changedImage.m_color[((size_t)y * image.m_width + x) * wordCount]);
+            }
+        }
+    }
+
+    return changedImage;
+}
+
+static std::vector<VALAR_CPU_RECT> MakeDirtyRects(const TEST_IMAGE& image)
+{
+    VALAR_CPU_RECT rects[4];
+    rects[0].m_left = 13;
+    rects[0].m_top = 9;
+    rects[0].m_right = 75;
+    rects[0].m_bottom = 40;
+    // Overlaps the first rect.
+    rects[1].m_left = 60;
+    rects[1].m_top = 30;
+    rects[1].m_right = 130;
+    rects[1].m_bottom = 71;
+    // Reaches past the color buffer.
+    rects[2].m_left = image.m_width - 20;
+    rects[2].m_top = image.m_height / 2;
+    rects[2].m_right = image.m_width + 40;
+    rects[2].m_bottom = image.m_height / 2 + 17;
+    // Empty.
+    rects[3].m_left = 5;
+    rects[3].m_top = 5;
+    rects[3].m_right = 5;
+    rects[3].m_bottom = 9;
+
+    return std::vector<VALAR_CPU_RECT>(rects, rects + 4);
+}
+
+// Recomputing the dirty rects of a mask gives the mask of the changed image, with regions of interest and with
+// amortized masks whose frame index does not have the dirty tiles due.
+static void TestDirtyRects()
+{
+    const VALAR_CPU_FORMAT colorFormats[] = { VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, VALAR_CPU_FORMAT_R8G8B8A8_UNORM };
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+
+    for (VALAR_CPU_FORMAT colorFormat : colorFormats) {
+        const TEST_IMAGE image = MakeTestImage(331, 203, colorFormat, TEST_PATTERN_MIXED, 1);
+        const std::vector<VALAR_CPU_RECT> rects = MakeDirtyRects(image);
+        const TEST_IMAGE changedImage = ChangeRects(image, rects, false, 2);
+
+        for (uint32_t tileSize : tileSizes) {
+            for (uint32_t variant = 0; variant < 3; variant++) {
+                VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+                VALAR_CPU_DESCRIPTOR changedDesc = MakeTestDescriptor(changedImage, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+                const uint32_t tilesX = GetTileCountX(desc);
+                const uint32_t tilesY = GetTileCountY(desc);
+
+                // Cuts through the first two rects.
+                VALAR_CPU_TILE_RECT regionOfInterest;
+                regionOfInterest.m_left = 40 / tileSize;
+                regionOfInterest.m_top = 0;
+                regionOfInterest.m_right = tilesX;
+                regionOfInterest.m_bottom = 50 / tileSize + 1;
+
+                if (variant == 1) {
+                    desc.m_regionsOfInterest = changedDesc.m_regionsOfInterest = &regionOfInterest;
+                    desc.m_regionOfInterestCount = changedDesc.m_regionOfInterestCount = 1;
+                    desc.m_outsideShadingRate = changedDesc.m_outsideShadingRate = VALAR_SHADING_RATE_2X2;
+                }
+
+                desc.m_workerThreadCount = 2;
+
+                if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                    continue;
+                }
+
+                std::vector<uint8_t> changedMask((size_t)tilesX * tilesY, 0xEE);
+                std::vector<uint8_t> mask((size_t)tilesX * tilesY, 0xEE);
+
+                changedDesc.m_pOpaque = desc.m_pOpaque;
+                changedDesc.m_valarBuffer = changedMask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(changedDesc) == VALAR_RETURN_CODE_SUCCESS);
+
+                VALAR_CPU_MASK_STATISTICS changedStatistics;
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &changedStatistics) == VALAR_RETURN_CODE_SUCCESS);
+
+                desc.m_valarBuffer = mask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+
+                // Frame 1 of 16 has only a few of the dirty tiles due.
+                if (variant == 2) {
+                    changedDesc.m_amortizationPeriod = 16;
+                    changedDesc.m_frameIndex = 1;
+                }
+
+                changedDesc.m_valarBuffer = mask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(changedDesc, rects.data(), (uint32_t)rects.size()) == VALAR_RETURN_CODE_SUCCESS);
+
+                VALAR_CPU_MASK_STATISTICS statistics;
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+
+                VALAR_TEST_CHECK(CountDifferences(mask, changedMask) == 0);
+                VALAR_TEST_CHECK(memcmp(statistics.m_shadingRateTileCount, changedStatistics.m_shadingRateTileCount, sizeof(statistics.m_shadingRateTileCount)) == 0);
+
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+        }
+    }
+}
+
+// The change inside of the rects keeps the samples of the temporal mode, only the invalidated history keeps the
+// next temporal mask from reusing the statistics of the black image.
+static void TestDirtyRectsTemporal()
+{
+    const TEST_IMAGE image = MakeTestImage(256, 128, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_BLACK, 3);
+    const std::vector<VALAR_CPU_RECT> rects = MakeDirtyRects(image);
+    const TEST_IMAGE changedImage = ChangeRects(image, rects, true, 4);
+
+    const VALAR_CPU_DESCRIPTOR changedDesc = MakeTestDescriptor(changedImage, 8, 0);
+    const std::vector<uint8_t> changedMask = ComputeTestMask(changedDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+    desc.m_temporalReuse = true;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask(changedMask.size(), 0xEE);
+    desc.m_valarBuffer = mask.data();
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+    desc.m_colorBuffer = changedImage.m_color.data();
+    VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, rects.data(), (uint32_t)rects.size()) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(CountDifferences(mask, changedMask) == 0);
+
+    // The content did not change since the dirty rects.
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(CountDifferences(mask, changedMask) == 0);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+static void TestInvalidDirtyRects()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    desc.m_valarBuffer = mask.data();
+
+    VALAR_CPU_RECT invertedRect;
+    invertedRect.m_left = 5;
+    invertedRect.m_right = 4;
+    VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, &invertedRect, 1) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, nullptr, 1) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, nullptr, 0) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestDirtyRects();
+    TestDirtyRectsTemporal();
+    TestInvalidDirtyRects();
+
+    return FinishTest("VALARTestDirtyRects");
+}
\ No newline at end of file
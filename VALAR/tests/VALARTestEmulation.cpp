@@ -0,0 +1,183 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Wave sizes up to 128 lanes, wider than the 64 threads of an 8x8 group.
+static const uint32_t kWaveLaneCounts[] = { 4, 16, 32, 64, 128 };
+
+// The emulated mask shaders match VALAR_ComputeMaskCPU exactly outside of the Weber-Fechner modes, where the shader
+// reads neighbors past its groupshared tile, for every wave size and both permutations.
+static void TestEmulatedMasks()
+{
+    const TEST_IMAGE image = MakeTestImage(133, 71, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 3);
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+
+    for (uint32_t tileSize : tileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            if (mode & VALAR_TEST_MODE_WEBER_FECHNER) {
+                continue;
+            }
+
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+            desc.m_workerThreadCount = 0;
+
+            const std::vector<uint8_t> mask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            for (uint32_t waveLaneCount : kWaveLaneCounts) {
+                for (uint32_t genericShader = 0; genericShader < 2; genericShader++) {
+                    std::vector<uint8_t> emulatedMask(mask.size(), 0xEE);
+                    desc.m_valarBuffer = emulatedMask.data();
+
+                    VALAR_CPU_SHADER_EMULATION_STATISTICS statistics;
+                    VALAR_CPU_SHADER_EMULATION emulation;
+                    emulation.m_waveLaneCount = waveLaneCount;
+                    emulation.m_genericShader = genericShader != 0;
+                    emulation.m_pStatistics = &statistics;
+
+                    VALAR_TEST_CHECK(VALAR_ComputeMaskEmulatedCPU(desc, emulation) == VALAR_RETURN_CODE_SUCCESS);
+                    VALAR_TEST_CHECK(statistics.m_groupCount == mask.size());
+
+                    if (!VALAR_TEST_CHECK(CountDifferences(mask, emulatedMask) == 0)) {
+                        printf("    tile size %u mode %u wave lanes %u generic %u\n", tileSize, mode, waveLaneCount, genericShader);
+                    }
+                }
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// The emulated LP shader matches VALAR_ComputeMaskLPCPU with its default 4 samples exactly. ValarLPCS.hlsl reads
+// its upscaled motion vectors at row tileIndex.y * tileIndex.y, so upscaled motion vectors are left out.
+static void TestEmulatedLPMasks()
+{
+    const TEST_IMAGE image = MakeTestImage(133, 71, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 5);
+    const uint32_t modes[] = { 0, VALAR_TEST_MODE_MOTION_VECTORS };
+
+    for (uint32_t mode : modes) {
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 16, mode);
+        desc.m_workerThreadCount = 0;
+
+        if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+            continue;
+        }
+
+        std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+        desc.m_valarBuffer = mask.data();
+        VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+        for (uint32_t waveLaneCount : kWaveLaneCounts) {
+            std::vector<uint8_t> emulatedMask(mask.size(), 0xEE);
+            desc.m_valarBuffer = emulatedMask.data();
+
+            VALAR_CPU_SHADER_EMULATION emulation;
+            emulation.m_waveLaneCount = waveLaneCount;
+
+            VALAR_TEST_CHECK(VALAR_ComputeMaskLPEmulatedCPU(desc, emulation) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(CountDifferences(mask, emulatedMask) == 0);
+        }
+
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+    }
+}
+
+static void TestEmulatedOverlay()
+{
+    const TEST_IMAGE image = MakeTestImage(35, 19, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 7);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+    desc.m_workerThreadCount = 0;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    desc.m_valarBuffer = mask.data();
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+    std::vector<float> overlay((size_t)desc.m_upscaleWidth * desc.m_upscaleHeight * 4, -1.0f);
+
+    VALAR_CPU_SHADER_EMULATION_STATISTICS statistics;
+    VALAR_CPU_SHADER_EMULATION emulation;
+    emulation.m_debugGrid = true;
+    emulation.m_pStatistics = &statistics;
+    VALAR_TEST_CHECK(VALAR_DebugOverlayEmulatedCPU(desc, emulation) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    emulation.m_overlayBuffer = overlay.data();
+    VALAR_TEST_CHECK(VALAR_DebugOverlayEmulatedCPU(desc, emulation) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(statistics.m_groupCount == (uint64_t)desc.m_upscaleWidth * desc.m_upscaleHeight);
+
+    // The grid covers the tile edges, so some pixels of the overlay have been written.
+    size_t writtenCount = 0;
+    for (float value : overlay) {
+        writtenCount += (value != -1.0f) ? 1 : 0;
+    }
+    VALAR_TEST_CHECK(writtenCount > 0);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+static void TestInvalidEmulation()
+{
+    const TEST_IMAGE image = MakeTestImage(35, 19, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    desc.m_valarBuffer = mask.data();
+
+    const uint32_t waveLaneCounts[] = { 0, 2, 12, 256 };
+    for (uint32_t waveLaneCount : waveLaneCounts) {
+        VALAR_CPU_SHADER_EMULATION emulation;
+        emulation.m_waveLaneCount = waveLaneCount;
+
+        VALAR_TEST_CHECK(VALAR_ComputeMaskEmulatedCPU(desc, emulation) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+        VALAR_TEST_CHECK(VALAR_ComputeMaskLPEmulatedCPU(desc, emulation) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    }
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestEmulatedMasks();
+    TestEmulatedLPMasks();
+    TestEmulatedOverlay();
+    TestInvalidEmulation();
+
+    return FinishTest("VALARTestEmulation");
+}
\ No newline at end of file
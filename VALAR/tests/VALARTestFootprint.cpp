@@ -0,0 +1,168 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Row pitches aligned to 256 bytes and an unpadded last row, like GetCopyableFootprints of an R8_UINT texture.
+static void TestFootprints()
+{
+    struct FOOTPRINT_CASE
+    {
+        uint32_t                m_width;
+        uint32_t                m_height;
+        uint32_t                m_tileSize;
+        uint32_t                m_rowPitch;
+        uint32_t                m_sizeInBytes;
+    };
+
+    const FOOTPRINT_CASE footprintCases[] = {
+        { 1920, 1080, 8, 256, 256 * 134 + 240 },
+        { 1920, 1080, 16, 256, 256 * 67 + 120 },
+        { 3840, 2160, 8, 512, 512 * 269 + 480 },
+        { 2048, 8, 8, 256, 256 },
+        { 2056, 9, 8, 512, 512 + 257 },
+        { 1, 1, 32, 256, 1 },
+    };
+
+    for (const FOOTPRINT_CASE& footprintCase : footprintCases) {
+        VALAR_CPU_DESCRIPTOR desc;
+        desc.m_bufferWidth = footprintCase.m_width;
+        desc.m_bufferHeight = footprintCase.m_height;
+        desc.m_shadingRateTileSize = footprintCase.m_tileSize;
+
+        uint32_t rowPitch = 0;
+        uint32_t sizeInBytes = 0;
+        VALAR_TEST_CHECK(VALAR_GetMaskFootprintCPU(desc, rowPitch, sizeInBytes) == VALAR_RETURN_CODE_SUCCESS);
+
+        if (!VALAR_TEST_CHECK(rowPitch == footprintCase.m_rowPitch && sizeInBytes == footprintCase.m_sizeInBytes)) {
+            printf("    %ux%u tile size %u: row pitch %u size %u\n", footprintCase.m_width, footprintCase.m_height, footprintCase.m_tileSize, rowPitch, sizeInBytes);
+        }
+    }
+
+    VALAR_CPU_DESCRIPTOR invalidDesc;
+    uint32_t rowPitch = 0;
+    uint32_t sizeInBytes = 0;
+    VALAR_TEST_CHECK(VALAR_GetMaskFootprintCPU(invalidDesc, rowPitch, sizeInBytes) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc.m_bufferWidth = 64;
+    invalidDesc.m_bufferHeight = 64;
+    invalidDesc.m_shadingRateTileSize = 4;
+    VALAR_TEST_CHECK(VALAR_GetMaskFootprintCPU(invalidDesc, rowPitch, sizeInBytes) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+}
+
+// Compares a mask written with a row pitch with the tightly packed mask, the padding of every row stays untouched.
+static bool IsPitchedMaskEqual(const std::vector<uint8_t>& pitchedMask, uint32_t rowPitch, const std::vector<uint8_t>& mask, uint32_t tilesX)
+{
+    for (size_t i = 0; i < pitchedMask.size(); i++) {
+        const size_t tileY = i / rowPitch;
+        const size_t tileX = i % rowPitch;
+        const uint8_t expected = (tileX < tilesX) ? mask[tileY * tilesX + tileX] : 0xEE;
+
+        if (pitchedMask[i] != expected) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Masks written into a buffer of exactly the footprint size match the packed masks, for the full, LP, tile rect and
+// dirty rect paths.
+static void TestPitchedMasks()
+{
+    const uint32_t sizes[][2] = { { 333, 197 }, { 2100, 40 }, { 7, 5 } };
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+
+    for (const uint32_t* size : sizes) {
+        const TEST_IMAGE image = MakeTestImage(size[0], size[1], VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, size[0]);
+
+        for (uint32_t tileSize : tileSizes) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            const uint32_t tilesX = GetTileCountX(desc);
+            const uint32_t tilesY = GetTileCountY(desc);
+
+            uint32_t rowPitch = 0;
+            uint32_t sizeInBytes = 0;
+            VALAR_TEST_CHECK(VALAR_GetMaskFootprintCPU(desc, rowPitch, sizeInBytes) == VALAR_RETURN_CODE_SUCCESS);
+
+            VALAR_CPU_DESCRIPTOR packedDesc = desc;
+            VALAR_CPU_DESCRIPTOR pitchedDesc = desc;
+            pitchedDesc.m_valarRowPitch = rowPitch;
+
+            std::vector<uint8_t> mask((size_t)tilesX * tilesY, 0xEE);
+            std::vector<uint8_t> pitchedMask(sizeInBytes, 0xEE);
+            packedDesc.m_valarBuffer = mask.data();
+            pitchedDesc.m_valarBuffer = pitchedMask.data();
+
+            VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(packedDesc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(pitchedDesc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(IsPitchedMaskEqual(pitchedMask, rowPitch, mask, tilesX));
+
+            VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(packedDesc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(pitchedDesc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(IsPitchedMaskEqual(pitchedMask, rowPitch, mask, tilesX));
+
+            VALAR_CPU_TILE_RECT tileRect;
+            tileRect.m_right = tilesX;
+            tileRect.m_bottom = tilesY;
+            VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(packedDesc, tileRect) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(pitchedDesc, tileRect) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(IsPitchedMaskEqual(pitchedMask, rowPitch, mask, tilesX));
+
+            VALAR_CPU_RECT dirtyRect;
+            dirtyRect.m_left = image.m_width / 3;
+            dirtyRect.m_top = image.m_height / 4;
+            dirtyRect.m_right = image.m_width;
+            dirtyRect.m_bottom = image.m_height / 2 + 1;
+            VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(packedDesc, &dirtyRect, 1) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(pitchedDesc, &dirtyRect, 1) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(IsPitchedMaskEqual(pitchedMask, rowPitch, mask, tilesX));
+
+            // A row pitch below the width of the mask is rejected.
+            VALAR_CPU_DESCRIPTOR invalidDesc = pitchedDesc;
+            invalidDesc.m_valarRowPitch = tilesX - 1;
+            if (tilesX > 1) {
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+int main()
+{
+    TestFootprints();
+    TestPitchedMasks();
+
+    return FinishTest("VALARTestFootprint");
+}
\ No newline at end of file
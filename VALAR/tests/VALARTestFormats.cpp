@@ -0,0 +1,166 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const VALAR_CPU_FORMAT kColorFormats[] = {
+    VALAR_CPU_FORMAT_R32G32B32A32_FLOAT,
+    VALAR_CPU_FORMAT_R8G8B8A8_UNORM,
+    VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB,
+    VALAR_CPU_FORMAT_B8G8R8A8_UNORM,
+    VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB,
+    VALAR_CPU_FORMAT_R10G10B10A2_UNORM,
+    VALAR_CPU_FORMAT_R11G11B10_FLOAT,
+    VALAR_CPU_FORMAT_R16G16B16A16_FLOAT,
+};
+
+static float RGBLuminance(float r, float g, float b)
+{
+    return r * 0.212671f + g * 0.715160f + b * 0.072169f;
+}
+
+static float DecodeSRGB(uint32_t value)
+{
+    const double encoded = (double)value / 255.0;
+
+    return (float)((encoded <= 0.04045) ? encoded / 12.92 : pow((encoded + 0.055) / 1.055, 2.4));
+}
+
+// Luminance of single pixels of every format, with the channel order, the transfer function and the small floats
+// decoded like a typed load. Pixels outside of the view read as black.
+static void TestPixelDecode()
+{
+    struct PIXEL_CASE
+    {
+        VALAR_CPU_FORMAT        m_format;
+        uint32_t                m_pixel[4];
+        float                   m_luminance;
+    };
+
+    const float half = 128.0f / 255.0f;
+    const float one = 1.0f;
+    const float pointFive = 0.5f;
+    uint32_t floatPixel[4];
+    const float floatChannels[4] = { one, pointFive, 0.0f, one };
+    memcpy(floatPixel, floatChannels, sizeof(floatPixel));
+
+    const PIXEL_CASE pixelCases[] = {
+        { VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, { floatPixel[0], floatPixel[1], floatPixel[2], floatPixel[3] }, RGBLuminance(1.0f, 0.25f, 0.0f) },
+        { VALAR_CPU_FORMAT_R8G8B8A8_UNORM, { 0x00FF8000 }, RGBLuminance(0.0f, half * half, 1.0f) },
+        { VALAR_CPU_FORMAT_B8G8R8A8_UNORM, { 0x00FF8000 }, RGBLuminance(1.0f, half * half, 0.0f) },
+        { VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB, { 0xFF000080 }, RGBLuminance(DecodeSRGB(128), 0.0f, 0.0f) },
+        { VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB, { 0xFF000080 }, RGBLuminance(0.0f, 0.0f, DecodeSRGB(128)) },
+        { VALAR_CPU_FORMAT_R10G10B10A2_UNORM, { 1023 | (512 << 10) | (3u << 30) }, RGBLuminance(1.0f, (512.0f / 1023.0f) * (512.0f / 1023.0f), 0.0f) },
+        // 1.0, 0.5 and 1.0 in the 6 and 5-bit mantissa floats.
+        { VALAR_CPU_FORMAT_R11G11B10_FLOAT, { 0x3C0 | (0x380 << 11) | (0x1E0u << 22) }, RGBLuminance(1.0f, 0.25f, 1.0f) },
+        // 1.0, 0.5, 2.0 and 1.0 as halfs.
+        { VALAR_CPU_FORMAT_R16G16B16A16_FLOAT, { 0x3C00 | (0x3800 << 16), 0x4000 | (0x3C00 << 16) }, RGBLuminance(1.0f, 0.25f, 4.0f) },
+    };
+
+    for (const PIXEL_CASE& pixelCase : pixelCases) {
+        VALAR_CPU_IMAGE_VIEW view;
+        view.m_data = pixelCase.m_pixel;
+        view.m_width = 1;
+        view.m_height = 1;
+        view.m_rowPitch = GetColorPixelSize(pixelCase.m_format);
+        view.m_format = pixelCase.m_format;
+
+        const float luminance = FetchLuminance(view, 0, 0);
+        if (!VALAR_TEST_CHECK(fabsf(luminance - pixelCase.m_luminance) <= 1e-6f * pixelCase.m_luminance)) {
+            printf("    format %u luminance %g expected %g\n", pixelCase.m_format, luminance, pixelCase.m_luminance);
+        }
+
+        VALAR_TEST_CHECK(FetchLuminance(view, -1, 0) == 0.0f);
+        VALAR_TEST_CHECK(FetchLuminance(view, 0, 1) == 0.0f);
+    }
+}
+
+// Black, white and pure black and white patterns are close to exact in every format, so every format with the square
+// law computes the mask of the float format. The sRGB formats linearize the gray levels of white with another curve.
+static void TestFormatsAgree()
+{
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+
+    for (uint32_t pattern = TEST_PATTERN_BLACK; pattern < TEST_PATTERN_COUNT; pattern++) {
+        const TEST_IMAGE floatImage = MakeTestImage(75, 41, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, (TEST_PATTERN)pattern, 0);
+
+        for (uint32_t tileSize : tileSizes) {
+            for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+                const std::vector<uint8_t> floatMask = ComputeTestMask(MakeTestDescriptor(floatImage, tileSize, mode), VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+                for (VALAR_CPU_FORMAT colorFormat : kColorFormats) {
+                    if (colorFormat == VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB || colorFormat == VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB) {
+                        continue;
+                    }
+
+                    const TEST_IMAGE image = MakeTestImage(75, 41, colorFormat, (TEST_PATTERN)pattern, 0);
+                    const std::vector<uint8_t> mask = ComputeTestMask(MakeTestDescriptor(image, tileSize, mode), VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+                    if (!VALAR_TEST_CHECK(CountDifferences(mask, floatMask) == 0)) {
+                        printf("    pattern %u tile size %u mode %u format %u\n", pattern, tileSize, mode, colorFormat);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Formats outside of VALAR_CPU_FORMAT and the velocity formats are rejected as color formats.
+static void TestInvalidFormats()
+{
+    const TEST_IMAGE image = MakeTestImage(35, 19, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    desc.m_valarBuffer = mask.data();
+
+    const VALAR_CPU_FORMAT invalidFormats[] = { VALAR_CPU_FORMAT_R32_UINT, VALAR_CPU_FORMAT_R32G32_FLOAT, (VALAR_CPU_FORMAT)100 };
+    for (VALAR_CPU_FORMAT colorFormat : invalidFormats) {
+        VALAR_CPU_DESCRIPTOR invalidDesc = desc;
+        invalidDesc.m_colorFormat = colorFormat;
+        VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    }
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestPixelDecode();
+    TestFormatsAgree();
+    TestInvalidFormats();
+
+    return FinishTest("VALARTestFormats");
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+
+static const VALAR_CPU_INSTRUCTION_SET kInstructionSets[] = {
+    VALAR_CPU_INSTRUCTION_SET_SSE41,
+    VALAR_CPU_INSTRUCTION_SET_AVX2,
+    VALAR_CPU_INSTRUCTION_SET_AVX512,
+    VALAR_CPU_INSTRUCTION_SET_NEON,
+};
+
+static const VALAR_CPU_FORMAT kColorFormats[] = {
+    VALAR_CPU_FORMAT_R32G32B32A32_FLOAT,
+    VALAR_CPU_FORMAT_R8G8B8A8_UNORM,
+    VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB,
+    VALAR_CPU_FORMAT_B8G8R8A8_UNORM,
+    VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB,
+    VALAR_CPU_FORMAT_R10G10B10A2_UNORM,
+    VALAR_CPU_FORMAT_R11G11B10_FLOAT,
+    VALAR_CPU_FORMAT_R16G16B16A16_FLOAT,
+};
+
+static bool IsInstructionSetSupported(const VALAR_CPU_FEATURES& features, VALAR_CPU_INSTRUCTION_SET instructionSet)
+{
+    switch (instructionSet)
+    {
+    case VALAR_CPU_INSTRUCTION_SET_SSE41:
+        return features.m_sse41Supported;
+    case VALAR_CPU_INSTRUCTION_SET_AVX2:
+        return features.m_avx2Supported;
+    case VALAR_CPU_INSTRUCTION_SET_AVX512:
+        return features.m_avx512Supported;
+    case VALAR_CPU_INSTRUCTION_SET_NEON:
+        return features.m_neonSupported;
+    default:
+        return true;
+    }
+}
+
+static std::vector<VALAR_TILE_STATISTICS> ComputeInstructionSetStatistics(const VALAR_CPU_DESCRIPTOR& desc, VALAR_CPU_INSTRUCTION_SET instructionSet)
+{
+    VALAR_CPU_DESCRIPTOR statsDesc = desc;
+    statsDesc.m_instructionSet = instructionSet;
+    statsDesc.m_workerThreadCount = 0;
+
+    if (VALAR_InitializeCPU(statsDesc) != VALAR_RETURN_CODE_SUCCESS) {
+        return std::vector<VALAR_TILE_STATISTICS>();
+    }
+
+    const std::vector<VALAR_TILE_STATISTICS> stats = ComputeKernelStatistics(statsDesc);
+    VALAR_ReleaseCPU(statsDesc);
+
+    return stats;
+}
+
+// Every vector kernel accumulates in the order of the scalar kernel, so the tile statistics and the masks are bit
+// identical, for the float kernels as well as for the fixed-point kernels of the 8-bit formats.
+static void CompareWithScalar(const TEST_IMAGE& image, const VALAR_CPU_FEATURES& features)
+{
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            const VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+            const std::vector<uint8_t> scalarMask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_SCALAR, 0);
+            const std::vector<VALAR_TILE_STATISTICS> scalarStats = ComputeInstructionSetStatistics(desc, VALAR_CPU_INSTRUCTION_SET_SCALAR);
+
+            for (VALAR_CPU_INSTRUCTION_SET instructionSet : kInstructionSets) {
+                if (!IsInstructionSetSupported(features, instructionSet)) {
+                    continue;
+                }
+
+                const std::vector<uint8_t> mask = ComputeTestMask(desc, instructionSet, 0);
+                const std::vector<VALAR_TILE_STATISTICS> stats = ComputeInstructionSetStatistics(desc, instructionSet);
+
+                if (!VALAR_TEST_CHECK(CountDifferences(mask, scalarMask) == 0) ||
+                    !VALAR_TEST_CHECK(stats.size() == scalarStats.size() &&
+                        memcmp(stats.data(), scalarStats.data(), stats.size() * sizeof(VALAR_TILE_STATISTICS)) == 0)) {
+                    printf("    %ux%u format %u tile size %u mode %u instruction set %u\n",
+                        image.m_width, image.m_height, image.m_colorFormat, tileSize, mode, instructionSet);
+                }
+            }
+        }
+    }
+}
+
+static void TestRandomImages(const VALAR_CPU_FEATURES& features)
+{
+    // Partial tiles, rows of several spans, a single tile and a single pixel.
+    const uint32_t sizes[][2] = { { 333, 197 }, { 1030, 37 }, { 32, 32 }, { 7, 5 }, { 1, 1 } };
+
+    for (VALAR_CPU_FORMAT colorFormat : kColorFormats) {
+        for (const uint32_t* size : sizes) {
+            CompareWithScalar(MakeTestImage(size[0], size[1], colorFormat, TEST_PATTERN_MIXED, size[0] + colorFormat), features);
+        }
+    }
+}
+
+static void TestEdgeImages(const VALAR_CPU_FEATURES& features)
+{
+    for (VALAR_CPU_FORMAT colorFormat : kColorFormats) {
+        for (uint32_t pattern = TEST_PATTERN_BLACK; pattern < TEST_PATTERN_COUNT; pattern++) {
+            CompareWithScalar(MakeTestImage(67, 35, colorFormat, (TEST_PATTERN)pattern, 0), features);
+        }
+    }
+}
+
+static void TestUnsupportedInstructionSets(const VALAR_CPU_FEATURES& features)
+{
+    const TEST_IMAGE image = MakeTestImage(16, 16, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+
+    for (VALAR_CPU_INSTRUCTION_SET instructionSet : kInstructionSets) {
+        if (IsInstructionSetSupported(features, instructionSet)) {
+            continue;
+        }
+
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+        desc.m_instructionSet = instructionSet;
+        VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_NOT_SUPPORTED);
+    }
+}
+
+int main()
+{
+    VALAR_CPU_DESCRIPTOR desc;
+    if (!VALAR_TEST_CHECK(VALAR_CheckSupportCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return FinishTest("VALARTestInstructionSets");
+    }
+
+    printf("SSE4.1 %d, AVX2 %d, AVX-512 %d, NEON %d\n", desc.m_cpuFeatures.m_sse41Supported, desc.m_cpuFeatures.m_avx2Supported,
+        desc.m_cpuFeatures.m_avx512Supported, desc.m_cpuFeatures.m_neonSupported);
+
+    TestRandomImages(desc.m_cpuFeatures);
+    TestEdgeImages(desc.m_cpuFeatures);
+    TestUnsupportedInstructionSets(desc.m_cpuFeatures);
+
+    return FinishTest("VALARTestInstructionSets");
+}
\ No newline at end of file
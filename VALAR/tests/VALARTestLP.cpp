@@ -0,0 +1,194 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+
+// Rate of ValarLPCS.hlsl, the 2x2 quad at the centroid of the tile with half the sensitivity threshold.
+static uint8_t ComputeCentroidShadingRate(const VALAR_CPU_DESCRIPTOR& desc, uint32_t tileX, uint32_t tileY)
+{
+    const VALAR_CPU_IMAGE_VIEW colorView = GetColorView(desc);
+    const int32_t x = (int32_t)(tileX * desc.m_shadingRateTileSize + desc.m_shadingRateTileSize / 2);
+    const int32_t y = (int32_t)(tileY * desc.m_shadingRateTileSize + desc.m_shadingRateTileSize / 2);
+
+    const float luma1 = FetchLuminance(colorView, x, y);
+    const float luma2 = FetchLuminance(colorView, x + 1, y);
+    const float luma3 = FetchLuminance(colorView, x, y + 1);
+    const float luma4 = FetchLuminance(colorView, x + 1, y + 1);
+
+    const float avgTileLuma = (luma1 + luma2 + luma3 + luma4) / 4.0f;
+    const float avgTileLumaX = fabsf(luma2 - luma1) + fabsf(luma4 - luma3);
+    const float avgTileLumaY = fabsf(luma3 - luma1) + fabsf(luma4 - luma2);
+    const float jndThreshold = ComputeJNDThreshold(desc.m_sensitivityThreshold / 2.0f, avgTileLuma, desc.m_environmentLuminance);
+
+    const float velocity = desc.m_useMotionVectors ? FetchVelocity(desc, (uint32_t)x, (uint32_t)y) : 10000.0f;
+    const float velocityHError = ComputeVelocityHError(velocity, desc.m_useMotionVectors);
+
+    const uint32_t xClass = GetShadingRateAxisClass(velocityHError * sqrtf(avgTileLumaX) >= jndThreshold, false);
+    const uint32_t yClass = GetShadingRateAxisClass(velocityHError * sqrtf(avgTileLumaY) >= jndThreshold, false);
+
+    return (uint8_t)LookupShadingRate(xClass, yClass, false);
+}
+
+static std::vector<uint8_t> ComputeTestMaskLP(const VALAR_CPU_DESCRIPTOR& desc, uint32_t workerThreadCount)
+{
+    VALAR_CPU_DESCRIPTOR maskDesc = desc;
+    maskDesc.m_workerThreadCount = workerThreadCount;
+    maskDesc.m_pOpaque = nullptr;
+
+    if (VALAR_InitializeCPU(maskDesc) != VALAR_RETURN_CODE_SUCCESS) {
+        return std::vector<uint8_t>();
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    maskDesc.m_valarBuffer = mask.data();
+
+    VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+
+    return mask;
+}
+
+// With its default 4 samples and without rotation the LP mask is the mask of the shader.
+static void TestCentroidSamples()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 11);
+    const uint32_t modes[] = { 0, VALAR_TEST_MODE_MOTION_VECTORS, VALAR_TEST_MODE_UPSCALED_MOTION_VECTORS };
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode : modes) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+            const std::vector<uint8_t> mask = ComputeTestMaskLP(desc, 0);
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            size_t differenceCount = 0;
+            for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                    differenceCount += (mask[(size_t)tileY * GetTileCountX(desc) + tileX] != ComputeCentroidShadingRate(desc, tileX, tileY)) ? 1 : 0;
+                }
+            }
+
+            if (!VALAR_TEST_CHECK(differenceCount == 0)) {
+                printf("    tile size %u mode %u: %zu tiles differ\n", tileSize, mode, differenceCount);
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// Every sample count and pattern only shades at the full and half rates, gives the same mask on any number of
+// workers, and reads whole flat and checkerboard tiles like the full mask does. Rotated patterns change with the frame.
+static void TestSamplePatterns()
+{
+    const uint32_t sampleCounts[] = { 4, 8, 16 };
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R8G8B8A8_UNORM, TEST_PATTERN_MIXED, 12);
+    const TEST_IMAGE whiteImage = MakeTestImage(96, 64, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_WHITE, 0);
+    const TEST_IMAGE checkerboardImage = MakeTestImage(96, 64, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_CHECKERBOARD, 0);
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t sampleCount : sampleCounts) {
+            for (uint32_t rotateSamples = 0; rotateSamples < 2; rotateSamples++) {
+                VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+                desc.m_LPSampleCount = sampleCount;
+                desc.m_LPRotateSamples = rotateSamples != 0;
+                desc.m_frameIndex = 7;
+
+                const std::vector<uint8_t> mask = ComputeTestMaskLP(desc, 0);
+                VALAR_TEST_CHECK(CountDifferences(ComputeTestMaskLP(desc, 3), mask) == 0);
+
+                size_t quarterRateCount = 0;
+                for (uint8_t shadingRate : mask) {
+                    quarterRateCount += (shadingRate != VALAR_SHADING_RATE_1X1 && shadingRate != VALAR_SHADING_RATE_1X2 &&
+                        shadingRate != VALAR_SHADING_RATE_2X1 && shadingRate != VALAR_SHADING_RATE_2X2) ? 1 : 0;
+                }
+                VALAR_TEST_CHECK(quarterRateCount == 0);
+
+                // Without rotation the frame does not matter, with rotation some frame moves the samples onto other pixels.
+                size_t frameDifferenceCount = 0;
+                for (uint32_t frameIndex = 8; frameIndex < 12; frameIndex++) {
+                    VALAR_CPU_DESCRIPTOR frameDesc = desc;
+                    frameDesc.m_frameIndex = frameIndex;
+                    frameDifferenceCount += CountDifferences(ComputeTestMaskLP(frameDesc, 0), mask);
+                }
+                VALAR_TEST_CHECK((frameDifferenceCount != 0) == (rotateSamples != 0));
+
+                VALAR_CPU_DESCRIPTOR whiteDesc = MakeTestDescriptor(whiteImage, tileSize, 0);
+                whiteDesc.m_LPSampleCount = sampleCount;
+                whiteDesc.m_LPRotateSamples = rotateSamples != 0;
+                const std::vector<uint8_t> whiteMask = ComputeTestMaskLP(whiteDesc, 0);
+                VALAR_TEST_CHECK(CountDifferences(whiteMask, std::vector<uint8_t>(whiteMask.size(), VALAR_SHADING_RATE_2X2)) == 0);
+
+                VALAR_CPU_DESCRIPTOR checkerboardDesc = MakeTestDescriptor(checkerboardImage, tileSize, 0);
+                checkerboardDesc.m_LPSampleCount = sampleCount;
+                checkerboardDesc.m_LPRotateSamples = rotateSamples != 0;
+                const std::vector<uint8_t> checkerboardMask = ComputeTestMaskLP(checkerboardDesc, 0);
+                VALAR_TEST_CHECK(CountDifferences(checkerboardMask, std::vector<uint8_t>(checkerboardMask.size(), VALAR_SHADING_RATE_1X1)) == 0);
+            }
+        }
+    }
+}
+
+static void TestInvalidSampleCounts()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    desc.m_valarBuffer = mask.data();
+
+    const uint32_t sampleCounts[] = { 0, 2, 12, 32 };
+    for (uint32_t sampleCount : sampleCounts) {
+        VALAR_CPU_DESCRIPTOR invalidDesc = desc;
+        invalidDesc.m_LPSampleCount = sampleCount;
+        VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    }
+
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), 0xEE)) == 0);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestCentroidSamples();
+    TestSamplePatterns();
+    TestInvalidSampleCounts();
+
+    return FinishTest("VALARTestLP");
+}
\ No newline at end of file
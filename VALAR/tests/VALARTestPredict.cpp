@@ -0,0 +1,222 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+static const uint8_t kShadingRates[] = { VALAR_SHADING_RATE_1X1, VALAR_SHADING_RATE_1X2, VALAR_SHADING_RATE_2X1, VALAR_SHADING_RATE_2X2,
+    VALAR_SHADING_RATE_2X4, VALAR_SHADING_RATE_4X2, VALAR_SHADING_RATE_4X4 };
+
+// Packed velocity of (x, y) whole pixels.
+static uint32_t PackVelocity(int32_t x, int32_t y)
+{
+    uint32_t packed = 0;
+
+    for (uint32_t value = 0; value < 0x400; value++) {
+        if (UnpackXY(value) == (float)x) {
+            packed |= value;
+        }
+        if (UnpackXY(value) == (float)y) {
+            packed |= value << 10;
+        }
+    }
+
+    return packed;
+}
+
+// Per axis finer rate, the X and Y rates are the upper and lower two bits of D3D12_SHADING_RATE.
+static uint8_t GetExpectedFinerShadingRate(uint8_t shadingRateA, uint8_t shadingRateB)
+{
+    const uint8_t rateX = ((shadingRateA >> 2) < (shadingRateB >> 2)) ? shadingRateA >> 2 : shadingRateB >> 2;
+    const uint8_t rateY = ((shadingRateA & 0x3) < (shadingRateB & 0x3)) ? shadingRateA & 0x3 : shadingRateB & 0x3;
+    return (uint8_t)((rateX << 2) | rateY);
+}
+
+// Random rates of the API in a mask of desc with row pitch desc.m_valarRowPitch, and 0xEE in the padding.
+static std::vector<uint8_t> MakeRandomMask(const VALAR_CPU_DESCRIPTOR& desc, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::vector<uint8_t> mask((size_t)GetValarRowPitch(desc) * GetTileCountY(desc), 0xEE);
+
+    for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+        for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+            mask[(size_t)tileY * GetValarRowPitch(desc) + tileX] = kShadingRates[random() % 7];
+        }
+    }
+
+    return mask;
+}
+
+// Expected prediction of a horizontal motion of velocityX pixels, a whole or half tile in either direction.
+static uint8_t GetExpectedShadingRate(const VALAR_CPU_DESCRIPTOR& desc, const std::vector<uint8_t>& mask, int32_t velocityX, uint32_t tileX, uint32_t tileY)
+{
+    const int32_t tileSize = (int32_t)desc.m_shadingRateTileSize;
+    const int32_t tilesX = (int32_t)GetTileCountX(desc);
+    const uint8_t* row = &mask[(size_t)tileY * GetValarRowPitch(desc)];
+    // A motion vector of +v moves the content by -v, source tile x lands on x - v / tileSize.
+    const int32_t shift = velocityX / tileSize;
+    uint8_t shadingRate = 0xFF;
+
+    const int32_t sourceBegin = (velocityX % tileSize == 0) ? (int32_t)tileX + shift : (int32_t)tileX + ((velocityX > 0) ? 0 : -1);
+    const int32_t sourceEnd = (velocityX % tileSize == 0) ? sourceBegin + 1 : sourceBegin + 2;
+
+    for (int32_t sourceX = sourceBegin; sourceX < sourceEnd; sourceX++) {
+        if (sourceX >= 0 && sourceX < tilesX) {
+            shadingRate = (shadingRate == 0xFF) ? row[sourceX] : GetExpectedFinerShadingRate(shadingRate, row[sourceX]);
+        }
+    }
+
+    return (shadingRate == 0xFF) ? (uint8_t)VALAR_SHADING_RATE_1X1 : shadingRate;
+}
+
+// Without motion vectors, or with zero ones, the prediction is a copy of the mask.
+static void TestCopy()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_BLACK, 0);
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < 2; mode++) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, (mode != 0) ? VALAR_TEST_MODE_MOTION_VECTORS : 0);
+            desc.m_valarRowPitch = GetTileCountX(desc) + 5;
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            std::vector<uint8_t> mask = MakeRandomMask(desc, tileSize + mode);
+            std::vector<uint8_t> predictedMask(mask.size(), 0xEE);
+            desc.m_valarBuffer = mask.data();
+
+            VALAR_TEST_CHECK(VALAR_PredictMaskCPU(desc, predictedMask.data()) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(CountDifferences(predictedMask, mask) == 0);
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// A uniform horizontal motion of whole and half tiles moves the rates of every row, the content entering the
+// frame predicts 1X1 and half tiles take the finer rate of the two tiles they overlap.
+static void TestMotion()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_BLACK, 0);
+
+    for (uint32_t tileSize : kTileSizes) {
+        const int32_t velocities[] = { (int32_t)tileSize, -(int32_t)tileSize, (int32_t)tileSize / 2, -(int32_t)tileSize / 2, 3 * (int32_t)tileSize };
+
+        for (int32_t velocityX : velocities) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+            desc.m_valarRowPitch = GetTileCountX(desc) + 5;
+
+            const std::vector<uint32_t> velocity((size_t)image.m_width * image.m_height, PackVelocity(velocityX, 0));
+            desc.m_velocityBuffer = velocity.data();
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            std::vector<uint8_t> mask = MakeRandomMask(desc, tileSize);
+            std::vector<uint8_t> predictedMask(mask.size(), 0xEE);
+            desc.m_valarBuffer = mask.data();
+
+            VALAR_TEST_CHECK(VALAR_PredictMaskCPU(desc, predictedMask.data()) == VALAR_RETURN_CODE_SUCCESS);
+
+            size_t differenceCount = 0;
+            for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                for (uint32_t tileX = 0; tileX < GetValarRowPitch(desc); tileX++) {
+                    const uint8_t expected = (tileX < GetTileCountX(desc)) ? GetExpectedShadingRate(desc, mask, velocityX, tileX, tileY) : (uint8_t)0xEE;
+                    differenceCount += (predictedMask[(size_t)tileY * GetValarRowPitch(desc) + tileX] != expected) ? 1 : 0;
+                }
+            }
+
+            if (!VALAR_TEST_CHECK(differenceCount == 0)) {
+                printf("    tile size %u velocity %d: %zu tiles differ\n", tileSize, velocityX, differenceCount);
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// A 1X2 and a 2X1 tile landing on the same tile predict 1X1, a 2X4 and a 4X2 tile 2X2.
+static void TestFinerRates()
+{
+    const TEST_IMAGE image = MakeTestImage(64, 8, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_BLACK, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, VALAR_TEST_MODE_MOTION_VECTORS);
+
+    const std::vector<uint32_t> velocity((size_t)image.m_width * image.m_height, PackVelocity(4, 0));
+    desc.m_velocityBuffer = velocity.data();
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask = { VALAR_SHADING_RATE_1X2, VALAR_SHADING_RATE_2X1, VALAR_SHADING_RATE_2X4, VALAR_SHADING_RATE_4X2,
+        VALAR_SHADING_RATE_4X4, VALAR_SHADING_RATE_4X4, VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_4X4 };
+    const std::vector<uint8_t> expectedMask = { VALAR_SHADING_RATE_1X1, VALAR_SHADING_RATE_2X1, VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_4X2,
+        VALAR_SHADING_RATE_4X4, VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_4X4 };
+    std::vector<uint8_t> predictedMask(mask.size(), 0xEE);
+    desc.m_valarBuffer = mask.data();
+
+    VALAR_TEST_CHECK(VALAR_PredictMaskCPU(desc, predictedMask.data()) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(CountDifferences(predictedMask, expectedMask) == 0);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+static void TestInvalidArguments()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, VALAR_TEST_MODE_MOTION_VECTORS);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), VALAR_SHADING_RATE_2X2);
+    desc.m_valarBuffer = mask.data();
+
+    VALAR_TEST_CHECK(VALAR_PredictMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_PredictMaskCPU(desc, mask.data()) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), VALAR_SHADING_RATE_2X2)) == 0);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestCopy();
+    TestMotion();
+    TestFinerRates();
+    TestInvalidArguments();
+
+    return FinishTest("VALARTestPredict");
+}
\ No newline at end of file
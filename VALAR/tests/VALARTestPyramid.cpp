@@ -0,0 +1,158 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Every level of a pyramid matches the mask of VALAR_ComputeMaskCPU at its tile size, with and without a row pitch,
+// and only the level of the descriptor tile size is counted.
+static void TestPyramidLevels()
+{
+    const VALAR_CPU_FORMAT colorFormats[] = { VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, VALAR_CPU_FORMAT_R8G8B8A8_UNORM, VALAR_CPU_FORMAT_R11G11B10_FLOAT };
+    const uint32_t sizes[][2] = { { 301, 133 }, { 1100, 41 }, { 7, 3 } };
+    const uint32_t modes[] = { 0, VALAR_TEST_MODE_MOTION_VECTORS, VALAR_TEST_MODE_UPSCALED_MOTION_VECTORS };
+
+    for (VALAR_CPU_FORMAT colorFormat : colorFormats) {
+        for (const uint32_t* size : sizes) {
+            const TEST_IMAGE image = MakeTestImage(size[0], size[1], colorFormat, TEST_PATTERN_MIXED, size[0] + colorFormat);
+
+            for (uint32_t mode : modes) {
+                VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 16, mode);
+                if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                    continue;
+                }
+
+                std::vector<uint8_t> masks[VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT];
+                std::vector<uint8_t> levels[VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT];
+                uint32_t tileCounts[VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT];
+                VALAR_CPU_MASK_PYRAMID pyramid;
+
+                for (uint32_t level = 0; level < VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT; level++) {
+                    VALAR_CPU_DESCRIPTOR levelDesc = desc;
+                    levelDesc.m_shadingRateTileSize = 8 << level;
+                    masks[level] = ComputeTestMask(levelDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+                    // Level 1 is written with a padded row pitch.
+                    const uint32_t tilesX = GetTileCountX(levelDesc);
+                    const uint32_t rowPitch = (level == 1) ? tilesX + 5 : tilesX;
+                    levels[level].assign((size_t)rowPitch * GetTileCountY(levelDesc), 0xEE);
+                    tileCounts[level] = tilesX * GetTileCountY(levelDesc);
+
+                    pyramid.m_valarBuffers[level] = levels[level].data();
+                    pyramid.m_valarRowPitches[level] = (level == 1) ? rowPitch : 0;
+                }
+
+                VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_SUCCESS);
+
+                VALAR_CPU_MASK_STATISTICS statistics;
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(statistics.m_tileCount == tileCounts[1]);
+
+                for (uint32_t level = 0; level < VALAR_CPU_MASK_PYRAMID_LEVEL_COUNT; level++) {
+                    const uint32_t tileSize = 8 << level;
+                    const uint32_t tilesX = (image.m_width + tileSize - 1) / tileSize;
+                    const uint32_t rowPitch = (level == 1) ? tilesX + 5 : tilesX;
+                    size_t differenceCount = 0;
+
+                    for (size_t i = 0; i < levels[level].size(); i++) {
+                        const size_t tileX = i % rowPitch;
+                        const uint8_t expected = (tileX < tilesX) ? masks[level][(i / rowPitch) * tilesX + tileX] : 0xEE;
+                        differenceCount += (levels[level][i] != expected) ? 1 : 0;
+                    }
+
+                    if (!VALAR_TEST_CHECK(differenceCount == 0)) {
+                        printf("    %ux%u format %u mode %u level %u\n", image.m_width, image.m_height, colorFormat, mode, level);
+                    }
+                }
+
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+        }
+    }
+}
+
+// A null buffer skips its level.
+static void TestPartialPyramid()
+{
+    const TEST_IMAGE image = MakeTestImage(133, 71, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 4);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    VALAR_CPU_DESCRIPTOR levelDesc = desc;
+    levelDesc.m_shadingRateTileSize = 32;
+    const std::vector<uint8_t> mask = ComputeTestMask(levelDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+    std::vector<uint8_t> level(mask.size(), 0xEE);
+    VALAR_CPU_MASK_PYRAMID pyramid;
+    pyramid.m_valarBuffers[2] = level.data();
+
+    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(CountDifferences(level, mask) == 0);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+static void TestInvalidPyramids()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> level((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    VALAR_CPU_MASK_PYRAMID pyramid;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    pyramid.m_valarBuffers[0] = level.data();
+    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_SUCCESS);
+
+    // The neighborhood minimum of Weber-Fechner mode does not reduce from 8x8 tiles.
+    VALAR_CPU_DESCRIPTOR weberFechnerDesc = desc;
+    weberFechnerDesc.m_weberFechnerMode = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(weberFechnerDesc, pyramid) == VALAR_RETURN_CODE_NOT_SUPPORTED);
+
+    // Amortized tiles would keep their rate in one level and not in the levels reduced from them.
+    VALAR_CPU_DESCRIPTOR amortizedDesc = desc;
+    amortizedDesc.m_amortizationPeriod = 4;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(amortizedDesc, pyramid) == VALAR_RETURN_CODE_NOT_SUPPORTED);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestPyramidLevels();
+    TestPartialPyramid();
+    TestInvalidPyramids();
+
+    return FinishTest("VALARTestPyramid");
+}
\ No newline at end of file
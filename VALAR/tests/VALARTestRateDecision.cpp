@@ -0,0 +1,166 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+
+// Every combination of axis classes maps to the D3D12 rate of the paper, 4x1 and 1x4 clamped to 2x1 and 1x2, and
+// the quarter rates shaded at 2x without m_allowQuarterRateShading.
+static void TestRateTable()
+{
+    const uint32_t expectedRates[VALAR_RATE_CLASS_COUNT][VALAR_RATE_CLASS_COUNT][2] = {
+        {
+            { VALAR_SHADING_RATE_1X1, VALAR_SHADING_RATE_1X1 },
+            { VALAR_SHADING_RATE_1X2, VALAR_SHADING_RATE_1X2 },
+            { VALAR_SHADING_RATE_1X2, VALAR_SHADING_RATE_1X2 },
+        },
+        {
+            { VALAR_SHADING_RATE_2X1, VALAR_SHADING_RATE_2X1 },
+            { VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_2X2 },
+            { VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_2X4 },
+        },
+        {
+            { VALAR_SHADING_RATE_2X1, VALAR_SHADING_RATE_2X1 },
+            { VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_4X2 },
+            { VALAR_SHADING_RATE_2X2, VALAR_SHADING_RATE_4X4 },
+        },
+    };
+
+    for (uint32_t xClass = 0; xClass < VALAR_RATE_CLASS_COUNT; xClass++) {
+        for (uint32_t yClass = 0; yClass < VALAR_RATE_CLASS_COUNT; yClass++) {
+            for (uint32_t allowQuarterRate = 0; allowQuarterRate < 2; allowQuarterRate++) {
+                VALAR_TEST_CHECK(LookupShadingRate(xClass, yClass, allowQuarterRate != 0) == expectedRates[xClass][yClass][allowQuarterRate]);
+                VALAR_TEST_CHECK(ResolveShadingRateClasses(xClass, yClass, allowQuarterRate != 0) == expectedRates[xClass][yClass][allowQuarterRate]);
+            }
+        }
+    }
+}
+
+// A tile passing the full rate test is shaded at the full rate unless it also passes the quarter rate test, and
+// ClassifyShadingRateAxis makes both tests like Equations 14 and 16.
+static void TestAxisClasses()
+{
+    VALAR_TEST_CHECK(GetShadingRateAxisClass(false, false) == VALAR_RATE_CLASS_HALF);
+    VALAR_TEST_CHECK(GetShadingRateAxisClass(true, false) == VALAR_RATE_CLASS_FULL);
+    VALAR_TEST_CHECK(GetShadingRateAxisClass(false, true) == VALAR_RATE_CLASS_QUARTER);
+    VALAR_TEST_CHECK(GetShadingRateAxisClass(true, true) == VALAR_RATE_CLASS_QUARTER);
+
+    std::mt19937 random(61);
+    uint32_t classCount[VALAR_RATE_CLASS_COUNT] = {};
+
+    for (uint32_t i = 0; i < 100000; i++) {
+        const float avgError = (float)(random() % 10000) / 10000.0f;
+        const float velocityHError = (float)(random() % 1000) / 1000.0f;
+        const float velocityQError = velocityHError * 2.13f;
+        const float jndThreshold = (float)(random() % 1000) / 2000.0f;
+
+        const uint32_t axisClass = ClassifyShadingRateAxis(avgError, velocityHError, velocityQError, jndThreshold);
+        const bool isFullRate = velocityHError * avgError >= jndThreshold;
+        const bool isQuarterRate = velocityQError * avgError < jndThreshold;
+
+        VALAR_TEST_CHECK(axisClass == (isQuarterRate ? VALAR_RATE_CLASS_QUARTER : (isFullRate ? VALAR_RATE_CLASS_FULL : VALAR_RATE_CLASS_HALF)));
+        classCount[axisClass]++;
+    }
+
+    for (uint32_t count : classCount) {
+        VALAR_TEST_CHECK(count > 0);
+    }
+}
+
+// The linearized curves run from 1 and K at rest to the values of the paper at 16 pixels per frame, K only scales
+// the quarter rate error once. Without motion vectors they stay at their values at rest.
+static void TestVelocityCurves()
+{
+    const float quarterRateModifiers[] = { 1.0f, 2.13f, 3.0f };
+
+    VALAR_TEST_CHECK(ComputeVelocityHError(0.0f, true) == 1.0f);
+    VALAR_TEST_CHECK(fabsf(ComputeVelocityHError(16.0f, true) - 0.0468f) < 1e-6f);
+    VALAR_TEST_CHECK(ComputeVelocityHError(16.0f, false) == 1.0f);
+
+    for (float K : quarterRateModifiers) {
+        VALAR_TEST_CHECK(ComputeVelocityQError(0.0f, K, true) == K);
+        VALAR_TEST_CHECK(fabsf(ComputeVelocityQError(16.0f, K, true) - 0.1629f) < 1e-6f);
+        VALAR_TEST_CHECK(ComputeVelocityQError(16.0f, K, false) == K);
+    }
+
+    VALAR_TEST_CHECK(ComputeJNDThreshold(0.5f, 0.3f, 0.02f) == 0.5f * (0.3f + 0.02f));
+}
+
+// Tile statistics of an average luminance of 0.5 with the given mean squared derivatives and velocity.
+static VALAR_TILE_STATISTICS MakeTileStatistics(uint32_t tileSize, float lumaX, float lumaY, float velocity)
+{
+    const float numPixels = (float)(tileSize * tileSize);
+
+    VALAR_TILE_STATISTICS stats;
+    stats.m_lumaSum = 0.5f * numPixels;
+    stats.m_lumaSumX = lumaX * numPixels;
+    stats.m_lumaSumY = lumaY * numPixels;
+    stats.m_velocityMin = velocity;
+
+    return stats;
+}
+
+// The rate of a tile follows the detail of each axis, quarter rates only where they are allowed, and fast motion
+// hides detail.
+static void TestTileDecision()
+{
+    const TEST_IMAGE image = MakeTestImage(64, 64, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_BLACK, 0);
+
+    for (uint32_t tileSize : kTileSizes) {
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, 0);
+        VALAR_CPU_DESCRIPTOR halfRateDesc = desc;
+        halfRateDesc.m_allowQuarterRateShading = false;
+        VALAR_CPU_DESCRIPTOR motionDesc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+
+        // With the default threshold of 0.5 and environment luminance of 0.02 the JND threshold is 0.26, a root mean
+        // square derivative of 1 passes the full rate test and 0 the quarter rate test.
+        VALAR_TEST_CHECK(ComputeTileShadingRate(desc, MakeTileStatistics(tileSize, 0.0f, 0.0f, 0.0f)) == VALAR_SHADING_RATE_4X4);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(halfRateDesc, MakeTileStatistics(tileSize, 0.0f, 0.0f, 0.0f)) == VALAR_SHADING_RATE_2X2);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(desc, MakeTileStatistics(tileSize, 1.0f, 1.0f, 0.0f)) == VALAR_SHADING_RATE_1X1);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(desc, MakeTileStatistics(tileSize, 1.0f, 0.0f, 0.0f)) == VALAR_SHADING_RATE_1X2);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(desc, MakeTileStatistics(tileSize, 0.0f, 1.0f, 0.0f)) == VALAR_SHADING_RATE_2X1);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(desc, MakeTileStatistics(tileSize, 1.0f, 0.01f, 0.0f)) == VALAR_SHADING_RATE_1X2);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(desc, MakeTileStatistics(tileSize, 0.04f, 0.0f, 0.0f)) == VALAR_SHADING_RATE_2X4);
+
+        VALAR_TEST_CHECK(ComputeTileShadingRate(motionDesc, MakeTileStatistics(tileSize, 1.0f, 1.0f, 0.0f)) == VALAR_SHADING_RATE_1X1);
+        VALAR_TEST_CHECK(ComputeTileShadingRate(motionDesc, MakeTileStatistics(tileSize, 1.0f, 1.0f, 16.0f)) == VALAR_SHADING_RATE_4X4);
+    }
+}
+
+int main()
+{
+    TestRateTable();
+    TestAxisClasses();
+    TestVelocityCurves();
+    TestTileDecision();
+
+    return FinishTest("VALARTestRateDecision");
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+
+// Without any luminance difference every tile takes the coarsest rate, in every mode and with partial tiles, since
+// the pixels outside of the buffer are black as well.
+static void TestBlackImage()
+{
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            const TEST_IMAGE image = MakeTestImage(5 * tileSize + 3, 3 * tileSize + 1, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_BLACK, 0);
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+
+            const std::vector<uint8_t> quarterMask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_SCALAR, 0);
+            VALAR_TEST_CHECK(CountDifferences(quarterMask, std::vector<uint8_t>(quarterMask.size(), VALAR_SHADING_RATE_4X4)) == 0);
+
+            desc.m_allowQuarterRateShading = false;
+            const std::vector<uint8_t> halfMask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_SCALAR, 0);
+            VALAR_TEST_CHECK(CountDifferences(halfMask, std::vector<uint8_t>(halfMask.size(), VALAR_SHADING_RATE_2X2)) == 0);
+        }
+    }
+}
+
+// Flat tiles take the coarsest rate, stripes are only shaded at the full rate across them. Tiles on
+// the left and top border also see the black pixels outside of the buffer and are skipped.
+static void TestPatterns()
+{
+    struct PATTERN_CASE
+    {
+        TEST_PATTERN            m_pattern;
+        VALAR_SHADING_RATE      m_shadingRate;
+    };
+
+    const PATTERN_CASE patternCases[] = {
+        { TEST_PATTERN_WHITE, VALAR_SHADING_RATE_4X4 },
+        { TEST_PATTERN_CHECKERBOARD, VALAR_SHADING_RATE_1X1 },
+        { TEST_PATTERN_HORIZONTAL_STRIPES, VALAR_SHADING_RATE_2X1 },
+        { TEST_PATTERN_VERTICAL_STRIPES, VALAR_SHADING_RATE_1X2 },
+    };
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (const PATTERN_CASE& patternCase : patternCases) {
+            const TEST_IMAGE image = MakeTestImage(4 * tileSize, 3 * tileSize, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, patternCase.m_pattern, 0);
+            const VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, 0);
+            const std::vector<uint8_t> mask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_SCALAR, 0);
+
+            for (uint32_t tileY = 1; tileY < 3; tileY++) {
+                for (uint32_t tileX = 1; tileX < 4; tileX++) {
+                    VALAR_TEST_CHECK(mask[tileY * 4 + tileX] == patternCase.m_shadingRate);
+                }
+            }
+        }
+    }
+}
+
+// The fused kernels match the straight per tile port of the shader up to the rounding of the float sums, and the
+// mask holds the rates of the kernel statistics, partial tiles and spans of several kernel calls included.
+static void TestTileStatistics()
+{
+    const uint32_t sizes[][2] = { { 333, 197 }, { 7, 5 }, { 1, 1 }, { 64, 64 }, { 1030, 37 } };
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            for (const uint32_t* size : sizes) {
+                const TEST_IMAGE image = MakeTestImage(size[0], size[1], VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, tileSize + mode + size[0]);
+                VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+                desc.m_instructionSet = VALAR_CPU_INSTRUCTION_SET_SCALAR;
+                desc.m_workerThreadCount = 0;
+
+                if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                    continue;
+                }
+
+                std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+                desc.m_valarBuffer = mask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+                const std::vector<VALAR_TILE_STATISTICS> stats = ComputeKernelStatistics(desc);
+                uint32_t statisticsErrorCount = 0;
+                uint32_t shadingRateErrorCount = 0;
+
+                for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                    for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                        const size_t tile = (size_t)tileY * GetTileCountX(desc) + tileX;
+
+                        VALAR_TILE_STATISTICS reference;
+                        ComputeTileStatistics(desc, tileX, tileY, reference);
+
+                        const float values[4] = { stats[tile].m_lumaSum, stats[tile].m_lumaSumX, stats[tile].m_lumaSumY, stats[tile].m_velocityMin };
+                        const float referenceValues[4] = { reference.m_lumaSum, reference.m_lumaSumX, reference.m_lumaSumY, reference.m_velocityMin };
+
+                        for (uint32_t i = 0; i < 4; i++) {
+                            if (fabsf(values[i] - referenceValues[i]) > 1e-4f * fmaxf(fabsf(referenceValues[i]), 1e-2f)) {
+                                statisticsErrorCount++;
+                            }
+                        }
+
+                        if (mask[tile] != ComputeTileShadingRate(desc, stats[tile])) {
+                            shadingRateErrorCount++;
+                        }
+                    }
+                }
+
+                VALAR_TEST_CHECK(statisticsErrorCount == 0);
+                VALAR_TEST_CHECK(shadingRateErrorCount == 0);
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+        }
+    }
+}
+
+static void TestInvalidArguments()
+{
+    const TEST_IMAGE image = MakeTestImage(64, 48, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 1);
+    std::vector<uint8_t> mask(8 * 6, 0xEE);
+
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+    desc.m_valarBuffer = mask.data();
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_NOT_INITIALIZED);
+    VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_DESCRIPTOR invalidDesc = desc;
+    invalidDesc.m_bufferWidth = 0;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_bufferHeight = 0;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_colorBuffer = nullptr;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_valarBuffer = nullptr;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_shadingRateTileSize = 12;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_useMotionVectors = true;
+    invalidDesc.m_velocityBuffer = nullptr;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_useMotionVectors = true;
+    invalidDesc.m_useUpscaleMotionVectors = true;
+    invalidDesc.m_upscaledVelocityBuffer = nullptr;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    // None of the rejected calls wrote the mask.
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), 0xEE)) == 0);
+
+    // A disabled mask is left alone as well.
+    desc.m_enabled = false;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), 0xEE)) == 0);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_NOT_INITIALIZED);
+}
+
+int main()
+{
+    TestBlackImage();
+    TestPatterns();
+    TestTileStatistics();
+    TestInvalidArguments();
+
+    return FinishTest("VALARTestReference");
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+
+// Random rects of whole tiles, including empty ones, overlapping ones and ones reaching the edges of the mask.
+static std::vector<VALAR_CPU_TILE_RECT> MakeRandomRects(const VALAR_CPU_DESCRIPTOR& desc, uint32_t rectCount, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::vector<VALAR_CPU_TILE_RECT> rects(rectCount);
+
+    for (VALAR_CPU_TILE_RECT& rect : rects) {
+        rect.m_left = random() % (GetTileCountX(desc) + 1);
+        rect.m_top = random() % (GetTileCountY(desc) + 1);
+        rect.m_right = rect.m_left + random() % (GetTileCountX(desc) + 1 - rect.m_left);
+        rect.m_bottom = rect.m_top + random() % (GetTileCountY(desc) + 1 - rect.m_top);
+    }
+
+    return rects;
+}
+
+static bool IsInsideRects(const std::vector<VALAR_CPU_TILE_RECT>& rects, uint32_t tileX, uint32_t tileY)
+{
+    for (const VALAR_CPU_TILE_RECT& rect : rects) {
+        if (tileX >= rect.m_left && tileX < rect.m_right && tileY >= rect.m_top && tileY < rect.m_bottom) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Tiles inside of the regions are the tiles of the full mask, the other tiles the fill rate, and the statistics
+// count both. Async masks, dirty rects over the whole image and row bands give the same mask, LP masks fill the
+// same tiles and the pyramid does not support regions.
+static void TestRegions()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R8G8B8A8_UNORM, TEST_PATTERN_MIXED, 41);
+    const uint32_t rectCounts[] = { 1, 2, 5 };
+    const VALAR_SHADING_RATE outsideShadingRates[] = { VALAR_SHADING_RATE_4X4, VALAR_SHADING_RATE_1X2 };
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            const VALAR_CPU_DESCRIPTOR fullDesc = MakeTestDescriptor(image, tileSize, mode);
+            const std::vector<uint8_t> fullMask = ComputeTestMask(fullDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+            for (uint32_t rectCount : rectCounts) {
+                const std::vector<VALAR_CPU_TILE_RECT> rects = MakeRandomRects(fullDesc, rectCount, tileSize + mode * 7 + rectCount * 100);
+                const VALAR_SHADING_RATE outsideShadingRate = outsideShadingRates[rectCount % 2];
+
+                VALAR_CPU_DESCRIPTOR desc = fullDesc;
+                desc.m_regionsOfInterest = rects.data();
+                desc.m_regionOfInterestCount = rectCount;
+                desc.m_outsideShadingRate = outsideShadingRate;
+                desc.m_workerThreadCount = 3;
+                desc.m_asyncMaskBufferCount = 1;
+
+                if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                    continue;
+                }
+
+                std::vector<uint8_t> expectedMask(fullMask.size());
+                uint32_t shadingRateTileCount[VALAR_CPU_SHADING_RATE_COUNT] = {};
+                for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                    for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                        const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                        expectedMask[i] = IsInsideRects(rects, tileX, tileY) ? fullMask[i] : (uint8_t)outsideShadingRate;
+                        shadingRateTileCount[expectedMask[i]]++;
+                    }
+                }
+
+                std::vector<uint8_t> mask(fullMask.size(), 0xEE);
+                desc.m_valarBuffer = mask.data();
+                VALAR_CPU_MASK_STATISTICS statistics;
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+
+                const size_t differenceCount = CountDifferences(mask, expectedMask);
+                if (!VALAR_TEST_CHECK(differenceCount == 0)) {
+                    printf("    tile size %u mode %u rects %u: %zu tiles differ\n", tileSize, mode, rectCount, differenceCount);
+                }
+                VALAR_TEST_CHECK(memcmp(statistics.m_shadingRateTileCount, shadingRateTileCount, sizeof(shadingRateTileCount)) == 0);
+
+                VALAR_CPU_ASYNC_MASK asyncMask;
+                if (VALAR_TEST_CHECK(VALAR_ComputeMaskAsyncCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS)) {
+                    VALAR_TEST_CHECK(VALAR_WaitForMaskCPU(desc, asyncMask) == VALAR_RETURN_CODE_SUCCESS);
+                    VALAR_TEST_CHECK(memcmp(asyncMask.m_valarBuffer, expectedMask.data(), expectedMask.size()) == 0);
+                    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+                }
+
+                const VALAR_CPU_RECT dirtyRect = { 0, 0, image.m_width, image.m_height };
+                std::fill(mask.begin(), mask.end(), (uint8_t)0xEE);
+                VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, &dirtyRect, 1) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(CountDifferences(mask, expectedMask) == 0);
+
+                // Row bands, one tile row at a time. Upscaled motion vectors do not line up with a band.
+                if ((mode & VALAR_TEST_MODE_UPSCALED_MOTION_VECTORS) == 0) {
+                    std::vector<uint8_t> bandMask(fullMask.size(), 0xEE);
+                    const size_t colorRowWords = (size_t)image.m_width * GetColorWordCount(image.m_colorFormat);
+
+                    for (uint32_t tileRow = 0; tileRow < GetTileCountY(desc); tileRow++) {
+                        const uint32_t firstRow = (tileRow > 0) ? tileRow * tileSize - 1 : 0;
+
+                        VALAR_CPU_ROW_BAND band;
+                        band.m_tileRow = tileRow;
+                        band.m_colorRows = &image.m_color[firstRow * colorRowWords];
+                        band.m_velocityRows = &image.m_velocity[(size_t)firstRow * image.m_width];
+
+                        VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, band, &bandMask[(size_t)tileRow * GetTileCountX(desc)]) == VALAR_RETURN_CODE_SUCCESS);
+                    }
+
+                    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+                    VALAR_TEST_CHECK(CountDifferences(bandMask, expectedMask) == 0);
+                }
+
+                // The LP mask of the regions is the LP mask of the whole image inside of them.
+                VALAR_CPU_DESCRIPTOR fullLPDesc = desc;
+                std::vector<uint8_t> fullLPMask(fullMask.size(), 0xEE);
+                fullLPDesc.m_regionOfInterestCount = 0;
+                fullLPDesc.m_valarBuffer = fullLPMask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(fullLPDesc) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(fullLPDesc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+
+                std::vector<uint8_t> expectedLPMask(fullMask.size());
+                std::fill(shadingRateTileCount, shadingRateTileCount + VALAR_CPU_SHADING_RATE_COUNT, 0u);
+                for (uint32_t tileY = 0; tileY < GetTileCountY(desc); tileY++) {
+                    for (uint32_t tileX = 0; tileX < GetTileCountX(desc); tileX++) {
+                        const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                        expectedLPMask[i] = IsInsideRects(rects, tileX, tileY) ? fullLPMask[i] : (uint8_t)outsideShadingRate;
+                        shadingRateTileCount[expectedLPMask[i]]++;
+                    }
+                }
+
+                std::fill(mask.begin(), mask.end(), (uint8_t)0xEE);
+                VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(CountDifferences(mask, expectedLPMask) == 0);
+                VALAR_TEST_CHECK(memcmp(statistics.m_shadingRateTileCount, shadingRateTileCount, sizeof(shadingRateTileCount)) == 0);
+
+                // The pyramid levels have tiles of other sizes than the regions.
+                if ((mode & VALAR_TEST_MODE_WEBER_FECHNER) == 0) {
+                    std::vector<uint8_t> levelMask(fullMask.size(), 0xEE);
+                    VALAR_CPU_MASK_PYRAMID pyramid;
+                    pyramid.m_valarBuffers[GetTileSizeIndex(tileSize)] = levelMask.data();
+                    VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_NOT_SUPPORTED);
+                    VALAR_TEST_CHECK(CountDifferences(levelMask, std::vector<uint8_t>(levelMask.size(), 0xEE)) == 0);
+                }
+
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+        }
+    }
+}
+
+// A region over the whole mask is the full mask, empty regions fill every tile.
+static void TestWholeAndEmptyRegions()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 42);
+
+    for (uint32_t tileSize : kTileSizes) {
+        const VALAR_CPU_DESCRIPTOR fullDesc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+        const std::vector<uint8_t> fullMask = ComputeTestMask(fullDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+        const VALAR_CPU_TILE_RECT wholeRect = { 0, 0, GetTileCountX(fullDesc), GetTileCountY(fullDesc) };
+        const VALAR_CPU_TILE_RECT emptyRects[2] = { { 1, 1, 1, 3 }, { 2, 2, 5, 2 } };
+
+        VALAR_CPU_DESCRIPTOR desc = fullDesc;
+        desc.m_regionsOfInterest = &wholeRect;
+        desc.m_regionOfInterestCount = 1;
+        desc.m_outsideShadingRate = VALAR_SHADING_RATE_4X4;
+        VALAR_TEST_CHECK(CountDifferences(ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0), fullMask) == 0);
+
+        desc.m_regionsOfInterest = emptyRects;
+        desc.m_regionOfInterestCount = 2;
+        VALAR_TEST_CHECK(CountDifferences(ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0), std::vector<uint8_t>(fullMask.size(), VALAR_SHADING_RATE_4X4)) == 0);
+    }
+}
+
+static void TestInvalidRegions()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    desc.m_valarBuffer = mask.data();
+
+    // The mask is 9x5 tiles.
+    const VALAR_CPU_TILE_RECT validRect = { 0, 0, 9, 5 };
+    const VALAR_CPU_TILE_RECT invalidRects[] = { { 0, 0, 10, 5 }, { 0, 0, 9, 6 }, { 3, 0, 2, 5 }, { 0, 3, 9, 2 } };
+
+    for (const VALAR_CPU_TILE_RECT& invalidRect : invalidRects) {
+        const VALAR_CPU_TILE_RECT rects[2] = { validRect, invalidRect };
+        VALAR_CPU_DESCRIPTOR invalidDesc = desc;
+        invalidDesc.m_regionsOfInterest = rects;
+        invalidDesc.m_regionOfInterestCount = 2;
+        VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    }
+
+    VALAR_CPU_DESCRIPTOR nullDesc = desc;
+    nullDesc.m_regionOfInterestCount = 1;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(nullDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_CPU_DESCRIPTOR rateDesc = desc;
+    rateDesc.m_regionsOfInterest = &validRect;
+    rateDesc.m_regionOfInterestCount = 1;
+    rateDesc.m_outsideShadingRate = (VALAR_SHADING_RATE)3;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(rateDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    // The history of the temporal mode covers whole masks.
+    VALAR_CPU_DESCRIPTOR temporalDesc = desc;
+    temporalDesc.m_regionsOfInterest = &validRect;
+    temporalDesc.m_regionOfInterestCount = 1;
+    temporalDesc.m_temporalReuse = true;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(temporalDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), 0xEE)) == 0);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestRegions();
+    TestWholeAndEmptyRegions();
+    TestInvalidRegions();
+
+    return FinishTest("VALARTestRegionsOfInterest");
+}
\ No newline at end of file
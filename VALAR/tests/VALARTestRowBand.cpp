@@ -0,0 +1,136 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Every tile row computed from a band copied into a buffer of exactly its rows matches the row of the full mask.
+static void TestRowBands()
+{
+    const uint32_t sizes[][2] = { { 333, 197 }, { 64, 64 }, { 7, 5 } };
+    const VALAR_CPU_FORMAT colorFormats[] = { VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, VALAR_CPU_FORMAT_R8G8B8A8_UNORM, VALAR_CPU_FORMAT_R16G16B16A16_FLOAT };
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+    const uint32_t modes[] = { 0, VALAR_TEST_MODE_MOTION_VECTORS, VALAR_TEST_MODE_WEBER_FECHNER | VALAR_TEST_MODE_MOTION_VECTORS };
+
+    for (const uint32_t* size : sizes) {
+        for (VALAR_CPU_FORMAT colorFormat : colorFormats) {
+            const TEST_IMAGE image = MakeTestImage(size[0], size[1], colorFormat, TEST_PATTERN_MIXED, size[1]);
+            const uint32_t wordCount = GetColorWordCount(colorFormat);
+
+            for (uint32_t tileSize : tileSizes) {
+                for (uint32_t mode : modes) {
+                    const VALAR_CPU_DESCRIPTOR imageDesc = MakeTestDescriptor(image, tileSize, mode);
+                    const std::vector<uint8_t> mask = ComputeTestMask(imageDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+                    VALAR_CPU_DESCRIPTOR desc = imageDesc;
+                    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                        continue;
+                    }
+
+                    const uint32_t tilesX = GetTileCountX(desc);
+                    std::vector<uint8_t> bandMask(mask.size(), 0xEE);
+
+                    for (uint32_t tileRow = 0; tileRow < GetTileCountY(desc); tileRow++) {
+                        const uint32_t firstRow = (tileRow > 0) ? tileRow * tileSize - 1 : 0;
+                        const uint32_t lastRow = std::min((tileRow + 1) * tileSize, image.m_height);
+                        const size_t colorRowWords = (size_t)image.m_width * wordCount;
+
+                        const std::vector<uint32_t> colorRows(image.m_color.begin() + firstRow * colorRowWords, image.m_color.begin() + lastRow * colorRowWords);
+                        const std::vector<uint32_t> velocityRows(image.m_velocity.begin() + (size_t)firstRow * image.m_width,
+                            image.m_velocity.begin() + (size_t)lastRow * image.m_width);
+
+                        VALAR_CPU_ROW_BAND band;
+                        band.m_tileRow = tileRow;
+                        band.m_colorRows = colorRows.data();
+                        band.m_velocityRows = velocityRows.data();
+
+                        VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, band, &bandMask[(size_t)tileRow * tilesX]) == VALAR_RETURN_CODE_SUCCESS);
+                    }
+
+                    VALAR_TEST_CHECK(CountDifferences(mask, bandMask) == 0);
+                    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+                }
+            }
+        }
+    }
+}
+
+static void TestInvalidRowBands()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, VALAR_TEST_MODE_MOTION_VECTORS);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> valarRow(GetTileCountX(desc));
+
+    VALAR_CPU_ROW_BAND band;
+    band.m_tileRow = GetTileCountY(desc) - 1;
+    band.m_colorRows = image.m_color.data();
+    band.m_velocityRows = image.m_velocity.data();
+    VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, band, valarRow.data()) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, band, nullptr) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_CPU_ROW_BAND pastBand = band;
+    pastBand.m_tileRow++;
+    VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, pastBand, valarRow.data()) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_CPU_ROW_BAND noVelocityBand = band;
+    noVelocityBand.m_velocityRows = nullptr;
+    VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, noVelocityBand, valarRow.data()) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    // Upscaled velocity rows do not line up with the rows of a band.
+    VALAR_CPU_DESCRIPTOR upscaledDesc = desc;
+    upscaledDesc.m_useUpscaleMotionVectors = true;
+    VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(upscaledDesc, band, valarRow.data()) == VALAR_RETURN_CODE_NOT_SUPPORTED);
+
+    // Only the views of a band start at a later row.
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    VALAR_CPU_DESCRIPTOR viewDesc = desc;
+    viewDesc.m_valarBuffer = mask.data();
+    viewDesc.m_colorView.m_data = image.m_color.data();
+    viewDesc.m_colorView.m_width = image.m_width;
+    viewDesc.m_colorView.m_height = image.m_height;
+    viewDesc.m_colorView.m_format = image.m_colorFormat;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(viewDesc) == VALAR_RETURN_CODE_SUCCESS);
+
+    viewDesc.m_colorView.m_firstRow = 1;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(viewDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(viewDesc, band, valarRow.data()) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestRowBands();
+    TestInvalidRowBands();
+
+    return FinishTest("VALARTestRowBand");
+}
\ No newline at end of file
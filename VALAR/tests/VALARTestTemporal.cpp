@@ -0,0 +1,337 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARCPUCommon.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const uint32_t kTileSizes[] = { 8, 16, 32 };
+static const uint32_t kModes[] = { 0, VALAR_TEST_MODE_WEBER_FECHNER, VALAR_TEST_MODE_MOTION_VECTORS };
+
+// Width x height window of a float image starting at column offsetX, with zero motion vectors.
+static TEST_IMAGE CropTestImage(const TEST_IMAGE& image, uint32_t offsetX, uint32_t width, uint32_t height)
+{
+    TEST_IMAGE crop;
+    crop.m_width = width;
+    crop.m_height = height;
+    crop.m_colorFormat = image.m_colorFormat;
+    crop.m_color.resize((size_t)width * height * 4);
+    crop.m_velocity.resize((size_t)width * height, 0);
+    crop.m_upscaledVelocity.resize((size_t)4 * width * height * 2, 0.0f);
+
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(&crop.m_color[(size_t)y * width * 4], &image.m_color[((size_t)y * image.m_width + offsetX) * 4], (size_t)width * 4 * sizeof(uint32_t));
+    }
+
+    return crop;
+}
+
+// Packed velocity of (pixels, 0).
+static uint32_t PackHorizontalVelocity(uint32_t pixels)
+{
+    for (uint32_t x = 0; x < 0x200; x++) {
+        if (UnpackXY(x) == (float)pixels) {
+            return x;
+        }
+    }
+
+    return 0;
+}
+
+// Computes the temporal mask of desc and the full mask of the same frame with fullDesc, another descriptor.
+static size_t CompareWithFullMask(const VALAR_CPU_DESCRIPTOR& desc, const VALAR_CPU_DESCRIPTOR& fullDesc, std::vector<uint8_t>& mask, std::vector<uint8_t>& fullMask)
+{
+    VALAR_CPU_DESCRIPTOR temporalDesc = desc;
+    temporalDesc.m_valarBuffer = mask.data();
+    VALAR_CPU_MASK_STATISTICS statistics;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(temporalDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(temporalDesc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(statistics.m_tileCount == mask.size());
+
+    VALAR_CPU_DESCRIPTOR maskDesc = fullDesc;
+    maskDesc.m_colorBuffer = desc.m_colorBuffer;
+    maskDesc.m_velocityBuffer = desc.m_velocityBuffer;
+    maskDesc.m_valarBuffer = fullMask.data();
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(maskDesc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+
+    return CountDifferences(mask, fullMask);
+}
+
+// The first mask and the masks of an unchanged image are the full mask. A changed block is recomputed right away,
+// and every tile within m_temporalMaxAge masks.
+static void TestStaticImage()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 31);
+
+    for (uint32_t tileSize : kTileSizes) {
+        for (uint32_t mode : kModes) {
+            TEST_IMAGE changedImage = image;
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+            VALAR_CPU_DESCRIPTOR fullDesc = desc;
+            desc.m_temporalReuse = true;
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS && VALAR_InitializeCPU(fullDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            const size_t tileCount = (size_t)GetTileCountX(desc) * GetTileCountY(desc);
+            std::vector<uint8_t> mask(tileCount, 0xEE);
+            std::vector<uint8_t> fullMask(tileCount, 0xEE);
+
+            VALAR_TEST_CHECK(CompareWithFullMask(desc, fullDesc, mask, fullMask) == 0);
+            VALAR_TEST_CHECK(CompareWithFullMask(desc, fullDesc, mask, fullMask) == 0);
+
+            // A bright block over 2x2 whole tiles, which changes the sampled luminance of every one of them.
+            const uint32_t blockX = 2 * tileSize;
+            const uint32_t blockY = 2 * tileSize;
+            for (uint32_t y = blockY; y < blockY + 2 * tileSize; y++) {
+                for (uint32_t x = blockX; x < blockX + 2 * tileSize; x++) {
+                    const float channels[4] = { 4.0f, 3.0f, 2.0f, 1.0f };
+                    EncodeColor(changedImage.m_colorFormat, channels, &changedImage.m_color[((size_t)y * image.m_width + x) * 4]);
+                }
+            }
+
+            desc.m_colorBuffer = changedImage.m_color.data();
+            CompareWithFullMask(desc, fullDesc, mask, fullMask);
+
+            size_t blockDifferenceCount = 0;
+            for (uint32_t tileY = 2; tileY < 4; tileY++) {
+                for (uint32_t tileX = 2; tileX < 4; tileX++) {
+                    const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                    blockDifferenceCount += (mask[i] != fullMask[i]) ? 1 : 0;
+                }
+            }
+            VALAR_TEST_CHECK(blockDifferenceCount == 0);
+
+            size_t differenceCount = 0;
+            for (uint32_t i = 0; i < desc.m_temporalMaxAge; i++) {
+                differenceCount = CompareWithFullMask(desc, fullDesc, mask, fullMask);
+            }
+            VALAR_TEST_CHECK(differenceCount == 0);
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(fullDesc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// A pan of whole tiles along its motion vectors reuses the statistics of the tiles it came from.
+static void TestPan()
+{
+    const TEST_IMAGE image = MakeTestImage(333 + 4 * 32, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 32);
+
+    for (uint32_t tileSize : kTileSizes) {
+        std::vector<TEST_IMAGE> frames;
+        for (uint32_t frame = 0; frame < 4; frame++) {
+            frames.push_back(CropTestImage(image, frame * tileSize, 333, 197));
+        }
+
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(frames[0], tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+        VALAR_CPU_DESCRIPTOR fullDesc = desc;
+        desc.m_temporalReuse = true;
+        // The pan keeps every luminance, any rejected tile comes from the motion vectors.
+        desc.m_temporalLumaTolerance = 0.0f;
+
+        if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS && VALAR_InitializeCPU(fullDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+            continue;
+        }
+
+        const size_t tileCount = (size_t)GetTileCountX(desc) * GetTileCountY(desc);
+        std::vector<uint8_t> mask(tileCount, 0xEE);
+        std::vector<uint8_t> fullMask(tileCount, 0xEE);
+        VALAR_TEST_CHECK(CompareWithFullMask(desc, fullDesc, mask, fullMask) == 0);
+
+        // The content of pixel x was at x + tileSize in the previous frame.
+        const std::vector<uint32_t> velocity((size_t)333 * 197, PackHorizontalVelocity(tileSize));
+        VALAR_TEST_CHECK(velocity[0] != 0);
+
+        for (uint32_t frame = 1; frame < 4; frame++) {
+            desc.m_colorBuffer = frames[frame].m_color.data();
+            desc.m_velocityBuffer = velocity.data();
+
+            const size_t differenceCount = CompareWithFullMask(desc, fullDesc, mask, fullMask);
+            if (!VALAR_TEST_CHECK(differenceCount == 0)) {
+                printf("    tile size %u frame %u: %zu tiles differ\n", tileSize, frame, differenceCount);
+            }
+        }
+
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(fullDesc) == VALAR_RETURN_CODE_SUCCESS);
+    }
+}
+
+// Masks, LP masks, pyramids and row bands computed outside of the temporal mode invalidate the history, even tolerances that accept any
+// change then recompute every tile of the next temporal mask. Dirty rects only invalidate the tiles they recomputed.
+static void TestInvalidation()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 33);
+    const TEST_IMAGE changedImage = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_WHITE, 0);
+
+    for (uint32_t invalidation = 0; invalidation < 6; invalidation++) {
+        VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+        VALAR_CPU_DESCRIPTOR fullDesc = desc;
+        desc.m_temporalReuse = true;
+        desc.m_temporalLumaTolerance = 1.0e30f;
+
+        if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS && VALAR_InitializeCPU(fullDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+            continue;
+        }
+
+        const size_t tileCount = (size_t)GetTileCountX(desc) * GetTileCountY(desc);
+        std::vector<uint8_t> mask(tileCount, 0xEE);
+        std::vector<uint8_t> fullMask(tileCount, 0xEE);
+        CompareWithFullMask(desc, fullDesc, mask, fullMask);
+
+        desc.m_colorBuffer = changedImage.m_color.data();
+        desc.m_valarBuffer = mask.data();
+
+        // The rect grows by the pixel of the gradients to its right and bottom, it covers tiles 0 to 2.
+        const VALAR_CPU_RECT dirtyRect = { 0, 0, 16, 16 };
+
+        if (invalidation == 1) {
+            VALAR_CPU_DESCRIPTOR maskDesc = desc;
+            maskDesc.m_temporalReuse = false;
+            VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(maskDesc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(maskDesc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+        } else if (invalidation == 2) {
+            VALAR_TEST_CHECK(VALAR_ComputeDirtyRectsCPU(desc, &dirtyRect, 1) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+        } else if (invalidation == 3) {
+            VALAR_CPU_MASK_PYRAMID pyramid;
+            pyramid.m_valarBuffers[0] = mask.data();
+            VALAR_TEST_CHECK(VALAR_ComputeMaskPyramidCPU(desc, pyramid) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+        } else if (invalidation == 4) {
+            // The first tile row, read from the full image.
+            VALAR_CPU_ROW_BAND band;
+            band.m_colorRows = changedImage.m_color.data();
+            band.m_velocityRows = changedImage.m_velocity.data();
+            VALAR_TEST_CHECK(VALAR_ComputeRowBandCPU(desc, band, mask.data()) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+        } else if (invalidation == 5) {
+            VALAR_TEST_CHECK(VALAR_ComputeMaskLPCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+        }
+
+        // Without an invalidation the tolerances keep the statistics of the old image.
+        const bool invalidatesHistory = (invalidation != 0 && invalidation != 2);
+        const size_t differenceCount = CompareWithFullMask(desc, fullDesc, mask, fullMask);
+        VALAR_TEST_CHECK((differenceCount == 0) == invalidatesHistory);
+
+        size_t rectDifferenceCount = 0;
+        for (uint32_t tileY = 0; tileY < 3; tileY++) {
+            for (uint32_t tileX = 0; tileX < 3; tileX++) {
+                const size_t i = (size_t)tileY * GetTileCountX(desc) + tileX;
+                rectDifferenceCount += (mask[i] != fullMask[i]) ? 1 : 0;
+            }
+        }
+        VALAR_TEST_CHECK((rectDifferenceCount == 0) == (invalidation != 0));
+
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(fullDesc) == VALAR_RETURN_CODE_SUCCESS);
+    }
+}
+
+// The reuse decisions of a frame sequence do not depend on the worker threads that made them.
+static void TestWorkerThreads()
+{
+    const TEST_IMAGE image = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 35);
+    const TEST_IMAGE changedImage = MakeTestImage(333, 197, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 36);
+    const uint32_t workerThreadCounts[] = { 0, 1, 3, VALAR_CPU_WORKER_THREAD_COUNT_AUTO };
+
+    for (uint32_t tileSize : kTileSizes) {
+        std::vector<std::vector<uint8_t>> firstMasks;
+
+        for (uint32_t workerThreadCount : workerThreadCounts) {
+            VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+            desc.m_temporalReuse = true;
+            desc.m_workerThreadCount = workerThreadCount;
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            std::vector<std::vector<uint8_t>> masks;
+            for (uint32_t frame = 0; frame < 6; frame++) {
+                std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+                desc.m_colorBuffer = (frame % 3 == 2) ? changedImage.m_color.data() : image.m_color.data();
+                desc.m_valarBuffer = mask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, nullptr) == VALAR_RETURN_CODE_SUCCESS);
+                masks.push_back(mask);
+            }
+
+            if (firstMasks.empty()) {
+                firstMasks = masks;
+            } else {
+                for (size_t frame = 0; frame < masks.size(); frame++) {
+                    VALAR_TEST_CHECK(CountDifferences(masks[frame], firstMasks[frame]) == 0);
+                }
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+static void TestInvalidCombinations()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+    desc.m_temporalReuse = true;
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+    desc.m_valarBuffer = mask.data();
+    const VALAR_CPU_TILE_RECT tileRect = { 0, 0, 2, 2 };
+
+    VALAR_CPU_DESCRIPTOR amortizedDesc = desc;
+    amortizedDesc.m_amortizationPeriod = 4;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(amortizedDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(desc, tileRect) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+    VALAR_TEST_CHECK(VALAR_ComputeMaskBatchCPU(&desc, 1) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_TEST_CHECK(CountDifferences(mask, std::vector<uint8_t>(mask.size(), 0xEE)) == 0);
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestStaticImage();
+    TestPan();
+    TestInvalidation();
+    TestWorkerThreads();
+    TestInvalidCombinations();
+
+    return FinishTest("VALARTestTemporal");
+}
\ No newline at end of file
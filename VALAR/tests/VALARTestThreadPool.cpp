@@ -0,0 +1,115 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Every tile row is computed by exactly one participant, whichever range it was stolen from.
+static void TestWorkerThreadCounts()
+{
+    const uint32_t workerThreadCounts[] = { 1, 2, 3, 8, VALAR_CPU_WORKER_THREAD_COUNT_AUTO };
+    const uint32_t sizes[][2] = { { 333, 197 }, { 1920, 1080 }, { 100, 8 } };
+
+    for (const uint32_t* size : sizes) {
+        const TEST_IMAGE image = MakeTestImage(size[0], size[1], VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, size[0]);
+        const VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, VALAR_TEST_MODE_MOTION_VECTORS);
+        const std::vector<uint8_t> singleThreadMask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+        for (uint32_t workerThreadCount : workerThreadCounts) {
+            VALAR_CPU_DESCRIPTOR poolDesc = desc;
+            poolDesc.m_workerThreadCount = workerThreadCount;
+
+            if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(poolDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+                continue;
+            }
+
+            // The pool is reused by every call.
+            for (uint32_t i = 0; i < 8; i++) {
+                std::vector<uint8_t> mask(singleThreadMask.size(), 0xEE);
+                poolDesc.m_valarBuffer = mask.data();
+
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(poolDesc) == VALAR_RETURN_CODE_SUCCESS);
+                VALAR_TEST_CHECK(CountDifferences(mask, singleThreadMask) == 0);
+            }
+
+            VALAR_TEST_CHECK(VALAR_ReleaseCPU(poolDesc) == VALAR_RETURN_CODE_SUCCESS);
+        }
+    }
+}
+
+// The core array is only read with one core per worker thread, a mismatching count leaves the workers unpinned.
+static void TestWorkerThreadCores()
+{
+    const TEST_IMAGE image = MakeTestImage(256, 128, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    const VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+    const std::vector<uint8_t> singleThreadMask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+    const uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+    const uint32_t autoWorkerThreadCount = (hardwareThreadCount > 1) ? hardwareThreadCount - 1 : 0;
+    const uint32_t workerCores[] = { 0, 0, 0, 0 };
+
+    struct CORE_CASE
+    {
+        uint32_t                m_workerThreadCount;
+        uint32_t                m_workerThreadCoreCount;
+    };
+
+    const CORE_CASE coreCases[] = {
+        { 4, 4 },
+        { 4, 2 },
+        { 0, 0 },
+        { 0, 4 },
+        // A count guessed for another machine, larger than the array.
+        { VALAR_CPU_WORKER_THREAD_COUNT_AUTO, (autoWorkerThreadCount == 1) ? 2u : 1u },
+    };
+
+    for (const CORE_CASE& coreCase : coreCases) {
+        VALAR_CPU_DESCRIPTOR coreDesc = desc;
+        coreDesc.m_workerThreadCount = coreCase.m_workerThreadCount;
+        coreDesc.m_workerThreadCores = workerCores;
+        coreDesc.m_workerThreadCoreCount = coreCase.m_workerThreadCoreCount;
+
+        if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(coreDesc) == VALAR_RETURN_CODE_SUCCESS)) {
+            continue;
+        }
+
+        std::vector<uint8_t> mask(singleThreadMask.size(), 0xEE);
+        coreDesc.m_valarBuffer = mask.data();
+
+        VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(coreDesc) == VALAR_RETURN_CODE_SUCCESS);
+        VALAR_TEST_CHECK(CountDifferences(mask, singleThreadMask) == 0);
+        VALAR_TEST_CHECK(VALAR_ReleaseCPU(coreDesc) == VALAR_RETURN_CODE_SUCCESS);
+    }
+}
+
+int main()
+{
+    TestWorkerThreadCounts();
+    TestWorkerThreadCores();
+
+    return FinishTest("VALARTestThreadPool");
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Computes the mask of desc as a grid of rects, one thread per column of rects, and returns its statistics.
+static VALAR_CPU_MASK_STATISTICS ComputeTileGrid(const VALAR_CPU_DESCRIPTOR& desc, uint32_t columnCount, uint32_t rowCount)
+{
+    const uint32_t tilesX = GetTileCountX(desc);
+    const uint32_t tilesY = GetTileCountY(desc);
+
+    std::vector<std::thread> threads;
+    std::vector<uint32_t> failureCounts(columnCount);
+
+    for (uint32_t column = 0; column < columnCount; column++) {
+        threads.emplace_back([&, column] {
+            for (uint32_t row = 0; row < rowCount; row++) {
+                VALAR_CPU_TILE_RECT tileRect;
+                tileRect.m_left = column * tilesX / columnCount;
+                tileRect.m_right = (column + 1) * tilesX / columnCount;
+                tileRect.m_top = row * tilesY / rowCount;
+                tileRect.m_bottom = (row + 1) * tilesY / rowCount;
+
+                // The failure count of VALAR_TEST_CHECK belongs to the main thread.
+                if (VALAR_ComputeTilesCPU(desc, tileRect) != VALAR_RETURN_CODE_SUCCESS) {
+                    failureCounts[column]++;
+                }
+            }
+        });
+    }
+
+    for (uint32_t column = 0; column < columnCount; column++) {
+        threads[column].join();
+        VALAR_TEST_CHECK(failureCounts[column] == 0);
+    }
+
+    VALAR_CPU_MASK_STATISTICS statistics;
+    VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+
+    return statistics;
+}
+
+static bool IsStatisticsEqual(const VALAR_CPU_MASK_STATISTICS& a, const VALAR_CPU_MASK_STATISTICS& b)
+{
+    for (uint32_t i = 0; i < VALAR_CPU_SHADING_RATE_COUNT; i++) {
+        if (a.m_shadingRateTileCount[i] != b.m_shadingRateTileCount[i]) {
+            return false;
+        }
+    }
+
+    return a.m_tileCount == b.m_tileCount;
+}
+
+// Rects computed on concurrent threads add up to the mask and the statistics of VALAR_ComputeMaskCPU, also with
+// regions of interest cutting through the rects.
+static void TestTileRects()
+{
+    const uint32_t sizes[][2] = { { 1001, 777 }, { 333, 197 }, { 7, 5 } };
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+
+    for (const uint32_t* size : sizes) {
+        const TEST_IMAGE image = MakeTestImage(size[0], size[1], VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, size[0]);
+
+        for (uint32_t tileSize : tileSizes) {
+            for (uint32_t useRegionsOfInterest = 0; useRegionsOfInterest < 2; useRegionsOfInterest++) {
+                VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, VALAR_TEST_MODE_MOTION_VECTORS);
+                const uint32_t tilesX = GetTileCountX(desc);
+                const uint32_t tilesY = GetTileCountY(desc);
+
+                VALAR_CPU_TILE_RECT regionsOfInterest[2];
+                regionsOfInterest[0].m_left = tilesX / 4;
+                regionsOfInterest[0].m_top = 0;
+                regionsOfInterest[0].m_right = tilesX / 2 + 1;
+                regionsOfInterest[0].m_bottom = tilesY / 2 + 1;
+                regionsOfInterest[1].m_left = tilesX / 3;
+                regionsOfInterest[1].m_top = tilesY / 3;
+                regionsOfInterest[1].m_right = tilesX;
+                regionsOfInterest[1].m_bottom = tilesY;
+
+                if (useRegionsOfInterest) {
+                    desc.m_regionsOfInterest = regionsOfInterest;
+                    desc.m_regionOfInterestCount = 2;
+                    desc.m_outsideShadingRate = VALAR_SHADING_RATE_4X4;
+                }
+
+                if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                    continue;
+                }
+
+                std::vector<uint8_t> mask((size_t)tilesX * tilesY, 0xEE);
+                std::vector<uint8_t> tileMask((size_t)tilesX * tilesY, 0xEE);
+
+                desc.m_valarBuffer = mask.data();
+                VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+                VALAR_CPU_MASK_STATISTICS statistics;
+                VALAR_TEST_CHECK(VALAR_FinalizeMaskCPU(desc, &statistics) == VALAR_RETURN_CODE_SUCCESS);
+
+                desc.m_valarBuffer = tileMask.data();
+                const VALAR_CPU_MASK_STATISTICS tileStatistics = ComputeTileGrid(desc, 3, 5);
+
+                VALAR_TEST_CHECK(CountDifferences(mask, tileMask) == 0);
+                VALAR_TEST_CHECK(IsStatisticsEqual(statistics, tileStatistics));
+
+                VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+            }
+        }
+    }
+}
+
+static void TestInvalidTileRects()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, 0);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    desc.m_valarBuffer = mask.data();
+
+    VALAR_CPU_TILE_RECT tileRect;
+    tileRect.m_right = GetTileCountX(desc);
+    tileRect.m_bottom = GetTileCountY(desc);
+    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(desc, tileRect) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_TILE_RECT pastRect = tileRect;
+    pastRect.m_right++;
+    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(desc, pastRect) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_CPU_TILE_RECT invertedRect = tileRect;
+    invertedRect.m_left = 2;
+    invertedRect.m_right = 1;
+    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(desc, invertedRect) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    // The temporal mode only reprojects whole masks.
+    VALAR_CPU_DESCRIPTOR temporalDesc = desc;
+    temporalDesc.m_temporalReuse = true;
+    VALAR_TEST_CHECK(VALAR_ComputeTilesCPU(temporalDesc, tileRect) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestTileRects();
+    TestInvalidTileRects();
+
+    return FinishTest("VALARTestTiles");
+}
\ No newline at end of file
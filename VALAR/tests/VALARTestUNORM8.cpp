@@ -0,0 +1,120 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARCPUOpaque.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+static const VALAR_CPU_FORMAT kColorFormats[] = {
+    VALAR_CPU_FORMAT_R8G8B8A8_UNORM,
+    VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB,
+    VALAR_CPU_FORMAT_B8G8R8A8_UNORM,
+    VALAR_CPU_FORMAT_B8G8R8A8_UNORM_SRGB,
+};
+
+// Mask of the float tile kernels and the float rate decision, which the fixed-point path has to reproduce.
+static std::vector<uint8_t> ComputeFloatMask(const VALAR_CPU_DESCRIPTOR& desc)
+{
+    const std::vector<VALAR_TILE_STATISTICS> stats = ComputeKernelStatistics(desc);
+
+    std::vector<uint8_t> mask(stats.size());
+    for (size_t i = 0; i < stats.size(); i++) {
+        mask[i] = ComputeTileShadingRate(desc, stats[i]);
+    }
+
+    return mask;
+}
+
+static bool IsQuarterShadingRate(uint8_t shadingRate)
+{
+    return shadingRate == VALAR_SHADING_RATE_2X4 || shadingRate == VALAR_SHADING_RATE_4X2 || shadingRate == VALAR_SHADING_RATE_4X4;
+}
+
+// Masks of the fixed-point kernels of the 8-bit formats equal the masks of the float path, including the quarter
+// rates that only the second comparison of every axis decides.
+static void CompareWithFloatPath(const TEST_IMAGE& image, size_t& quarterRateTileCount)
+{
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+    const float sensitivityThresholds[] = { 0.05f, 0.5f, 4.0f };
+
+    for (uint32_t tileSize : tileSizes) {
+        for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+            for (float sensitivityThreshold : sensitivityThresholds) {
+                for (uint32_t allowQuarterRate = 0; allowQuarterRate < 2; allowQuarterRate++) {
+                    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+                    desc.m_sensitivityThreshold = sensitivityThreshold;
+                    desc.m_allowQuarterRateShading = allowQuarterRate != 0;
+
+                    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+                        continue;
+                    }
+
+                    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc), 0xEE);
+                    desc.m_valarBuffer = mask.data();
+                    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+                    if (!VALAR_TEST_CHECK(CountDifferences(mask, ComputeFloatMask(desc)) == 0)) {
+                        printf("    %ux%u format %u tile size %u mode %u threshold %g quarter rate %u\n",
+                            image.m_width, image.m_height, image.m_colorFormat, tileSize, mode, sensitivityThreshold, allowQuarterRate);
+                    }
+
+                    for (uint8_t shadingRate : mask) {
+                        quarterRateTileCount += IsQuarterShadingRate(shadingRate) ? 1 : 0;
+                    }
+
+                    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+                }
+            }
+        }
+    }
+}
+
+static void TestFloatPath()
+{
+    const uint32_t sizes[][2] = { { 333, 197 }, { 1030, 37 }, { 7, 5 } };
+    size_t quarterRateTileCount = 0;
+
+    for (VALAR_CPU_FORMAT colorFormat : kColorFormats) {
+        for (const uint32_t* size : sizes) {
+            CompareWithFloatPath(MakeTestImage(size[0], size[1], colorFormat, TEST_PATTERN_MIXED, size[0] + colorFormat), quarterRateTileCount);
+        }
+
+        for (uint32_t pattern = TEST_PATTERN_BLACK; pattern < TEST_PATTERN_COUNT; pattern++) {
+            CompareWithFloatPath(MakeTestImage(67, 35, colorFormat, (TEST_PATTERN)pattern, 0), quarterRateTileCount);
+        }
+    }
+
+    // Otherwise the quarter rate comparisons are never exercised.
+    VALAR_TEST_CHECK(quarterRateTileCount > 0);
+}
+
+int main()
+{
+    TestFloatPath();
+
+    return FinishTest("VALARTestUNORM8");
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+// Copyright (C) 2023 Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "VALARCPU.h"
+#include "VALARTest.h"
+
+using namespace Intel;
+using namespace Intel::Test;
+
+// Padded buffer of noise holding an image at m_origin.
+struct TEST_ATLAS
+{
+    std::vector<uint32_t>       m_words;
+    uint32_t                    m_rowPitch = 0;
+    const uint32_t*             m_origin = nullptr;
+};
+
+// Copies height rows of rowWords words to word (x, y) of an atlas with padWords more words per row.
+static TEST_ATLAS MakeAtlas(const uint32_t* rows, uint32_t rowWords, uint32_t height, uint32_t x, uint32_t y, uint32_t padWords)
+{
+    TEST_ATLAS atlas;
+    const uint32_t atlasWidth = x + rowWords + padWords;
+
+    atlas.m_words.resize((size_t)atlasWidth * (y + height + 3));
+    for (size_t i = 0; i < atlas.m_words.size(); i++) {
+        atlas.m_words[i] = (uint32_t)(i * 2654435761u);
+    }
+
+    for (uint32_t row = 0; row < height; row++) {
+        memcpy(&atlas.m_words[(size_t)(y + row) * atlasWidth + x], rows + (size_t)row * rowWords, rowWords * sizeof(uint32_t));
+    }
+
+    atlas.m_rowPitch = atlasWidth * sizeof(uint32_t);
+    atlas.m_origin = &atlas.m_words[(size_t)y * atlasWidth + x];
+
+    return atlas;
+}
+
+// Views into padded atlases compute the masks of the tightly packed buffers, for every input and tile size.
+static void TestAtlasViews()
+{
+    const VALAR_CPU_FORMAT colorFormats[] = { VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, VALAR_CPU_FORMAT_B8G8R8A8_UNORM, VALAR_CPU_FORMAT_R16G16B16A16_FLOAT };
+    const uint32_t tileSizes[] = { 8, 16, 32 };
+
+    for (VALAR_CPU_FORMAT colorFormat : colorFormats) {
+        const TEST_IMAGE image = MakeTestImage(133, 71, colorFormat, TEST_PATTERN_MIXED, colorFormat);
+        const uint32_t colorWords = image.m_width * GetColorWordCount(colorFormat);
+
+        const TEST_ATLAS colorAtlas = MakeAtlas(image.m_color.data(), colorWords, image.m_height, 5, 3, 7);
+        const TEST_ATLAS velocityAtlas = MakeAtlas(image.m_velocity.data(), image.m_width, image.m_height, 1, 2, 9);
+        const TEST_ATLAS upscaledAtlas = MakeAtlas((const uint32_t*)image.m_upscaledVelocity.data(), 2 * 2 * image.m_width, 2 * image.m_height, 4, 1, 2);
+
+        for (uint32_t tileSize : tileSizes) {
+            for (uint32_t mode = 0; mode < VALAR_TEST_MODE_COUNT; mode++) {
+                const VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, tileSize, mode);
+                const std::vector<uint8_t> mask = ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0);
+
+                // The legacy pointers are left set, the views take precedence.
+                VALAR_CPU_DESCRIPTOR viewDesc = desc;
+                viewDesc.m_colorFormat = VALAR_CPU_FORMAT_R32G32B32A32_FLOAT;
+
+                viewDesc.m_colorView.m_data = colorAtlas.m_origin;
+                viewDesc.m_colorView.m_rowPitch = colorAtlas.m_rowPitch;
+                viewDesc.m_colorView.m_width = image.m_width;
+                viewDesc.m_colorView.m_height = image.m_height;
+                viewDesc.m_colorView.m_format = colorFormat;
+
+                viewDesc.m_velocityView.m_data = velocityAtlas.m_origin;
+                viewDesc.m_velocityView.m_rowPitch = velocityAtlas.m_rowPitch;
+                viewDesc.m_velocityView.m_width = image.m_width;
+                viewDesc.m_velocityView.m_height = image.m_height;
+                viewDesc.m_velocityView.m_format = VALAR_CPU_FORMAT_R32_UINT;
+
+                viewDesc.m_upscaledVelocityView.m_data = upscaledAtlas.m_origin;
+                viewDesc.m_upscaledVelocityView.m_rowPitch = upscaledAtlas.m_rowPitch;
+                viewDesc.m_upscaledVelocityView.m_width = desc.m_upscaleWidth;
+                viewDesc.m_upscaledVelocityView.m_height = desc.m_upscaleHeight;
+                viewDesc.m_upscaledVelocityView.m_format = VALAR_CPU_FORMAT_R32G32_FLOAT;
+
+                if (!VALAR_TEST_CHECK(CountDifferences(ComputeTestMask(viewDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0), mask) == 0)) {
+                    printf("    format %u tile size %u mode %u\n", colorFormat, tileSize, mode);
+                }
+            }
+        }
+    }
+}
+
+// A view with a row pitch of 0 has tightly packed rows.
+static void TestPackedView()
+{
+    const TEST_IMAGE image = MakeTestImage(67, 35, VALAR_CPU_FORMAT_R8G8B8A8_UNORM_SRGB, TEST_PATTERN_MIXED, 2);
+    const VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 16, 0);
+
+    VALAR_CPU_DESCRIPTOR viewDesc = desc;
+    viewDesc.m_colorBuffer = nullptr;
+    viewDesc.m_colorFormat = VALAR_CPU_FORMAT_R32G32B32A32_FLOAT;
+    viewDesc.m_colorView.m_data = image.m_color.data();
+    viewDesc.m_colorView.m_width = image.m_width;
+    viewDesc.m_colorView.m_height = image.m_height;
+    viewDesc.m_colorView.m_format = image.m_colorFormat;
+
+    VALAR_TEST_CHECK(CountDifferences(ComputeTestMask(viewDesc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0), ComputeTestMask(desc, VALAR_CPU_INSTRUCTION_SET_AUTO, 0)) == 0);
+}
+
+static void TestInvalidViews()
+{
+    const TEST_IMAGE image = MakeTestImage(35, 19, VALAR_CPU_FORMAT_R32G32B32A32_FLOAT, TEST_PATTERN_MIXED, 0);
+    VALAR_CPU_DESCRIPTOR desc = MakeTestDescriptor(image, 8, VALAR_TEST_MODE_MOTION_VECTORS);
+
+    if (!VALAR_TEST_CHECK(VALAR_InitializeCPU(desc) == VALAR_RETURN_CODE_SUCCESS)) {
+        return;
+    }
+
+    std::vector<uint8_t> mask((size_t)GetTileCountX(desc) * GetTileCountY(desc));
+    desc.m_valarBuffer = mask.data();
+
+    desc.m_colorView.m_data = image.m_color.data();
+    desc.m_colorView.m_width = image.m_width;
+    desc.m_colorView.m_height = image.m_height;
+    desc.m_colorView.m_format = image.m_colorFormat;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+
+    VALAR_CPU_DESCRIPTOR invalidDesc = desc;
+    invalidDesc.m_colorView.m_data = (const uint8_t*)image.m_color.data() + 2;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_colorView.m_rowPitch = image.m_width * 16 + 2;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_colorView.m_rowPitch = image.m_width * 16 - 16;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_colorView.m_width = image.m_width - 1;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_colorView.m_height = image.m_height + 1;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    invalidDesc = desc;
+    invalidDesc.m_colorView.m_format = VALAR_CPU_FORMAT_R32_UINT;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    // The velocity view only takes the packed velocity format.
+    invalidDesc = desc;
+    invalidDesc.m_velocityView.m_data = image.m_velocity.data();
+    invalidDesc.m_velocityView.m_width = image.m_width;
+    invalidDesc.m_velocityView.m_height = image.m_height;
+    invalidDesc.m_velocityView.m_format = VALAR_CPU_FORMAT_R32G32_FLOAT;
+    VALAR_TEST_CHECK(VALAR_ComputeMaskCPU(invalidDesc) == VALAR_RETURN_CODE_INVALID_ARGUMENT);
+
+    VALAR_TEST_CHECK(VALAR_ReleaseCPU(desc) == VALAR_RETURN_CODE_SUCCESS);
+}
+
+int main()
+{
+    TestAtlasViews();
+    TestPackedView();
+    TestInvalidViews();
+
+    return FinishTest("VALARTestViews");
+}
\ No newline at end of file